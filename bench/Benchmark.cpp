@@ -0,0 +1,86 @@
+/****************************************************************************//**
+ * @file
+ * @brief Runs the BenchmarkSuite and writes the results as JSON or CSV.
+ * Build with the ARSDK and FFmpeg headers and libraries on the search paths:
+ * g++ -std=c++14 -O2 -pthread -Iinclude -I<ARSDK>/usr/include bench/Benchmark.cpp
+ * -Llib -L<ARSDK>/usr/lib -lwscDrone -larcontroller -lardiscovery -larsal
+ * -lavformat -lavcodec -lswscale -lavutil -o wscDroneBenchmark
+ * and run on an idle machine, e.g.
+ * ./wscDroneBenchmark -l 1.4.0 -o results.json bebop_856x480.h264 bebop_1280x720.h264
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+#include "wscDrone/Benchmark.h"
+
+namespace {
+
+void usage(const char *program)
+{
+    std::fprintf(stderr,
+                 "usage: %s [-l label] [-c] [-d milliseconds] [-r readers] [-o file] [clip.h264 ...]\n"
+                 "  -l  label identifying the run, e.g. the library release\n"
+                 "  -c  write CSV instead of JSON\n"
+                 "  -d  minimum time each benchmark runs for, default 1000\n"
+                 "  -r  most reader threads in the frame hand-off benchmarks, default 8\n"
+                 "  -o  file to write the results to, default standard output\n"
+                 "Each clip is an H.264 elementary stream for the decode benchmarks. Without clips only\n"
+                 "the conversion, hand-off, wake and dispatch benchmarks run.\n",
+                 program);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    wscDrone::BenchmarkOptions options;
+    bool csv = false;
+    std::string output;
+    int option;
+    while ((option = getopt(argc, argv, "l:cd:r:o:h")) != -1) {
+        switch (option) {
+        case 'l': options.label = optarg; break;
+        case 'c': csv = true; break;
+        case 'd': options.durationMilliseconds = static_cast<unsigned>(std::strtoul(optarg, nullptr, 10)); break;
+        case 'r': options.maxReaders = static_cast<unsigned>(std::strtoul(optarg, nullptr, 10)); break;
+        case 'o': output = optarg; break;
+        default:
+            usage(argv[0]);
+            return option == 'h' ? 0 : 2;
+        }
+    }
+    for (int i = optind; i < argc; i++) { options.clips.push_back(argv[i]); }
+
+    std::string results;
+    try {
+        wscDrone::BenchmarkSuite suite(options);
+        suite.runAll();
+        results = csv ? suite.toCsv() : suite.toJson();
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    std::FILE *file = output.empty() ? stdout : std::fopen(output.c_str(), "w");
+    if (!file) {
+        std::fprintf(stderr, "unable to create %s\n", output.c_str());
+        return 1;
+    }
+    const bool written = std::fwrite(results.data(), 1, results.size(), file) == results.size();
+    if (file != stdout && std::fclose(file) != 0) { return 1; }
+    return written ? 0 : 1;
+}
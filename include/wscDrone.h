@@ -18,8 +18,40 @@
 #include "wscDrone/Pilot.h"
 #include "wscDrone/VideoDecoder.h"
 #include "wscDrone/Semaphore.h"
+#include "wscDrone/FutexSemaphore.h"
 #include "wscDrone/Utils.h"
 #include "wscDrone/VideoFrame.h"
+#include "wscDrone/PixelFormat.h"
+#include "wscDrone/ColourConvert.h"
+#include "wscDrone/SpscQueue.h"
+#include "wscDrone/TripleBufferFrame.h"
+#include "wscDrone/SharedMemoryFrame.h"
+#include "wscDrone/FramePool.h"
+#include "wscDrone/FrameOutputs.h"
+#include "wscDrone/H264Decoder.h"
+#include "wscDrone/LatencyHistogram.h"
+#include "wscDrone/DroneTransport.h"
+#include "wscDrone/CodecCache.h"
+#include "wscDrone/DecodeWorkerPool.h"
+#include "wscDrone/DecodePipeline.h"
+#include "wscDrone/ImageEncoder.h"
+#include "wscDrone/SnapshotEncoder.h"
+#include "wscDrone/EventLoop.h"
+#include "wscDrone/Fleet.h"
+#include "wscDrone/SeqLock.h"
+#include "wscDrone/Telemetry.h"
+#include "wscDrone/CommandDispatcher.h"
+#include "wscDrone/FtpClient.h"
+#include "wscDrone/MediaDownloader.h"
+#include "wscDrone/MoveSequencer.h"
+#include "wscDrone/SetpointStreamer.h"
+#include "wscDrone/CameraOrientationScheduler.h"
+#include "wscDrone/LocalTransport.h"
+#include "wscDrone/Simulator.h"
+#include "wscDrone/FlightLog.h"
+#include "wscDrone/FlightRecorder.h"
+#include "wscDrone/FlightReplay.h"
+#include "wscDrone/StreamRecorder.h"
 
 /// This namespace encapsulates the Wescam Drone Layer
 namespace wscDrone {
@@ -0,0 +1,683 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the BenchmarkSuite, which times the video and
+ * control hot paths and reports the results in machine-readable form.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libARController/ARController.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "CommandDispatcher.h"
+#include "FutexSemaphore.h"
+#include "H264Decoder.h"
+#include "LatencyHistogram.h"
+#include "LocalTransport.h"
+#include "MoveSequencer.h"
+#include "PixelFormat.h"
+#include "Semaphore.h"
+#include "Simulator.h"
+#include "Telemetry.h"
+#include "TripleBufferFrame.h"
+#include "Utils.h"
+#include "VideoDecoder.h"
+
+namespace wscDrone {
+
+/// Configuration of a BenchmarkSuite
+struct BenchmarkOptions {
+    std::string label;                 ///< identifies the run in the output, e.g. the library release
+    std::vector<std::string> clips;    ///< H.264 elementary streams for the decode benchmarks, e.g. 856x480 and 1280x720 recordings
+    unsigned durationMilliseconds = 1000; ///< minimum time each benchmark runs for
+    unsigned minIterations        = 100;  ///< minimum operations each benchmark times
+    unsigned warmupIterations     = 10;   ///< untimed operations before each benchmark
+    unsigned maxReaders           = 8;    ///< the frame hand-off runs with 1, 2, 4 ... up to this many readers
+    unsigned handoffWidth         = 856;  ///< frame size for the hand-off benchmarks
+    unsigned handoffHeight        = 480;
+};
+
+/// The outcome of one benchmark
+struct BenchmarkResult {
+    std::string name;            ///< benchmark name, e.g. "decode.h264decoder"
+    std::string parameters;      ///< inputs as comma separated key=value pairs
+    uint64_t    iterations = 0;  ///< operations timed
+    uint64_t    bytes      = 0;  ///< bytes processed by the timed operations
+    double      seconds    = 0.0; ///< wall time of the timed operations
+    LatencyHistogramSnapshot latency; ///< time of each operation
+    std::vector<std::pair<std::string, double>> counters; ///< secondary measurements, e.g. reader throughput
+
+    /// Get the throughput in operations
+    /// @returns operations per second
+    double opsPerSecond() const { return seconds > 0.0 ? iterations / seconds : 0.0; }
+
+    /// Get the throughput in bytes
+    /// @returns megabytes (10^6 bytes) per second
+    double megabytesPerSecond() const { return seconds > 0.0 ? bytes / seconds / 1e6 : 0.0; }
+};
+
+/// Times the hot paths of the library: H.264 decode through bebop_driver::VideoDecoder and
+/// H264Decoder, colour conversion, frame hand-off through the VideoFrame buffer mutex and the
+/// TripleBufferFrame, Semaphore and FutexSemaphore wake latency, command callback dispatch and
+/// CommandDispatcher table dispatch.
+/// @details Each run function appends to the results, which toJson() and toCsv() format for
+/// comparison between library releases. The suite is not included by wscDrone.h; bench/Benchmark.cpp
+/// runs it from the command line. A benchmark program is a few lines:
+/// @code
+/// wscDrone::BenchmarkOptions options;
+/// options.label = "1.4.0";
+/// options.clips = { "bebop_856x480.h264", "bebop_1280x720.h264" };
+/// wscDrone::BenchmarkSuite suite(options);
+/// suite.runAll();
+/// std::cout << suite.toJson();
+/// @endcode
+/// Decode benchmarks loop over each clip from its first I-frame and throw std::runtime_error if a
+/// clip cannot be read. Run on an otherwise idle machine with a fixed CPU frequency for stable results.
+class BenchmarkSuite {
+public:
+    /// Construct a suite
+    /// @param options what to run and for how long
+    explicit BenchmarkSuite(const BenchmarkOptions &options = BenchmarkOptions()) : m_options(options) {}
+
+    BenchmarkSuite(const BenchmarkSuite &) = delete;
+    BenchmarkSuite &operator=(const BenchmarkSuite &) = delete;
+
+    /// Run every benchmark
+    void runAll()
+    {
+        for (const std::string &clip : m_options.clips) {
+            auto stream = H264ElementaryStream::load(clip);
+            runVideoDecoder(*stream, clip);
+            runH264Decoder(*stream, clip, 1);
+            runH264Decoder(*stream, clip, 0);
+            runColourConvert(*stream, clip);
+        }
+        runConvertSimdVersusSwscale();
+        for (unsigned readers = 1; readers <= m_options.maxReaders; readers *= 2) {
+            runMutexHandoff(readers);
+        }
+        runTripleBufferHandoff();
+        runSemaphoreWake<Semaphore>("semaphore.wake");
+        runSemaphoreWake<FutexSemaphore>("futexsemaphore.wake");
+        runCommandDispatch();
+        runCommandTableDispatch();
+    }
+
+    /// Time bebop_driver::VideoDecoder::Decode(), which decodes each frame and converts it to RGB
+    /// with ConvertFrameToRGB()
+    /// @param stream the clip
+    /// @param clipName name of the clip in the results
+    /// @returns the result
+    BenchmarkResult runVideoDecoder(const H264ElementaryStream &stream, const std::string &clipName)
+    {
+        bebop_driver::VideoDecoder decoder;
+        std::vector<uint8_t> sps = stream.getSps();
+        std::vector<uint8_t> pps = stream.getPps();
+        decoder.SetH264Params(sps.data(), static_cast<uint32_t>(sps.size()), pps.data(), static_cast<uint32_t>(pps.size()));
+
+        std::vector<uint8_t> buffer;
+        size_t next = stream.getFirstIFrame();
+        auto op = [&]() -> uint64_t {
+            const H264ElementaryStream::AccessUnit &unit = m_nextUnit(stream, next);
+            buffer.assign(stream.getData() + unit.offset, stream.getData() + unit.offset + unit.size);
+            ARCONTROLLER_Frame_t frame;
+            std::memset(&frame, 0, sizeof(frame));
+            frame.data     = buffer.data();
+            frame.capacity = static_cast<uint32_t>(buffer.capacity());
+            frame.used     = static_cast<uint32_t>(buffer.size());
+            frame.isIFrame = unit.isIFrame ? 1 : 0;
+            decoder.Decode(&frame);
+            return unit.size;
+        };
+        BenchmarkResult result = m_time("decode.videodecoder", "", op);
+        result.parameters = m_clipParameters(clipName, decoder.GetFrameWidth(), decoder.GetFrameHeight());
+        return m_add(std::move(result));
+    }
+
+    /// Time H264Decoder decoding without colour conversion
+    /// @param stream the clip
+    /// @param clipName name of the clip in the results
+    /// @param threadCount decoder threads, 0 for one per core
+    /// @returns the result
+    BenchmarkResult runH264Decoder(const H264ElementaryStream &stream, const std::string &clipName,
+                                   int threadCount)
+    {
+        DecoderOptions decoderOptions;
+        decoderOptions.threadCount = threadCount;
+        H264Decoder decoder(decoderOptions);
+        decoder.setH264Params(stream.getSps().data(), static_cast<uint32_t>(stream.getSps().size()),
+                              stream.getPps().data(), static_cast<uint32_t>(stream.getPps().size()));
+
+        size_t  next = stream.getFirstIFrame();
+        int64_t pts  = 0;
+        auto op = [&]() -> uint64_t {
+            if (next >= stream.getAccessUnits().size()) {
+                // restart cleanly at each loop of the clip
+                decoder.flush();
+                while (decoder.receiveFrame()) {}
+            }
+            const H264ElementaryStream::AccessUnit &unit = m_nextUnit(stream, next);
+            decoder.sendPacket(stream.getData() + unit.offset, unit.size, unit.isIFrame, pts++);
+            while (decoder.receiveFrame()) {}
+            return unit.size;
+        };
+        BenchmarkResult result = m_time("decode.h264decoder", "", op);
+        result.parameters = m_clipParameters(clipName, decoder.getWidth(), decoder.getHeight()) +
+                            ",threads=" + std::to_string(threadCount);
+        return m_add(std::move(result));
+    }
+
+    /// Time H264Decoder::convertTo() of one decoded picture into each PixelFormat. RGB24 is the
+    /// conversion ConvertFrameToRGB() performs inside bebop_driver::VideoDecoder.
+    /// @param stream the clip
+    /// @param clipName name of the clip in the results
+    /// @returns the results, one per format, empty if no picture could be decoded
+    std::vector<BenchmarkResult> runColourConvert(const H264ElementaryStream &stream, const std::string &clipName)
+    {
+        DecoderOptions decoderOptions;
+        decoderOptions.threadCount = 1;
+        H264Decoder decoder(decoderOptions);
+        decoder.setH264Params(stream.getSps().data(), static_cast<uint32_t>(stream.getSps().size()),
+                              stream.getPps().data(), static_cast<uint32_t>(stream.getPps().size()));
+        bool decoded = false;
+        const auto &units = stream.getAccessUnits();
+        for (size_t i = stream.getFirstIFrame(); i < units.size() && !decoded; i++) {
+            decoder.sendPacket(stream.getData() + units[i].offset, units[i].size, units[i].isIFrame,
+                               static_cast<int64_t>(i));
+            decoded = decoder.receiveFrame() != nullptr;
+        }
+        if (!decoded) {
+            decoder.flush();
+            decoded = decoder.receiveFrame() != nullptr;
+        }
+
+        std::vector<BenchmarkResult> results;
+        if (!decoded) { return results; }
+        const unsigned width  = decoder.getWidth();
+        const unsigned height = decoder.getHeight();
+        static const std::pair<PixelFormat, const char *> FORMATS[] = {
+            { PixelFormat::RGB24, "rgb24" }, { PixelFormat::BGR24, "bgr24" }, { PixelFormat::RGBA, "rgba" },
+            { PixelFormat::NV12, "nv12" }, { PixelFormat::YUV420P, "yuv420p" }, { PixelFormat::GRAY8, "gray8" },
+        };
+        for (const auto &format : FORMATS) {
+            const size_t bytes = getPlaneLayout(format.first, width, height).totalBytes;
+            std::vector<uint8_t> dst(bytes + SWSCALE_DST_PADDING);
+            auto op = [&]() -> uint64_t {
+                decoder.convertTo(format.first, dst.data(), width, height);
+                return bytes;
+            };
+            BenchmarkResult result = m_time("convert", m_clipParameters(clipName, width, height) +
+                                            ",format=" + format.second, op);
+            results.push_back(m_add(std::move(result)));
+        }
+        return results;
+    }
+
+    /// Time the SIMD YUV420P kernels against swscale, which H264Decoder::convertTo() uses when
+    /// DecoderOptions::simdConversion is off, for each packed RGB format at 1/1, 1/2 and 1/4 scale of a
+    /// synthetic Bebop 2 sized picture, 856x480
+    /// @returns the results, a swscale and a SIMD result per format and scale. Each SIMD result has a
+    /// speedup counter, the swscale mean time divided by the SIMD mean time. No SIMD results are
+    /// produced on a CPU without the kernels.
+    std::vector<BenchmarkResult> runConvertSimdVersusSwscale()
+    {
+        const unsigned width  = BEBOP2_STREAM_WIDTH;
+        const unsigned height = BEBOP2_STREAM_HEIGHT;
+        const PlaneLayout source = getPlaneLayout(PixelFormat::YUV420P, width, height);
+        std::vector<uint8_t> picture(source.totalBytes);
+        for (size_t i = 0; i < picture.size(); i++) {
+            picture[i] = static_cast<uint8_t>((i * 7) ^ (i >> 9)); // detail in every plane, nothing constant
+        }
+        const uint8_t *planes[3]  = { picture.data() + source.offset[0], picture.data() + source.offset[1],
+                                      picture.data() + source.offset[2] };
+        const int      strides[3] = { source.stride[0], source.stride[1], source.stride[2] };
+
+        static const std::pair<PixelFormat, const char *> FORMATS[] = {
+            { PixelFormat::RGB24, "rgb24" }, { PixelFormat::BGR24, "bgr24" }, { PixelFormat::RGBA, "rgba" },
+        };
+        static const unsigned SCALES[] = { 1, 2, 4 };
+
+        std::vector<BenchmarkResult> results;
+        SwsContext *swsCtx = nullptr;
+        for (const auto &format : FORMATS) {
+            for (unsigned scale : SCALES) {
+                const unsigned dstWidth  = width / scale;
+                const unsigned dstHeight = height / scale;
+                const PlaneLayout layout = getPlaneLayout(format.first, dstWidth, dstHeight);
+                // swscale's x86 fast path stores whole 16 pixel blocks, so it writes past the last row of
+                // a destination whose width is not a multiple of 16, e.g. 856
+                std::vector<uint8_t> dst(layout.totalBytes + SWSCALE_DST_PADDING);
+                const std::string parameters = "width=" + std::to_string(width) + ",height=" + std::to_string(height) +
+                                               ",format=" + format.second + ",scale=" + std::to_string(scale);
+
+                // the same context and flags as H264Decoder::convert()
+                swsCtx = sws_getCachedContext(swsCtx, static_cast<int>(width), static_cast<int>(height), AV_PIX_FMT_YUV420P,
+                                              static_cast<int>(dstWidth), static_cast<int>(dstHeight),
+                                              toAVPixelFormat(format.first), SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+                if (!swsCtx) { continue; }
+                uint8_t *dstPlanes[4]  = { dst.data(), nullptr, nullptr, nullptr };
+                int      dstStrides[4] = { layout.stride[0], 0, 0, 0 };
+                auto swscaleOp = [&]() -> uint64_t {
+                    sws_scale(swsCtx, planes, strides, 0, static_cast<int>(height), dstPlanes, dstStrides);
+                    return layout.totalBytes;
+                };
+                results.push_back(m_add(m_time("convert.swscale", parameters, swscaleOp)));
+                const double swscaleMean = results.back().latency.meanMicroseconds();
+
+                if (!convertYUV420P(planes, strides, width, height, format.first, dst.data(), layout.stride[0], scale)) {
+                    continue;
+                }
+                auto simdOp = [&]() -> uint64_t {
+                    convertYUV420P(planes, strides, width, height, format.first, dst.data(), layout.stride[0], scale);
+                    return layout.totalBytes;
+                };
+                BenchmarkResult result = m_time("convert.simd", parameters, simdOp);
+                const double simdMean = result.latency.meanMicroseconds();
+                result.counters.emplace_back("speedup", simdMean > 0.0 ? swscaleMean / simdMean : 0.0);
+                results.push_back(m_add(std::move(result)));
+            }
+        }
+        if (swsCtx) { sws_freeContext(swsCtx); }
+        return results;
+    }
+
+    /// Time publishing RGB frames into a VideoFrame-sized buffer under the buffer mutex, the way the
+    /// VideoDriver does, while reader threads copy the frame out under the same mutex
+    /// @param readers number of reader threads contending for the mutex
+    /// @returns the result. The latency is the writer's lock and copy time per frame. The counters
+    /// hold the total reader copies per second.
+    BenchmarkResult runMutexHandoff(unsigned readers)
+    {
+        const size_t bytes = getPlaneLayout(PixelFormat::RGB24, m_options.handoffWidth, m_options.handoffHeight).totalBytes;
+        std::vector<uint8_t> source(bytes, 0x5a);
+        std::vector<uint8_t> frame(bytes);
+        std::shared_ptr<std::mutex> bufferMutex = std::make_shared<std::mutex>();
+
+        std::atomic<bool>     running{true};
+        std::atomic<uint64_t> reads{0};
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < readers; i++) {
+            threads.emplace_back([&]() {
+                std::vector<uint8_t> copy(bytes);
+                uint64_t n = 0;
+                while (running.load(std::memory_order_relaxed)) {
+                    std::lock_guard<std::mutex> lck(*bufferMutex);
+                    std::memcpy(copy.data(), frame.data(), bytes);
+                    n++;
+                }
+                reads.fetch_add(n);
+            });
+        }
+
+        auto op = [&]() -> uint64_t {
+            std::lock_guard<std::mutex> lck(*bufferMutex);
+            std::memcpy(frame.data(), source.data(), bytes);
+            return bytes;
+        };
+        const uint64_t startNs = monotonicNanoseconds();
+        BenchmarkResult result = m_time("handoff.mutex", m_sizeParameters() + ",readers=" + std::to_string(readers), op);
+        running = false;
+        for (auto &thread : threads) { thread.join(); }
+        const double elapsed = (monotonicNanoseconds() - startNs) / 1e9;
+        result.counters.emplace_back("readsPerSecond", elapsed > 0.0 ? reads.load() / elapsed : 0.0);
+        return m_add(std::move(result));
+    }
+
+    /// Time publishing RGB frames through a TripleBufferFrame while one reader acquires them
+    /// @returns the result. The latency is the writer's copy and publish time per frame. The counters
+    /// hold the new frames the reader copied out per second.
+    BenchmarkResult runTripleBufferHandoff()
+    {
+        TripleBufferFrame frame(m_options.handoffHeight, m_options.handoffWidth, PixelFormat::RGB24);
+        const size_t bytes = frame.getFrameSizeBytes();
+        std::vector<uint8_t> source(bytes, 0x5a);
+
+        std::atomic<bool>     running{true};
+        std::atomic<uint64_t> reads{0};
+        std::thread reader([&]() {
+            std::vector<uint8_t> copy(bytes);
+            uint64_t n = 0;
+            uint64_t lastSequence = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                FrameView view = frame.acquireLatest();
+                if (!view.valid() || view.sequence == lastSequence) { continue; }
+                std::memcpy(copy.data(), view.data, bytes);
+                lastSequence = view.sequence;
+                n++;
+            }
+            reads.fetch_add(n);
+        });
+
+        uint64_t sequence = 0;
+        auto op = [&]() -> uint64_t {
+            std::memcpy(frame.getWriteBuffer(), source.data(), bytes);
+            frame.publish(++sequence, 0);
+            return bytes;
+        };
+        const uint64_t startNs = monotonicNanoseconds();
+        BenchmarkResult result = m_time("handoff.triplebuffer", m_sizeParameters() + ",readers=1", op);
+        running = false;
+        reader.join();
+        const double elapsed = (monotonicNanoseconds() - startNs) / 1e9;
+        result.counters.emplace_back("readsPerSecond", elapsed > 0.0 ? reads.load() / elapsed : 0.0);
+        return m_add(std::move(result));
+    }
+
+    /// Time how long a thread blocked in wait() takes to run after another thread calls notify()
+    /// @tparam SemaphoreType Semaphore or FutexSemaphore
+    /// @param name benchmark name in the results
+    /// @returns the result. The latency is notify() to the waiter running, measured by ping-pong.
+    template <typename SemaphoreType>
+    BenchmarkResult runSemaphoreWake(const char *name)
+    {
+        SemaphoreType ping;
+        SemaphoreType pong;
+        std::atomic<bool>     running{true};
+        std::atomic<uint64_t> notifiedNs{0};
+        LatencyHistogram      wake;
+        std::atomic<bool>     recording{false};
+
+        std::thread waiter([&]() {
+            while (true) {
+                ping.wait();
+                const uint64_t now = monotonicNanoseconds();
+                if (!running.load()) { break; }
+                if (recording.load(std::memory_order_relaxed)) {
+                    wake.record(now - notifiedNs.load(std::memory_order_relaxed));
+                }
+                pong.notify();
+            }
+        });
+
+        auto op = [&]() -> uint64_t {
+            // let the waiter block before notifying, so the wake path is measured rather than a spin
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            notifiedNs.store(monotonicNanoseconds(), std::memory_order_relaxed);
+            ping.notify();
+            pong.wait();
+            return 0;
+        };
+        BenchmarkResult result = m_time(name, "", op, &recording);
+        running = false;
+        ping.notify();
+        waiter.join();
+        result.latency = wake.snapshot();
+        return m_add(std::move(result));
+    }
+
+    /// Time passing telemetry commands to the command callbacks of a transport with a TelemetryCache
+    /// and a MoveSequencer attached, as the ARSDK command thread does for every state update
+    /// @returns the result. The latency is one command dispatched to every callback.
+    BenchmarkResult runCommandDispatch()
+    {
+        auto transport = std::make_shared<DispatchTransport>();
+        TelemetryCache telemetry;
+        telemetry.attach(std::static_pointer_cast<DroneTransport>(transport));
+        MoveSequencer sequencer(std::static_pointer_cast<DroneTransport>(transport));
+
+        CommandDictionary commands[NUM_TELEMETRY_COMMANDS];
+        m_fillTelemetryCommands(commands);
+
+        unsigned next = 0;
+        auto op = [&]() -> uint64_t {
+            const unsigned index = next++ % NUM_TELEMETRY_COMMANDS;
+            transport->dispatch(m_telemetryKey(index), commands[index]);
+            return 0;
+        };
+        return m_add(m_time("command.dispatch", "callbacks=2", op));
+    }
+
+    /// Time passing the same telemetry commands to a CommandDispatcher with two subscribers per command,
+    /// which decodes each command once from the compile time command table
+    /// @returns the result. The latency is one command decoded and dispatched to both subscribers.
+    BenchmarkResult runCommandTableDispatch()
+    {
+        auto transport = std::make_shared<DispatchTransport>();
+        CommandDispatcher dispatcher;
+        dispatcher.attach(std::static_pointer_cast<DroneTransport>(transport));
+        uint64_t received = 0;
+        const DecodedCommandCallback count = [](const DecodedCommand &, void *customData) {
+            ++*static_cast<uint64_t *>(customData);
+        };
+        for (CommandType type : { CommandType::ATTITUDE, CommandType::POSITION, CommandType::SPEED, CommandType::BATTERY }) {
+            dispatcher.subscribe(type, count, &received);
+            dispatcher.subscribe(type, count, &received);
+        }
+
+        CommandDictionary commands[NUM_TELEMETRY_COMMANDS];
+        m_fillTelemetryCommands(commands);
+
+        unsigned next = 0;
+        auto op = [&]() -> uint64_t {
+            const unsigned index = next++ % NUM_TELEMETRY_COMMANDS;
+            transport->dispatch(m_telemetryKey(index), commands[index]);
+            return 0;
+        };
+        return m_add(m_time("command.dispatch_table", "subscribers=2", op));
+    }
+
+    /// Get the results so far
+    /// @returns the results in the order they were run
+    const std::vector<BenchmarkResult> &getResults() const { return m_results; }
+
+    /// Format the results as JSON
+    /// @returns a JSON object with the label and an array of results
+    std::string toJson() const
+    {
+        std::string out = "{\n  \"label\": \"" + m_escapeJson(m_options.label) + "\",\n  \"results\": [";
+        for (size_t i = 0; i < m_results.size(); i++) {
+            const BenchmarkResult &r = m_results[i];
+            out += i ? ",\n    {" : "\n    {";
+            out += "\"name\": \"" + m_escapeJson(r.name) + "\", ";
+            out += "\"parameters\": \"" + m_escapeJson(r.parameters) + "\", ";
+            out += "\"iterations\": " + std::to_string(r.iterations) + ", ";
+            out += "\"seconds\": " + m_number(r.seconds) + ", ";
+            out += "\"opsPerSecond\": " + m_number(r.opsPerSecond()) + ", ";
+            out += "\"megabytesPerSecond\": " + m_number(r.megabytesPerSecond()) + ", ";
+            out += "\"meanNs\": " + m_number(r.latency.meanMicroseconds() * 1000.0) + ", ";
+            out += "\"p50Ns\": " + std::to_string(r.latency.percentileNs(50.0)) + ", ";
+            out += "\"p90Ns\": " + std::to_string(r.latency.percentileNs(90.0)) + ", ";
+            out += "\"p99Ns\": " + std::to_string(r.latency.percentileNs(99.0)) + ", ";
+            out += "\"maxNs\": " + std::to_string(r.latency.maxNs) + ", ";
+            out += "\"counters\": {";
+            for (size_t c = 0; c < r.counters.size(); c++) {
+                out += (c ? ", \"" : "\"") + m_escapeJson(r.counters[c].first) + "\": " + m_number(r.counters[c].second);
+            }
+            out += "}}";
+        }
+        out += "\n  ]\n}\n";
+        return out;
+    }
+
+    /// Format the results as CSV with a header line. Counters are omitted.
+    /// @returns the CSV text
+    std::string toCsv() const
+    {
+        std::string out = "label,name,parameters,iterations,seconds,ops_per_second,megabytes_per_second,"
+                          "mean_ns,p50_ns,p90_ns,p99_ns,max_ns\n";
+        for (const BenchmarkResult &r : m_results) {
+            out += m_quoteCsv(m_options.label) + "," + m_quoteCsv(r.name) + "," + m_quoteCsv(r.parameters) + "," +
+                   std::to_string(r.iterations) + "," + m_number(r.seconds) + "," + m_number(r.opsPerSecond()) + "," +
+                   m_number(r.megabytesPerSecond()) + "," + m_number(r.latency.meanMicroseconds() * 1000.0) + "," +
+                   std::to_string(r.latency.percentileNs(50.0)) + "," + std::to_string(r.latency.percentileNs(90.0)) + "," +
+                   std::to_string(r.latency.percentileNs(99.0)) + "," + std::to_string(r.latency.maxNs) + "\n";
+        }
+        return out;
+    }
+
+private:
+    /// A transport with no drone behind it, so commands can be dispatched directly
+    class DispatchTransport : public LocalTransport {
+    public:
+        void start() override {}
+        void stop() override {}
+        void startVideo() override {}
+        void stopVideo() override {}
+        std::shared_ptr<VideoFrame> getFrame() override { return nullptr; }
+        void moveRelativeMetres(float, float, float, float) override {}
+        unsigned getBatteryLevel() override { return 0; }
+
+        void dispatch(eARCONTROLLER_DICTIONARY_KEY key, CommandDictionary &dictionary) { m_dispatchCommand(key, dictionary); }
+    };
+
+    static constexpr unsigned NUM_TELEMETRY_COMMANDS = 4; ///< commands passed by the command benchmarks
+    static constexpr size_t   SWSCALE_DST_PADDING    = 64; ///< bytes after a swscale destination it may write
+
+    BenchmarkOptions m_options;             ///< configuration
+    std::vector<BenchmarkResult> m_results; ///< results in run order
+
+    /// Run an operation repeatedly after a warm up, recording the time of each
+    /// @param name benchmark name
+    /// @param parameters benchmark inputs
+    /// @param op the operation, returning the bytes it processed
+    /// @param recording when given, set while timed operations run
+    /// @returns the result
+    template <typename Operation>
+    BenchmarkResult m_time(const std::string &name, const std::string &parameters, Operation &op,
+                           std::atomic<bool> *recording = nullptr)
+    {
+        for (unsigned i = 0; i < m_options.warmupIterations; i++) { op(); }
+        if (recording) { recording->store(true); }
+
+        LatencyHistogram histogram;
+        BenchmarkResult result;
+        result.name       = name;
+        result.parameters = parameters;
+        const uint64_t durationNs = uint64_t(m_options.durationMilliseconds) * 1000000;
+        const uint64_t startNs = monotonicNanoseconds();
+        uint64_t nowNs = startNs;
+        while (result.iterations < m_options.minIterations || nowNs - startNs < durationNs) {
+            const uint64_t beforeNs = nowNs;
+            result.bytes += op();
+            nowNs = monotonicNanoseconds();
+            histogram.record(nowNs - beforeNs);
+            result.iterations++;
+        }
+        if (recording) { recording->store(false); }
+        result.seconds = (nowNs - startNs) / 1e9;
+        result.latency = histogram.snapshot();
+        return result;
+    }
+
+    /// Get the next access unit of a clip, looping back to its first I-frame at the end
+    /// @param stream the clip
+    /// @param next index of the access unit to return, advanced past it
+    /// @returns the access unit
+    static const H264ElementaryStream::AccessUnit &m_nextUnit(const H264ElementaryStream &stream, size_t &next)
+    {
+        if (next >= stream.getAccessUnits().size()) { next = stream.getFirstIFrame(); }
+        return stream.getAccessUnits()[next++];
+    }
+
+    /// Fill the arguments of the telemetry commands passed by the command benchmarks
+    /// @param commands receives the attitude, position, speed and battery commands
+    static void m_fillTelemetryCommands(CommandDictionary (&commands)[NUM_TELEMETRY_COMMANDS])
+    {
+        commands[0].addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED_ROLL, 0.1f)
+                   .addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED_PITCH, 0.2f)
+                   .addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED_YAW, 0.3f);
+        commands[1].addDouble(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED_LATITUDE, 45.0)
+                   .addDouble(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED_LONGITUDE, -75.0)
+                   .addDouble(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED_ALTITUDE, 10.0);
+        commands[2].addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED_SPEEDX, 1.0f)
+                   .addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED_SPEEDY, 0.0f)
+                   .addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED_SPEEDZ, 0.0f);
+        commands[3].addU8(ARCONTROLLER_DICTIONARY_KEY_COMMON_COMMONSTATE_BATTERYSTATECHANGED_PERCENT, 80);
+    }
+
+    /// Get the key of a telemetry command filled by m_fillTelemetryCommands()
+    static eARCONTROLLER_DICTIONARY_KEY m_telemetryKey(unsigned index)
+    {
+        static const eARCONTROLLER_DICTIONARY_KEY KEYS[NUM_TELEMETRY_COMMANDS] = {
+            ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED,
+            ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED,
+            ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED,
+            ARCONTROLLER_DICTIONARY_KEY_COMMON_COMMONSTATE_BATTERYSTATECHANGED,
+        };
+        return KEYS[index];
+    }
+
+    /// Append a result
+    /// @returns a copy of the result, as a later append may move the stored one
+    BenchmarkResult m_add(BenchmarkResult result)
+    {
+        m_results.push_back(std::move(result));
+        return m_results.back();
+    }
+
+    static std::string m_clipParameters(const std::string &clip, unsigned width, unsigned height)
+    {
+        return "clip=" + clip + ",width=" + std::to_string(width) + ",height=" + std::to_string(height);
+    }
+
+    std::string m_sizeParameters() const
+    {
+        return "width=" + std::to_string(m_options.handoffWidth) + ",height=" + std::to_string(m_options.handoffHeight);
+    }
+
+    static std::string m_number(double value)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.6g", value);
+        return text;
+    }
+
+    static std::string m_escapeJson(const std::string &value)
+    {
+        std::string escaped;
+        for (char c : value) {
+            if (c == '"' || c == '\\') { escaped += '\\'; escaped += c; continue; }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char code[8];
+                std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+                escaped += code;
+                continue;
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    static std::string m_quoteCsv(const std::string &value)
+    {
+        if (value.find_first_of(",\"\n") == std::string::npos) { return value; }
+        std::string quoted = "\"";
+        for (char c : value) {
+            if (c == '"') { quoted += '"'; }
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+};
+
+} // wscDrone
+
+#endif /* BENCHMARK_H_ */
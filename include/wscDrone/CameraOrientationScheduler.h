@@ -0,0 +1,334 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the CameraOrientationScheduler, which coalesces
+ * and rate limits camera orientation commands.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef CAMERAORIENTATIONSCHEDULER_H_
+#define CAMERAORIENTATIONSCHEDULER_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "CommandDispatcher.h"
+#include "DroneTransport.h"
+#include "LatencyHistogram.h"
+#include "Telemetry.h"
+#include "Utils.h"
+
+namespace wscDrone {
+
+/// CameraOrientationScheduler configuration
+struct CameraOrientationOptions {
+    unsigned rateHz        = 10;    ///< most orientation commands sent per second
+    float    deadbandDeg   = 0.1f;  ///< a target within this of the last one sent on both axes is not sent
+    float    toleranceDeg  = 0.5f;  ///< a reported orientation within this of a command sent confirms it
+    size_t   maxInFlight   = 16;    ///< commands remembered while waiting for their orientation report
+};
+
+/// Counters and latencies of a CameraOrientationScheduler
+struct CameraOrientationStats {
+    uint64_t requests    = 0; ///< calls to setTiltPan()
+    uint64_t coalesced   = 0; ///< requests replaced by a later one before they were sent
+    uint64_t sent        = 0; ///< commands the transport accepted
+    uint64_t sendErrors  = 0; ///< commands the transport rejected, which are not retried
+    uint64_t skipped     = 0; ///< targets within the deadband of the last command sent
+    uint64_t clamped     = 0; ///< targets clamped to the reported camera limits
+    uint64_t confirmed   = 0; ///< commands matched by an orientation report
+    uint64_t superseded  = 0; ///< commands never reported because a later one was applied first
+    bool     limitsKnown = false;              ///< the drone has reported its camera limits
+    CameraSettingsTelemetry    limits;         ///< the limits last reported
+    CameraOrientationTelemetry reported;       ///< the orientation last reported
+    LatencyHistogramSnapshot commandToApplied; ///< setTiltPan() of the value sent until its orientation report
+    LatencyHistogramSnapshot sendToApplied;    ///< command sent until its orientation report
+    LatencyHistogramSnapshot queueDelay;       ///< setTiltPan() of the value sent until it was sent
+};
+
+/// Sends camera orientation commands at a bounded rate, always with the newest target.
+/// @details A tracker that calls CameraControl::setTiltPan() every frame puts every call into the ARSDK
+/// command queue, which saturates and leaves the camera applying stale targets. setTiltPan() here only
+/// replaces the pending target, so any number of calls between two sends cost one command. A sender
+/// thread sends the pending target through DroneTransport::sendCameraOrientation() no more than
+/// CameraOrientationOptions::rateHz times a second, after clamping it to the limits the drone reports
+/// with its camera settings command and dropping it if it is within the deadband of the last target
+/// sent. attach() subscribes to the camera settings and orientation commands: each orientation report
+/// is matched to the command it confirms, which gives the command-to-applied latency, and commands it
+/// overtook are counted as superseded.
+class CameraOrientationScheduler {
+public:
+    CameraOrientationScheduler() = delete;
+
+    /// Construct a scheduler. The sender thread is started by start().
+    /// @param transport the drone whose camera is moved
+    /// @param options rate, deadband and matching configuration
+    explicit CameraOrientationScheduler(std::shared_ptr<DroneTransport> transport,
+                                        const CameraOrientationOptions &options = CameraOrientationOptions())
+        : m_transport(transport), m_options(options)
+    {
+        if (!m_transport) { throw std::invalid_argument("CameraOrientationScheduler: null transport"); }
+        if (m_options.rateHz == 0 || m_options.rateHz > 1000) {
+            throw std::invalid_argument("CameraOrientationScheduler: rate must be 1 to 1000 Hz");
+        }
+        if (m_options.maxInFlight == 0) { m_options.maxInFlight = 1; }
+    }
+
+    /// Stops the sender thread and detaches from the dispatcher
+    ~CameraOrientationScheduler()
+    {
+        stop();
+        detach();
+    }
+
+    CameraOrientationScheduler(const CameraOrientationScheduler &) = delete;
+    CameraOrientationScheduler &operator=(const CameraOrientationScheduler &) = delete;
+
+    /// Receive the camera settings and orientation reports of the drone
+    /// @param dispatcher dispatcher attached to the same drone, it must outlive the subscription
+    void attach(CommandDispatcher &dispatcher)
+    {
+        detach();
+        dispatcher.subscribe(CommandType::CAMERA_SETTINGS, m_onCommandDefault, this);
+        dispatcher.subscribe(CommandType::CAMERA_ORIENTATION, m_onCommandDefault, this);
+        m_dispatcher = &dispatcher;
+    }
+
+    /// Stop receiving reports
+    void detach()
+    {
+        if (!m_dispatcher) { return; }
+        m_dispatcher->unsubscribe(CommandType::CAMERA_SETTINGS, m_onCommandDefault, this);
+        m_dispatcher->unsubscribe(CommandType::CAMERA_ORIENTATION, m_onCommandDefault, this);
+        m_dispatcher = nullptr;
+    }
+
+    /// Start the sender thread. A target set earlier is sent now.
+    void start()
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        if (m_running) { return; }
+        m_running = true;
+        m_thread = std::thread(&CameraOrientationScheduler::m_sendLoop, this);
+    }
+
+    /// Stop the sender thread. A pending target is not sent.
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            if (!m_running) { return; }
+            m_running = false;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    /// Set the camera orientation to send next, replacing any target not yet sent. Safe to call from any
+    /// thread; it never waits for the drone.
+    /// @param tilt angle in degrees, positive (negative) tilts up (down)
+    /// @param pan angle in degrees, positive (negative) pans right (left)
+    void setTiltPan(float tilt, float pan)
+    {
+        if (std::isnan(tilt) || std::isnan(pan)) { return; }
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_requests++;
+            if (m_targetPending) { m_coalesced++; }
+            m_targetPending = true;
+            m_target.tilt   = tilt;
+            m_target.pan    = pan;
+            m_target.requestNs = monotonicNanoseconds();
+        }
+        m_cv.notify_one();
+    }
+
+    /// Look straight ahead, equivalent to setTiltPan(0, 0)
+    void setForward() { setTiltPan(0.0f, 0.0f); }
+
+    /// Handle a decoded camera command. Called on the ARSDK command thread by the subscriptions of
+    /// attach(), or by an application that dispatches commands itself.
+    /// @param command a CAMERA_SETTINGS or CAMERA_ORIENTATION command, others are ignored
+    void onCommand(const DecodedCommand &command)
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        if (command.type == CommandType::CAMERA_SETTINGS) {
+            m_limits = command.cameraSettings;
+            m_limitsKnown = true;
+        } else if (command.type == CommandType::CAMERA_ORIENTATION) {
+            m_reported = command.cameraOrientation;
+            m_confirm(command.cameraOrientation);
+        }
+    }
+
+    /// Get the counters, latencies and the camera state last reported. Safe to call from any thread.
+    /// @returns the statistics
+    CameraOrientationStats getStats() const
+    {
+        CameraOrientationStats stats;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            stats.requests    = m_requests;
+            stats.coalesced   = m_coalesced;
+            stats.sent        = m_sent;
+            stats.sendErrors  = m_sendErrors;
+            stats.skipped     = m_skipped;
+            stats.clamped     = m_clamped;
+            stats.confirmed   = m_confirmed;
+            stats.superseded  = m_superseded;
+            stats.limitsKnown = m_limitsKnown;
+            stats.limits      = m_limits;
+            stats.reported    = m_reported;
+        }
+        stats.commandToApplied = m_commandToApplied.snapshot();
+        stats.sendToApplied    = m_sendToApplied.snapshot();
+        stats.queueDelay       = m_queueDelay.snapshot();
+        return stats;
+    }
+
+    /// Get the configuration
+    /// @returns the options given at construction
+    const CameraOrientationOptions &getOptions() const { return m_options; }
+
+private:
+    /// A target, or a command waiting for its orientation report
+    struct Orientation {
+        float    tilt = 0.0f;
+        float    pan  = 0.0f;
+        uint64_t requestNs = 0; ///< time of the setTiltPan() call
+        uint64_t sentNs    = 0; ///< time the command was sent
+    };
+
+    std::shared_ptr<DroneTransport> m_transport;      ///< the drone
+    CameraOrientationOptions        m_options;        ///< configuration
+    CommandDispatcher              *m_dispatcher = nullptr; ///< dispatcher of the report subscriptions
+
+    mutable std::mutex      m_mutex;                  ///< protects every member below
+    std::condition_variable m_cv;                     ///< signals a new target or stop()
+    std::thread             m_thread;                 ///< the sender thread
+    bool                    m_running = false;        ///< true while the sender thread should run
+    bool                    m_targetPending = false;  ///< m_target has not been sent
+    Orientation             m_target;                 ///< the newest target
+    bool                    m_haveSent = false;       ///< m_lastSent is valid
+    Orientation             m_lastSent;               ///< the last command sent
+    uint64_t                m_nextSendNs = 0;         ///< earliest time of the next command
+    std::deque<Orientation> m_inFlight;               ///< commands sent and not yet reported, oldest first
+    bool                    m_limitsKnown = false;
+    CameraSettingsTelemetry    m_limits;
+    CameraOrientationTelemetry m_reported;
+
+    uint64_t m_requests   = 0;
+    uint64_t m_coalesced  = 0;
+    uint64_t m_sent       = 0;
+    uint64_t m_sendErrors = 0;
+    uint64_t m_skipped    = 0;
+    uint64_t m_clamped    = 0;
+    uint64_t m_confirmed  = 0;
+    uint64_t m_superseded = 0;
+    LatencyHistogram m_commandToApplied;
+    LatencyHistogram m_sendToApplied;
+    LatencyHistogram m_queueDelay;
+
+    /// Clamp a target to the reported limits. Called with m_mutex held.
+    /// @returns true if the target changed
+    bool m_clamp(Orientation &target) const
+    {
+        if (!m_limitsKnown || m_limits.tiltMin > m_limits.tiltMax || m_limits.panMin > m_limits.panMax) { return false; }
+        const float tilt = std::max(m_limits.tiltMin, std::min(m_limits.tiltMax, target.tilt));
+        const float pan  = std::max(m_limits.panMin, std::min(m_limits.panMax, target.pan));
+        const bool changed = tilt != target.tilt || pan != target.pan;
+        target.tilt = tilt;
+        target.pan  = pan;
+        return changed;
+    }
+
+    /// Match an orientation report to the newest command it confirms. Called with m_mutex held.
+    void m_confirm(const CameraOrientationTelemetry &report)
+    {
+        const uint64_t reportNs = report.timestampNs ? report.timestampNs : monotonicNanoseconds();
+        for (size_t i = m_inFlight.size(); i > 0; i--) {
+            const Orientation &command = m_inFlight[i - 1];
+            if (std::fabs(command.tilt - report.tilt) > m_options.toleranceDeg ||
+                std::fabs(command.pan - report.pan) > m_options.toleranceDeg) {
+                continue;
+            }
+            m_commandToApplied.record(reportNs > command.requestNs ? reportNs - command.requestNs : 0);
+            m_sendToApplied.record(reportNs > command.sentNs ? reportNs - command.sentNs : 0);
+            m_confirmed++;
+            // the commands before it were overtaken, the camera is past them
+            m_superseded += i - 1;
+            m_inFlight.erase(m_inFlight.begin(), m_inFlight.begin() + static_cast<std::ptrdiff_t>(i));
+            return;
+        }
+    }
+
+    /// Body of the sender thread
+    void m_sendLoop()
+    {
+        const uint64_t periodNs = 1000000000ULL / m_options.rateHz;
+        std::unique_lock<std::mutex> lck(m_mutex);
+        while (true) {
+            m_cv.wait(lck, [this]() { return !m_running || m_targetPending; });
+            if (!m_running) { return; }
+            const uint64_t nowNs = monotonicNanoseconds();
+            if (nowNs < m_nextSendNs) {
+                // later calls keep replacing the target while the rate limit holds it back
+                m_cv.wait_for(lck, std::chrono::nanoseconds(m_nextSendNs - nowNs), [this]() { return !m_running; });
+                continue;
+            }
+
+            Orientation command = m_target;
+            m_targetPending = false;
+            if (m_clamp(command)) { m_clamped++; }
+            if (m_haveSent && std::fabs(command.tilt - m_lastSent.tilt) <= m_options.deadbandDeg &&
+                std::fabs(command.pan - m_lastSent.pan) <= m_options.deadbandDeg) {
+                m_skipped++;
+                continue;
+            }
+
+            lck.unlock();
+            command.sentNs = monotonicNanoseconds();
+            const bool sent = m_transport->sendCameraOrientation(command.tilt, command.pan);
+            lck.lock();
+
+            m_nextSendNs = command.sentNs + periodNs;
+            if (!sent) {
+                m_sendErrors++;
+                continue;
+            }
+            m_sent++;
+            m_queueDelay.record(command.sentNs - command.requestNs);
+            m_haveSent = true;
+            m_lastSent = command;
+            m_inFlight.push_back(command);
+            if (m_inFlight.size() > m_options.maxInFlight) {
+                m_inFlight.pop_front();
+                m_superseded++;
+            }
+        }
+    }
+
+    static void m_onCommandDefault(const DecodedCommand &command, void *customData)
+    {
+        static_cast<CameraOrientationScheduler *>(customData)->onCommand(command);
+    }
+};
+
+} // wscDrone
+
+#endif /* CAMERAORIENTATIONSCHEDULER_H_ */
@@ -0,0 +1,222 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the CodecParameterCache, which remembers the H.264
+ * decoder configuration of each drone between connections.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef CODECCACHE_H_
+#define CODECCACHE_H_
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace wscDrone {
+
+/// The H.264 decoder configuration of one drone
+struct H264CodecParameters {
+    std::vector<uint8_t> sps; ///< SPS NAL unit including its start code
+    std::vector<uint8_t> pps; ///< PPS NAL unit including its start code
+};
+
+/// Magic number at the start of a codec cache file
+constexpr char CODEC_CACHE_MAGIC[4] = { 'W', 'S', 'C', 'C' };
+/// Version of the codec cache file format
+constexpr uint32_t CODEC_CACHE_VERSION = 1;
+
+/// Remembers the last SPS/PPS received from each drone, by name, so a DecodePipeline can be primed with
+/// them and open its decoder while the drone is still connecting.
+/// @details With a file path, the cache is loaded on construction and rewritten whenever an entry
+/// changes, so the parameters survive restarts of the application. A Bebop 2 sends the same parameters
+/// for as long as its video settings are unchanged; stale ones cost nothing, as the parameters the
+/// drone sends replace them before the first I-frame. The file is written to a temporary name, synced
+/// and renamed, so neither a crash nor a power loss leaves a partial file, and an unreadable file is
+/// treated as empty.
+/// All methods are thread safe.
+class CodecParameterCache {
+public:
+    /// Construct a cache
+    /// @param path file the cache is loaded from and saved to, empty to keep it in memory only
+    explicit CodecParameterCache(const std::string &path = "") : m_path(path)
+    {
+        if (!m_path.empty()) { m_load(); }
+    }
+
+    CodecParameterCache(const CodecParameterCache &) = delete;
+    CodecParameterCache &operator=(const CodecParameterCache &) = delete;
+
+    /// Get the parameters of a drone
+    /// @param name the drone, normally its IP address
+    /// @param parameters receives the parameters
+    /// @returns false if the drone is not in the cache
+    bool get(const std::string &name, H264CodecParameters &parameters) const
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        auto it = m_entries.find(name);
+        if (it == m_entries.end()) { return false; }
+        parameters = it->second;
+        return true;
+    }
+
+    /// Store the parameters of a drone, saving the file if they changed
+    /// @param name the drone, normally its IP address
+    /// @param parameters the parameters last received from the drone
+    /// @returns false if the file could not be written
+    bool set(const std::string &name, const H264CodecParameters &parameters)
+    {
+        if (parameters.sps.empty() || parameters.pps.empty()) { return true; }
+        std::lock_guard<std::mutex> lck(m_mutex);
+        H264CodecParameters &entry = m_entries[name];
+        if (entry.sps == parameters.sps && entry.pps == parameters.pps) { return true; }
+        entry = parameters;
+        return m_path.empty() || m_save();
+    }
+
+    /// Forget the parameters of a drone
+    /// @param name the drone
+    void erase(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        if (m_entries.erase(name) > 0 && !m_path.empty()) { m_save(); }
+    }
+
+    /// Get the number of drones in the cache
+    /// @returns the entry count
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        return m_entries.size();
+    }
+
+    /// Get the file the cache is saved to
+    /// @returns the path, empty when the cache is in memory only
+    const std::string &getPath() const { return m_path; }
+
+private:
+    const std::string m_path;                              ///< cache file, empty for none
+    mutable std::mutex m_mutex;                            ///< protects m_entries
+    std::map<std::string, H264CodecParameters> m_entries;  ///< parameters by drone name
+
+    /// Load the file, leaving the cache empty if it is missing or unreadable
+    void m_load()
+    {
+        std::ifstream file(m_path, std::ios::binary);
+        if (!file) { return; }
+        std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t offset = 0;
+        char magic[sizeof(CODEC_CACHE_MAGIC)];
+        uint32_t version = 0;
+        uint32_t count   = 0;
+        if (!m_read(bytes, offset, magic, sizeof(magic)) || std::memcmp(magic, CODEC_CACHE_MAGIC, sizeof(magic)) != 0 ||
+            !m_read(bytes, offset, &version, sizeof(version)) || version != CODEC_CACHE_VERSION ||
+            !m_read(bytes, offset, &count, sizeof(count))) {
+            return;
+        }
+        std::map<std::string, H264CodecParameters> entries;
+        for (uint32_t i = 0; i < count; i++) {
+            std::vector<uint8_t> name;
+            H264CodecParameters parameters;
+            if (!m_readBlock(bytes, offset, name) || !m_readBlock(bytes, offset, parameters.sps) ||
+                !m_readBlock(bytes, offset, parameters.pps)) {
+                return;
+            }
+            entries[std::string(name.begin(), name.end())] = std::move(parameters);
+        }
+        m_entries = std::move(entries);
+    }
+
+    /// Write every entry to a temporary file and rename it over the cache file. Called with m_mutex held.
+    /// @returns false on any write error
+    bool m_save()
+    {
+        std::vector<char> bytes(CODEC_CACHE_MAGIC, CODEC_CACHE_MAGIC + sizeof(CODEC_CACHE_MAGIC));
+        const uint32_t count = static_cast<uint32_t>(m_entries.size());
+        m_append(bytes, &CODEC_CACHE_VERSION, sizeof(CODEC_CACHE_VERSION));
+        m_append(bytes, &count, sizeof(count));
+        for (const auto &entry : m_entries) {
+            m_appendBlock(bytes, entry.first.data(), entry.first.size());
+            m_appendBlock(bytes, entry.second.sps.data(), entry.second.sps.size());
+            m_appendBlock(bytes, entry.second.pps.data(), entry.second.pps.size());
+        }
+
+        const std::string temporary = m_path + ".tmp";
+        int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) { return false; }
+        size_t written = 0;
+        while (written < bytes.size()) {
+            const ssize_t ret = write(fd, bytes.data() + written, bytes.size() - written);
+            if (ret < 0 && errno == EINTR) { continue; }
+            if (ret <= 0) { break; }
+            written += static_cast<size_t>(ret);
+        }
+        // the data must be on disk before the rename, or a power loss can leave an empty file in place
+        const bool synced = written == bytes.size() && fsync(fd) == 0;
+        close(fd);
+        if (!synced || std::rename(temporary.c_str(), m_path.c_str()) != 0) {
+            unlink(temporary.c_str());
+            return false;
+        }
+        // make the rename itself durable
+        const size_t slash = m_path.find_last_of('/');
+        const std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : m_path.substr(0, slash));
+        int dirFd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd >= 0) {
+            fsync(dirFd);
+            close(dirFd);
+        }
+        return true;
+    }
+
+    static bool m_read(const std::vector<char> &bytes, size_t &offset, void *value, size_t size)
+    {
+        if (bytes.size() - offset < size) { return false; }
+        std::memcpy(value, bytes.data() + offset, size);
+        offset += size;
+        return true;
+    }
+
+    static bool m_readBlock(const std::vector<char> &bytes, size_t &offset, std::vector<uint8_t> &block)
+    {
+        uint32_t size = 0;
+        if (!m_read(bytes, offset, &size, sizeof(size)) || bytes.size() - offset < size) { return false; }
+        block.assign(bytes.data() + offset, bytes.data() + offset + size);
+        offset += size;
+        return true;
+    }
+
+    static void m_append(std::vector<char> &bytes, const void *value, size_t size)
+    {
+        const char *first = static_cast<const char *>(value);
+        bytes.insert(bytes.end(), first, first + size);
+    }
+
+    static void m_appendBlock(std::vector<char> &bytes, const void *block, size_t size)
+    {
+        const uint32_t size32 = static_cast<uint32_t>(size);
+        m_append(bytes, &size32, sizeof(size32));
+        m_append(bytes, block, size);
+    }
+};
+
+} // wscDrone
+
+#endif /* CODECCACHE_H_ */
@@ -0,0 +1,494 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains hand-vectorised YUV420P to RGB/BGR/RGBA conversion
+ * kernels with fused downscaling, selected at runtime by CPU feature detection.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef COLOURCONVERT_H_
+#define COLOURCONVERT_H_
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "PixelFormat.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define WSCDRONE_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define WSCDRONE_X86_SIMD 0
+#endif
+
+namespace wscDrone {
+
+/// Instruction set levels of the colour conversion kernels
+enum class SimdLevel : unsigned {
+    NONE   = 0, ///< no SIMD kernels, callers fall back to swscale
+    SSE4   = 1, ///< SSE4.1, 16 pixels per iteration
+    AVX2   = 2, ///< AVX2, 32 pixels per iteration
+    AVX512 = 3  ///< AVX-512F/BW, 64 pixels per iteration
+};
+
+/// Detect the best kernel level supported by the CPU. The result is computed once.
+/// @returns the best supported SimdLevel
+inline SimdLevel detectSimdLevel()
+{
+#if WSCDRONE_X86_SIMD
+    static const SimdLevel level = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) { return SimdLevel::AVX512; }
+        if (__builtin_cpu_supports("avx2"))   { return SimdLevel::AVX2; }
+        if (__builtin_cpu_supports("sse4.1")) { return SimdLevel::SSE4; }
+        return SimdLevel::NONE;
+    }();
+    return level;
+#else
+    return SimdLevel::NONE;
+#endif
+}
+
+namespace detail {
+
+// BT.601 limited range in 6-bit fixed point, matching the swscale default for YUV420P:
+//   R = 1.164(Y-16) + 1.596(V-128)
+//   G = 1.164(Y-16) - 0.391(U-128) - 0.813(V-128)
+//   B = 1.164(Y-16) + 2.018(U-128)
+// The scalar and vector kernels produce bit-identical results.
+constexpr int COEF_Y  = 75;
+constexpr int COEF_RV = 102;
+constexpr int COEF_GU = 25;
+constexpr int COEF_GV = 52;
+constexpr int COEF_BU = 129;
+constexpr int ROUND   = 32;
+constexpr int SHIFT   = 6;
+
+inline uint8_t clampToByte(int value) { return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value)); }
+
+/// Write one pixel in the requested packed format
+inline void storePixel(uint8_t *dst, PixelFormat format, int y, int u, int v)
+{
+    const int ys = (y - 16) * COEF_Y + ROUND;
+    u -= 128;
+    v -= 128;
+    const uint8_t r = clampToByte((ys + COEF_RV * v) >> SHIFT);
+    const uint8_t g = clampToByte((ys - COEF_GU * u - COEF_GV * v) >> SHIFT);
+    const uint8_t b = clampToByte((ys + COEF_BU * u) >> SHIFT);
+    switch (format) {
+    case PixelFormat::BGR24 : dst[0] = b; dst[1] = g; dst[2] = r; break;
+    case PixelFormat::RGBA  : dst[0] = r; dst[1] = g; dst[2] = b; dst[3] = 255; break;
+    default                 : dst[0] = r; dst[1] = g; dst[2] = b; break;
+    }
+}
+
+/// Bytes per pixel of the packed formats the kernels write
+inline unsigned packedBytesPerPixel(PixelFormat format) { return format == PixelFormat::RGBA ? 4 : 3; }
+
+/// Convert pixels [first, width) of one row. Also handles the tails left by the vector kernels.
+inline void convertRowScalar(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *dst,
+                             unsigned first, unsigned width, PixelFormat format)
+{
+    const unsigned bpp = packedBytesPerPixel(format);
+    for (unsigned x = first; x < width; x++) {
+        storePixel(dst + x * bpp, format, y[x], u[x / 2], v[x / 2]);
+    }
+}
+
+/// dst[i] is the rounded mean of the 2x2 block at column 2i of rows a and b. An odd last column is
+/// averaged with itself.
+inline void halveScalar(const uint8_t *a, const uint8_t *b, uint8_t *dst, unsigned first, unsigned inWidth)
+{
+    const unsigned outWidth = (inWidth + 1) / 2;
+    for (unsigned i = first; i < outWidth; i++) {
+        const unsigned x0 = 2 * i;
+        const unsigned x1 = (x0 + 1 < inWidth) ? x0 + 1 : x0;
+        dst[i] = static_cast<uint8_t>((a[x0] + a[x1] + b[x0] + b[x1] + 2) >> 2);
+    }
+}
+
+#if WSCDRONE_X86_SIMD
+
+/// Interleave 16 pixels of three channels into 48 bytes of packed 24-bit pixels
+__attribute__((target("sse4.1"))) inline void store24_sse(uint8_t *dst, __m128i c0, __m128i c1, __m128i c2)
+{
+    const __m128i m00 = _mm_setr_epi8( 0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1, -1,  5);
+    const __m128i m01 = _mm_setr_epi8(-1,  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1, -1);
+    const __m128i m02 = _mm_setr_epi8(-1, -1,  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1);
+    const __m128i m10 = _mm_setr_epi8(-1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1, 10, -1);
+    const __m128i m11 = _mm_setr_epi8( 5, -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1, 10);
+    const __m128i m12 = _mm_setr_epi8(-1,  5, -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1);
+    const __m128i m20 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+    const __m128i m21 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+    const __m128i m22 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+    __m128i out0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, m00), _mm_shuffle_epi8(c1, m01)), _mm_shuffle_epi8(c2, m02));
+    __m128i out1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, m10), _mm_shuffle_epi8(c1, m11)), _mm_shuffle_epi8(c2, m12));
+    __m128i out2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, m20), _mm_shuffle_epi8(c1, m21)), _mm_shuffle_epi8(c2, m22));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),      out0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), out1);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 32), out2);
+}
+
+/// Store 16 pixels of R, G, B channels in the requested packed format
+__attribute__((target("sse4.1"))) inline void storePacked_sse(uint8_t *dst, PixelFormat format, __m128i r, __m128i g, __m128i b)
+{
+    if (format == PixelFormat::RGBA) {
+        const __m128i a    = _mm_set1_epi8(-1);
+        const __m128i rgLo = _mm_unpacklo_epi8(r, g);
+        const __m128i rgHi = _mm_unpackhi_epi8(r, g);
+        const __m128i baLo = _mm_unpacklo_epi8(b, a);
+        const __m128i baHi = _mm_unpackhi_epi8(b, a);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),      _mm_unpacklo_epi16(rgLo, baLo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), _mm_unpackhi_epi16(rgLo, baLo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 32), _mm_unpacklo_epi16(rgHi, baHi));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 48), _mm_unpackhi_epi16(rgHi, baHi));
+    } else if (format == PixelFormat::BGR24) {
+        store24_sse(dst, b, g, r);
+    } else {
+        store24_sse(dst, r, g, b);
+    }
+}
+
+/// Colour-convert eight pixels held as 16-bit lanes
+__attribute__((target("sse4.1"))) inline void yuvToRgb_sse(__m128i y, __m128i u, __m128i v, __m128i &r, __m128i &g, __m128i &b)
+{
+    const __m128i ys = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)), _mm_set1_epi16(COEF_Y)),
+                                     _mm_set1_epi16(ROUND));
+    u = _mm_sub_epi16(u, _mm_set1_epi16(128));
+    v = _mm_sub_epi16(v, _mm_set1_epi16(128));
+    r = _mm_srai_epi16(_mm_adds_epi16(ys, _mm_mullo_epi16(v, _mm_set1_epi16(COEF_RV))), SHIFT);
+    g = _mm_srai_epi16(_mm_subs_epi16(ys, _mm_add_epi16(_mm_mullo_epi16(u, _mm_set1_epi16(COEF_GU)),
+                                                        _mm_mullo_epi16(v, _mm_set1_epi16(COEF_GV)))), SHIFT);
+    b = _mm_srai_epi16(_mm_adds_epi16(ys, _mm_mullo_epi16(u, _mm_set1_epi16(COEF_BU))), SHIFT);
+}
+
+__attribute__((target("sse4.1"))) inline void convertRow_sse(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                                                              uint8_t *dst, unsigned width, PixelFormat format)
+{
+    const unsigned bpp  = packedBytesPerPixel(format);
+    const __m128i  zero = _mm_setzero_si128();
+    unsigned x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i y8  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x));
+        const __m128i u16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(u + x / 2)), zero);
+        const __m128i v16 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(v + x / 2)), zero);
+        __m128i rLo, gLo, bLo, rHi, gHi, bHi;
+        yuvToRgb_sse(_mm_unpacklo_epi8(y8, zero), _mm_unpacklo_epi16(u16, u16), _mm_unpacklo_epi16(v16, v16), rLo, gLo, bLo);
+        yuvToRgb_sse(_mm_unpackhi_epi8(y8, zero), _mm_unpackhi_epi16(u16, u16), _mm_unpackhi_epi16(v16, v16), rHi, gHi, bHi);
+        storePacked_sse(dst + x * bpp, format, _mm_packus_epi16(rLo, rHi), _mm_packus_epi16(gLo, gHi), _mm_packus_epi16(bLo, bHi));
+    }
+    convertRowScalar(y, u, v, dst, x, width, format);
+}
+
+__attribute__((target("sse4.1"))) inline void halve_sse(const uint8_t *a, const uint8_t *b, uint8_t *dst, unsigned inWidth)
+{
+    const __m128i ones = _mm_set1_epi8(1);
+    const __m128i two  = _mm_set1_epi16(2);
+    unsigned i = 0;
+    for (; 2 * i + 32 <= inWidth; i += 16) {
+        __m128i a0 = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 2 * i)),      ones);
+        __m128i a1 = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 2 * i + 16)), ones);
+        __m128i b0 = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + 2 * i)),      ones);
+        __m128i b1 = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + 2 * i + 16)), ones);
+        __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(a0, b0), two), 2);
+        __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(a1, b1), two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    halveScalar(a, b, dst, i, inWidth);
+}
+
+__attribute__((target("avx2"))) inline void yuvToRgb_avx2(__m256i y, __m256i u, __m256i v, __m256i &r, __m256i &g, __m256i &b)
+{
+    const __m256i ys = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(y, _mm256_set1_epi16(16)), _mm256_set1_epi16(COEF_Y)),
+                                        _mm256_set1_epi16(ROUND));
+    u = _mm256_sub_epi16(u, _mm256_set1_epi16(128));
+    v = _mm256_sub_epi16(v, _mm256_set1_epi16(128));
+    r = _mm256_srai_epi16(_mm256_adds_epi16(ys, _mm256_mullo_epi16(v, _mm256_set1_epi16(COEF_RV))), SHIFT);
+    g = _mm256_srai_epi16(_mm256_subs_epi16(ys, _mm256_add_epi16(_mm256_mullo_epi16(u, _mm256_set1_epi16(COEF_GU)),
+                                                                 _mm256_mullo_epi16(v, _mm256_set1_epi16(COEF_GV)))), SHIFT);
+    b = _mm256_srai_epi16(_mm256_adds_epi16(ys, _mm256_mullo_epi16(u, _mm256_set1_epi16(COEF_BU))), SHIFT);
+}
+
+__attribute__((target("avx2"))) inline void convertRow_avx2(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                                                             uint8_t *dst, unsigned width, PixelFormat format)
+{
+    const unsigned bpp = packedBytesPerPixel(format);
+    unsigned x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const __m256i yLo = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x)));
+        const __m256i yHi = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x + 16)));
+        // duplicate each chroma sample for its two pixels, ordering lanes so unpack stays in pixel order
+        const __m256i u16 = _mm256_permute4x64_epi64(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(u + x / 2))), 0xD8);
+        const __m256i v16 = _mm256_permute4x64_epi64(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(v + x / 2))), 0xD8);
+        __m256i rLo, gLo, bLo, rHi, gHi, bHi;
+        yuvToRgb_avx2(yLo, _mm256_unpacklo_epi16(u16, u16), _mm256_unpacklo_epi16(v16, v16), rLo, gLo, bLo);
+        yuvToRgb_avx2(yHi, _mm256_unpackhi_epi16(u16, u16), _mm256_unpackhi_epi16(v16, v16), rHi, gHi, bHi);
+        const __m256i r8 = _mm256_permute4x64_epi64(_mm256_packus_epi16(rLo, rHi), 0xD8);
+        const __m256i g8 = _mm256_permute4x64_epi64(_mm256_packus_epi16(gLo, gHi), 0xD8);
+        const __m256i b8 = _mm256_permute4x64_epi64(_mm256_packus_epi16(bLo, bHi), 0xD8);
+        storePacked_sse(dst + x * bpp, format, _mm256_castsi256_si128(r8), _mm256_castsi256_si128(g8), _mm256_castsi256_si128(b8));
+        storePacked_sse(dst + (x + 16) * bpp, format, _mm256_extracti128_si256(r8, 1), _mm256_extracti128_si256(g8, 1),
+                        _mm256_extracti128_si256(b8, 1));
+    }
+    convertRowScalar(y, u, v, dst, x, width, format);
+}
+
+// GCC 12 reports the _mm_undefined_si128() placeholders inside the AVX-512 intrinsics as uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f,avx512bw"))) inline void yuvToRgb_avx512(__m512i y, __m512i u, __m512i v, __m512i &r, __m512i &g, __m512i &b)
+{
+    const __m512i ys = _mm512_add_epi16(_mm512_mullo_epi16(_mm512_sub_epi16(y, _mm512_set1_epi16(16)), _mm512_set1_epi16(COEF_Y)),
+                                        _mm512_set1_epi16(ROUND));
+    u = _mm512_sub_epi16(u, _mm512_set1_epi16(128));
+    v = _mm512_sub_epi16(v, _mm512_set1_epi16(128));
+    r = _mm512_srai_epi16(_mm512_adds_epi16(ys, _mm512_mullo_epi16(v, _mm512_set1_epi16(COEF_RV))), SHIFT);
+    g = _mm512_srai_epi16(_mm512_subs_epi16(ys, _mm512_add_epi16(_mm512_mullo_epi16(u, _mm512_set1_epi16(COEF_GU)),
+                                                                 _mm512_mullo_epi16(v, _mm512_set1_epi16(COEF_GV)))), SHIFT);
+    b = _mm512_srai_epi16(_mm512_adds_epi16(ys, _mm512_mullo_epi16(u, _mm512_set1_epi16(COEF_BU))), SHIFT);
+}
+
+__attribute__((target("avx512f,avx512bw"))) inline void convertRow_avx512(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                                                                          uint8_t *dst, unsigned width, PixelFormat format)
+{
+    static const uint16_t dupIndex[64] = {
+         0,  0,  1,  1,  2,  2,  3,  3,  4,  4,  5,  5,  6,  6,  7,  7,  8,  8,  9,  9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14, 15, 15,
+        16, 16, 17, 17, 18, 18, 19, 19, 20, 20, 21, 21, 22, 22, 23, 23, 24, 24, 25, 25, 26, 26, 27, 27, 28, 28, 29, 29, 30, 30, 31, 31 };
+    const __m512i dupLo   = _mm512_loadu_si512(dupIndex);
+    const __m512i dupHi   = _mm512_loadu_si512(dupIndex + 32);
+    const __m512i laneFix = _mm512_set_epi64(7, 5, 3, 1, 6, 4, 2, 0);
+    const unsigned bpp = packedBytesPerPixel(format);
+    unsigned x = 0;
+    for (; x + 64 <= width; x += 64) {
+        const __m512i yLo = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + x)));
+        const __m512i yHi = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + x + 32)));
+        const __m512i u16 = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(u + x / 2)));
+        const __m512i v16 = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(v + x / 2)));
+        __m512i rLo, gLo, bLo, rHi, gHi, bHi;
+        yuvToRgb_avx512(yLo, _mm512_permutexvar_epi16(dupLo, u16), _mm512_permutexvar_epi16(dupLo, v16), rLo, gLo, bLo);
+        yuvToRgb_avx512(yHi, _mm512_permutexvar_epi16(dupHi, u16), _mm512_permutexvar_epi16(dupHi, v16), rHi, gHi, bHi);
+        const __m512i r8 = _mm512_permutexvar_epi64(laneFix, _mm512_packus_epi16(rLo, rHi));
+        const __m512i g8 = _mm512_permutexvar_epi64(laneFix, _mm512_packus_epi16(gLo, gHi));
+        const __m512i b8 = _mm512_permutexvar_epi64(laneFix, _mm512_packus_epi16(bLo, bHi));
+        storePacked_sse(dst + x * bpp,        format, _mm512_extracti32x4_epi32(r8, 0), _mm512_extracti32x4_epi32(g8, 0), _mm512_extracti32x4_epi32(b8, 0));
+        storePacked_sse(dst + (x + 16) * bpp, format, _mm512_extracti32x4_epi32(r8, 1), _mm512_extracti32x4_epi32(g8, 1), _mm512_extracti32x4_epi32(b8, 1));
+        storePacked_sse(dst + (x + 32) * bpp, format, _mm512_extracti32x4_epi32(r8, 2), _mm512_extracti32x4_epi32(g8, 2), _mm512_extracti32x4_epi32(b8, 2));
+        storePacked_sse(dst + (x + 48) * bpp, format, _mm512_extracti32x4_epi32(r8, 3), _mm512_extracti32x4_epi32(g8, 3), _mm512_extracti32x4_epi32(b8, 3));
+    }
+    convertRowScalar(y, u, v, dst, x, width, format);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // WSCDRONE_X86_SIMD
+
+/// Convert one row at the requested kernel level
+inline void convertRow(SimdLevel level, const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                       uint8_t *dst, unsigned width, PixelFormat format)
+{
+    switch (level) {
+#if WSCDRONE_X86_SIMD
+    case SimdLevel::AVX512 : convertRow_avx512(y, u, v, dst, width, format); return;
+    case SimdLevel::AVX2   : convertRow_avx2(y, u, v, dst, width, format);   return;
+    case SimdLevel::SSE4   : convertRow_sse(y, u, v, dst, width, format);    return;
+#endif
+    default : convertRowScalar(y, u, v, dst, 0, width, format); return;
+    }
+}
+
+/// 2x2 box-filter rows a and b into (inWidth + 1) / 2 samples
+inline void halve(SimdLevel level, const uint8_t *a, const uint8_t *b, uint8_t *dst, unsigned inWidth)
+{
+#if WSCDRONE_X86_SIMD
+    if (level != SimdLevel::NONE) {
+        halve_sse(a, b, dst, inWidth);
+        return;
+    }
+#endif
+    halveScalar(a, b, dst, 0, inWidth);
+}
+
+} // detail
+
+/// Convert a YUV420P (BT.601 limited range) image to packed RGB24, BGR24 or RGBA, optionally
+/// downscaling by 2 or 4 in the same pass with a box filter.
+/// @details Meant as a faster replacement for swscale on the decode thread. When it returns false the
+/// caller should fall back to swscale.
+/// @param src Y, U and V plane pointers
+/// @param srcStride Y, U and V plane strides in bytes
+/// @param srcWidth source width in pixels
+/// @param srcHeight source height in lines
+/// @param format destination format, RGB24, BGR24 or RGBA
+/// @param dst destination buffer of srcHeight / scale lines
+/// @param dstStride destination stride in bytes
+/// @param scale downscale factor, 1, 2 or 4. The output is srcWidth / scale by srcHeight / scale.
+/// @param level kernel level, defaults to the best the CPU supports
+/// @returns false when the format, scale or level is not supported by the kernels
+inline bool convertYUV420P(const uint8_t *const src[3], const int srcStride[3], unsigned srcWidth, unsigned srcHeight,
+                           PixelFormat format, uint8_t *dst, int dstStride, unsigned scale = 1,
+                           SimdLevel level = detectSimdLevel())
+{
+    if (level == SimdLevel::NONE) { return false; }
+    if (format != PixelFormat::RGB24 && format != PixelFormat::BGR24 && format != PixelFormat::RGBA) { return false; }
+    if (scale != 1 && scale != 2 && scale != 4) { return false; }
+
+    const unsigned outWidth    = srcWidth / scale;
+    const unsigned outHeight   = srcHeight / scale;
+    const unsigned chromaWidth = (srcWidth + 1) / 2;
+    if (outWidth == 0 || outHeight == 0) { return false; }
+
+    // Line buffers for the downscaled rows. The extra slack covers the halving of odd widths.
+    thread_local std::vector<uint8_t> lines;
+    const unsigned lineBytes = chromaWidth + 64;
+    if (lines.size() < 6 * lineBytes) { lines.resize(6 * lineBytes); }
+    uint8_t *yLine = lines.data();
+    uint8_t *uLine = yLine + lineBytes;
+    uint8_t *vLine = uLine + lineBytes;
+    uint8_t *tmpA  = vLine + lineBytes;
+    uint8_t *tmpB  = tmpA + lineBytes;
+    uint8_t *tmpC  = tmpB + lineBytes;
+
+    for (unsigned oy = 0; oy < outHeight; oy++) {
+        const uint8_t *yRow;
+        const uint8_t *uRow;
+        const uint8_t *vRow;
+        if (scale == 1) {
+            yRow = src[0] + static_cast<size_t>(oy) * srcStride[0];
+            uRow = src[1] + static_cast<size_t>(oy / 2) * srcStride[1];
+            vRow = src[2] + static_cast<size_t>(oy / 2) * srcStride[2];
+        } else if (scale == 2) {
+            // luma rows 2oy and 2oy+1 box filtered, chroma row oy halved horizontally only
+            const uint8_t *y0 = src[0] + static_cast<size_t>(2 * oy) * srcStride[0];
+            const uint8_t *u0 = src[1] + static_cast<size_t>(oy) * srcStride[1];
+            const uint8_t *v0 = src[2] + static_cast<size_t>(oy) * srcStride[2];
+            detail::halve(level, y0, y0 + srcStride[0], yLine, srcWidth);
+            detail::halve(level, u0, u0, uLine, chromaWidth);
+            detail::halve(level, v0, v0, vLine, chromaWidth);
+            yRow = yLine;
+            uRow = uLine;
+            vRow = vLine;
+        } else {
+            // luma rows 4oy..4oy+3 and chroma rows 2oy, 2oy+1 box filtered, chroma halved again horizontally
+            const uint8_t *y0 = src[0] + static_cast<size_t>(4 * oy) * srcStride[0];
+            const uint8_t *u0 = src[1] + static_cast<size_t>(2 * oy) * srcStride[1];
+            const uint8_t *v0 = src[2] + static_cast<size_t>(2 * oy) * srcStride[2];
+            const unsigned halfWidth = (srcWidth + 1) / 2;
+            detail::halve(level, y0, y0 + srcStride[0], tmpA, srcWidth);
+            detail::halve(level, y0 + 2 * srcStride[0], y0 + 3 * srcStride[0], tmpB, srcWidth);
+            detail::halve(level, tmpA, tmpB, yLine, halfWidth);
+            detail::halve(level, u0, u0 + srcStride[1], tmpC, chromaWidth);
+            detail::halve(level, tmpC, tmpC, uLine, (chromaWidth + 1) / 2);
+            detail::halve(level, v0, v0 + srcStride[2], tmpC, chromaWidth);
+            detail::halve(level, tmpC, tmpC, vLine, (chromaWidth + 1) / 2);
+            yRow = yLine;
+            uRow = uLine;
+            vRow = vLine;
+        }
+        detail::convertRow(level, yRow, uRow, vRow, dst + static_cast<size_t>(oy) * dstStride, outWidth, format);
+    }
+    return true;
+}
+
+/// Number of levels of an image pyramid: full, half and quarter size
+constexpr unsigned PYRAMID_LEVELS = 3;
+
+/// Convert a YUV420P image into up to three pyramid levels, full, 1/2 and 1/4 size, in one pass.
+/// @details The source is read once, in bands of four lines: each band is converted at full size,
+/// box filtered to two half size lines and those lines filtered again to one quarter size line, so
+/// the quarter level costs no extra reads of the source. Crop a region by offsetting the plane
+/// pointers to an even x and y. Unlike convertYUV420P() this also runs at SimdLevel::NONE, on the
+/// scalar kernels, since swscale has no equivalent.
+/// @param src Y, U and V plane pointers
+/// @param srcStride Y, U and V plane strides in bytes
+/// @param srcWidth source width in pixels
+/// @param srcHeight source height in lines
+/// @param format destination format, RGB24, BGR24, RGBA or GRAY8
+/// @param dst destination of each level, nullptr for a level not wanted. Level n is srcWidth >> n by srcHeight >> n.
+/// @param dstStride destination stride of each level in bytes
+/// @param level kernel level, defaults to the best the CPU supports
+/// @returns false when the format is not supported by the kernels
+inline bool convertYUV420PPyramid(const uint8_t *const src[3], const int srcStride[3], unsigned srcWidth,
+                                  unsigned srcHeight, PixelFormat format, uint8_t *const dst[PYRAMID_LEVELS],
+                                  const int dstStride[PYRAMID_LEVELS], SimdLevel level = detectSimdLevel())
+{
+    const bool gray = format == PixelFormat::GRAY8;
+    if (!gray && format != PixelFormat::RGB24 && format != PixelFormat::BGR24 && format != PixelFormat::RGBA) {
+        return false;
+    }
+
+    const unsigned width[PYRAMID_LEVELS]  = { srcWidth, srcWidth / 2, srcWidth / 4 };
+    const unsigned height[PYRAMID_LEVELS] = { srcHeight, srcHeight / 2, srcHeight / 4 };
+    const unsigned halfWidth   = (srcWidth + 1) / 2;
+    const unsigned chromaWidth = (srcWidth + 1) / 2;
+    auto output = [&](unsigned n, unsigned line, const uint8_t *y, const uint8_t *u, const uint8_t *v) {
+        uint8_t *out = dst[n] + static_cast<size_t>(line) * dstStride[n];
+        if (gray) {
+            std::memcpy(out, y, width[n]);
+        } else {
+            detail::convertRow(level, y, u, v, out, width[n], format);
+        }
+    };
+
+    // Half size lines of the current band and the quarter size line made from them
+    thread_local std::vector<uint8_t> lines;
+    const unsigned lineBytes = halfWidth + 64;
+    if (lines.size() < 9 * lineBytes) { lines.resize(9 * lineBytes); }
+    uint8_t *yHalf[2] = { lines.data(), lines.data() + lineBytes };
+    uint8_t *uHalf[2] = { yHalf[1] + lineBytes, yHalf[1] + 2 * lineBytes };
+    uint8_t *vHalf[2] = { uHalf[1] + lineBytes, uHalf[1] + 2 * lineBytes };
+    uint8_t *yQuarter = vHalf[1] + lineBytes;
+    uint8_t *uQuarter = yQuarter + lineBytes;
+    uint8_t *vQuarter = uQuarter + lineBytes;
+
+    for (unsigned band = 0; 4 * band < srcHeight; band++) {
+        if (dst[0]) {
+            for (unsigned line = 4 * band; line < srcHeight && line < 4 * band + 4; line++) {
+                output(0, line, src[0] + static_cast<size_t>(line) * srcStride[0],
+                       src[1] + static_cast<size_t>(line / 2) * srcStride[1],
+                       src[2] + static_cast<size_t>(line / 2) * srcStride[2]);
+            }
+        }
+        const bool quarter = dst[2] && band < height[2];
+        if (!dst[1] && !quarter) { continue; }
+
+        for (unsigned half = 0; half < 2 && 2 * band + half < height[1]; half++) {
+            // luma lines 2l and 2l+1 box filtered, chroma line l halved horizontally only
+            const unsigned line = 2 * band + half;
+            const uint8_t *y0 = src[0] + static_cast<size_t>(2 * line) * srcStride[0];
+            detail::halve(level, y0, y0 + srcStride[0], yHalf[half], srcWidth);
+            if (!gray) {
+                const uint8_t *u0 = src[1] + static_cast<size_t>(line) * srcStride[1];
+                const uint8_t *v0 = src[2] + static_cast<size_t>(line) * srcStride[2];
+                detail::halve(level, u0, u0, uHalf[half], chromaWidth);
+                detail::halve(level, v0, v0, vHalf[half], chromaWidth);
+            }
+            if (dst[1]) { output(1, line, yHalf[half], uHalf[half], vHalf[half]); }
+        }
+        if (quarter) {
+            detail::halve(level, yHalf[0], yHalf[1], yQuarter, halfWidth);
+            if (!gray) {
+                detail::halve(level, uHalf[0], uHalf[1], uQuarter, (chromaWidth + 1) / 2);
+                detail::halve(level, vHalf[0], vHalf[1], vQuarter, (chromaWidth + 1) / 2);
+            }
+            output(2, band, yQuarter, uQuarter, vQuarter);
+        }
+    }
+    return true;
+}
+
+} // wscDrone
+
+#endif /* COLOURCONVERT_H_ */
@@ -0,0 +1,539 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the CommandDispatcher, a table driven dispatcher
+ * of decoded ARSDK commands to any number of subscribers.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef COMMANDDISPATCHER_H_
+#define COMMANDDISPATCHER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libARController/ARController.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "DroneController.h"
+#include "DroneTransport.h"
+#include "Telemetry.h"
+#include "Utils.h"
+
+namespace wscDrone {
+
+/// Commands the CommandDispatcher decodes into typed values
+enum class CommandType : unsigned {
+    UNKNOWN            = 0,  ///< not decoded, only the key and raw dictionary are available
+    BATTERY            = 1,  ///< DecodedCommand::battery
+    FLYING_STATE       = 2,  ///< DecodedCommand::flyingState
+    ATTITUDE           = 3,  ///< DecodedCommand::attitude
+    POSITION           = 4,  ///< DecodedCommand::position
+    SPEED              = 5,  ///< DecodedCommand::speed
+    ALTITUDE           = 6,  ///< DecodedCommand::altitude
+    CAMERA_ORIENTATION = 7,  ///< DecodedCommand::cameraOrientation
+    CAMERA_SETTINGS    = 8,  ///< DecodedCommand::cameraSettings
+    PICTURE_STATE      = 9,  ///< DecodedCommand::mediaState
+    VIDEO_STATE        = 10, ///< DecodedCommand::mediaState
+    PICTURE_EVENT      = 11, ///< DecodedCommand::mediaState, with the event in state
+    VIDEO_ENABLE       = 12, ///< DecodedCommand::mediaState, with the enabled flag in state
+    MOVE_BY_END        = 13, ///< DecodedCommand::moveByEnd
+    COUNT              = 14  ///< number of command types
+};
+
+/// The end of a relative move
+struct MoveByEndTelemetry {
+    uint64_t timestampNs = 0; ///< monotonic receive time
+    float dX   = 0.0f;        ///< forward displacement in metres
+    float dY   = 0.0f;        ///< right displacement in metres
+    float dZ   = 0.0f;        ///< down displacement in metres
+    float dPsi = 0.0f;        ///< heading change in radians
+    int   error = 0;          ///< raw ARSDK MoveByEnd error value
+};
+
+/// One received command with its arguments decoded once, for every subscriber
+struct DecodedCommand {
+    eARCONTROLLER_DICTIONARY_KEY key = ARCONTROLLER_DICTIONARY_KEY_MAX;  ///< the ARSDK command key
+    CommandType type    = CommandType::UNKNOWN;                         ///< selects the member of the union
+    uint64_t timestampNs = 0;                                           ///< monotonic receive time
+    ARCONTROLLER_DICTIONARY_ELEMENT_t *element = nullptr; ///< the raw arguments, valid during the callback only
+    union {
+        BatteryTelemetry           battery;
+        FlyingStateTelemetry       flyingState;
+        AttitudeTelemetry          attitude;
+        PositionTelemetry          position;
+        SpeedTelemetry             speed;
+        AltitudeTelemetry          altitude;
+        CameraOrientationTelemetry cameraOrientation;
+        CameraSettingsTelemetry    cameraSettings;
+        MediaStateTelemetry        mediaState;
+        MoveByEndTelemetry         moveByEnd;
+    };
+
+    DecodedCommand() : battery() {}
+};
+
+/// alias for the callback invoked on the ARSDK command thread with each decoded command
+using DecodedCommandCallback = void (*)(const DecodedCommand &command, void *customData);
+
+namespace detail {
+
+/// Most arguments of any decoded command
+constexpr unsigned MAX_COMMAND_ARGUMENTS = 5;
+
+/// alias for a function filling the typed member of a DecodedCommand from argument values in table order
+using CommandDecoder = void (*)(const ARCONTROLLER_DICTIONARY_VALUE_t *values, DecodedCommand &command);
+
+/// How one command is decoded
+struct CommandDescriptor {
+    eARCONTROLLER_DICTIONARY_KEY key = ARCONTROLLER_DICTIONARY_KEY_MAX; ///< the ARSDK command key
+    CommandDecoder decode = nullptr;                                   ///< fills the typed member
+    unsigned numArguments = 0;                                         ///< number of arguments used
+    const char *arguments[MAX_COMMAND_ARGUMENTS] = {};                 ///< argument names in decode order
+};
+
+/// The command descriptors by CommandType and the CommandType of every ARSDK key
+struct CommandTable {
+    CommandDescriptor descriptors[static_cast<unsigned>(CommandType::COUNT)];
+    CommandType       types[ARCONTROLLER_DICTIONARY_KEY_MAX];
+};
+
+inline void decodeBattery(const ARCONTROLLER_DICTIONARY_VALUE_t *v, DecodedCommand &c)
+{
+    c.battery = BatteryTelemetry();
+    c.battery.timestampNs = c.timestampNs;
+    c.battery.percent     = v[0].U8;
+}
+
+inline void decodeFlyingState(const ARCONTROLLER_DICTIONARY_VALUE_t *v, DecodedCommand &c)
+{
+    c.flyingState = FlyingStateTelemetry();
+    c.flyingState.timestampNs = c.timestampNs;
+    c.flyingState.state = static_cast<eARCOMMANDS_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE>(v[0].I32);
+}
+
+inline void decodeAttitude(const ARCONTROLLER_DICTIONARY_VALUE_t *v, DecodedCommand &c)
+{
+    c.attitude = AttitudeTelemetry();
+    c.attitude.timestampNs = c.timestampNs;
+    c.attitude.roll  = v[0].Float;
+    c.attitude.pitch = v[1].Float;
+    c.attitude.yaw   = v[2].Float;
+}
+
+inline void decodePosition(const ARCONTROLLER_DICTIONARY_VALUE_t *v, DecodedCommand &c)
+{
+    c.position = PositionTelemetry();
+    c.position.timestampNs = c.timestampNs;
+    c.position.latitude  = v[0].Double;
+    c.position.longitude = v[1].Double;
+    c.position.altitude  = v[2].Double;
+}
+
+inline void decodeSpeed(const ARCONTROLLER_DICTIONARY_VALUE_t *v, DecodedCommand &c)
+{
+    c.speed = SpeedTelemetry();
+    c.speed.timestampNs = c.timestampNs;
+    c.speed.speedX = v[0].Float;
+    c.speed.speedY = v[1].Float;
+    c.speed.speedZ = v[2].Float;
+}
+
+inline void decodeAltitude(const ARCONTROLLER_DICTIONARY_VALUE_t *v, DecodedCommand &c)
+{
+    c.altitude = AltitudeTelemetry();
+    c.altitude.timestampNs = c.timestampNs;
+    c.altitude.altitude = v[0].Double;
+}
+
+inline void decodeCameraOrientation(const ARCONTROLLER_DICTIONARY_VALUE_t *v, DecodedCommand &c)
+{
+    c.cameraOrientation = CameraOrientationTelemetry();
+    c.cameraOrientation.timestampNs = c.timestampNs;
+    c.cameraOrientation.tilt = v[0].Float;
+    c.cameraOrientation.pan  = v[1].Float;
+}
+
+inline void decodeCameraSettings(const ARCONTROLLER_DICTIONARY_VALUE_t *v, DecodedCommand &c)
+{
+    c.cameraSettings = CameraSettingsTelemetry();
+    c.cameraSettings.timestampNs = c.timestampNs;
+    c.cameraSettings.fov     = v[0].Float;
+    c.cameraSettings.panMax  = v[1].Float;
+    c.cameraSettings.panMin  = v[2].Float;
+    c.cameraSettings.tiltMax = v[3].Float;
+    c.cameraSettings.tiltMin = v[4].Float;
+}
+
+inline void decodeMediaState(const ARCONTROLLER_DICTIONARY_VALUE_t *v, DecodedCommand &c)
+{
+    c.mediaState = MediaStateTelemetry();
+    c.mediaState.timestampNs = c.timestampNs;
+    c.mediaState.state = v[0].I32;
+    c.mediaState.error = v[1].I32;
+}
+
+inline void decodeVideoEnable(const ARCONTROLLER_DICTIONARY_VALUE_t *v, DecodedCommand &c)
+{
+    c.mediaState = MediaStateTelemetry();
+    c.mediaState.timestampNs = c.timestampNs;
+    c.mediaState.state = v[0].I32;
+}
+
+inline void decodeMoveByEnd(const ARCONTROLLER_DICTIONARY_VALUE_t *v, DecodedCommand &c)
+{
+    c.moveByEnd = MoveByEndTelemetry();
+    c.moveByEnd.timestampNs = c.timestampNs;
+    c.moveByEnd.dX    = v[0].Float;
+    c.moveByEnd.dY    = v[1].Float;
+    c.moveByEnd.dZ    = v[2].Float;
+    c.moveByEnd.dPsi  = v[3].Float;
+    c.moveByEnd.error = v[4].I32;
+}
+
+/// Describe one command
+/// @returns the descriptor
+constexpr CommandDescriptor describeCommand(eARCONTROLLER_DICTIONARY_KEY key, CommandDecoder decode, const char *a0,
+                                           const char *a1 = nullptr, const char *a2 = nullptr,
+                                           const char *a3 = nullptr, const char *a4 = nullptr)
+{
+    CommandDescriptor descriptor{};
+    descriptor.key    = key;
+    descriptor.decode = decode;
+    const char *names[MAX_COMMAND_ARGUMENTS] = { a0, a1, a2, a3, a4 };
+    for (unsigned i = 0; i < MAX_COMMAND_ARGUMENTS && names[i]; i++) {
+        descriptor.arguments[i] = names[i];
+        descriptor.numArguments = i + 1;
+    }
+    return descriptor;
+}
+
+/// Build the command table at compile time. Adding a command takes a CommandType, a decoder and a line here.
+/// @returns the table
+constexpr CommandTable makeCommandTable()
+{
+    CommandTable table{};
+    auto &d = table.descriptors;
+    d[static_cast<unsigned>(CommandType::BATTERY)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_COMMON_COMMONSTATE_BATTERYSTATECHANGED, decodeBattery,
+        ARCONTROLLER_DICTIONARY_KEY_COMMON_COMMONSTATE_BATTERYSTATECHANGED_PERCENT);
+    d[static_cast<unsigned>(CommandType::FLYING_STATE)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED, decodeFlyingState,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE);
+    d[static_cast<unsigned>(CommandType::ATTITUDE)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED, decodeAttitude,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED_ROLL,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED_PITCH,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED_YAW);
+    d[static_cast<unsigned>(CommandType::POSITION)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED, decodePosition,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED_LATITUDE,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED_LONGITUDE,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED_ALTITUDE);
+    d[static_cast<unsigned>(CommandType::SPEED)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED, decodeSpeed,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED_SPEEDX,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED_SPEEDY,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED_SPEEDZ);
+    d[static_cast<unsigned>(CommandType::ALTITUDE)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ALTITUDECHANGED, decodeAltitude,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ALTITUDECHANGED_ALTITUDE);
+    d[static_cast<unsigned>(CommandType::CAMERA_ORIENTATION)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_CAMERASTATE_ORIENTATIONV2, decodeCameraOrientation,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_CAMERASTATE_ORIENTATIONV2_TILT,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_CAMERASTATE_ORIENTATIONV2_PAN);
+    d[static_cast<unsigned>(CommandType::CAMERA_SETTINGS)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED, decodeCameraSettings,
+        ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_FOV,
+        ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_PANMAX,
+        ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_PANMIN,
+        ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_TILTMAX,
+        ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_TILTMIN);
+    d[static_cast<unsigned>(CommandType::PICTURE_STATE)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDSTATE_PICTURESTATECHANGEDV2, decodeMediaState,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDSTATE_PICTURESTATECHANGEDV2_STATE,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDSTATE_PICTURESTATECHANGEDV2_ERROR);
+    d[static_cast<unsigned>(CommandType::VIDEO_STATE)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDSTATE_VIDEOSTATECHANGEDV2, decodeMediaState,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDSTATE_VIDEOSTATECHANGEDV2_STATE,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDSTATE_VIDEOSTATECHANGEDV2_ERROR);
+    d[static_cast<unsigned>(CommandType::PICTURE_EVENT)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDEVENT_PICTUREEVENTCHANGED, decodeMediaState,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDEVENT_PICTUREEVENTCHANGED_EVENT,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDEVENT_PICTUREEVENTCHANGED_ERROR);
+    d[static_cast<unsigned>(CommandType::VIDEO_ENABLE)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIASTREAMINGSTATE_VIDEOENABLECHANGED, decodeVideoEnable,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIASTREAMINGSTATE_VIDEOENABLECHANGED_ENABLED);
+    d[static_cast<unsigned>(CommandType::MOVE_BY_END)] = describeCommand(
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND, decodeMoveByEnd,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_DX,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_DY,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_DZ,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_DPSI,
+        ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_ERROR);
+
+    for (unsigned type = 1; type < static_cast<unsigned>(CommandType::COUNT); type++) {
+        if (d[type].key < ARCONTROLLER_DICTIONARY_KEY_MAX) { table.types[d[type].key] = static_cast<CommandType>(type); }
+    }
+    return table;
+}
+
+/// Get the command table, built at compile time
+/// @returns the table
+inline const CommandTable &commandTable()
+{
+    static constexpr CommandTable TABLE = makeCommandTable();
+    return TABLE;
+}
+
+/// Look up one argument, trying the position it is expected at before hashing its name
+/// @param arguments the argument table
+/// @param position the argument visited at this position of the table, advanced past it
+/// @param name the argument name
+/// @returns the argument, nullptr if it is missing
+inline ARCONTROLLER_DICTIONARY_ARG_t *findArgument(ARCONTROLLER_DICTIONARY_ARG_t *arguments,
+                                                   ARCONTROLLER_DICTIONARY_ARG_t *&position, const char *name)
+{
+    // ARSDK adds the arguments in protocol order, which is also the table order, so the next entry
+    // of the uthash list is normally the one wanted and a string compare replaces the hash lookup
+    if (position && (position->argument == name || std::strcmp(position->argument, name) == 0)) {
+        ARCONTROLLER_DICTIONARY_ARG_t *found = position;
+        position = static_cast<ARCONTROLLER_DICTIONARY_ARG_t *>(position->hh.next);
+        return found;
+    }
+    ARCONTROLLER_DICTIONARY_ARG_t *found = nullptr;
+    HASH_FIND_STR(arguments, name, found);
+    if (found) { position = static_cast<ARCONTROLLER_DICTIONARY_ARG_t *>(found->hh.next); }
+    return found;
+}
+
+} // detail
+
+/// A table driven dispatcher of ARSDK commands to any number of subscribers per command.
+/// @details Each received command is looked up by key in a table built at compile time, its arguments
+/// are decoded once into a DecodedCommand and every subscriber of the command receives the same typed
+/// value, instead of each callback searching the ARSDK dictionary and converting the arguments itself.
+/// Subscribing and unsubscribing copy the subscriber list of the command and publish the copy with one
+/// atomic store, so the ARSDK command thread never takes a lock; the old list is freed once every
+/// dispatch that could still be reading it has finished. attach() adds the dispatcher's callback to a
+/// DroneController next to the library's own callbacks. A user command callback can also forward to
+/// onCommandReceived() instead.
+class CommandDispatcher {
+public:
+    CommandDispatcher()
+    {
+        for (auto &list : m_subscribers) { list.store(new SubscriberList()); }
+    }
+
+    ~CommandDispatcher()
+    {
+        for (auto &list : m_subscribers) { delete list.load(); }
+    }
+
+    CommandDispatcher(const CommandDispatcher &) = delete;
+    CommandDispatcher &operator=(const CommandDispatcher &) = delete;
+
+    /// Register the dispatcher's command callback with a DroneController. The dispatcher must outlive the
+    /// controller's command stream.
+    /// @param droneController smart pointer to the controller to listen to
+    void attach(std::shared_ptr<DroneController> droneController)
+    {
+        droneController->registerCommandReceivedCallback(m_onCommandReceivedDefault, this);
+    }
+
+    /// Register the dispatcher's command callback with a DroneTransport, e.g. a SimulatedDrone
+    /// @param transport smart pointer to the transport to listen to
+    void attach(std::shared_ptr<DroneTransport> transport)
+    {
+        transport->registerCommandReceivedCallback(m_onCommandReceivedDefault, this);
+    }
+
+    /// Subscribe to one type of command. Safe to call from any thread, except from inside a callback.
+    /// @param type the command type, CommandType::UNKNOWN for every command without a decoder
+    /// @param callback function invoked on the ARSDK command thread with each decoded command
+    /// @param customData pointer passed back to the callback
+    void subscribe(CommandType type, DecodedCommandCallback callback, void *customData)
+    {
+        m_update(m_slot(type), callback, customData, true);
+    }
+
+    /// Subscribe to every command, decoded or not
+    /// @param callback function invoked on the ARSDK command thread with each command
+    /// @param customData pointer passed back to the callback
+    void subscribeAll(DecodedCommandCallback callback, void *customData)
+    {
+        m_update(ALL_SLOT, callback, customData, true);
+    }
+
+    /// Remove a subscription made with subscribe(). When this returns the callback is no longer running
+    /// and will not be called again, so customData may be destroyed. Must not be called from inside a callback.
+    /// @param type the command type it was subscribed to
+    /// @param callback the callback
+    /// @param customData the custom data it was subscribed with
+    void unsubscribe(CommandType type, DecodedCommandCallback callback, void *customData)
+    {
+        m_update(m_slot(type), callback, customData, false);
+    }
+
+    /// Remove a subscription made with subscribeAll()
+    /// @param callback the callback
+    /// @param customData the custom data it was subscribed with
+    void unsubscribeAll(DecodedCommandCallback callback, void *customData)
+    {
+        m_update(ALL_SLOT, callback, customData, false);
+    }
+
+    /// Decode one received command and invoke its subscribers. Called on the ARSDK command thread.
+    /// @param commandKey the ARSDK command key
+    /// @param elementDictionary the ARSDK argument dictionary
+    void onCommandReceived(eARCONTROLLER_DICTIONARY_KEY commandKey, ARCONTROLLER_DICTIONARY_ELEMENT_t *elementDictionary)
+    {
+        const detail::CommandTable &table = detail::commandTable();
+        DecodedCommand command;
+        command.key  = commandKey;
+        command.type = (commandKey >= 0 && commandKey < ARCONTROLLER_DICTIONARY_KEY_MAX) ? table.types[commandKey]
+                                                                                        : CommandType::UNKNOWN;
+        command.timestampNs = monotonicNanoseconds();
+        command.element     = m_findElement(elementDictionary);
+
+        const unsigned slot = static_cast<unsigned>(command.type);
+        const unsigned epoch = m_epoch.load() & 1;
+        m_readers[epoch].fetch_add(1);
+        const SubscriberList *subscribers = m_subscribers[slot].load();
+        const SubscriberList *all         = m_subscribers[ALL_SLOT].load();
+
+        if (!subscribers->empty() || !all->empty()) {
+            if (command.type != CommandType::UNKNOWN) {
+                // a command without its argument element is delivered as UNKNOWN rather than as zeros
+                if (command.element) { m_decode(table.descriptors[slot], command); }
+                else { command.type = CommandType::UNKNOWN; }
+            }
+            for (const Subscriber &s : *subscribers) { s.callback(command, s.customData); }
+            for (const Subscriber &s : *all) { s.callback(command, s.customData); }
+            m_dispatched.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_readers[epoch].fetch_sub(1);
+    }
+
+    /// Get the number of commands delivered to at least one subscriber
+    /// @returns the count since construction
+    uint64_t getDispatchedCount() const { return m_dispatched.load(std::memory_order_relaxed); }
+
+private:
+    /// One subscription
+    struct Subscriber {
+        DecodedCommandCallback callback;
+        void *customData;
+    };
+    using SubscriberList = std::vector<Subscriber>;
+
+    static constexpr unsigned ALL_SLOT  = static_cast<unsigned>(CommandType::COUNT); ///< slot of subscribeAll()
+    static constexpr unsigned NUM_SLOTS = ALL_SLOT + 1;                               ///< number of subscriber lists
+
+    std::atomic<const SubscriberList *> m_subscribers[NUM_SLOTS]; ///< published subscriber list of each slot
+    std::mutex            m_updateMutex;                          ///< serializes subscription changes
+    std::atomic<unsigned> m_epoch{0};                             ///< selects the reader count new dispatches use
+    std::atomic<unsigned> m_readers[2] {};                        ///< dispatches in progress in each epoch
+    std::atomic<uint64_t> m_dispatched{0};                        ///< commands delivered
+
+    /// Get the slot of a command type
+    static unsigned m_slot(CommandType type)
+    {
+        const unsigned slot = static_cast<unsigned>(type);
+        if (slot >= ALL_SLOT) { throw std::invalid_argument("CommandDispatcher: invalid command type"); }
+        return slot;
+    }
+
+    /// Publish a copy of one subscriber list with a subscription added or removed, then free the old list
+    void m_update(unsigned slot, DecodedCommandCallback callback, void *customData, bool add)
+    {
+        if (!callback) { throw std::invalid_argument("CommandDispatcher: null callback"); }
+        std::lock_guard<std::mutex> lock(m_updateMutex);
+        const SubscriberList *old = m_subscribers[slot].load(std::memory_order_relaxed);
+        SubscriberList *list = new SubscriberList(*old);
+        if (add) {
+            list->push_back(Subscriber{callback, customData});
+        } else {
+            for (auto it = list->begin(); it != list->end(); ++it) {
+                if (it->callback == callback && it->customData == customData) { list->erase(it); break; }
+            }
+        }
+        m_subscribers[slot].store(list);
+        m_synchronize();
+        delete old;
+    }
+
+    /// Wait until every dispatch that started before the call has finished
+    void m_synchronize()
+    {
+        // Flipping the epoch twice, and draining the reader count left behind each time, covers a
+        // dispatch that read the epoch just before a flip but had not yet counted itself in.
+        for (unsigned flip = 0; flip < 2; flip++) {
+            const unsigned previous = m_epoch.fetch_add(1) & 1;
+            while (m_readers[previous].load() != 0) { std::this_thread::yield(); }
+        }
+    }
+
+    /// Find the argument element of a command
+    /// @returns the element, nullptr if it is missing
+    static ARCONTROLLER_DICTIONARY_ELEMENT_t *m_findElement(ARCONTROLLER_DICTIONARY_ELEMENT_t *elementDictionary)
+    {
+        if (!elementDictionary) { return nullptr; }
+        // commands without a list have a single element, which is the head of the dictionary
+        if (elementDictionary->key && std::strcmp(elementDictionary->key, ARCONTROLLER_DICTIONARY_SINGLE_KEY) == 0) {
+            return elementDictionary;
+        }
+        ARCONTROLLER_DICTIONARY_ELEMENT_t *element = nullptr;
+        HASH_FIND_STR(elementDictionary, ARCONTROLLER_DICTIONARY_SINGLE_KEY, element);
+        return element;
+    }
+
+    /// Gather the arguments of a command in table order and decode them
+    static void m_decode(const detail::CommandDescriptor &descriptor, DecodedCommand &command)
+    {
+        ARCONTROLLER_DICTIONARY_VALUE_t values[detail::MAX_COMMAND_ARGUMENTS];
+        std::memset(values, 0, sizeof(values));
+        ARCONTROLLER_DICTIONARY_ARG_t *arguments = command.element->arguments;
+        ARCONTROLLER_DICTIONARY_ARG_t *position  = arguments;
+        for (unsigned i = 0; i < descriptor.numArguments; i++) {
+            ARCONTROLLER_DICTIONARY_ARG_t *arg = detail::findArgument(arguments, position, descriptor.arguments[i]);
+            if (arg) { values[i] = arg->value; }
+        }
+        descriptor.decode(values, command);
+    }
+
+    /// Command callback registered by attach()
+    /// @param commandKey the ARSDK command key
+    /// @param elementDictionary the ARSDK argument dictionary
+    /// @param customData a pointer to an instance of CommandDispatcher
+    static void m_onCommandReceivedDefault(eARCONTROLLER_DICTIONARY_KEY commandKey,
+                                           ARCONTROLLER_DICTIONARY_ELEMENT_t *elementDictionary, void *customData)
+    {
+        CommandDispatcher *dispatcher = static_cast<CommandDispatcher *>(customData);
+        if (dispatcher) { dispatcher->onCommandReceived(commandKey, elementDictionary); }
+    }
+};
+
+} // wscDrone
+
+#endif /* COMMANDDISPATCHER_H_ */
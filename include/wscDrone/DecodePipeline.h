@@ -0,0 +1,1087 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the DecodePipeline class which moves H.264 decoding
+ * off the ARSDK stream callback thread onto a dedicated decode thread.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef DECODEPIPELINE_H_
+#define DECODEPIPELINE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DecodeWorkerPool.h"
+#include "DroneTransport.h"
+#include "FrameOutputs.h"
+#include "FramePool.h"
+#include "H264Decoder.h"
+#include "LatencyHistogram.h"
+#include "SeqLock.h"
+#include "SharedMemoryFrame.h"
+#include "SpscQueue.h"
+#include "TripleBufferFrame.h"
+#include "Utils.h"
+#include "VideoDriver.h"
+
+namespace wscDrone {
+
+/// What to do with incoming compressed frames when the decode queue is full
+enum class OverflowPolicy : unsigned {
+    DROP_OLDEST    = 0, ///< discard the oldest queued frame to make room for the new one, decoding then resumes at the next I-frame
+    DROP_UNTIL_IDR = 1  ///< discard the new frame and every frame after it until the next I-frame
+};
+
+/// A compressed H.264 frame copied out of the ARSDK receive buffer
+struct CompressedFrame {
+    std::vector<uint8_t> data;       ///< the H.264 access unit
+    bool     isIFrame   = false;     ///< true when the drone flagged this frame as an I-frame
+    uint64_t sequence   = 0;         ///< receive-order sequence number
+    uint64_t receivedNs = 0;         ///< monotonic time the ARSDK callback received the frame
+};
+
+/// How a DecodePipeline sheds decode work when the ground station cannot keep up
+struct AdaptiveDecodeOptions {
+    double   targetFps     = 0.0;   ///< most frames per second to publish, 0 for no limit. Excess frames are shed before decode.
+    bool     adaptive      = false; ///< lower the DecodeQuality under overload and raise it again once the load falls
+    DecodeQuality lowestQuality = DecodeQuality::IDR_ONLY; ///< the lowest level adaptive decode steps down to
+    double   overloadLoad  = 0.9;   ///< step down when decode time exceeds this fraction of the frame interval
+    double   recoverLoad   = 0.5;   ///< step up when decode time is below this fraction of the frame interval
+    unsigned holdFrames    = 30;    ///< frames to stay at a level before stepping up, doubled each time it has to step back down
+};
+
+/// alias for the callback invoked on the decode thread with each decoded frame
+using DecodedFrameCallback = void (*)(const FrameRef &frame, void *customData);
+
+/// Monotonic timestamps of one frame through the pipeline, from monotonicNanoseconds()
+struct FrameTimestamps {
+    uint64_t sequence      = 0;     ///< receive sequence number, which is also the decode order
+    uint64_t receivedNs    = 0;     ///< the ARSDK callback received the compressed frame
+    uint64_t decodeStartNs = 0;     ///< the frame was submitted to the decoder
+    uint64_t decodeEndNs   = 0;     ///< the decoded picture was available
+    uint64_t convertEndNs  = 0;     ///< colour conversion finished, decodeEndNs if nothing was converted
+    uint64_t publishNs     = 0;     ///< the frame was in the VideoFrame and passed to the callback
+    bool     isIFrame      = false; ///< true when the drone flagged the frame as an I-frame
+};
+
+/// alias for the callback invoked on the decode thread with the timestamps of each published frame
+using FrameTimestampsCallback = void (*)(const FrameTimestamps &timestamps, void *customData);
+
+/// Pipeline stages with a latency histogram
+enum class LatencyStage : unsigned {
+    QUEUE_WAIT = 0, ///< ARSDK receive to decode start
+    DECODE     = 1, ///< decode start to the decoded picture being available
+    CONVERT    = 2, ///< decoded picture to the end of colour conversion
+    PUBLISH    = 3, ///< decoded picture to the frame being in the VideoFrame and passed to the callback
+    TOTAL      = 4, ///< ARSDK receive to the frame being in the VideoFrame
+    COUNT      = 5  ///< number of stages
+};
+
+/// Get the name of a latency stage as used in exported metrics
+/// @param stage the stage
+/// @returns the name, e.g. "queue_wait"
+inline const char *latencyStageName(LatencyStage stage)
+{
+    switch (stage) {
+    case LatencyStage::QUEUE_WAIT : return "queue_wait";
+    case LatencyStage::DECODE     : return "decode";
+    case LatencyStage::CONVERT    : return "convert";
+    case LatencyStage::PUBLISH    : return "publish";
+    case LatencyStage::TOTAL      : return "total";
+    default                       : return "unknown";
+    }
+}
+
+/// Latency counters for one pipeline stage
+struct StageLatency {
+    uint64_t count   = 0; ///< number of samples
+    uint64_t totalNs = 0; ///< sum of all samples in nanoseconds
+    uint64_t maxNs   = 0; ///< largest sample in nanoseconds
+
+    /// Get the mean latency
+    /// @returns the mean in microseconds, 0 when there are no samples
+    double meanMicroseconds() const { return count ? (totalNs / 1000.0) / count : 0.0; }
+};
+
+/// A snapshot of the DecodePipeline counters
+struct DecodePipelineStats {
+    uint64_t framesReceived = 0;  ///< frames delivered by the ARSDK callback
+    uint64_t bytesReceived  = 0;  ///< compressed bytes delivered by the ARSDK callback
+    uint64_t framesDecoded  = 0;  ///< frames successfully decoded and published
+    uint64_t framesDropped  = 0;  ///< frames discarded because the queue was full
+    uint64_t framesSkipped  = 0;  ///< frames discarded while waiting for an I-frame
+    uint64_t decodeErrors   = 0;  ///< frames the decoder rejected
+    uint64_t poolExhausted  = 0;  ///< frames or FrameOutputSet outputs lost because a FramePool was empty
+    uint64_t poolTooSmall   = 0;  ///< frames lost because the FramePool's frames are smaller than the output
+    uint64_t framesShed     = 0;  ///< frames not decoded because of the DecodeQuality or a resync
+    uint64_t framesThrottled = 0; ///< frames not published because of the target frame rate
+    DecodeQuality quality   = DecodeQuality::FULL; ///< current decode quality
+    size_t   queueDepth     = 0;  ///< compressed frames currently queued
+    size_t   queueHighWater = 0;  ///< deepest the queue has been
+    size_t   queueCapacity  = 0;  ///< maximum number of queued frames
+    uint64_t lastFrameNs    = 0;  ///< monotonic time the last frame was published, 0 before the first
+    uint64_t startNs        = 0;  ///< monotonic time of the last start(), 0 before it
+    uint64_t firstFrameNs   = 0;  ///< monotonic time the first frame after start() was published, 0 before it
+    StageLatency queueWait;       ///< ARSDK receive to decode start
+    StageLatency decode;          ///< decode start to the decoded picture being available
+    StageLatency publish;         ///< colour conversion and hand-off to the VideoFrame and callback
+    StageLatency total;           ///< ARSDK receive to the frame being available in the VideoFrame
+};
+
+/// The counters and latency histograms of one DecodePipeline, for export
+struct DecodePipelineMetrics {
+    std::string         stream; ///< label identifying the stream, e.g. the drone IP address
+    DecodePipelineStats stats;  ///< the counters
+    LatencyHistogramSnapshot latency[static_cast<unsigned>(LatencyStage::COUNT)]; ///< histograms by LatencyStage
+};
+
+/// The DecodePipeline takes over the video callbacks of a VideoDriver. The ARSDK stream thread only
+/// copies each compressed frame into a bounded lock-free queue, and a dedicated thread performs the
+/// decode, colour conversion and VideoFrame update. A decode stall therefore no longer stalls the
+/// ARSDK reader; instead the configured OverflowPolicy decides which frames are lost.
+/// @details Decoding uses the pipeline's own multi-threaded H264Decoder rather than the VideoDriver's
+/// inherited bebop_driver::VideoDecoder, and colour conversion writes straight into the destination
+/// buffers. The pipeline must outlive the video stream. Call VideoDriver::stop() before destroying it.
+/// When a DecodeWorkerPool is set the pipeline has no thread of its own and is decoded by the pool.
+/// Every frame is timestamped at receive, decode start and end, colour conversion and publish. The
+/// latencies feed lock-free histograms that can be read at any time or exported with dumpMetrics();
+/// the cost is a few clock reads and relaxed atomic adds per frame.
+/// Under overload, setAdaptiveDecode() makes the pipeline drop work before it is done rather than
+/// after: frames over the target frame rate are not decoded, or decoded but not converted when later
+/// frames refer to them, and the DecodeQuality steps down as far as decoding only I-frames. Whenever
+/// a reference frame is lost the decoder waits for the next I-frame, so it resyncs without artifacts.
+class DecodePipeline : public DecodeWorkerStream {
+public:
+    DecodePipeline() = delete;
+
+    /// Construct a pipeline for the specified VideoDriver
+    /// @param videoDriver smart pointer to the VideoDriver whose frames should be decoded
+    /// @param queueDepth maximum number of compressed frames waiting for the decoder
+    /// @param policy what to do when the queue is full
+    /// @param decoderOptions threading and latency options for the H.264 decoder
+    DecodePipeline(std::shared_ptr<VideoDriver> videoDriver, size_t queueDepth = 8,
+                   OverflowPolicy policy = OverflowPolicy::DROP_OLDEST,
+                   const DecoderOptions &decoderOptions = DecoderOptions())
+        : DecodePipeline(std::make_shared<ArsdkTransport>(nullptr, videoDriver, nullptr), queueDepth, policy,
+                         decoderOptions) {}
+
+    /// Construct a pipeline for the video of a DroneTransport, e.g. a SimulatedDrone
+    /// @param transport smart pointer to the transport whose frames should be decoded
+    /// @param queueDepth maximum number of compressed frames waiting for the decoder
+    /// @param policy what to do when the queue is full
+    /// @param decoderOptions threading and latency options for the H.264 decoder
+    DecodePipeline(std::shared_ptr<DroneTransport> transport, size_t queueDepth = 8,
+                   OverflowPolicy policy = OverflowPolicy::DROP_OLDEST,
+                   const DecoderOptions &decoderOptions = DecoderOptions())
+        : m_transport(transport), m_queue(queueDepth), m_policy(policy), m_decoder(decoderOptions) {}
+
+    /// Stops the decode thread
+    ~DecodePipeline() override { stop(); }
+
+    DecodePipeline(const DecodePipeline &) = delete;
+    DecodePipeline &operator=(const DecodePipeline &) = delete;
+
+    /// Start the decode thread, or attach to the worker pool, and register the pipeline callbacks with
+    /// the VideoDriver. This replaces the VideoDriver default video callbacks.
+    void start()
+    {
+        if (m_running.exchange(true)) { return; }
+        m_firstFrameNs.store(0, std::memory_order_relaxed);
+        m_startNs.store(monotonicNanoseconds(), std::memory_order_relaxed);
+        m_deferConversion = m_workerPool && m_workerPool->isBatchingConversion();
+        if (m_workerPool) {
+            m_workerPool->attach(this);
+            // open the decoder with any configuration given to setDecoderConfig() before frames arrive
+            if (m_configPending.load()) { m_wake(); }
+        } else {
+            m_decodeThread = std::thread(&DecodePipeline::m_decodeLoop, this);
+        }
+        m_transport->registerVideoCallback(m_decoderConfigCallDefault, m_onFrameReceivedDefault, this);
+    }
+
+    /// Stop the decode thread, or detach from the worker pool. Frames received while stopped are ignored.
+    void stop()
+    {
+        if (!m_running.exchange(false)) { return; }
+        if (m_workerPool) {
+            m_workerPool->detach(this);
+            m_deferConversion = false;
+            if (m_pictureParked) {
+                m_pictureParked = false;
+                m_publishPicture(m_parkedTimestamps);
+            }
+            m_decoder.flush();
+            m_drainDecoder();
+            return;
+        }
+        m_wake();
+        if (m_decodeThread.joinable()) { m_decodeThread.join(); }
+    }
+
+    /// Prime the decoder with SPS/PPS known ahead of the stream, e.g. cached from an earlier connection to
+    /// the same drone. The decoder is opened with them as soon as the pipeline starts, so the first I-frame
+    /// decodes without waiting for the drone's configuration. Parameters received from the drone replace
+    /// them and reopen the decoder only if they differ.
+    /// @param sps SPS NAL unit including its start code
+    /// @param pps PPS NAL unit including its start code
+    void setDecoderConfig(const std::vector<uint8_t> &sps, const std::vector<uint8_t> &pps)
+    {
+        if (sps.empty() || pps.empty()) { return; }
+        {
+            std::lock_guard<std::mutex> lck(m_configMutex);
+            m_sps = sps;
+            m_pps = pps;
+        }
+        m_configPending = true;
+        if (m_running.load()) { m_wake(); }
+    }
+
+    /// Get the SPS/PPS last received from the drone, e.g. to cache them for the next connection
+    /// @param sps receives the SPS NAL unit including its start code
+    /// @param pps receives the PPS NAL unit including its start code
+    /// @returns the number of configurations received from the drone, 0 if none has been and sps and pps
+    /// are left unchanged
+    uint64_t getDecoderConfig(std::vector<uint8_t> &sps, std::vector<uint8_t> &pps)
+    {
+        std::lock_guard<std::mutex> lck(m_configMutex);
+        if (m_configsReceived == 0) { return 0; }
+        sps = m_sps;
+        pps = m_pps;
+        return m_configsReceived;
+    }
+
+    /// Decode on a shared DecodeWorkerPool instead of a dedicated thread. Call before start(). Pair it
+    /// with DecoderOptions::threadCount = 1 so the thread count does not grow with the number of streams.
+    /// When the pool batches conversion, each decoded picture is converted and published by the pool in
+    /// a batch with other streams' pictures. Use setDecodePriority() to favour a lead drone.
+    /// @param workerPool smart pointer to the pool, nullptr for a dedicated thread
+    void setWorkerPool(std::shared_ptr<DecodeWorkerPool> workerPool) { m_workerPool = workerPool; }
+
+    /// Get a smart pointer to the worker pool
+    /// @returns smart pointer to the DecodeWorkerPool, nullptr when using a dedicated thread
+    std::shared_ptr<DecodeWorkerPool> getWorkerPool() { return m_workerPool; }
+
+    /// Decode queued frames on a DecodeWorkerPool thread. Not for direct use.
+    /// @param maxFrames the most frames to decode before yielding the thread
+    /// @returns true when more work is queued
+    bool service(unsigned maxFrames) override
+    {
+        m_applyDecoderConfig();
+        CompressedFrame &work = m_poolWork;
+        for (unsigned i = 0; i < maxFrames; i++) {
+            if (!m_decodeNext(work)) { return false; }
+            if (m_pictureParked) { return true; }
+        }
+        return m_queue.size() > 0 || m_configPending.load();
+    }
+
+    /// Convert and publish the picture service() handed to the pool, then carry on with any further
+    /// pictures the decoder has ready. Runs on a DecodeWorkerPool thread. Not for direct use.
+    /// @returns true when more work is queued
+    bool convert() override
+    {
+        if (m_pictureParked) {
+            const uint64_t startNs = monotonicNanoseconds();
+            m_pictureParked = false;
+            m_publishPicture(m_parkedTimestamps);
+            m_drainDecoder();
+            m_convertBusyNs += monotonicNanoseconds() - startNs;
+        }
+        return m_queue.size() > 0 || m_configPending.load();
+    }
+
+    /// Check if the decode thread is running
+    /// @returns true when running
+    bool isRunning() { return m_running.load(); }
+
+    /// Change the overflow policy. Takes effect on the next received frame.
+    /// @param policy the new policy
+    void setOverflowPolicy(OverflowPolicy policy) { m_policy.store(policy); }
+
+    /// Get the current overflow policy
+    /// @returns the overflow policy
+    OverflowPolicy getOverflowPolicy() { return m_policy.load(); }
+
+    /// Select the pixel format of pooled frames and of a plain VideoFrame. A plain VideoFrame receives the
+    /// planes back to back as getPlaneLayout() describes and must be large enough to hold them. A
+    /// TripleBufferFrame always receives its own format. Takes effect on the next decoded frame.
+    /// @param format the output pixel format, RGB24 by default
+    void setOutputFormat(PixelFormat format) { m_outputFormat.store(format); }
+
+    /// Get the output pixel format
+    /// @returns the output pixel format
+    PixelFormat getOutputFormat() { return m_outputFormat.load(); }
+
+    /// Downscale pooled frames by an integer factor. 2 and 4 are fused into the SIMD colour conversion for
+    /// packed RGB formats, other factors go through swscale. VideoFrames always receive their own size.
+    /// Takes effect on the next decoded frame.
+    /// @param scale divisor applied to the decoded width and height, 1 by default
+    void setOutputScale(unsigned scale) { m_outputScale.store(scale > 0 ? scale : 1); }
+
+    /// Get the downscale factor of pooled frames
+    /// @returns the downscale factor
+    unsigned getOutputScale() { return m_outputScale.load(); }
+
+    /// Configure frame rate limiting and adaptive decode quality. Call before start().
+    /// @param options the adaptive decode configuration
+    void setAdaptiveDecode(const AdaptiveDecodeOptions &options) { m_adaptiveOptions = options; }
+
+    /// Get the adaptive decode configuration
+    /// @returns the options
+    AdaptiveDecodeOptions getAdaptiveDecode() { return m_adaptiveOptions; }
+
+    /// Change the decode quality. With adaptive decode this is the level it starts from. Safe to call from
+    /// any thread, takes effect on the next decoded frame.
+    /// @param quality the new level
+    void setDecodeQuality(DecodeQuality quality)
+    {
+        m_quality.store(quality);
+        m_qualityPending = true;
+    }
+
+    /// Get the decode quality
+    /// @returns the current level
+    DecodeQuality getDecodeQuality() { return m_quality.load(); }
+
+    /// Set the pool that decoded frames are copied into for the decoded frame callback. Call before start().
+    /// Frames the pool is too small for, such as RGBA output into a pool of 3 bytes per pixel, are counted
+    /// in DecodePipelineStats::poolTooSmall.
+    /// @param framePool smart pointer to a FramePool sized for the stream and output format
+    void setFramePool(std::shared_ptr<FramePool> framePool) { m_framePool = framePool; }
+
+    /// Get a smart pointer to the FramePool used for decoded frames
+    /// @returns smart pointer to the FramePool, nullptr if none is set
+    std::shared_ptr<FramePool> getFramePool() { return m_framePool; }
+
+    /// Register a callback to receive every decoded frame as a FrameRef. The callback runs on the decode
+    /// thread and may keep copies of the handle for as long as it likes. Requires a FramePool. Call
+    /// before start().
+    /// @param callback the function to execute for each decoded frame
+    /// @param customData a raw pointer passed back to the callback
+    void registerDecodedFrameCallback(const DecodedFrameCallback &callback, void *customData)
+    {
+        m_frameCallback   = callback;
+        m_frameCustomData = customData;
+    }
+
+    /// Produce region of interest crops and pyramid levels from every decoded frame. Call before start().
+    /// @param frameOutputs smart pointer to the output set, which the application keeps to move its regions
+    void setFrameOutputs(std::shared_ptr<FrameOutputSet> frameOutputs) { m_frameOutputs = frameOutputs; }
+
+    /// Get a smart pointer to the output set
+    /// @returns smart pointer to the FrameOutputSet, nullptr if none is set
+    std::shared_ptr<FrameOutputSet> getFrameOutputs() { return m_frameOutputs; }
+
+    /// Register a callback to receive the outputs of the FrameOutputSet for every decoded frame. The
+    /// callback runs on the decode thread and may keep copies of the handles. Call before start().
+    /// @param callback the function to execute for each decoded frame
+    /// @param customData a raw pointer passed back to the callback
+    void registerFrameOutputsCallback(const FrameOutputsCallback &callback, void *customData)
+    {
+        m_outputsCallback   = callback;
+        m_outputsCustomData = customData;
+    }
+
+    /// Register a callback to receive the timestamps of every published frame. The callback runs on the
+    /// decode thread and must be quick. Call before start().
+    /// @param callback the function to execute for each frame
+    /// @param customData a raw pointer passed back to the callback
+    void registerFrameTimestampsCallback(const FrameTimestampsCallback &callback, void *customData)
+    {
+        m_timestampsCallback   = callback;
+        m_timestampsCustomData = customData;
+    }
+
+    /// Get the timestamps of the most recently published frame. Safe to call from any thread.
+    /// @returns the timestamps, all zero before the first frame
+    FrameTimestamps getLastFrameTimestamps() const { return m_lastTimestamps.load(); }
+
+    /// Get a copy of one latency histogram. Safe to call from any thread.
+    /// @param stage the pipeline stage
+    /// @returns the histogram
+    LatencyHistogramSnapshot getLatencyHistogram(LatencyStage stage) const
+    {
+        return m_latency[static_cast<unsigned>(stage) % LATENCY_STAGES].snapshot();
+    }
+
+    /// Get the counters and every latency histogram. Safe to call from any thread.
+    /// @param stream label identifying the stream in exported metrics
+    /// @returns the metrics
+    DecodePipelineMetrics getMetrics(const std::string &stream = "")
+    {
+        DecodePipelineMetrics metrics;
+        metrics.stream = stream;
+        metrics.stats  = getStats();
+        for (unsigned i = 0; i < LATENCY_STAGES; i++) { metrics.latency[i] = m_latency[i].snapshot(); }
+        return metrics;
+    }
+
+    /// Get the counters and latency histograms in the Prometheus text format
+    /// @param stream label identifying the stream
+    /// @returns the metrics text
+    std::string dumpMetrics(const std::string &stream = "");
+
+    /// Get a snapshot of the pipeline counters. Safe to call from any thread.
+    /// @returns the current counters
+    DecodePipelineStats getStats()
+    {
+        DecodePipelineStats stats;
+        stats.framesReceived = m_framesReceived.load(std::memory_order_relaxed);
+        stats.bytesReceived  = m_bytesReceived.load(std::memory_order_relaxed);
+        stats.framesDecoded  = m_framesDecoded.load(std::memory_order_relaxed);
+        stats.framesDropped  = m_framesDropped.load(std::memory_order_relaxed);
+        stats.framesSkipped  = m_framesSkipped.load(std::memory_order_relaxed);
+        stats.decodeErrors   = m_decodeErrors.load(std::memory_order_relaxed);
+        stats.poolExhausted  = m_poolExhausted.load(std::memory_order_relaxed);
+        stats.poolTooSmall   = m_poolTooSmall.load(std::memory_order_relaxed);
+        stats.framesShed     = m_framesShed.load(std::memory_order_relaxed);
+        stats.framesThrottled = m_framesThrottled.load(std::memory_order_relaxed);
+        stats.quality        = m_quality.load(std::memory_order_relaxed);
+        stats.queueDepth     = m_queue.size();
+        stats.queueHighWater = m_queueHighWater.load(std::memory_order_relaxed);
+        stats.queueCapacity  = m_queue.capacity();
+        stats.lastFrameNs    = m_lastFrameNs.load(std::memory_order_relaxed);
+        stats.startNs        = m_startNs.load(std::memory_order_relaxed);
+        stats.firstFrameNs   = m_firstFrameNs.load(std::memory_order_relaxed);
+        stats.queueWait      = m_stageLatency(LatencyStage::QUEUE_WAIT);
+        stats.decode         = m_stageLatency(LatencyStage::DECODE);
+        stats.publish        = m_stageLatency(LatencyStage::PUBLISH);
+        stats.total          = m_stageLatency(LatencyStage::TOTAL);
+        return stats;
+    }
+
+    /// Reset all counters to zero
+    void resetStats()
+    {
+        m_framesReceived = 0;
+        m_bytesReceived  = 0;
+        m_framesDecoded  = 0;
+        m_framesDropped  = 0;
+        m_framesSkipped  = 0;
+        m_decodeErrors   = 0;
+        m_poolExhausted  = 0;
+        m_poolTooSmall   = 0;
+        m_framesShed     = 0;
+        m_framesThrottled = 0;
+        m_queueHighWater = 0;
+        for (auto &histogram : m_latency) { histogram.reset(); }
+    }
+
+private:
+    /// Number of in-flight packets whose timing is remembered, must exceed the decoder delay
+    static constexpr size_t RECEIVE_HISTORY = 64;
+    static constexpr unsigned LATENCY_STAGES = static_cast<unsigned>(LatencyStage::COUNT);
+    /// Frames at a new quality level before the load is judged again, the settling time of the averages
+    static constexpr unsigned ADAPT_SETTLE_FRAMES = 16;
+    /// Most times holdFrames is doubled
+    static constexpr unsigned MAX_HOLD_MULTIPLIER = 16;
+
+    /// Timing of a packet submitted to the decoder, kept until its picture comes out
+    struct PacketTiming {
+        uint64_t receivedNs    = 0;
+        uint64_t decodeStartNs = 0;
+        bool     isIFrame      = false;
+        bool     publish       = true;  ///< false when only decoded to serve as a reference
+    };
+
+    std::shared_ptr<DroneTransport> m_transport = nullptr; ///< source of the video and owner of the VideoFrame
+    SpscQueue<CompressedFrame>   m_queue;                 ///< compressed frames waiting for the decode thread
+    std::atomic<OverflowPolicy>  m_policy;                ///< current overflow policy
+    std::atomic<bool>            m_running{false};        ///< true while the decode thread should run
+    std::atomic<PixelFormat>     m_outputFormat{PixelFormat::RGB24}; ///< format of pooled frames and plain VideoFrames
+    std::atomic<unsigned>        m_outputScale{1};        ///< downscale factor of pooled frames
+    std::thread                  m_decodeThread;          ///< the decode thread
+    std::shared_ptr<DecodeWorkerPool> m_workerPool = nullptr; ///< shared decode threads used instead of m_decodeThread
+    CompressedFrame              m_poolWork;              ///< frame being decoded by a pool thread
+    H264Decoder                  m_decoder;               ///< decoder, only touched by the decode thread
+    std::vector<uint8_t>         m_scratch;               ///< conversion target for VideoFrames updated under the mutex
+    PacketTiming                 m_packetTiming[RECEIVE_HISTORY]; ///< timing of recent packets by sequence
+    std::shared_ptr<FramePool>   m_framePool = nullptr;   ///< pool for frames handed to m_frameCallback
+    DecodedFrameCallback         m_frameCallback = nullptr; ///< user callback for decoded frames
+    void                        *m_frameCustomData = nullptr; ///< user data for m_frameCallback
+    std::shared_ptr<FrameOutputSet> m_frameOutputs = nullptr; ///< crops and pyramid levels handed to m_outputsCallback
+    FrameOutputs                 m_outputs;               ///< outputs of the frame being published
+    FrameOutputsCallback         m_outputsCallback = nullptr; ///< user callback for the frame outputs
+    void                        *m_outputsCustomData = nullptr; ///< user data for m_outputsCallback
+    FrameTimestampsCallback      m_timestampsCallback = nullptr; ///< user callback for frame timestamps
+    void                        *m_timestampsCustomData = nullptr; ///< user data for m_timestampsCallback
+    SeqLock<FrameTimestamps>     m_lastTimestamps;        ///< timestamps of the last published frame
+    bool                         m_deferConversion = false; ///< hand pictures to the pool for batched conversion
+    bool                         m_pictureParked = false; ///< a decoded picture is waiting for convert()
+    FrameTimestamps              m_parkedTimestamps;      ///< timestamps of the waiting picture
+
+    // Adaptive decode state, only touched by the decode thread
+    AdaptiveDecodeOptions m_adaptiveOptions;        ///< configuration
+    std::atomic<DecodeQuality> m_quality{DecodeQuality::FULL}; ///< current decode quality
+    std::atomic<bool> m_qualityPending{false};      ///< setDecodeQuality() was called
+    uint64_t m_expectedSequence = 0;                ///< sequence number of the next frame if none was lost
+    uint64_t m_lastReceivedNs   = 0;                ///< receive time of the previous frame
+    double   m_intervalNs       = 0.0;              ///< average time between received frames
+    double   m_busyNs           = 0.0;              ///< average decode thread time spent per received frame
+    uint64_t m_convertBusyNs    = 0;                ///< conversion time of pool batches not yet averaged in
+    double   m_fpsTokens        = 1.0;              ///< frames the target frame rate allows to be published now
+    unsigned m_framesAtQuality  = 0;                ///< frames since the quality last changed
+    unsigned m_recoverHold      = 0;                ///< frames to wait before stepping up, 0 for holdFrames
+    bool     m_steppedUp        = false;            ///< the last quality change was a step up
+    bool     m_overloaded       = false;            ///< the last frame was judged overloaded
+
+    // Producer (ARSDK thread) state
+    uint64_t m_nextSequence   = 0;     ///< sequence number for the next received frame
+    bool     m_awaitingIFrame = false; ///< true while DROP_UNTIL_IDR is discarding frames
+
+    // SPS/PPS handoff from the ARSDK thread to the decode thread
+    std::mutex           m_configMutex;
+    std::vector<uint8_t> m_sps;
+    std::vector<uint8_t> m_pps;
+    uint64_t             m_configsReceived = 0; ///< configurations received from the drone, under m_configMutex
+    std::atomic<bool>    m_configPending{false};
+
+    // Decode thread wakeup, the producer only takes the lock when the decode thread is asleep
+    std::mutex              m_wakeMutex;
+    std::condition_variable m_wakeCv;
+    std::atomic<bool>       m_consumerWaiting{false};
+
+    std::atomic<uint64_t> m_framesReceived{0};
+    std::atomic<uint64_t> m_bytesReceived{0};
+    std::atomic<uint64_t> m_framesDecoded{0};
+    std::atomic<uint64_t> m_framesDropped{0};
+    std::atomic<uint64_t> m_framesSkipped{0};
+    std::atomic<uint64_t> m_decodeErrors{0};
+    std::atomic<uint64_t> m_poolExhausted{0};
+    std::atomic<uint64_t> m_poolTooSmall{0};
+    std::atomic<uint64_t> m_framesShed{0};
+    std::atomic<uint64_t> m_framesThrottled{0};
+    std::atomic<size_t>   m_queueHighWater{0};
+    std::atomic<uint64_t> m_lastFrameNs{0};
+    std::atomic<uint64_t> m_startNs{0};
+    std::atomic<uint64_t> m_firstFrameNs{0};
+    LatencyHistogram      m_latency[LATENCY_STAGES]; ///< histograms by LatencyStage
+
+    /// Summarise one latency histogram
+    /// @param stage the pipeline stage
+    /// @returns the count, total and maximum
+    StageLatency m_stageLatency(LatencyStage stage) const
+    {
+        const LatencyHistogram &histogram = m_latency[static_cast<unsigned>(stage)];
+        StageLatency latency;
+        latency.count   = histogram.getCount();
+        latency.totalNs = histogram.getTotalNs();
+        latency.maxNs   = histogram.getMaxNs();
+        return latency;
+    }
+
+    /// Record one latency sample
+    /// @param stage the pipeline stage
+    /// @param ns the latency in nanoseconds
+    void m_recordLatency(LatencyStage stage, uint64_t ns) { m_latency[static_cast<unsigned>(stage)].record(ns); }
+
+    /// Wake the decode thread if it is sleeping, or schedule the pipeline on the worker pool
+    void m_wake()
+    {
+        if (m_workerPool) {
+            m_workerPool->schedule(this);
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_consumerWaiting.load(std::memory_order_relaxed) || !m_running.load()) {
+            std::lock_guard<std::mutex> lck(m_wakeMutex);
+            m_wakeCv.notify_one();
+        }
+    }
+
+    /// Queue a received frame according to the overflow policy. Runs on the ARSDK thread.
+    /// @param frame the ARSDK frame
+    void m_enqueue(const ARCONTROLLER_Frame_t *frame)
+    {
+        const uint64_t receivedNs = monotonicNanoseconds();
+        const bool     isIFrame   = frame->isIFrame != 0;
+        m_framesReceived.fetch_add(1, std::memory_order_relaxed);
+        m_bytesReceived.fetch_add(frame->used, std::memory_order_relaxed);
+
+        if (m_awaitingIFrame) {
+            if (!isIFrame) {
+                m_framesSkipped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            m_awaitingIFrame = false;
+        }
+
+        auto fill = [&](CompressedFrame &slot) {
+            slot.data.assign(frame->data, frame->data + frame->used);
+            slot.isIFrame   = isIFrame;
+            slot.sequence   = m_nextSequence;
+            slot.receivedNs = receivedNs;
+        };
+
+        bool queued = m_queue.tryPush(fill);
+        if (!queued) {
+            if (m_policy.load(std::memory_order_relaxed) == OverflowPolicy::DROP_UNTIL_IDR && !isIFrame) {
+                m_awaitingIFrame = true;
+            } else {
+                // Make room by discarding old frames. An I-frame always gets in under DROP_UNTIL_IDR
+                // since it is the resync point. The consumer may briefly hold the slot being
+                // refilled, so give up after a few attempts rather than spin.
+                for (unsigned attempt = 0; attempt < 4 && !queued; attempt++) {
+                    if (m_queue.dropOldest()) {
+                        m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    queued = m_queue.tryPush(fill);
+                }
+            }
+        }
+
+        m_nextSequence++;
+        if (!queued) {
+            m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        size_t depth = m_queue.size();
+        size_t prev  = m_queueHighWater.load(std::memory_order_relaxed);
+        while (depth > prev && !m_queueHighWater.compare_exchange_weak(prev, depth, std::memory_order_relaxed)) {}
+        m_wake();
+    }
+
+    /// Apply any SPS/PPS update received from the drone. Runs on the decode thread.
+    void m_applyDecoderConfig()
+    {
+        if (!m_configPending.exchange(false)) { return; }
+        std::lock_guard<std::mutex> lck(m_configMutex);
+        m_decoder.setH264Params(m_sps.data(), static_cast<uint32_t>(m_sps.size()),
+                                m_pps.data(), static_cast<uint32_t>(m_pps.size()));
+        m_decoder.open();
+    }
+
+    /// Convert the decoded picture into the FramePool frame, the FrameOutputSet outputs and the user
+    /// VideoFrame. Runs on the decode thread.
+    /// @details The picture is converted once, straight into the first destination, and copied to the
+    /// second only when both have the same format and geometry. A TripleBufferFrame or SharedMemoryFrame
+    /// is filled through its write buffer and published without taking the VideoDriver buffer mutex. Any other VideoFrame
+    /// is converted into a scratch buffer and copied under the mutex, keeping the lock hold time short.
+    /// @param sequence receive sequence number of the packet that produced the picture
+    /// @param receivedNs receive time of the packet that produced the picture
+    /// @returns the time the first colour conversion finished, 0 if nothing was converted
+    uint64_t m_publishFrame(uint64_t sequence, uint64_t receivedNs)
+    {
+        uint64_t convertEndNs = 0;
+        const uint8_t *converted = nullptr;
+        PixelFormat convertedFormat = PixelFormat::RGB24;
+        unsigned convertedWidth  = 0;
+        unsigned convertedHeight = 0;
+        auto produce = [&](uint8_t *dst, PixelFormat format, unsigned width, unsigned height) -> bool {
+            if (converted && convertedFormat == format && convertedWidth == width && convertedHeight == height) {
+                std::memcpy(dst, converted, getPlaneLayout(format, width, height).totalBytes);
+                return true;
+            }
+            if (!m_decoder.convertTo(format, dst, width, height)) { return false; }
+            if (!convertEndNs) { convertEndNs = monotonicNanoseconds(); }
+            converted       = dst;
+            convertedFormat = format;
+            convertedWidth  = width;
+            convertedHeight = height;
+            return true;
+        };
+
+        const PixelFormat format = m_outputFormat.load(std::memory_order_relaxed);
+        const unsigned scale  = m_outputScale.load(std::memory_order_relaxed);
+        const unsigned width  = m_decoder.getWidth() / scale;
+        const unsigned height = m_decoder.getHeight() / scale;
+        FrameRef pooled;
+        if (m_framePool && m_frameCallback && width > 0 && height > 0) {
+            if (m_framePool->getFrameSizeBytes() < getPlaneLayout(format, width, height).totalBytes) {
+                // e.g. an RGBA output into a pool sized for fewer bytes per pixel
+                m_poolTooSmall.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                pooled = m_framePool->acquire();
+                if (!pooled) { m_poolExhausted.fetch_add(1, std::memory_order_relaxed); }
+            }
+            if (pooled && produce(pooled.mutableData(), format, width, height)) {
+                pooled.setInfo(width, height, format, sequence, receivedNs);
+                m_frameCallback(pooled, m_frameCustomData);
+            }
+        }
+
+        const AVFrame *picture = m_decoder.getPicture();
+        if (m_frameOutputs && m_outputsCallback && picture) {
+            const unsigned lost = m_frameOutputs->produce(*picture, sequence, receivedNs, m_outputs);
+            if (lost) { m_poolExhausted.fetch_add(lost, std::memory_order_relaxed); }
+            if (!convertEndNs) { convertEndNs = monotonicNanoseconds(); }
+            m_outputsCallback(m_outputs, m_outputsCustomData);
+            m_outputs.reset();
+        }
+
+        std::shared_ptr<VideoFrame> frame = m_transport->getFrame();
+        if (!frame) { return convertEndNs; }
+        const unsigned frameWidth  = frame->getWidth();
+        const unsigned frameHeight = frame->getHeight();
+
+        TripleBufferFrame *tripleBuffer = dynamic_cast<TripleBufferFrame *>(frame.get());
+        if (tripleBuffer) {
+            if (produce(tripleBuffer->getWriteBuffer(), tripleBuffer->getFormat(), frameWidth, frameHeight)) {
+                tripleBuffer->publish(sequence, receivedNs);
+            }
+            return convertEndNs;
+        }
+
+        SharedMemoryFrame *sharedFrame = dynamic_cast<SharedMemoryFrame *>(frame.get());
+        if (sharedFrame) {
+            // converted straight into shared memory, other processes read it in place
+            if (produce(sharedFrame->getWriteBuffer(), sharedFrame->getFormat(), frameWidth, frameHeight)) {
+                sharedFrame->publish(sequence, receivedNs);
+            }
+            return convertEndNs;
+        }
+
+        const size_t bytes = getPlaneLayout(format, frameWidth, frameHeight).totalBytes;
+        if (bytes == 0 || frame->getFrameSizeBytes() < bytes) { return convertEndNs; }
+        const uint8_t *pixels = converted;
+        if (!pixels || convertedFormat != format || convertedWidth != frameWidth || convertedHeight != frameHeight) {
+            m_scratch.resize(bytes);
+            if (!produce(m_scratch.data(), format, frameWidth, frameHeight)) { return convertEndNs; }
+            pixels = m_scratch.data();
+        }
+        std::shared_ptr<std::mutex> guard = m_transport->getBufferMutex();
+        if (guard) {
+            std::lock_guard<std::mutex> lck(*guard);
+            std::memcpy(frame->getRawPointer(), pixels, bytes);
+        } else {
+            std::memcpy(frame->getRawPointer(), pixels, bytes);
+        }
+        return convertEndNs;
+    }
+
+    /// Publish every picture the decoder has ready and record its timestamps. Runs on the decode thread.
+    /// When conversion is batched by the worker pool it stops at the first picture and hands it over.
+    /// @details Decode latency is measured from the submission of the packet that produced the picture,
+    /// so it includes any frame delay of a multi-threaded decoder.
+    void m_drainDecoder()
+    {
+        while (const AVFrame *decoded = m_decoder.receiveFrame()) {
+            FrameTimestamps timestamps;
+            timestamps.sequence = static_cast<uint64_t>(decoded->pts);
+            const PacketTiming &packet = m_packetTiming[timestamps.sequence % RECEIVE_HISTORY];
+            timestamps.receivedNs    = packet.receivedNs;
+            timestamps.decodeStartNs = packet.decodeStartNs;
+            timestamps.isIFrame      = packet.isIFrame;
+            timestamps.decodeEndNs   = monotonicNanoseconds();
+            if (!packet.publish) { continue; }
+            if (m_deferConversion) {
+                // the picture stays in the decoder until the pool calls convert()
+                m_parkedTimestamps = timestamps;
+                m_pictureParked    = true;
+                m_requestConversion();
+                return;
+            }
+            m_publishPicture(timestamps);
+        }
+    }
+
+    /// Convert and publish the decoder's current picture and record its latencies. Runs on the decode thread.
+    /// @param timestamps the picture's timestamps up to the end of decoding, completed here
+    void m_publishPicture(FrameTimestamps &timestamps)
+    {
+        const uint64_t convertEndNs = m_publishFrame(timestamps.sequence, timestamps.receivedNs);
+        timestamps.convertEndNs = convertEndNs ? convertEndNs : timestamps.decodeEndNs;
+        timestamps.publishNs    = monotonicNanoseconds();
+
+        m_recordLatency(LatencyStage::DECODE,  timestamps.decodeEndNs - timestamps.decodeStartNs);
+        m_recordLatency(LatencyStage::CONVERT, timestamps.convertEndNs - timestamps.decodeEndNs);
+        m_recordLatency(LatencyStage::PUBLISH, timestamps.publishNs - timestamps.decodeEndNs);
+        m_recordLatency(LatencyStage::TOTAL,   timestamps.publishNs - timestamps.receivedNs);
+        m_lastTimestamps.store(timestamps);
+        m_lastFrameNs.store(timestamps.publishNs, std::memory_order_relaxed);
+        if (m_firstFrameNs.load(std::memory_order_relaxed) == 0) {
+            m_firstFrameNs.store(timestamps.publishNs, std::memory_order_relaxed);
+        }
+        m_framesDecoded.fetch_add(1, std::memory_order_relaxed);
+        if (m_timestampsCallback) { m_timestampsCallback(timestamps, m_timestampsCustomData); }
+    }
+
+    /// Decode the next queued frame, if any, and publish the resulting pictures
+    /// @param work holds the popped frame, its old buffer is handed back to the producer for reuse
+    /// @returns false when the queue was empty
+    bool m_decodeNext(CompressedFrame &work)
+    {
+        bool popped = m_queue.tryPop([&work](CompressedFrame &slot) {
+            std::swap(work.data, slot.data);
+            work.isIFrame   = slot.isIFrame;
+            work.sequence   = slot.sequence;
+            work.receivedNs = slot.receivedNs;
+        });
+        if (!popped) { return false; }
+
+        const uint64_t decodeStartNs = monotonicNanoseconds();
+        m_recordLatency(LatencyStage::QUEUE_WAIT, decodeStartNs - work.receivedNs);
+        PacketTiming &packet = m_packetTiming[work.sequence % RECEIVE_HISTORY];
+        packet.receivedNs    = work.receivedNs;
+        packet.decodeStartNs = decodeStartNs;
+        packet.isIFrame      = work.isIFrame;
+        packet.publish       = true;
+        if (!m_admit(work, packet.publish)) {
+            m_adaptBusy(decodeStartNs);
+            return true;
+        }
+
+        const uint64_t skipped = m_decoder.getPacketsSkipped();
+        const bool sent = m_decoder.sendPacket(work.data.data(), work.data.size(), work.isIFrame,
+                                               static_cast<int64_t>(work.sequence));
+        if (m_decoder.getPacketsSkipped() != skipped) { m_framesShed.fetch_add(1, std::memory_order_relaxed); }
+        if (!sent) {
+            m_decodeErrors.fetch_add(1, std::memory_order_relaxed);
+            m_adaptBusy(decodeStartNs);
+            return true;
+        }
+        m_drainDecoder();
+        m_adaptBusy(decodeStartNs);
+        return true;
+    }
+
+    /// Set the decoder quality and reset the hold time. Runs on the decode thread.
+    /// @param quality the new level
+    void m_setQuality(DecodeQuality quality)
+    {
+        m_decoder.setQuality(quality);
+        m_quality.store(quality, std::memory_order_relaxed);
+        m_framesAtQuality = 0;
+    }
+
+    /// Decide whether a frame is decoded and published, stepping the decode quality with the load first.
+    /// Runs on the decode thread.
+    /// @param work the popped frame
+    /// @param publish set to false when the frame is decoded only because later frames refer to it
+    /// @returns false when the frame is dropped before decode
+    bool m_admit(const CompressedFrame &work, bool &publish)
+    {
+        const AdaptiveDecodeOptions &options = m_adaptiveOptions;
+        if (m_qualityPending.exchange(false)) { m_setQuality(m_quality.load()); }
+
+        // a gap means the queue overflowed. Without the lost references the frames up to the next
+        // I-frame would decode with artifacts, so resync instead.
+        const bool lostFrames = work.sequence != m_expectedSequence && m_lastReceivedNs != 0;
+        m_expectedSequence = work.sequence + 1;
+        if (lostFrames && !work.isIFrame) { m_decoder.awaitIFrame(); }
+
+        const uint64_t intervalNs = m_lastReceivedNs && work.receivedNs > m_lastReceivedNs
+                                  ? work.receivedNs - m_lastReceivedNs : 0;
+        m_lastReceivedNs = work.receivedNs;
+        if (intervalNs) {
+            m_intervalNs = m_intervalNs > 0.0 ? m_intervalNs + (intervalNs - m_intervalNs) / ADAPT_SETTLE_FRAMES
+                                              : static_cast<double>(intervalNs);
+        }
+        if (options.adaptive) { m_adaptQuality(); }
+
+        if (options.targetFps <= 0.0) { return true; }
+        m_fpsTokens = std::min(m_fpsTokens + intervalNs * options.targetFps / 1e9, 2.0);
+        if (m_fpsTokens >= 1.0 || work.isIFrame) {
+            // I-frames are always admitted, they are where every resync starts
+            m_fpsTokens = std::max(m_fpsTokens - 1.0, -1.0);
+            return true;
+        }
+        m_framesThrottled.fetch_add(1, std::memory_order_relaxed);
+        if (!h264IsReferenceFrame(work.data.data(), work.data.size())) { return false; }
+        if (m_overloaded) {
+            // no time to decode frames that are never shown, wait for the next I-frame instead
+            m_decoder.awaitIFrame();
+            return false;
+        }
+        publish = false;
+        return true;
+    }
+
+    /// Step the decode quality down under overload and back up once the load falls. Runs on the decode thread.
+    /// @details The load is the average decode thread time per received frame over the average frame
+    /// interval, so it is independent of the frame rate. A queue half full counts as overload too. The
+    /// time before stepping up doubles whenever a step up has to be undone, so a stream whose load sits
+    /// between two levels settles on the lower one instead of oscillating.
+    void m_adaptQuality()
+    {
+        const AdaptiveDecodeOptions &options = m_adaptiveOptions;
+        const unsigned hold = options.holdFrames > 0 ? options.holdFrames : 1;
+        if (m_recoverHold == 0) { m_recoverHold = hold; }
+        if (m_framesAtQuality < UINT32_MAX) { m_framesAtQuality++; }
+
+        const double load = m_intervalNs > 0.0 ? m_busyNs / m_intervalNs : 0.0;
+        m_overloaded = load > options.overloadLoad || m_queue.size() * 2 >= m_queue.capacity();
+        const unsigned level = static_cast<unsigned>(m_decoder.getQuality());
+        if (m_overloaded) {
+            if (level < static_cast<unsigned>(options.lowestQuality) && m_framesAtQuality >= ADAPT_SETTLE_FRAMES) {
+                if (m_steppedUp) { m_recoverHold = std::min(m_recoverHold * 2, hold * MAX_HOLD_MULTIPLIER); }
+                m_steppedUp = false;
+                m_setQuality(static_cast<DecodeQuality>(level + 1));
+            }
+        } else if (load < options.recoverLoad && level > 0 && m_framesAtQuality >= m_recoverHold) {
+            m_steppedUp = true;
+            if (level == 1) { m_recoverHold = hold; }
+            m_setQuality(static_cast<DecodeQuality>(level - 1));
+        }
+    }
+
+    /// Average the decode thread time spent on a frame into the load. Runs on the decode thread.
+    /// @param decodeStartNs when work on the frame started
+    void m_adaptBusy(uint64_t decodeStartNs)
+    {
+        const double busyNs = static_cast<double>(monotonicNanoseconds() - decodeStartNs + m_convertBusyNs);
+        m_convertBusyNs = 0;
+        m_busyNs += (busyNs - m_busyNs) / ADAPT_SETTLE_FRAMES;
+    }
+
+    /// Body of the decode thread
+    void m_decodeLoop()
+    {
+        CompressedFrame work;
+        while (m_running.load()) {
+            m_applyDecoderConfig();
+
+            if (!m_decodeNext(work)) {
+                std::unique_lock<std::mutex> lck(m_wakeMutex);
+                m_consumerWaiting.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                m_wakeCv.wait_for(lck, std::chrono::milliseconds(50), [this]() {
+                    return !m_running.load() || m_queue.size() > 0 || m_configPending.load();
+                });
+                m_consumerWaiting.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        // publish the pictures still held in the decoder's delay line
+        m_decoder.flush();
+        m_drainDecoder();
+    }
+
+    /// Callback for handling decoder changes, runs on the ARSDK thread
+    /// @param codec ARSDK3 codec
+    /// @param customData a pointer to an instance of DecodePipeline
+    static eARCONTROLLER_ERROR m_decoderConfigCallDefault(ARCONTROLLER_Stream_Codec_t codec, void *customData)
+    {
+        DecodePipeline *pipeline = static_cast<DecodePipeline *>(customData);
+        if (!pipeline || codec.type != ARCONTROLLER_STREAM_CODEC_TYPE_H264) { return ARCONTROLLER_OK; }
+
+        {
+            std::lock_guard<std::mutex> lck(pipeline->m_configMutex);
+            const uint8_t *sps = codec.parameters.h264parameters.spsBuffer;
+            const uint8_t *pps = codec.parameters.h264parameters.ppsBuffer;
+            pipeline->m_sps.assign(sps, sps + codec.parameters.h264parameters.spsSize);
+            pipeline->m_pps.assign(pps, pps + codec.parameters.h264parameters.ppsSize);
+            pipeline->m_configsReceived++;
+        }
+        pipeline->m_configPending = true;
+        pipeline->m_wake();
+        return ARCONTROLLER_OK;
+    }
+
+    /// Callback for handling new video frames received, runs on the ARSDK thread
+    /// @param frame pointer to a ARSDK3 frame
+    /// @param customData a pointer to an instance of DecodePipeline
+    static eARCONTROLLER_ERROR m_onFrameReceivedDefault(ARCONTROLLER_Frame_t *frame, void *customData)
+    {
+        DecodePipeline *pipeline = static_cast<DecodePipeline *>(customData);
+        if (!pipeline || !frame || !pipeline->m_running.load(std::memory_order_relaxed)) { return ARCONTROLLER_OK; }
+        pipeline->m_enqueue(frame);
+        return ARCONTROLLER_OK;
+    }
+};
+
+/// Escape a Prometheus label value
+/// @param value the raw value
+/// @returns the value with backslashes, quotes and newlines escaped
+inline std::string escapeMetricLabel(const std::string &value)
+{
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\n') { escaped += "\\n"; continue; }
+        if (c == '\\' || c == '"') { escaped += '\\'; }
+        escaped += c;
+    }
+    return escaped;
+}
+
+/// Format the metrics of several pipelines in the Prometheus text exposition format, with each metric
+/// family written once and a stream label on every sample
+/// @param streams the metrics of each pipeline
+/// @returns the metrics text
+inline std::string formatPrometheusMetrics(const std::vector<DecodePipelineMetrics> &streams)
+{
+    struct Counter {
+        const char *name;
+        const char *type;
+        const char *help;
+        uint64_t (*get)(const DecodePipelineStats &);
+    };
+    static const Counter COUNTERS[] = {
+        { "wscdrone_video_frames_received_total", "counter", "Compressed frames delivered by the drone",
+          [](const DecodePipelineStats &s) -> uint64_t { return s.framesReceived; } },
+        { "wscdrone_video_bytes_received_total", "counter", "Compressed bytes delivered by the drone",
+          [](const DecodePipelineStats &s) -> uint64_t { return s.bytesReceived; } },
+        { "wscdrone_video_frames_decoded_total", "counter", "Frames decoded and published",
+          [](const DecodePipelineStats &s) -> uint64_t { return s.framesDecoded; } },
+        { "wscdrone_video_queue_depth", "gauge", "Compressed frames waiting for the decoder",
+          [](const DecodePipelineStats &s) -> uint64_t { return s.queueDepth; } },
+        { "wscdrone_video_queue_high_water", "gauge", "Deepest the decode queue has been",
+          [](const DecodePipelineStats &s) -> uint64_t { return s.queueHighWater; } },
+        { "wscdrone_video_decode_quality", "gauge", "Decode quality level, 0 for full and 3 for I-frames only",
+          [](const DecodePipelineStats &s) -> uint64_t { return static_cast<uint64_t>(s.quality); } },
+    };
+
+    std::string out;
+    for (const Counter &counter : COUNTERS) {
+        out += std::string("# HELP ") + counter.name + " " + counter.help + "\n";
+        out += std::string("# TYPE ") + counter.name + " " + counter.type + "\n";
+        for (const auto &stream : streams) {
+            out += std::string(counter.name) + "{stream=\"" + escapeMetricLabel(stream.stream) + "\"} " +
+                   std::to_string(counter.get(stream.stats)) + "\n";
+        }
+    }
+
+    out += "# HELP wscdrone_video_frames_dropped_total Frames lost before reaching the application\n"
+           "# TYPE wscdrone_video_frames_dropped_total counter\n";
+    for (const auto &stream : streams) {
+        const std::pair<const char *, uint64_t> reasons[] = {
+            { "queue_full",      stream.stats.framesDropped },
+            { "awaiting_iframe", stream.stats.framesSkipped },
+            { "decode_error",    stream.stats.decodeErrors },
+            { "pool_exhausted",  stream.stats.poolExhausted },
+            { "pool_too_small",  stream.stats.poolTooSmall },
+            { "shed",            stream.stats.framesShed },
+            { "throttled",       stream.stats.framesThrottled },
+        };
+        for (const auto &reason : reasons) {
+            out += "wscdrone_video_frames_dropped_total{stream=\"" + escapeMetricLabel(stream.stream) +
+                   "\",reason=\"" + reason.first + "\"} " + std::to_string(reason.second) + "\n";
+        }
+    }
+
+    out += "# HELP wscdrone_video_latency_seconds Frame latency of each pipeline stage\n"
+           "# TYPE wscdrone_video_latency_seconds histogram\n";
+    for (const auto &stream : streams) {
+        for (unsigned i = 0; i < static_cast<unsigned>(LatencyStage::COUNT); i++) {
+            const std::string labels = "stream=\"" + escapeMetricLabel(stream.stream) + "\",stage=\"" +
+                                       latencyStageName(static_cast<LatencyStage>(i)) + "\"";
+            stream.latency[i].appendPrometheus(out, "wscdrone_video_latency_seconds", labels);
+        }
+    }
+    return out;
+}
+
+inline std::string DecodePipeline::dumpMetrics(const std::string &stream)
+{
+    return formatPrometheusMetrics({ getMetrics(stream) });
+}
+
+} // wscDrone
+
+#endif /* DECODEPIPELINE_H_ */
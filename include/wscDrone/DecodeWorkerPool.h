@@ -0,0 +1,411 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains a fixed pool of decode threads shared by many
+ * video streams.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef DECODEWORKERPOOL_H_
+#define DECODEWORKERPOOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace wscDrone {
+
+class DecodeWorkerPool;
+
+/// Scheduling priority of a stream in a DecodeWorkerPool
+enum class DecodePriority : unsigned {
+    LEAD       = 0, ///< always serviced before any other stream, e.g. the drone being piloted
+    NORMAL     = 1, ///< the default
+    BACKGROUND = 2  ///< only serviced when no LEAD or NORMAL stream is ready
+};
+
+/// DecodeWorkerPool configuration
+struct DecodeWorkerPoolOptions {
+    size_t   numThreads      = 0;     ///< decode threads, 0 picks half the hardware threads
+    unsigned framesPerSlice  = 2;     ///< frames a stream may decode before yielding to the next ready stream
+    size_t   leadThreads     = 0;     ///< threads, included in numThreads, that only service LEAD streams
+    bool     batchConversion = false; ///< convert decoded pictures of many streams back to back, see convert()
+    unsigned conversionBatch = 8;     ///< most pictures one thread converts before looking for decode work
+    bool     pinThreads      = false; ///< pin each thread to one CPU so streams keep their caches warm
+};
+
+/// Work that a DecodeWorkerPool performs on behalf of one video stream
+class DecodeWorkerStream {
+public:
+    virtual ~DecodeWorkerStream() = default;
+
+    /// Process up to maxFrames queued frames. Never runs on two pool threads at once.
+    /// @param maxFrames the number of frames the stream may process before yielding its thread
+    /// @returns true when more work is already queued
+    virtual bool service(unsigned maxFrames) = 0;
+
+    /// Convert the decoded picture that service() or convert() left pending with m_requestConversion().
+    /// Never runs on two pool threads at once, nor at the same time as service().
+    /// @returns true when more work is already queued
+    virtual bool convert() { return false; }
+
+    /// Set the scheduling priority. Takes effect the next time the stream is queued.
+    /// @param priority the new priority
+    void setDecodePriority(DecodePriority priority) { m_priority.store(priority); }
+
+    /// Get the scheduling priority
+    /// @returns the priority
+    DecodePriority getDecodePriority() const { return m_priority.load(); }
+
+protected:
+    /// Hand the current decoded picture to the pool to be converted in a batch with the pictures of other
+    /// streams. Call from service() or convert() just before returning, and leave the picture untouched
+    /// until convert() runs. Only valid when the pool has DecodeWorkerPoolOptions::batchConversion set.
+    void m_requestConversion() { m_conversionRequested = true; }
+
+private:
+    friend DecodeWorkerPool;
+
+    enum : unsigned {
+        DETACHED = 0, ///< not attached to a pool, schedule() is ignored
+        IDLE     = 1, ///< attached with no pending work
+        QUEUED   = 2, ///< waiting in the ready queue
+        RUNNING  = 3, ///< being serviced by a pool thread
+        RERUN    = 4  ///< being serviced and more work arrived meanwhile
+    };
+    std::atomic<unsigned> m_poolState{DETACHED}; ///< scheduling state, changed under the pool mutex
+    std::atomic<DecodePriority> m_priority{DecodePriority::NORMAL}; ///< scheduling priority
+    bool     m_conversionRequested = false; ///< set by m_requestConversion(), read by the servicing thread
+    size_t   m_lastWorker  = SIZE_MAX;      ///< thread that last serviced the stream, under the pool mutex
+    unsigned m_bypassed    = 0;             ///< times passed over for a stream with affinity, under the pool mutex
+};
+
+/// A fixed set of threads that decode any number of streams. Each stream keeps its own decoder and queue;
+/// the pool only decides which stream runs next. A stream is serviced by at most one thread at a time, so
+/// its frames stay in order, and after framesPerSlice frames it goes to the back of the ready queue so one
+/// busy stream cannot starve the others. The thread count stays the same however many streams are attached.
+/// @details Streams are queued by DecodePriority and a thread always takes the highest priority ready
+/// stream, so a LEAD stream waits at most for one slice of another stream, or not at all when
+/// leadThreads are reserved for it. Within a priority a thread prefers a stream it serviced last, which
+/// keeps that stream's decoder state in the thread's cache, but never passes over the stream at the head
+/// of the queue more than once per pool thread. With batchConversion, streams hand their decoded pictures
+/// back to the pool and a thread converts up to conversionBatch pictures from any streams in one go,
+/// ahead of further decoding, so the colour conversion code and tables stay hot and decoders are not
+/// evicted from the cache between pictures.
+class DecodeWorkerPool {
+public:
+    DecodeWorkerPool() = delete;
+
+    /// Construct a pool and start its threads
+    /// @param numThreads number of decode threads, 0 picks half the hardware threads
+    /// @param framesPerSlice frames a stream may decode before yielding to the next ready stream
+    explicit DecodeWorkerPool(size_t numThreads, unsigned framesPerSlice = 2)
+        : DecodeWorkerPool(m_makeOptions(numThreads, framesPerSlice)) {}
+
+    /// Construct a pool and start its threads
+    /// @param options the pool configuration
+    explicit DecodeWorkerPool(const DecodeWorkerPoolOptions &options)
+        : m_options(options), m_framesPerSlice(options.framesPerSlice > 0 ? options.framesPerSlice : 1)
+    {
+        size_t numThreads = m_options.numThreads;
+        if (numThreads == 0) {
+            numThreads = std::max<size_t>(1, std::thread::hardware_concurrency() / 2);
+        }
+        m_options.numThreads  = numThreads;
+        m_options.leadThreads = std::min(m_options.leadThreads, numThreads - 1);
+        if (m_options.conversionBatch == 0) { m_options.conversionBatch = 1; }
+        for (size_t i = 0; i < numThreads; i++) {
+            m_threads.emplace_back(&DecodeWorkerPool::m_workerLoop, this, i);
+        }
+    }
+
+    /// Stops and joins the threads. All streams must have been detached.
+    ~DecodeWorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_running = false;
+        }
+        m_readyCv.notify_all();
+        for (auto &thread : m_threads) {
+            if (thread.joinable()) { thread.join(); }
+        }
+    }
+
+    DecodeWorkerPool(const DecodeWorkerPool &) = delete;
+    DecodeWorkerPool &operator=(const DecodeWorkerPool &) = delete;
+
+    /// Attach a stream so that schedule() takes effect
+    /// @param stream the stream
+    void attach(DecodeWorkerStream *stream)
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        if (stream->m_poolState.load() == DecodeWorkerStream::DETACHED) {
+            stream->m_poolState.store(DecodeWorkerStream::IDLE);
+            m_attached++;
+        }
+    }
+
+    /// Detach a stream. On return no pool thread is running the stream or will run it again.
+    /// @param stream the stream
+    void detach(DecodeWorkerStream *stream)
+    {
+        std::unique_lock<std::mutex> lck(m_mutex);
+        m_idleCv.wait(lck, [stream]() {
+            const unsigned state = stream->m_poolState.load();
+            return state != DecodeWorkerStream::RUNNING && state != DecodeWorkerStream::RERUN;
+        });
+        const unsigned state = stream->m_poolState.load();
+        if (state == DecodeWorkerStream::DETACHED) { return; }
+        if (state == DecodeWorkerStream::QUEUED) {
+            for (auto &queue : m_ready) { queue.erase(std::remove(queue.begin(), queue.end(), stream), queue.end()); }
+            for (auto &queue : m_convert) { queue.erase(std::remove(queue.begin(), queue.end(), stream), queue.end()); }
+        }
+        stream->m_poolState.store(DecodeWorkerStream::DETACHED);
+        stream->m_lastWorker  = SIZE_MAX;
+        m_attached--;
+    }
+
+    /// Tell the pool a stream has work. Cheap when the stream is already queued, so it may be called for
+    /// every received frame.
+    /// @param stream the stream
+    void schedule(DecodeWorkerStream *stream)
+    {
+        const unsigned state = stream->m_poolState.load(std::memory_order_acquire);
+        if (state == DecodeWorkerStream::QUEUED || state == DecodeWorkerStream::RERUN
+                || state == DecodeWorkerStream::DETACHED) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            switch (stream->m_poolState.load()) {
+            case DecodeWorkerStream::IDLE :
+                m_queue(stream, false);
+                break;
+            case DecodeWorkerStream::RUNNING :
+                stream->m_poolState.store(DecodeWorkerStream::RERUN);
+                return;
+            default :
+                return;
+            }
+        }
+        m_readyCv.notify_all();
+    }
+
+    /// Get the number of pool threads
+    /// @returns the thread count
+    size_t getThreadCount() const { return m_threads.size(); }
+
+    /// Get the number of attached streams
+    /// @returns the stream count
+    size_t getStreamCount()
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        return m_attached;
+    }
+
+    /// Get the number of streams waiting for a thread
+    /// @returns the number of streams waiting to decode or convert
+    size_t getReadyCount()
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        size_t count = 0;
+        for (const auto &queue : m_ready) { count += queue.size(); }
+        for (const auto &queue : m_convert) { count += queue.size(); }
+        return count;
+    }
+
+    /// Get the configuration, with numThreads resolved
+    /// @returns the options
+    const DecodeWorkerPoolOptions &getOptions() const { return m_options; }
+
+    /// Check if streams should hand decoded pictures back for batched conversion
+    /// @returns true when DecodeWorkerPoolOptions::batchConversion is set
+    bool isBatchingConversion() const { return m_options.batchConversion; }
+
+private:
+    static constexpr size_t PRIORITY_COUNT = 3;      ///< number of DecodePriority values
+
+    DecodeWorkerPoolOptions m_options;               ///< configuration
+    const unsigned m_framesPerSlice;                 ///< frames per stream before yielding
+    std::vector<std::thread> m_threads;              ///< the decode threads
+    std::mutex m_mutex;                              ///< protects the queues, m_attached and stream state changes
+    std::condition_variable m_readyCv;               ///< signalled when a stream becomes ready
+    std::condition_variable m_idleCv;                ///< signalled when a thread finishes a slice
+    std::deque<DecodeWorkerStream *> m_ready[PRIORITY_COUNT];   ///< streams waiting to decode, by priority
+    std::deque<DecodeWorkerStream *> m_convert[PRIORITY_COUNT]; ///< streams waiting to convert, by priority
+    size_t m_attached = 0;                           ///< number of attached streams
+    bool   m_running  = true;                        ///< false once the destructor runs
+
+    static DecodeWorkerPoolOptions m_makeOptions(size_t numThreads, unsigned framesPerSlice)
+    {
+        DecodeWorkerPoolOptions options;
+        options.numThreads     = numThreads;
+        options.framesPerSlice = framesPerSlice;
+        return options;
+    }
+
+    /// Put a stream in the decode or conversion queue of its priority. Called with m_mutex held.
+    /// @param stream the stream
+    /// @param converting true to queue it for convert()
+    void m_queue(DecodeWorkerStream *stream, bool converting)
+    {
+        const size_t priority = std::min<size_t>(static_cast<size_t>(stream->m_priority.load()), PRIORITY_COUNT - 1);
+        stream->m_poolState.store(DecodeWorkerStream::QUEUED);
+        (converting ? m_convert : m_ready)[priority].push_back(stream);
+    }
+
+    /// Get the number of priorities a thread may service, LEAD only for a reserved thread
+    /// @param worker the thread index
+    /// @returns 1 for a reserved thread, otherwise PRIORITY_COUNT
+    size_t m_prioritiesFor(size_t worker) const { return worker < m_options.leadThreads ? 1 : PRIORITY_COUNT; }
+
+    /// Check if a thread has anything to do. Called with m_mutex held.
+    /// @param worker the thread index
+    /// @returns true if a stream the thread may service is waiting
+    bool m_hasWork(size_t worker) const
+    {
+        for (size_t priority = 0; priority < m_prioritiesFor(worker); priority++) {
+            if (!m_ready[priority].empty() || !m_convert[priority].empty()) { return true; }
+        }
+        return false;
+    }
+
+    /// Take the next stream to decode, preferring the highest priority and then a stream this thread
+    /// serviced last. Called with m_mutex held.
+    /// @param worker the thread index
+    /// @returns the stream, nullptr if none may run on this thread
+    DecodeWorkerStream *m_takeReady(size_t worker)
+    {
+        for (size_t priority = 0; priority < m_prioritiesFor(worker); priority++) {
+            std::deque<DecodeWorkerStream *> &queue = m_ready[priority];
+            if (queue.empty()) { continue; }
+            size_t chosen = 0;
+            if (queue.front()->m_lastWorker != worker && queue.front()->m_bypassed < m_threads.size()) {
+                const size_t window = std::min(queue.size(), m_threads.size());
+                for (size_t i = 1; i < window; i++) {
+                    if (queue[i]->m_lastWorker == worker) { chosen = i; break; }
+                }
+            }
+            if (chosen) {
+                queue.front()->m_bypassed++;
+            } else {
+                queue.front()->m_bypassed = 0;
+            }
+            DecodeWorkerStream *stream = queue[chosen];
+            queue.erase(queue.begin() + static_cast<std::ptrdiff_t>(chosen));
+            return stream;
+        }
+        return nullptr;
+    }
+
+    /// Take up to conversionBatch streams with a picture to convert, highest priority first. Called with
+    /// m_mutex held.
+    /// @param worker the thread index
+    /// @param batch receives the streams
+    void m_takeConversions(size_t worker, std::vector<DecodeWorkerStream *> &batch)
+    {
+        batch.clear();
+        for (size_t priority = 0; priority < m_prioritiesFor(worker); priority++) {
+            std::deque<DecodeWorkerStream *> &queue = m_convert[priority];
+            while (!queue.empty() && batch.size() < m_options.conversionBatch) {
+                batch.push_back(queue.front());
+                queue.pop_front();
+            }
+        }
+    }
+
+    /// Queue a stream again, or mark it idle, after a thread ran it. Called with m_mutex held.
+    /// @param stream the stream
+    /// @param more what service() or convert() returned
+    void m_requeue(DecodeWorkerStream *stream, bool more)
+    {
+        if (stream->m_conversionRequested) {
+            stream->m_conversionRequested = false;
+            m_queue(stream, true);
+        } else if (more || stream->m_poolState.load() == DecodeWorkerStream::RERUN) {
+            m_queue(stream, false);
+        } else {
+            stream->m_poolState.store(DecodeWorkerStream::IDLE);
+        }
+    }
+
+    /// Pin the calling thread to one CPU
+    /// @param worker the thread index
+    static void m_pinThread(size_t worker)
+    {
+#ifdef __linux__
+        const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(static_cast<int>(worker % cpus), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)worker;
+#endif
+    }
+
+    /// Body of each pool thread
+    /// @param worker the thread index
+    void m_workerLoop(size_t worker)
+    {
+        if (m_options.pinThreads) { m_pinThread(worker); }
+        std::vector<DecodeWorkerStream *> batch;
+        batch.reserve(m_options.conversionBatch);
+
+        std::unique_lock<std::mutex> lck(m_mutex);
+        while (true) {
+            m_readyCv.wait(lck, [this, worker]() { return !m_running || m_hasWork(worker); });
+            if (!m_running) { return; }
+
+            // finish decoded pictures before decoding more, so conversion never falls behind
+            m_takeConversions(worker, batch);
+            if (!batch.empty()) {
+                for (DecodeWorkerStream *stream : batch) { stream->m_poolState.store(DecodeWorkerStream::RUNNING); }
+                lck.unlock();
+                std::vector<bool> more(batch.size());
+                for (size_t i = 0; i < batch.size(); i++) { more[i] = batch[i]->convert(); }
+                lck.lock();
+                for (size_t i = 0; i < batch.size(); i++) { m_requeue(batch[i], more[i]); }
+                m_readyCv.notify_all();
+                m_idleCv.notify_all();
+                continue;
+            }
+
+            DecodeWorkerStream *stream = m_takeReady(worker);
+            if (!stream) { continue; }
+            stream->m_poolState.store(DecodeWorkerStream::RUNNING);
+            stream->m_lastWorker = worker;
+            lck.unlock();
+
+            const bool more = stream->service(m_framesPerSlice);
+
+            lck.lock();
+            m_requeue(stream, more);
+            if (stream->m_poolState.load() == DecodeWorkerStream::QUEUED) { m_readyCv.notify_all(); }
+            m_idleCv.notify_all();
+        }
+    }
+};
+
+} // wscDrone
+
+#endif /* DECODEWORKERPOOL_H_ */
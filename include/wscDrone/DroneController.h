@@ -38,6 +38,7 @@ namespace wscDrone {
 
 // Forward declare some classes so they can be friended. This permits restricted access to the
 // underlying ARSDK.
+class ArsdkTransport;
 class CameraControl;
 class Pilot;
 class VideoDriver;
@@ -90,6 +91,7 @@ public:
     void stop();
 
 protected:
+    friend ArsdkTransport;
     friend CameraControl;
     friend Pilot;
     friend VideoDriver;
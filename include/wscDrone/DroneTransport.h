@@ -0,0 +1,223 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the DroneTransport interface between the library
+ * components and a drone, and its ARSDK implementation.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef DRONETRANSPORT_H_
+#define DRONETRANSPORT_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "Bebop2.h"
+#include "DroneController.h"
+#include "Pilot.h"
+#include "VideoDriver.h"
+
+namespace wscDrone {
+
+/// A continuous piloting command, sent as the ARSDK PCMD command. Each axis is a percentage of the
+/// maximum configured on the drone, from -100 to 100.
+struct PilotingSetpoint {
+    int8_t   roll  = 0;              ///< percentage of the maximum tilt, positive rolls right
+    int8_t   pitch = 0;              ///< percentage of the maximum tilt, positive pitches down and flies forward
+    int8_t   yaw   = 0;              ///< percentage of the maximum rotation speed, positive turns clockwise
+    int8_t   gaz   = 0;              ///< percentage of the maximum vertical speed, positive climbs
+    bool     useRollPitch = false;   ///< the PCMD flag, roll and pitch are ignored when false
+    uint32_t timestampAndSeqNum = 0; ///< milliseconds in the low 24 bits and a sequence number in the high 8
+};
+
+/// The connection to one drone as seen by DecodePipeline, TelemetryCache, MoveSequencer and Fleet.
+/// Callbacks use the ARSDK signatures, so the same code runs against a real drone through
+/// ArsdkTransport or against a SimulatedDrone.
+class DroneTransport {
+public:
+    virtual ~DroneTransport() = default;
+
+    /// Start the device controller. Returns once the start has been requested.
+    virtual void start() = 0;
+
+    /// Stop the device controller
+    virtual void stop() = 0;
+
+    /// Get the last received state of the device controller
+    /// @returns the last state received
+    virtual eARCONTROLLER_DEVICE_STATE getLastState() = 0;
+
+    /// Block until the device state changes or an implementation defined timeout expires
+    /// @returns true on state change, false on timeout
+    virtual bool waitForStateChange() = 0;
+
+    /// Add a callback for received commands
+    /// @param callback the function to execute for each command
+    /// @param customData a raw pointer passed back to the callback
+    virtual void registerCommandReceivedCallback(const CommandReceivedCallback &callback, void *customData) = 0;
+
+    /// Register the callbacks for the H.264 decoder configuration and received frames
+    /// @param decoderCallback the function to execute when the SPS/PPS change
+    /// @param videoCallback the function to execute for each compressed frame
+    /// @param customData a raw pointer passed back to the callbacks
+    virtual void registerVideoCallback(const VideoDecoderConfigCallback &decoderCallback,
+                                       const VideoFrameReceivedCallback &videoCallback, void *customData) = 0;
+
+    /// Start the video stream
+    virtual void startVideo() = 0;
+
+    /// Stop the video stream
+    virtual void stopVideo() = 0;
+
+    /// Get the VideoFrame decoded video is written to
+    /// @returns a smart pointer to the VideoFrame, may be nullptr
+    virtual std::shared_ptr<VideoFrame> getFrame() = 0;
+
+    /// Get the mutex guarding the VideoFrame
+    /// @returns a smart pointer to the mutex, may be nullptr
+    virtual std::shared_ptr<std::mutex> getBufferMutex() = 0;
+
+    /// Send a relative move without waiting, see Pilot::moveRelativeMetres(). Completion is reported by
+    /// a move-end command.
+    /// @param dx displacement in meters to the right (positive) or left (negative)
+    /// @param dy displacement in meters forward (positive) or backwards (negative)
+    /// @param dz displacement in meters down (positive) or up (negative)
+    /// @param heading heading change in degrees, positive is clockwise
+    virtual void moveRelativeMetres(float dx, float dy, float dz, float heading) = 0;
+
+    /// Get the current battery level
+    /// @returns battery level 0 to 100
+    virtual unsigned getBatteryLevel() = 0;
+
+    /// Set the piloting setpoint the drone flies, without waiting for an acknowledgement. The drone keeps
+    /// flying it until the next setpoint, so setpoints are normally updated by a SetpointStreamer and a
+    /// zero setpoint is set to hover.
+    /// @param setpoint the setpoint
+    /// @returns false if the setpoint was not sent, always for transports that cannot fly setpoints
+    virtual bool sendPilotingSetpoint(const PilotingSetpoint &setpoint)
+    {
+        (void)setpoint;
+        return false;
+    }
+
+    /// Send a camera orientation immediately. The drone reports the orientation it applied with a
+    /// camera orientation command. Normally sent through a CameraOrientationScheduler.
+    /// @param tilt angle in degrees, positive tilts up
+    /// @param pan angle in degrees, positive pans right
+    /// @returns false if the orientation was not sent, always for transports without a camera
+    virtual bool sendCameraOrientation(float tilt, float pan)
+    {
+        (void)tilt;
+        (void)pan;
+        return false;
+    }
+};
+
+/// A DroneTransport backed by the ARSDK classes of a real drone
+class ArsdkTransport : public DroneTransport {
+public:
+    ArsdkTransport() = delete;
+
+    /// Construct a transport for a Bebop2
+    /// @param drone smart pointer to the Bebop2
+    explicit ArsdkTransport(std::shared_ptr<Bebop2> drone)
+        : m_drone(drone), m_droneController(drone->getDroneController()),
+          m_videoDriver(drone->getVideoDriver()), m_pilot(drone->getPilot()) {}
+
+    /// Construct a transport from individual components. Any of them may be nullptr, in which case the
+    /// calls that need it do nothing.
+    /// @param droneController smart pointer to the DroneController
+    /// @param videoDriver smart pointer to the VideoDriver
+    /// @param pilot smart pointer to the Pilot
+    ArsdkTransport(std::shared_ptr<DroneController> droneController, std::shared_ptr<VideoDriver> videoDriver,
+                   std::shared_ptr<Pilot> pilot)
+        : m_droneController(droneController), m_videoDriver(videoDriver), m_pilot(pilot) {}
+
+    void start() override { if (m_droneController) { m_droneController->start(); } }
+    void stop() override  { if (m_droneController) { m_droneController->stop(); } }
+
+    eARCONTROLLER_DEVICE_STATE getLastState() override
+    {
+        return m_droneController ? m_droneController->getLastState() : ARCONTROLLER_DEVICE_STATE_STOPPED;
+    }
+
+    bool waitForStateChange() override { return m_droneController && m_droneController->waitForStateChange(); }
+
+    void registerCommandReceivedCallback(const CommandReceivedCallback &callback, void *customData) override
+    {
+        if (m_droneController) { m_droneController->registerCommandReceivedCallback(callback, customData); }
+    }
+
+    void registerVideoCallback(const VideoDecoderConfigCallback &decoderCallback,
+                               const VideoFrameReceivedCallback &videoCallback, void *customData) override
+    {
+        if (m_videoDriver) { m_videoDriver->registerVideoCallback(decoderCallback, videoCallback, customData); }
+    }
+
+    void startVideo() override { if (m_videoDriver) { m_videoDriver->start(); } }
+    void stopVideo() override  { if (m_videoDriver) { m_videoDriver->stop(); } }
+
+    std::shared_ptr<VideoFrame> getFrame() override
+    {
+        return m_videoDriver ? m_videoDriver->getFrame() : nullptr;
+    }
+
+    std::shared_ptr<std::mutex> getBufferMutex() override
+    {
+        return m_videoDriver ? m_videoDriver->getBufferMutex() : nullptr;
+    }
+
+    void moveRelativeMetres(float dx, float dy, float dz, float heading) override
+    {
+        if (!m_pilot) { return; }
+#ifndef RESTRICTED_ALTITUDE
+        if (dz != 0.0f) {
+            m_pilot->moveRelativeMetresRestricted(dx, dy, dz, heading, false);
+            return;
+        }
+#endif
+        m_pilot->moveRelativeMetres(dx, dy, heading, false);
+    }
+
+    unsigned getBatteryLevel() override { return m_drone ? m_drone->getBatteryLevel() : 0; }
+
+    /// The setpoint is stored in the device controller, whose looper sends the stored PCMD every 25 ms.
+    /// Sending it directly as well would interleave it with the looper's copy of the previous values.
+    bool sendPilotingSetpoint(const PilotingSetpoint &setpoint) override
+    {
+        ARCONTROLLER_Device_t *device = m_droneController ? m_droneController->getDeviceController() : nullptr;
+        if (!device || !device->aRDrone3) { return false; }
+        return device->aRDrone3->setPilotingPCMD(device->aRDrone3, setpoint.useRollPitch ? 1 : 0, setpoint.roll,
+                                                 setpoint.pitch, setpoint.yaw, setpoint.gaz,
+                                                 setpoint.timestampAndSeqNum) == ARCONTROLLER_OK;
+    }
+
+    bool sendCameraOrientation(float tilt, float pan) override
+    {
+        ARCONTROLLER_Device_t *device = m_droneController ? m_droneController->getDeviceController() : nullptr;
+        if (!device || !device->aRDrone3) { return false; }
+        return device->aRDrone3->sendCameraOrientationV2(device->aRDrone3, tilt, pan) == ARCONTROLLER_OK;
+    }
+
+    /// Get the Bebop2 this transport was constructed from
+    /// @returns smart pointer to the Bebop2, nullptr when constructed from components
+    std::shared_ptr<Bebop2> getDrone() { return m_drone; }
+
+private:
+    std::shared_ptr<Bebop2>          m_drone           = nullptr; ///< the drone, if constructed from one
+    std::shared_ptr<DroneController> m_droneController = nullptr; ///< device controller
+    std::shared_ptr<VideoDriver>     m_videoDriver     = nullptr; ///< video driver
+    std::shared_ptr<Pilot>           m_pilot           = nullptr; ///< piloting
+};
+
+} // wscDrone
+
+#endif /* DRONETRANSPORT_H_ */
@@ -0,0 +1,265 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains a single-threaded epoll event loop with posted
+ * tasks, periodic timers and file descriptor watches.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef EVENTLOOP_H_
+#define EVENTLOOP_H_
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace wscDrone {
+
+/// alias for work run on the event loop thread
+using EventTask = std::function<void()>;
+
+/// alias for a file descriptor handler, receives the epoll event bits
+using EventHandler = std::function<void(uint32_t events)>;
+
+/// One thread that runs posted tasks, periodic timers and file descriptor handlers. Handlers must not
+/// block; long operations belong on another thread, which can post its result back.
+class EventLoop {
+public:
+    /// Create the epoll instance. Throws std::runtime_error if the kernel objects cannot be created.
+    EventLoop()
+    {
+        m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+        m_wakeFd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_epollFd < 0 || m_wakeFd < 0) {
+            m_closeFds();
+            throw std::runtime_error("EventLoop: unable to create epoll or eventfd");
+        }
+        epoll_event event = {};
+        event.events  = EPOLLIN;
+        event.data.fd = m_wakeFd;
+        epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event);
+    }
+
+    /// Stops the loop and releases the file descriptors
+    ~EventLoop()
+    {
+        stop();
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            for (auto &timer : m_timers) { close(timer.first); }
+        }
+        m_closeFds();
+    }
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    /// Start the loop thread
+    void start()
+    {
+        if (m_running.exchange(true)) { return; }
+        m_thread = std::thread(&EventLoop::m_loop, this);
+    }
+
+    /// Stop and join the loop thread. Tasks posted but not yet run are discarded.
+    void stop()
+    {
+        if (!m_running.exchange(false)) { return; }
+        m_wake();
+        if (m_thread.joinable()) { m_thread.join(); }
+    }
+
+    /// Check if the caller is on the loop thread
+    /// @returns true on the loop thread
+    bool isLoopThread() const { return std::this_thread::get_id() == m_thread.get_id(); }
+
+    /// Run a task on the loop thread. Safe from any thread.
+    /// @param task the task
+    void post(EventTask task)
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        m_wake();
+    }
+
+    /// Run a handler on the loop thread every periodMilliseconds. Safe from any thread.
+    /// @param periodMilliseconds the period, also the delay before the first run
+    /// @param task the handler
+    /// @returns a timer id for cancelTimer(), or -1 on failure
+    int addTimer(unsigned periodMilliseconds, EventTask task)
+    {
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd < 0) { return -1; }
+        itimerspec spec = {};
+        spec.it_interval.tv_sec  = periodMilliseconds / 1000;
+        spec.it_interval.tv_nsec = static_cast<long>(periodMilliseconds % 1000) * 1000000L;
+        spec.it_value            = spec.it_interval;
+        if (periodMilliseconds == 0 || timerfd_settime(fd, 0, &spec, nullptr) < 0) {
+            close(fd);
+            return -1;
+        }
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_timers[fd] = std::make_shared<EventTask>(std::move(task));
+        }
+        if (!m_watch(fd, EPOLLIN)) {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_timers.erase(fd);
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    /// Cancel a timer. The handler will not run again once this returns, unless called from another
+    /// thread while the handler is running.
+    /// @param timerId the id returned by addTimer()
+    void cancelTimer(int timerId)
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        auto it = m_timers.find(timerId);
+        if (it == m_timers.end()) { return; }
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, timerId, nullptr);
+        close(timerId);
+        m_timers.erase(it);
+    }
+
+    /// Watch a file descriptor. The caller keeps ownership of the descriptor.
+    /// @param fd the descriptor
+    /// @param events epoll event bits, e.g. EPOLLIN
+    /// @param handler the handler to run on the loop thread when an event occurs
+    /// @returns true on success
+    bool addFd(int fd, uint32_t events, EventHandler handler)
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_handlers[fd] = std::make_shared<EventHandler>(std::move(handler));
+        }
+        if (!m_watch(fd, events)) {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_handlers.erase(fd);
+            return false;
+        }
+        return true;
+    }
+
+    /// Stop watching a file descriptor
+    /// @param fd the descriptor passed to addFd()
+    void removeFd(int fd)
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        if (m_handlers.erase(fd) > 0) {
+            epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+    }
+
+private:
+    static constexpr int MAX_EVENTS = 32;
+
+    int m_epollFd = -1;                      ///< the epoll instance
+    int m_wakeFd  = -1;                      ///< eventfd used to interrupt epoll_wait
+    std::atomic<bool> m_running{false};      ///< true while the loop thread should run
+    std::thread m_thread;                    ///< the loop thread
+    std::mutex  m_mutex;                     ///< protects the containers below
+    std::vector<EventTask> m_tasks;          ///< posted tasks waiting to run
+    std::map<int, std::shared_ptr<EventTask>>    m_timers;   ///< timerfd to handler
+    std::map<int, std::shared_ptr<EventHandler>> m_handlers; ///< watched fd to handler
+
+    void m_closeFds()
+    {
+        if (m_wakeFd  >= 0) { close(m_wakeFd);  m_wakeFd  = -1; }
+        if (m_epollFd >= 0) { close(m_epollFd); m_epollFd = -1; }
+    }
+
+    bool m_watch(int fd, uint32_t events)
+    {
+        epoll_event event = {};
+        event.events  = events;
+        event.data.fd = fd;
+        return epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+    }
+
+    void m_wake()
+    {
+        uint64_t one = 1;
+        ssize_t written = write(m_wakeFd, &one, sizeof(one));
+        (void)written; // EAGAIN means the counter is already non-zero, which is all we need
+    }
+
+    void m_runTasks()
+    {
+        std::vector<EventTask> tasks;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            tasks.swap(m_tasks);
+        }
+        for (auto &task : tasks) {
+            if (!m_running.load(std::memory_order_relaxed)) { return; }
+            task();
+        }
+    }
+
+    void m_dispatch(int fd, uint32_t events)
+    {
+        std::shared_ptr<EventTask>    timer;
+        std::shared_ptr<EventHandler> handler;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            auto timerIt = m_timers.find(fd);
+            if (timerIt != m_timers.end()) {
+                uint64_t expirations;
+                if (read(fd, &expirations, sizeof(expirations)) < 0) { return; }
+                timer = timerIt->second;
+            } else {
+                auto handlerIt = m_handlers.find(fd);
+                if (handlerIt == m_handlers.end()) { return; }
+                handler = handlerIt->second;
+            }
+        }
+        if (timer)   { (*timer)(); }
+        if (handler) { (*handler)(events); }
+    }
+
+    void m_loop()
+    {
+        epoll_event events[MAX_EVENTS];
+        while (m_running.load()) {
+            int count = epoll_wait(m_epollFd, events, MAX_EVENTS, -1);
+            if (count < 0) { continue; } // EINTR
+            for (int i = 0; i < count && m_running.load(std::memory_order_relaxed); i++) {
+                if (events[i].data.fd == m_wakeFd) {
+                    uint64_t value;
+                    ssize_t bytes = read(m_wakeFd, &value, sizeof(value));
+                    (void)bytes;
+                    m_runTasks();
+                } else {
+                    m_dispatch(events[i].data.fd, events[i].events);
+                }
+            }
+        }
+    }
+};
+
+} // wscDrone
+
+#endif /* EVENTLOOP_H_ */
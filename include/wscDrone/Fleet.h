@@ -0,0 +1,656 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the Fleet class for managing any number of Bebop 2
+ * drones from one event loop and a shared pool of decode threads.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef FLEET_H_
+#define FLEET_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bebop2.h"
+#include "CodecCache.h"
+#include "DroneTransport.h"
+#include "DecodePipeline.h"
+#include "DecodeWorkerPool.h"
+#include "EventLoop.h"
+#include "Utils.h"
+
+namespace wscDrone {
+
+/// Health of one drone in a Fleet
+enum class DroneHealth : unsigned {
+    CONNECTING    = 0, ///< discovery, controller start and video start are in progress
+    HEALTHY       = 1, ///< connected and decoding video
+    VIDEO_STALLED = 2, ///< connected but no frame has been decoded within FleetOptions::videoStallMs
+    DISCONNECTED  = 3, ///< the device controller has left the running state
+    FAILED        = 4  ///< the connection could not be established before the deadline
+};
+
+/// Fleet configuration
+struct FleetOptions {
+    size_t   decodeThreads    = 0;     ///< shared decode threads, 0 picks half the hardware threads
+    size_t   leadDecodeThreads = 0;    ///< decode threads reserved for the lead drone, see setLeadDrone()
+    bool     batchConversion  = false; ///< convert the decoded pictures of several drones back to back
+    size_t   connectThreads   = 4;     ///< threads creating, starting and tearing down drones
+    size_t   queueDepth       = 8;     ///< compressed frames queued per drone
+    OverflowPolicy overflowPolicy = OverflowPolicy::DROP_OLDEST; ///< per drone decode queue policy
+    AdaptiveDecodeOptions adaptiveDecode; ///< per drone frame rate limit and adaptive decode quality
+    unsigned connectTimeoutMs = 10000; ///< deadline for a drone to reach the running state
+    unsigned connectPollMs    = 10;    ///< period of the check for drones reaching the running state
+    std::string codecCachePath;        ///< file remembering each drone's SPS/PPS across runs, empty for memory only
+    unsigned statsIntervalMs  = 1000;  ///< period of the health check and rate computation
+    unsigned videoStallMs     = 1000;  ///< frame gap after which a connected drone is VIDEO_STALLED
+};
+
+/// A snapshot of the health and throughput of one drone
+struct FleetDroneStats {
+    std::string ipAddress;                   ///< IP address of the drone
+    DroneHealth health = DroneHealth::CONNECTING; ///< current health
+    unsigned batteryLevel      = 0;          ///< battery level, 0 to 100
+    uint64_t runningNs         = 0;          ///< time from addDrone() until the controller was running, 0 until then
+    uint64_t connectNs         = 0;          ///< time from addDrone() until video started, 0 until then
+    uint64_t firstFrameNs      = 0;          ///< time from addDrone() until the first decoded frame, 0 until then
+    bool     codecCacheHit     = false;      ///< the decoder was primed with cached SPS/PPS
+    double   framesPerSecond   = 0.0;        ///< decoded frames per second over the last stats interval
+    double   megabitsPerSecond = 0.0;        ///< compressed video bitrate over the last stats interval
+    DecodePipelineStats video;               ///< counters of the drone's decode pipeline
+};
+
+/// alias for a function creating the transport of one fleet drone. It runs on a connect thread.
+using TransportFactory = std::function<std::shared_ptr<DroneTransport>()>;
+
+/// alias for the callback invoked on the event loop thread when a drone's health changes
+using HealthChangeCallback = void (*)(const std::string &ipAddress, DroneHealth health, void *customData);
+
+/// The Fleet manages any number of drones identified by IP address, replacing the fixed Callsign set.
+/// @details Library threads are shared rather than created per drone: one EventLoop thread runs the
+/// periodic health checks and callbacks, a DecodeWorkerPool decodes every video stream, and a small
+/// set of connect threads brings drones up and down in parallel. Adding a tenth or thirtieth drone
+/// therefore adds no library threads. The threads created internally by ARSDK for each device
+/// controller are outside the library's control.
+/// Connecting never holds a connect thread while a drone is on its way up: a connect thread creates the
+/// transport and the decode pipeline and requests the controller start, the event loop watches every
+/// starting drone against its deadline, and a connect thread starts the video once it is running. All
+/// drones therefore come up concurrently whatever FleetOptions::connectThreads is. The decode pipeline
+/// is primed with the SPS/PPS the drone sent on its previous connection, kept in a CodecParameterCache,
+/// so the decoder is open before the first I-frame arrives. FleetDroneStats reports the time each drone
+/// took to reach the running state, start video and decode its first frame.
+class Fleet {
+public:
+    /// Construct a fleet. Threads are started by start().
+    /// @param options fleet configuration
+    explicit Fleet(const FleetOptions &options = FleetOptions())
+        : m_options(options), m_codecCache(std::make_shared<CodecParameterCache>(options.codecCachePath)) {}
+
+    /// Removes every drone and stops all threads
+    ~Fleet() { stop(); }
+
+    Fleet(const Fleet &) = delete;
+    Fleet &operator=(const Fleet &) = delete;
+
+    /// Start the event loop, decode pool and connect threads
+    void start()
+    {
+        if (m_running.exchange(true)) { return; }
+        DecodeWorkerPoolOptions poolOptions;
+        poolOptions.numThreads      = m_options.decodeThreads;
+        poolOptions.leadThreads     = m_options.leadDecodeThreads;
+        poolOptions.batchConversion = m_options.batchConversion;
+        m_decodePool = std::make_shared<DecodeWorkerPool>(poolOptions);
+        m_eventLoop.start();
+        m_statsTimer = m_eventLoop.addTimer(m_options.statsIntervalMs, [this]() { m_checkHealth(); });
+        m_connectTimer = m_eventLoop.addTimer(m_options.connectPollMs > 0 ? m_options.connectPollMs : 1,
+                                              [this]() { m_pollStarting(); });
+        const size_t connectThreads = m_options.connectThreads > 0 ? m_options.connectThreads : 1;
+        for (size_t i = 0; i < connectThreads; i++) {
+            m_connectThreads.emplace_back(&Fleet::m_connectLoop, this);
+        }
+    }
+
+    /// Remove every drone, waiting for them to be torn down, and stop all threads
+    void stop()
+    {
+        if (!m_running.load()) { return; }
+        for (const std::string &ipAddress : getIpAddresses()) {
+            removeDrone(ipAddress);
+        }
+        {
+            std::unique_lock<std::mutex> lck(m_jobMutex);
+            m_jobIdleCv.wait(lck, [this]() { return m_jobs.empty() && m_activeJobs == 0 && m_starting.empty(); });
+            m_running = false;
+        }
+        m_jobCv.notify_all();
+        for (auto &thread : m_connectThreads) {
+            if (thread.joinable()) { thread.join(); }
+        }
+        m_connectThreads.clear();
+        m_eventLoop.cancelTimer(m_statsTimer);
+        m_eventLoop.cancelTimer(m_connectTimer);
+        m_eventLoop.stop();
+        m_decodePool.reset();
+    }
+
+    /// Add a drone and start connecting to it in the background. Its health is CONNECTING until it is
+    /// HEALTHY or FAILED.
+    /// @param ipAddress the IP address of the drone
+    /// @param frame the VideoFrame the drone's video is decoded into
+    /// @returns false if the fleet is not started or the address is already in the fleet
+    bool addDrone(const std::string &ipAddress, std::shared_ptr<VideoFrame> frame)
+    {
+        return addTransport(ipAddress, [ipAddress, frame]() -> std::shared_ptr<DroneTransport> {
+            return std::make_shared<ArsdkTransport>(std::make_shared<Bebop2>(ipAddress, frame));
+        });
+    }
+
+    /// Add a drone with any transport, e.g. a SimulatedDrone, and start connecting to it in the background
+    /// @param ipAddress the name of the drone in the fleet, normally its IP address
+    /// @param factory creates the transport on a connect thread. It may throw to fail the connection.
+    /// @returns false if the fleet is not started or the name is already in the fleet
+    bool addTransport(const std::string &ipAddress, TransportFactory factory)
+    {
+        if (!m_running.load()) { return false; }
+        std::shared_ptr<Member> member = std::make_shared<Member>();
+        member->ipAddress = ipAddress;
+        member->factory   = std::move(factory);
+        member->addedNs   = monotonicNanoseconds();
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            if (!m_members.emplace(ipAddress, member).second) { return false; }
+        }
+        m_submit([this, member]() { m_connect(member); });
+        return true;
+    }
+
+    /// Remove a drone. Its video and controller are stopped in the background.
+    /// @param ipAddress the IP address of the drone
+    /// @returns false if the address is not in the fleet
+    bool removeDrone(const std::string &ipAddress)
+    {
+        std::shared_ptr<Member> member;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            auto it = m_members.find(ipAddress);
+            if (it == m_members.end()) { return false; }
+            member = it->second;
+            m_members.erase(it);
+            member->removed = true;
+        }
+        m_submit([this, member]() { m_disconnect(member); });
+        return true;
+    }
+
+    /// Get a drone
+    /// @param ipAddress the IP address of the drone
+    /// @returns smart pointer to the Bebop2, nullptr until it is connected or if it is not a Bebop2
+    std::shared_ptr<Bebop2> getDrone(const std::string &ipAddress)
+    {
+        std::shared_ptr<ArsdkTransport> arsdk = std::dynamic_pointer_cast<ArsdkTransport>(getTransport(ipAddress));
+        return arsdk ? arsdk->getDrone() : nullptr;
+    }
+
+    /// Get a drone's transport
+    /// @param ipAddress the IP address of the drone
+    /// @returns smart pointer to the DroneTransport, nullptr until it is connected
+    std::shared_ptr<DroneTransport> getTransport(const std::string &ipAddress)
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        auto it = m_members.find(ipAddress);
+        return it == m_members.end() ? nullptr : it->second->transport;
+    }
+
+    /// Get a drone's decode pipeline, e.g. to register a decoded frame callback
+    /// @param ipAddress the IP address of the drone
+    /// @returns smart pointer to the DecodePipeline, nullptr until the drone is connected
+    std::shared_ptr<DecodePipeline> getDecodePipeline(const std::string &ipAddress)
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        auto it = m_members.find(ipAddress);
+        return it == m_members.end() ? nullptr : it->second->pipeline;
+    }
+
+    /// Get the addresses of every drone in the fleet
+    /// @returns the IP addresses
+    std::vector<std::string> getIpAddresses()
+    {
+        std::vector<std::string> addresses;
+        std::lock_guard<std::mutex> lck(m_mutex);
+        for (const auto &entry : m_members) { addresses.push_back(entry.first); }
+        return addresses;
+    }
+
+    /// Get the number of drones in the fleet
+    /// @returns the drone count
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        return m_members.size();
+    }
+
+    /// Get the health and throughput of one drone
+    /// @param ipAddress the IP address of the drone
+    /// @param stats receives the snapshot
+    /// @returns false if the address is not in the fleet
+    bool getDroneStats(const std::string &ipAddress, FleetDroneStats &stats)
+    {
+        std::shared_ptr<Member> member;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            auto it = m_members.find(ipAddress);
+            if (it == m_members.end()) { return false; }
+            member = it->second;
+        }
+        stats = m_snapshot(member);
+        return true;
+    }
+
+    /// Get the health and throughput of every drone
+    /// @returns one snapshot per drone, ordered by IP address
+    std::vector<FleetDroneStats> getStats()
+    {
+        std::vector<FleetDroneStats> stats;
+        for (const auto &member : m_membersSnapshot()) { stats.push_back(m_snapshot(member)); }
+        return stats;
+    }
+
+    /// Get the video counters and latency histograms of every connected drone, labelled by IP address
+    /// @returns one entry per drone with a decode pipeline, ordered by IP address
+    std::vector<DecodePipelineMetrics> getMetrics()
+    {
+        std::vector<DecodePipelineMetrics> metrics;
+        for (const auto &member : m_membersSnapshot()) {
+            std::shared_ptr<DecodePipeline> pipeline;
+            {
+                std::lock_guard<std::mutex> lck(m_mutex);
+                pipeline = member->pipeline;
+            }
+            if (pipeline) { metrics.push_back(pipeline->getMetrics(member->ipAddress)); }
+        }
+        return metrics;
+    }
+
+    /// Get the video metrics of every connected drone in the Prometheus text format
+    /// @returns the metrics text
+    std::string dumpMetrics() { return formatPrometheusMetrics(getMetrics()); }
+
+    /// Designate the lead drone, whose video is decoded ahead of every other drone's and, with
+    /// FleetOptions::leadDecodeThreads, on threads of its own. Any previous lead becomes a normal drone.
+    /// @param ipAddress the IP address of the lead drone, empty for none
+    void setLeadDrone(const std::string &ipAddress)
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        m_leadDrone = ipAddress;
+        for (const auto &entry : m_members) {
+            if (entry.second->pipeline) {
+                entry.second->pipeline->setDecodePriority(entry.first == m_leadDrone ? DecodePriority::LEAD
+                                                                                     : DecodePriority::NORMAL);
+            }
+        }
+    }
+
+    /// Get the lead drone
+    /// @returns the IP address of the lead drone, empty if there is none
+    std::string getLeadDrone()
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        return m_leadDrone;
+    }
+
+    /// Register a callback for drone health changes. It runs on the event loop thread and must not
+    /// block. Call before start().
+    /// @param callback the function to execute on each change
+    /// @param customData a raw pointer passed back to the callback
+    void registerHealthChangeCallback(const HealthChangeCallback &callback, void *customData)
+    {
+        m_healthCallback   = callback;
+        m_healthCustomData = customData;
+    }
+
+    /// Get the number of threads owned by the fleet, which does not depend on the number of drones
+    /// @returns the event loop, decode and connect thread count
+    size_t getThreadCount() const
+    {
+        return 1 + m_connectThreads.size() + (m_decodePool ? m_decodePool->getThreadCount() : 0);
+    }
+
+    /// Get the event loop, e.g. to add application timers alongside the fleet's own
+    /// @returns reference to the event loop
+    EventLoop &getEventLoop() { return m_eventLoop; }
+
+    /// Get the shared decode pool
+    /// @returns smart pointer to the DecodeWorkerPool, nullptr before start()
+    std::shared_ptr<DecodeWorkerPool> getDecodeWorkerPool() { return m_decodePool; }
+
+    /// Get the cache of each drone's SPS/PPS, e.g. to seed it before the drones are added
+    /// @returns smart pointer to the cache
+    std::shared_ptr<CodecParameterCache> getCodecCache() { return m_codecCache; }
+
+private:
+    /// Per-drone state
+    struct Member {
+        std::string ipAddress;                           ///< IP address of the drone
+        TransportFactory                factory;         ///< creates the transport
+        std::shared_ptr<DroneTransport> transport;       ///< the drone, set under m_mutex once connected
+        std::shared_ptr<DecodePipeline> pipeline;        ///< the decode pipeline, set with transport
+        std::atomic<DroneHealth>        health{DroneHealth::CONNECTING}; ///< current health
+        std::atomic<bool>               removed{false};  ///< true once removeDrone() has been called
+        std::atomic<uint64_t>           runningNs{0};    ///< addDrone() to the running state
+        std::atomic<uint64_t>           connectNs{0};    ///< addDrone() to video start
+        std::atomic<bool>               codecCacheHit{false}; ///< the pipeline was primed from the cache
+        uint64_t addedNs     = 0;                        ///< time of addDrone()
+        uint64_t codecConfigs = 0;                       ///< decoder configurations cached, event loop thread only
+
+        std::mutex rateMutex;                            ///< protects the rate fields
+        uint64_t   lastFrames    = 0;                    ///< framesDecoded at the last sample
+        uint64_t   lastBytes     = 0;                    ///< bytesReceived at the last sample
+        uint64_t   lastSampleNs  = 0;                    ///< time of the last sample
+        double     framesPerSecond   = 0.0;              ///< rate over the last interval
+        double     megabitsPerSecond = 0.0;              ///< bitrate over the last interval
+    };
+
+    /// A drone whose controller has been started, waiting for the running state
+    struct Starting {
+        std::shared_ptr<Member>         member;
+        std::shared_ptr<DroneTransport> transport;
+        std::shared_ptr<DecodePipeline> pipeline;
+    };
+
+    FleetOptions m_options;                                      ///< configuration
+    std::shared_ptr<CodecParameterCache> m_codecCache;           ///< SPS/PPS of each drone
+    std::atomic<bool> m_running{false};                          ///< true between start() and stop()
+    EventLoop m_eventLoop;                                       ///< the shared event loop
+    int       m_statsTimer = -1;                                 ///< health check timer id
+    int       m_connectTimer = -1;                               ///< m_pollStarting() timer id
+    std::shared_ptr<DecodeWorkerPool> m_decodePool = nullptr;    ///< shared decode threads
+    std::mutex m_mutex;                                          ///< protects m_members and member pointers
+    std::map<std::string, std::shared_ptr<Member>> m_members;    ///< drones by IP address
+    std::string m_leadDrone;                                     ///< IP address of the lead drone, under m_mutex
+    HealthChangeCallback m_healthCallback = nullptr;             ///< user health callback
+    void *m_healthCustomData = nullptr;                          ///< user data for m_healthCallback
+
+    // Connect threads and their job queue
+    std::vector<std::thread> m_connectThreads;
+    std::mutex m_jobMutex;
+    std::condition_variable m_jobCv;
+    std::condition_variable m_jobIdleCv;
+    std::deque<std::function<void()>> m_jobs;
+    size_t m_activeJobs = 0;
+    std::vector<Starting> m_starting;    ///< drones waiting for the running state, under m_jobMutex
+
+    std::vector<std::shared_ptr<Member>> m_membersSnapshot()
+    {
+        std::vector<std::shared_ptr<Member>> members;
+        std::lock_guard<std::mutex> lck(m_mutex);
+        for (const auto &entry : m_members) { members.push_back(entry.second); }
+        return members;
+    }
+
+    void m_submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_jobMutex);
+            m_jobs.push_back(std::move(job));
+        }
+        m_jobCv.notify_one();
+    }
+
+    void m_connectLoop()
+    {
+        std::unique_lock<std::mutex> lck(m_jobMutex);
+        while (true) {
+            m_jobCv.wait(lck, [this]() { return !m_running.load() || !m_jobs.empty(); });
+            if (m_jobs.empty()) { return; }
+            std::function<void()> job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_activeJobs++;
+            lck.unlock();
+            job();
+            lck.lock();
+            m_activeJobs--;
+            m_jobIdleCv.notify_all();
+        }
+    }
+
+    /// Change a drone's health and notify the callback on the event loop thread
+    void m_setHealth(const std::shared_ptr<Member> &member, DroneHealth health)
+    {
+        if (member->health.exchange(health) == health || !m_healthCallback) { return; }
+        if (m_eventLoop.isLoopThread()) {
+            m_healthCallback(member->ipAddress, health, m_healthCustomData);
+        } else {
+            m_eventLoop.post([this, member, health]() {
+                m_healthCallback(member->ipAddress, health, m_healthCustomData);
+            });
+        }
+    }
+
+    /// Create a drone's transport and decode pipeline and start its controller. Runs on a connect thread.
+    void m_connect(std::shared_ptr<Member> member)
+    {
+        Starting starting;
+        starting.member = member;
+        try {
+            starting.transport = member->factory();
+
+            // One libavcodec thread per stream, the pool provides the parallelism across streams
+            DecoderOptions decoderOptions;
+            decoderOptions.threadCount = 1;
+            starting.pipeline = std::make_shared<DecodePipeline>(starting.transport, m_options.queueDepth,
+                                                                 m_options.overflowPolicy, decoderOptions);
+            starting.pipeline->setWorkerPool(m_decodePool);
+            starting.pipeline->setAdaptiveDecode(m_options.adaptiveDecode);
+            H264CodecParameters codec;
+            if (m_codecCache->get(member->ipAddress, codec)) {
+                starting.pipeline->setDecoderConfig(codec.sps, codec.pps);
+                member->codecCacheHit = true;
+            }
+            // the decoder opens while the controller connects
+            starting.pipeline->start();
+            starting.transport->start();
+        } catch (const std::exception &) {
+            if (starting.pipeline) { starting.pipeline->stop(); }
+            m_setHealth(member, DroneHealth::FAILED);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lck(m_jobMutex);
+        m_starting.push_back(std::move(starting));
+    }
+
+    /// Hand every starting drone that is running, removed or past its deadline to a connect thread.
+    /// Runs on the event loop thread.
+    void m_pollStarting()
+    {
+        const uint64_t nowNs     = monotonicNanoseconds();
+        const uint64_t timeoutNs = static_cast<uint64_t>(m_options.connectTimeoutMs) * 1000000ULL;
+        bool submitted = false;
+        {
+            std::lock_guard<std::mutex> lck(m_jobMutex);
+            for (auto it = m_starting.begin(); it != m_starting.end();) {
+                const Starting &starting = *it;
+                const bool running = starting.transport->getLastState() == ARCONTROLLER_DEVICE_STATE_RUNNING;
+                const bool removed = starting.member->removed.load();
+                if (!running && !removed && nowNs <= starting.member->addedNs + timeoutNs) {
+                    ++it;
+                    continue;
+                }
+                // moved straight from m_starting to m_jobs, so stop() always sees the drone in one of them
+                if (running && !removed) {
+                    starting.member->runningNs = nowNs - starting.member->addedNs;
+                    m_jobs.push_back([this, starting]() { m_startVideo(starting); });
+                } else {
+                    m_jobs.push_back([this, starting]() { m_abandon(starting); });
+                }
+                it = m_starting.erase(it);
+                submitted = true;
+            }
+        }
+        if (submitted) { m_jobCv.notify_all(); }
+    }
+
+    /// Start the video of a running drone and make it visible. Runs on a connect thread.
+    void m_startVideo(const Starting &starting)
+    {
+        const std::shared_ptr<Member> &member = starting.member;
+        try {
+            starting.transport->startVideo();
+        } catch (const std::exception &) {
+            m_abandon(starting);
+            return;
+        }
+
+        bool removed;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            removed = member->removed.load();
+            if (!removed) {
+                // the first frames may already be queued at NORMAL priority, which is harmless
+                starting.pipeline->setDecodePriority(member->ipAddress == m_leadDrone ? DecodePriority::LEAD
+                                                                                      : DecodePriority::NORMAL);
+                member->transport = starting.transport;
+                member->pipeline  = starting.pipeline;
+                member->connectNs = monotonicNanoseconds() - member->addedNs;
+            }
+        }
+        if (removed) {
+            // removed while connecting, m_disconnect found nothing to stop
+            m_stopDrone(starting.transport, starting.pipeline);
+            return;
+        }
+        m_setHealth(member, DroneHealth::HEALTHY);
+    }
+
+    /// Tear down a drone that did not come up. Runs on a connect thread.
+    void m_abandon(const Starting &starting)
+    {
+        starting.transport->stop();
+        starting.pipeline->stop();
+        m_setHealth(starting.member, DroneHealth::FAILED);
+    }
+
+    /// Tear a removed drone down. Runs on a connect thread.
+    void m_disconnect(std::shared_ptr<Member> member)
+    {
+        std::shared_ptr<DroneTransport> transport;
+        std::shared_ptr<DecodePipeline> pipeline;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            transport = member->transport;
+            pipeline  = member->pipeline;
+            member->transport = nullptr;
+            member->pipeline  = nullptr;
+        }
+        if (transport) { m_stopDrone(transport, pipeline); }
+    }
+
+    void m_stopDrone(std::shared_ptr<DroneTransport> transport, std::shared_ptr<DecodePipeline> pipeline)
+    {
+        transport->stopVideo();
+        if (pipeline) { pipeline->stop(); }
+        transport->stop();
+    }
+
+    /// Update rates and health of every drone. Runs on the event loop thread.
+    void m_checkHealth()
+    {
+        const uint64_t nowNs   = monotonicNanoseconds();
+        const uint64_t stallNs = static_cast<uint64_t>(m_options.videoStallMs) * 1000000ULL;
+        for (const auto &member : m_membersSnapshot()) {
+            std::shared_ptr<DroneTransport> transport;
+            std::shared_ptr<DecodePipeline> pipeline;
+            {
+                std::lock_guard<std::mutex> lck(m_mutex);
+                transport = member->transport;
+                pipeline  = member->pipeline;
+            }
+            if (!transport || !pipeline) { continue; }
+
+            DecodePipelineStats video = pipeline->getStats();
+            m_cacheCodec(member, *pipeline);
+            {
+                std::lock_guard<std::mutex> lck(member->rateMutex);
+                if (member->lastSampleNs != 0 && nowNs > member->lastSampleNs) {
+                    const double seconds = (nowNs - member->lastSampleNs) / 1e9;
+                    member->framesPerSecond   = (video.framesDecoded - member->lastFrames) / seconds;
+                    member->megabitsPerSecond = (video.bytesReceived - member->lastBytes) * 8.0 / 1e6 / seconds;
+                }
+                member->lastFrames   = video.framesDecoded;
+                member->lastBytes    = video.bytesReceived;
+                member->lastSampleNs = nowNs;
+            }
+
+            const uint64_t lastVideoNs = video.lastFrameNs ? video.lastFrameNs : member->addedNs + member->connectNs.load();
+            if (transport->getLastState() != ARCONTROLLER_DEVICE_STATE_RUNNING) {
+                m_setHealth(member, DroneHealth::DISCONNECTED);
+            } else if (nowNs > lastVideoNs + stallNs) {
+                m_setHealth(member, DroneHealth::VIDEO_STALLED);
+            } else {
+                m_setHealth(member, DroneHealth::HEALTHY);
+            }
+        }
+    }
+
+    /// Store the SPS/PPS a drone sent in the codec cache when they changed. Runs on the event loop thread.
+    void m_cacheCodec(const std::shared_ptr<Member> &member, DecodePipeline &pipeline)
+    {
+        H264CodecParameters codec;
+        const uint64_t configs = pipeline.getDecoderConfig(codec.sps, codec.pps);
+        if (configs == member->codecConfigs) { return; }
+        member->codecConfigs = configs;
+        m_codecCache->set(member->ipAddress, codec);
+    }
+
+    FleetDroneStats m_snapshot(const std::shared_ptr<Member> &member)
+    {
+        FleetDroneStats stats;
+        stats.ipAddress = member->ipAddress;
+        stats.health    = member->health.load();
+        stats.runningNs = member->runningNs.load();
+        stats.connectNs = member->connectNs.load();
+        stats.codecCacheHit = member->codecCacheHit.load();
+        std::shared_ptr<DroneTransport> transport;
+        std::shared_ptr<DecodePipeline> pipeline;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            transport = member->transport;
+            pipeline  = member->pipeline;
+        }
+        if (transport) { stats.batteryLevel = transport->getBatteryLevel(); }
+        if (pipeline) {
+            stats.video = pipeline->getStats();
+            if (stats.video.firstFrameNs > member->addedNs) {
+                stats.firstFrameNs = stats.video.firstFrameNs - member->addedNs;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lck(member->rateMutex);
+            stats.framesPerSecond   = member->framesPerSecond;
+            stats.megabitsPerSecond = member->megabitsPerSecond;
+        }
+        return stats;
+    }
+};
+
+} // wscDrone
+
+#endif /* FLEET_H_ */
@@ -0,0 +1,387 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the on-disk format of flight logs and a memory-mapped
+ * reader for them.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef FLIGHTLOG_H_
+#define FLIGHTLOG_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libARController/ARController.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace wscDrone {
+
+/// A flight log is a set of segment files, <path>.00000, <path>.00001 and so on, plus an index file
+/// <path>.idx. Each segment starts with a FlightLogFileHeader followed by 8 byte aligned records, each
+/// a FlightLogRecordHeader and its payload. A record type of END, or the end of the file, ends the
+/// segment. The index holds a FlightLogFileHeader and one FlightLogIndexEntry per record. All values
+/// are in host byte order.
+/// @details Payloads by record type:
+///  - DECODER_CONFIG: uint32 SPS size, uint32 PPS size, the SPS then the PPS, both with start codes
+///  - VIDEO_FRAME: the H.264 access unit as received, flags has FLIGHT_RECORD_IFRAME for I-frames
+///  - COMMAND: key is the ARSDK command key. uint32 argument count, then per argument a
+///    FlightLogArgument, the NUL terminated name and the value: the 8 byte value union, or the NUL
+///    terminated string for ARCONTROLLER_DICTIONARY_VALUE_TYPE_STRING.
+enum class FlightRecordType : uint32_t {
+    END            = 0, ///< no more records in this segment
+    DECODER_CONFIG = 1, ///< H.264 SPS and PPS
+    VIDEO_FRAME    = 2, ///< compressed video frame
+    COMMAND        = 3  ///< ARSDK command with its arguments
+};
+
+constexpr char     FLIGHT_LOG_SEGMENT_MAGIC[8] = {'W', 'S', 'C', 'F', 'L', 'O', 'G', '\0'};
+constexpr char     FLIGHT_LOG_INDEX_MAGIC[8]   = {'W', 'S', 'C', 'F', 'I', 'D', 'X', '\0'};
+constexpr uint32_t FLIGHT_LOG_VERSION   = 1;
+constexpr uint32_t FLIGHT_RECORD_IFRAME = 1; ///< VIDEO_FRAME flag for an I-frame
+
+/// Header of segment and index files
+struct FlightLogFileHeader {
+    char     magic[8];    ///< FLIGHT_LOG_SEGMENT_MAGIC or FLIGHT_LOG_INDEX_MAGIC
+    uint32_t version;     ///< FLIGHT_LOG_VERSION
+    uint32_t segment;     ///< segment number, zero for the index
+    uint64_t createdNs;   ///< monotonic time the file was created
+    uint64_t reserved;
+};
+
+/// Header of one record
+struct FlightLogRecordHeader {
+    uint32_t type;        ///< FlightRecordType
+    uint32_t size;        ///< payload size in bytes, excluding this header and padding
+    uint64_t timestampNs; ///< monotonic time the callback received the data
+    uint32_t flags;       ///< record type specific flags
+    uint32_t key;         ///< ARSDK command key of COMMAND records
+};
+
+/// One index entry
+struct FlightLogIndexEntry {
+    uint64_t timestampNs; ///< record timestamp
+    uint32_t segment;     ///< segment number
+    uint32_t offset;      ///< byte offset of the record header in the segment
+    uint32_t type;        ///< FlightRecordType
+    uint32_t flags;       ///< record flags
+};
+
+/// Header of one COMMAND argument
+struct FlightLogArgument {
+    uint16_t nameSize;    ///< name size including its NUL
+    uint16_t valueType;   ///< eARCONTROLLER_DICTIONARY_VALUE_TYPE
+    uint32_t valueSize;   ///< value size in bytes
+};
+
+static_assert(sizeof(FlightLogFileHeader) == 32, "flight log file header must be 32 bytes");
+static_assert(sizeof(FlightLogRecordHeader) == 24, "flight log record header must be 24 bytes");
+static_assert(sizeof(FlightLogIndexEntry) == 24, "flight log index entry must be 24 bytes");
+
+/// Get the file name of a segment
+/// @param path the flight log path
+/// @param segment the segment number
+/// @returns the segment file name
+inline std::string flightLogSegmentPath(const std::string &path, uint32_t segment)
+{
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), ".%05u", segment);
+    return path + suffix;
+}
+
+/// Get the file name of the index
+/// @param path the flight log path
+/// @returns the index file name
+inline std::string flightLogIndexPath(const std::string &path) { return path + ".idx"; }
+
+/// Get the space a record takes in a segment
+/// @param payloadSize the payload size in bytes
+/// @returns the header, payload and padding size in bytes
+inline size_t flightLogRecordBytes(size_t payloadSize)
+{
+    return (sizeof(FlightLogRecordHeader) + payloadSize + 7) & ~static_cast<size_t>(7);
+}
+
+/// One record of a flight log, pointing into the mapped segment
+struct FlightLogRecord {
+    FlightRecordType type = FlightRecordType::END; ///< record type
+    uint32_t flags       = 0;       ///< record flags
+    uint32_t key         = 0;       ///< ARSDK command key of COMMAND records
+    uint64_t timestampNs = 0;       ///< monotonic receive time
+    const uint8_t *data  = nullptr; ///< the payload
+    uint32_t size        = 0;       ///< payload size in bytes
+};
+
+/// Maps the segments of a flight log read-only and lists its records in timestamp order. The index is
+/// used when present, and any records written after the last index entry, e.g. by a recorder that did
+/// not shut down cleanly, are recovered by scanning the segments.
+class FlightLogReader {
+public:
+    FlightLogReader() = delete;
+
+    /// Open a flight log
+    /// @param path the flight log path, without the segment or index suffix
+    explicit FlightLogReader(const std::string &path)
+    {
+        m_mapSegments(path);
+        if (m_segments.empty()) {
+            throw std::runtime_error("FlightLogReader: no flight log segments at " + path);
+        }
+        uint32_t segment = 0;
+        size_t   offset  = sizeof(FlightLogFileHeader);
+        m_indexed = m_loadIndex(path, segment, offset);
+        if (!m_indexed) {
+            m_records.clear();
+            segment = 0;
+            offset  = sizeof(FlightLogFileHeader);
+        }
+        m_scan(segment, offset);
+        std::stable_sort(m_records.begin(), m_records.end(), [](const FlightLogRecord &a, const FlightLogRecord &b) {
+            return a.timestampNs < b.timestampNs;
+        });
+    }
+
+    /// Unmaps the segments
+    ~FlightLogReader()
+    {
+        for (auto &segment : m_segments) { munmap(segment.data, segment.size); }
+    }
+
+    FlightLogReader(const FlightLogReader &) = delete;
+    FlightLogReader &operator=(const FlightLogReader &) = delete;
+
+    /// Get the number of records
+    /// @returns the record count
+    size_t size() const { return m_records.size(); }
+
+    /// Get a record
+    /// @param index record number, 0 to size() - 1
+    /// @returns the record
+    const FlightLogRecord &operator[](size_t index) const { return m_records[index]; }
+
+    /// Get every record in timestamp order
+    /// @returns the records
+    const std::vector<FlightLogRecord> &getRecords() const { return m_records; }
+
+    /// Check whether the index file was used
+    /// @returns false if the records were found by scanning the segments
+    bool isIndexed() const { return m_indexed; }
+
+    /// Find the first record at or after a time
+    /// @param timestampNs the time to look for
+    /// @returns the record number, size() if every record is earlier
+    size_t seek(uint64_t timestampNs) const
+    {
+        auto it = std::lower_bound(m_records.begin(), m_records.end(), timestampNs,
+                                   [](const FlightLogRecord &record, uint64_t ns) { return record.timestampNs < ns; });
+        return static_cast<size_t>(it - m_records.begin());
+    }
+
+    /// Find the last I-frame at or before a time, where decoding can start
+    /// @param timestampNs the time to look for
+    /// @returns the record number, size() if there is no earlier I-frame
+    size_t seekIFrame(uint64_t timestampNs) const
+    {
+        size_t index = seek(timestampNs + 1);
+        while (index > 0) {
+            index--;
+            const FlightLogRecord &record = m_records[index];
+            if (record.type == FlightRecordType::VIDEO_FRAME && (record.flags & FLIGHT_RECORD_IFRAME)) { return index; }
+        }
+        return m_records.size();
+    }
+
+    /// Decode the payload of a DECODER_CONFIG record
+    /// @param record the record
+    /// @param sps receives a pointer to the SPS
+    /// @param spsSize receives the SPS size in bytes
+    /// @param pps receives a pointer to the PPS
+    /// @param ppsSize receives the PPS size in bytes
+    /// @returns false if the record is not a valid DECODER_CONFIG record
+    static bool parseDecoderConfig(const FlightLogRecord &record, const uint8_t *&sps, uint32_t &spsSize,
+                                   const uint8_t *&pps, uint32_t &ppsSize)
+    {
+        if (record.type != FlightRecordType::DECODER_CONFIG || record.size < 8) { return false; }
+        std::memcpy(&spsSize, record.data, sizeof(spsSize));
+        std::memcpy(&ppsSize, record.data + 4, sizeof(ppsSize));
+        if (static_cast<uint64_t>(spsSize) + ppsSize + 8 > record.size) { return false; }
+        sps = record.data + 8;
+        pps = sps + spsSize;
+        return true;
+    }
+
+    /// Decode the arguments of a COMMAND record
+    /// @param record the record
+    /// @param visit callable invoked as visit(const char *name, eARCONTROLLER_DICTIONARY_VALUE_TYPE type,
+    /// const ARCONTROLLER_DICTIONARY_VALUE_t &value) for each argument. Names and strings point into the log.
+    /// @returns false if the record is not a valid COMMAND record
+    template <typename Visit>
+    static bool forEachArgument(const FlightLogRecord &record, Visit &&visit)
+    {
+        if (record.type != FlightRecordType::COMMAND || record.size < 4) { return false; }
+        uint32_t count;
+        std::memcpy(&count, record.data, sizeof(count));
+        size_t pos = 4;
+        for (uint32_t i = 0; i < count; i++) {
+            FlightLogArgument argument;
+            if (pos + sizeof(argument) > record.size) { return false; }
+            std::memcpy(&argument, record.data + pos, sizeof(argument));
+            pos += sizeof(argument);
+            if (argument.nameSize == 0 || pos + argument.nameSize + argument.valueSize > record.size) { return false; }
+            const char *name = reinterpret_cast<const char *>(record.data + pos);
+            const uint8_t *valueData = record.data + pos + argument.nameSize;
+            if (name[argument.nameSize - 1] != '\0') { return false; }
+
+            ARCONTROLLER_DICTIONARY_VALUE_t value;
+            std::memset(&value, 0, sizeof(value));
+            const auto type = static_cast<eARCONTROLLER_DICTIONARY_VALUE_TYPE>(argument.valueType);
+            if (type == ARCONTROLLER_DICTIONARY_VALUE_TYPE_STRING) {
+                if (argument.valueSize == 0 || valueData[argument.valueSize - 1] != '\0') { return false; }
+                value.String = const_cast<char *>(reinterpret_cast<const char *>(valueData));
+            } else {
+                std::memcpy(&value, valueData, std::min<size_t>(argument.valueSize, sizeof(value)));
+            }
+            visit(name, type, value);
+            pos += argument.nameSize + argument.valueSize;
+        }
+        return true;
+    }
+
+private:
+    /// One mapped segment
+    struct Segment {
+        uint8_t *data = nullptr;
+        size_t   size = 0;
+    };
+
+    std::vector<Segment>         m_segments;        ///< mapped segments in order
+    std::vector<FlightLogRecord> m_records;         ///< every record
+    bool                         m_indexed = false; ///< true if the index was used
+
+    void m_mapSegments(const std::string &path)
+    {
+        for (uint32_t number = 0;; number++) {
+            int fd = open(flightLogSegmentPath(path, number).c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) { return; }
+            struct stat info;
+            void *data = MAP_FAILED;
+            if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(FlightLogFileHeader)) {
+                data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            }
+            close(fd);
+            if (data == MAP_FAILED) { return; }
+
+            Segment segment;
+            segment.data = static_cast<uint8_t *>(data);
+            segment.size = static_cast<size_t>(info.st_size);
+            FlightLogFileHeader header;
+            std::memcpy(&header, segment.data, sizeof(header));
+            if (std::memcmp(header.magic, FLIGHT_LOG_SEGMENT_MAGIC, sizeof(header.magic)) != 0 ||
+                header.version != FLIGHT_LOG_VERSION || header.segment != number) {
+                munmap(segment.data, segment.size);
+                return;
+            }
+            m_segments.push_back(segment);
+        }
+    }
+
+    /// Read one record header, checking that the record lies within its segment
+    /// @returns false at the end of the segment's records
+    bool m_readRecord(uint32_t segment, size_t offset, FlightLogRecord &record) const
+    {
+        const Segment &mapped = m_segments[segment];
+        if (offset + sizeof(FlightLogRecordHeader) > mapped.size) { return false; }
+        FlightLogRecordHeader header;
+        std::memcpy(&header, mapped.data + offset, sizeof(header));
+        if (header.type == static_cast<uint32_t>(FlightRecordType::END) ||
+            header.type > static_cast<uint32_t>(FlightRecordType::COMMAND) ||
+            offset + sizeof(header) + header.size > mapped.size) {
+            return false;
+        }
+        record.type        = static_cast<FlightRecordType>(header.type);
+        record.flags       = header.flags;
+        record.key         = header.key;
+        record.timestampNs = header.timestampNs;
+        record.data        = mapped.data + offset + sizeof(header);
+        record.size        = header.size;
+        return true;
+    }
+
+    /// Load the records listed in the index
+    /// @param segment receives the segment after the last indexed record
+    /// @param offset receives the offset after the last indexed record
+    /// @returns false if there is no usable index
+    bool m_loadIndex(const std::string &path, uint32_t &segment, size_t &offset)
+    {
+        std::ifstream file(flightLogIndexPath(path), std::ios::binary);
+        if (!file) { return false; }
+        std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (bytes.size() < sizeof(FlightLogFileHeader)) { return false; }
+        FlightLogFileHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (std::memcmp(header.magic, FLIGHT_LOG_INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != FLIGHT_LOG_VERSION) {
+            return false;
+        }
+
+        // a partly written final entry is ignored
+        const size_t count = (bytes.size() - sizeof(header)) / sizeof(FlightLogIndexEntry);
+        m_records.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            FlightLogIndexEntry entry;
+            std::memcpy(&entry, bytes.data() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+            FlightLogRecord record;
+            if (entry.segment >= m_segments.size() || !m_readRecord(entry.segment, entry.offset, record) ||
+                static_cast<uint32_t>(record.type) != entry.type || record.timestampNs != entry.timestampNs) {
+                return false;
+            }
+            m_records.push_back(record);
+            segment = entry.segment;
+            offset  = entry.offset + flightLogRecordBytes(record.size);
+        }
+        return true;
+    }
+
+    /// Add the records from a position to the end of the log
+    void m_scan(uint32_t segment, size_t offset)
+    {
+        for (; segment < m_segments.size(); segment++) {
+            FlightLogRecord record;
+            while (m_readRecord(segment, offset, record)) {
+                m_records.push_back(record);
+                offset += flightLogRecordBytes(record.size);
+            }
+            offset = sizeof(FlightLogFileHeader);
+        }
+    }
+};
+
+} // wscDrone
+
+#endif /* FLIGHTLOG_H_ */
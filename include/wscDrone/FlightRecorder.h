@@ -0,0 +1,455 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the FlightRecorder, which records the compressed
+ * video and commands of a drone to a flight log.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef FLIGHTRECORDER_H_
+#define FLIGHTRECORDER_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libARController/ARController.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "DroneTransport.h"
+#include "FlightLog.h"
+#include "SpscQueue.h"
+#include "Utils.h"
+
+namespace wscDrone {
+
+/// Configuration of a FlightRecorder
+struct FlightRecorderOptions {
+    size_t segmentBytes      = 64 * 1024 * 1024; ///< size at which a new segment file is started
+    size_t videoQueueDepth   = 64;   ///< video records waiting for the writer
+    size_t commandQueueDepth = 1024; ///< command records waiting for the writer
+};
+
+/// Counters of a FlightRecorder
+struct FlightRecorderStats {
+    uint64_t recordsWritten  = 0; ///< records written to the log
+    uint64_t bytesWritten    = 0; ///< segment bytes used, including headers and padding
+    uint64_t videoDropped    = 0; ///< frames and decoder configurations lost to a full queue
+    uint64_t commandsDropped = 0; ///< commands lost to a full queue
+    uint64_t writeErrors     = 0; ///< records lost because a segment could not be created
+    uint32_t segments        = 0; ///< segment files created
+};
+
+/// Records what a drone sends, decoder configurations, compressed frames and commands, to a flight log
+/// that FlightLogReader and FlightReplay read back. The recorder wraps the drone's DroneTransport and is
+/// used in its place, e.g. DecodePipeline(recorder), so the video callbacks pass through it.
+/// @details The ARSDK threads only copy each record into a preallocated slot of a lock-free queue and
+/// forward it; a writer thread appends the records to memory-mapped segment files. Commands arrive on
+/// more than one ARSDK thread, so their pushes are serialized by a mutex held only for the copy. The
+/// live path never waits for the disk. When a queue is full the record is dropped and counted. Only single-key
+/// commands, which include every state and event the library uses, are recorded.
+class FlightRecorder : public DroneTransport {
+public:
+    FlightRecorder() = delete;
+
+    /// Start recording a drone
+    /// @param transport smart pointer to the drone's transport
+    /// @param path the flight log path. Segment files and the index are created next to it.
+    /// @param options queue and segment sizes
+    FlightRecorder(std::shared_ptr<DroneTransport> transport, const std::string &path,
+                   const FlightRecorderOptions &options = FlightRecorderOptions())
+        : m_transport(transport), m_path(path), m_options(options),
+          m_videoQueue(options.videoQueueDepth), m_commandQueue(options.commandQueueDepth)
+    {
+        m_indexFile = std::fopen(flightLogIndexPath(path).c_str(), "wb");
+        if (!m_indexFile) {
+            throw std::runtime_error("FlightRecorder: unable to create " + flightLogIndexPath(path));
+        }
+        FlightLogFileHeader header = m_fileHeader(FLIGHT_LOG_INDEX_MAGIC, 0);
+        std::fwrite(&header, sizeof(header), 1, m_indexFile);
+
+        m_running = true;
+        m_writerThread = std::thread(&FlightRecorder::m_writerLoop, this);
+        m_transport->registerCommandReceivedCallback(m_onCommandReceivedDefault, this);
+    }
+
+    /// Closes the log. The recorder must outlive the drone's command and video streams.
+    ~FlightRecorder() override { close(); }
+
+    FlightRecorder(const FlightRecorder &) = delete;
+    FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+    /// Write everything queued, then close the segment and index files. Later records are ignored.
+    void close()
+    {
+        if (!m_running.exchange(false)) { return; }
+        {
+            std::lock_guard<std::mutex> lck(m_wakeMutex);
+            m_wakeCv.notify_one();
+        }
+        m_writerThread.join();
+        m_closeSegment();
+        std::fclose(m_indexFile);
+        m_indexFile = nullptr;
+    }
+
+    /// Get the recorder counters
+    /// @returns a snapshot of the counters
+    FlightRecorderStats getStats()
+    {
+        FlightRecorderStats stats;
+        stats.recordsWritten  = m_recordsWritten.load();
+        stats.bytesWritten    = m_bytesWritten.load();
+        stats.videoDropped    = m_videoDropped.load();
+        stats.commandsDropped = m_commandsDropped.load();
+        stats.writeErrors     = m_writeErrors.load();
+        stats.segments        = m_segments.load();
+        return stats;
+    }
+
+    void start() override { m_transport->start(); }
+    void stop() override  { m_transport->stop(); }
+    eARCONTROLLER_DEVICE_STATE getLastState() override { return m_transport->getLastState(); }
+    bool waitForStateChange() override { return m_transport->waitForStateChange(); }
+
+    void registerCommandReceivedCallback(const CommandReceivedCallback &callback, void *customData) override
+    {
+        m_transport->registerCommandReceivedCallback(callback, customData);
+    }
+
+    /// The callbacks are called by the recorder after it has queued each record
+    void registerVideoCallback(const VideoDecoderConfigCallback &decoderCallback,
+                               const VideoFrameReceivedCallback &videoCallback, void *customData) override
+    {
+        m_decoderCallback = decoderCallback;
+        m_videoCallback   = videoCallback;
+        m_videoCustomData = customData;
+        m_transport->registerVideoCallback(m_decoderConfigCallDefault, m_onFrameReceivedDefault, this);
+    }
+
+    void startVideo() override { m_transport->startVideo(); }
+    void stopVideo() override  { m_transport->stopVideo(); }
+    std::shared_ptr<VideoFrame> getFrame() override { return m_transport->getFrame(); }
+    std::shared_ptr<std::mutex> getBufferMutex() override { return m_transport->getBufferMutex(); }
+
+    void moveRelativeMetres(float dx, float dy, float dz, float heading) override
+    {
+        m_transport->moveRelativeMetres(dx, dy, dz, heading);
+    }
+
+    unsigned getBatteryLevel() override { return m_transport->getBatteryLevel(); }
+
+    bool sendPilotingSetpoint(const PilotingSetpoint &setpoint) override
+    {
+        return m_transport->sendPilotingSetpoint(setpoint);
+    }
+
+    bool sendCameraOrientation(float tilt, float pan) override
+    {
+        return m_transport->sendCameraOrientation(tilt, pan);
+    }
+
+private:
+    /// A record waiting for the writer. The payload capacity is reused.
+    struct PendingRecord {
+        FlightLogRecordHeader header;
+        std::vector<uint8_t>  payload;
+    };
+
+    std::shared_ptr<DroneTransport> m_transport = nullptr; ///< the recorded drone
+    const std::string           m_path;                    ///< flight log path
+    const FlightRecorderOptions m_options;                 ///< configuration
+
+    VideoDecoderConfigCallback m_decoderCallback = nullptr; ///< forwarded decoder configuration callback
+    VideoFrameReceivedCallback m_videoCallback   = nullptr; ///< forwarded frame callback
+    void *m_videoCustomData = nullptr;                      ///< user data for the forwarded callbacks
+
+    SpscQueue<PendingRecord> m_videoQueue;   ///< filled by the ARSDK stream thread
+    SpscQueue<PendingRecord> m_commandQueue; ///< filled by the ARSDK command threads under m_commandMutex
+    std::mutex        m_commandMutex;        ///< makes the command threads a single producer
+    std::atomic<bool> m_running{false};      ///< true until close()
+    std::thread       m_writerThread;        ///< appends the records to the log
+    std::mutex        m_wakeMutex;
+    std::condition_variable m_wakeCv;
+    std::atomic<bool> m_writerWaiting{false};
+
+    // Writer thread state
+    FILE    *m_indexFile     = nullptr;     ///< the index
+    int      m_segmentFd     = -1;          ///< the current segment
+    uint8_t *m_segmentData   = nullptr;     ///< the current segment mapping
+    size_t   m_segmentSize   = 0;           ///< size of the current segment mapping
+    size_t   m_segmentOffset = 0;           ///< next record offset in the current segment
+    uint32_t m_segmentNumber = 0;           ///< number of the next segment to create
+
+    std::atomic<uint64_t> m_recordsWritten{0};
+    std::atomic<uint64_t> m_bytesWritten{0};
+    std::atomic<uint64_t> m_videoDropped{0};
+    std::atomic<uint64_t> m_commandsDropped{0};
+    std::atomic<uint64_t> m_writeErrors{0};
+    std::atomic<uint32_t> m_segments{0};
+
+    static FlightLogFileHeader m_fileHeader(const char *magic, uint32_t segment)
+    {
+        FlightLogFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, magic, sizeof(header.magic));
+        header.version   = FLIGHT_LOG_VERSION;
+        header.segment   = segment;
+        header.createdNs = monotonicNanoseconds();
+        return header;
+    }
+
+    /// Wake the writer if it is asleep. Runs on the ARSDK threads.
+    void m_wake()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_writerWaiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lck(m_wakeMutex);
+            m_wakeCv.notify_one();
+        }
+    }
+
+    /// Queue a record. Runs on an ARSDK thread.
+    /// @param queue the producer thread's queue
+    /// @param type record type
+    /// @param flags record flags
+    /// @param key command key
+    /// @param fill callable invoked as fill(std::vector<uint8_t> &payload)
+    /// @returns false if the queue was full
+    template <typename Fill>
+    bool m_push(SpscQueue<PendingRecord> &queue, FlightRecordType type, uint32_t flags, uint32_t key, Fill &&fill)
+    {
+        if (!m_running.load(std::memory_order_relaxed)) { return true; }
+        const uint64_t nowNs = monotonicNanoseconds();
+        const bool queued = queue.tryPush([&](PendingRecord &record) {
+            record.header.type        = static_cast<uint32_t>(type);
+            record.header.timestampNs = nowNs;
+            record.header.flags       = flags;
+            record.header.key         = key;
+            fill(record.payload);
+            record.header.size        = static_cast<uint32_t>(record.payload.size());
+        });
+        if (queued) { m_wake(); }
+        return queued;
+    }
+
+    /// Create the next segment, large enough for a record of the given size
+    /// @returns false if the segment could not be created
+    bool m_openSegment(size_t recordBytes)
+    {
+        m_closeSegment();
+        const size_t size = std::max(m_options.segmentBytes, sizeof(FlightLogFileHeader) + recordBytes);
+        const std::string filename = flightLogSegmentPath(m_path, m_segmentNumber);
+        int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) { return false; }
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        m_segmentFd     = fd;
+        m_segmentData   = static_cast<uint8_t *>(data);
+        m_segmentSize   = size;
+        FlightLogFileHeader header = m_fileHeader(FLIGHT_LOG_SEGMENT_MAGIC, m_segmentNumber);
+        std::memcpy(m_segmentData, &header, sizeof(header));
+        m_segmentOffset = sizeof(header);
+        m_segmentNumber++;
+        m_segments++;
+        return true;
+    }
+
+    /// Unmap the current segment and trim it to the records written
+    void m_closeSegment()
+    {
+        if (m_segmentFd < 0) { return; }
+        munmap(m_segmentData, m_segmentSize);
+        // if trimming fails the unused tail stays zero, which reads as an END record
+        if (ftruncate(m_segmentFd, static_cast<off_t>(m_segmentOffset)) != 0) { m_writeErrors++; }
+        ::close(m_segmentFd);
+        m_segmentFd   = -1;
+        m_segmentData = nullptr;
+        m_segmentSize = 0;
+    }
+
+    /// Append one record to the log. Runs on the writer thread.
+    void m_write(const PendingRecord &record)
+    {
+        const size_t bytes = flightLogRecordBytes(record.payload.size());
+        if (m_segmentFd < 0 || m_segmentOffset + bytes > m_segmentSize) {
+            if (!m_openSegment(bytes)) {
+                m_writeErrors++;
+                return;
+            }
+        }
+        uint8_t *destination = m_segmentData + m_segmentOffset;
+        std::memcpy(destination, &record.header, sizeof(record.header));
+        if (!record.payload.empty()) {
+            std::memcpy(destination + sizeof(record.header), record.payload.data(), record.payload.size());
+        }
+        // padding is already zero in the new file
+
+        FlightLogIndexEntry entry;
+        entry.timestampNs = record.header.timestampNs;
+        entry.segment     = m_segmentNumber - 1;
+        entry.offset      = static_cast<uint32_t>(m_segmentOffset);
+        entry.type        = record.header.type;
+        entry.flags       = record.header.flags;
+        std::fwrite(&entry, sizeof(entry), 1, m_indexFile);
+
+        m_segmentOffset += bytes;
+        m_recordsWritten++;
+        m_bytesWritten += bytes;
+    }
+
+    void m_writerLoop()
+    {
+        auto consume = [this](PendingRecord &record) { m_write(record); };
+        while (true) {
+            bool wrote = false;
+            while (m_videoQueue.tryPop(consume))   { wrote = true; }
+            while (m_commandQueue.tryPop(consume)) { wrote = true; }
+            if (wrote) { continue; }
+            if (!m_running.load()) { break; }
+
+            std::unique_lock<std::mutex> lck(m_wakeMutex);
+            m_writerWaiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_wakeCv.wait_for(lck, std::chrono::milliseconds(100), [this]() {
+                return !m_running.load() || m_videoQueue.size() > 0 || m_commandQueue.size() > 0;
+            });
+            m_writerWaiting.store(false, std::memory_order_relaxed);
+            std::fflush(m_indexFile);
+        }
+        std::fflush(m_indexFile);
+    }
+
+    /// Serialize the arguments of a single-key command
+    static void m_serializeCommand(ARCONTROLLER_DICTIONARY_ARG_t *arguments, std::vector<uint8_t> &payload)
+    {
+        payload.resize(sizeof(uint32_t));
+        uint32_t count = 0;
+        ARCONTROLLER_DICTIONARY_ARG_t *argument = nullptr;
+        ARCONTROLLER_DICTIONARY_ARG_t *next     = nullptr;
+        HASH_ITER(hh, arguments, argument, next) {
+            const bool isString = argument->valueType == ARCONTROLLER_DICTIONARY_VALUE_TYPE_STRING;
+            const char *string  = isString && argument->value.String ? argument->value.String : "";
+            FlightLogArgument header;
+            header.nameSize  = static_cast<uint16_t>(std::strlen(argument->argument) + 1);
+            header.valueType = static_cast<uint16_t>(argument->valueType);
+            header.valueSize = static_cast<uint32_t>(isString ? std::strlen(string) + 1 : sizeof(argument->value));
+
+            const size_t pos = payload.size();
+            payload.resize(pos + sizeof(header) + header.nameSize + header.valueSize);
+            uint8_t *out = payload.data() + pos;
+            std::memcpy(out, &header, sizeof(header));
+            std::memcpy(out + sizeof(header), argument->argument, header.nameSize);
+            std::memcpy(out + sizeof(header) + header.nameSize,
+                        isString ? static_cast<const void *>(string) : static_cast<const void *>(&argument->value),
+                        header.valueSize);
+            count++;
+        }
+        std::memcpy(payload.data(), &count, sizeof(count));
+    }
+
+    /// Command callback. ARSDK runs it on one reader thread per command buffer, e.g. acknowledged and
+    /// non-acknowledged, so the push is serialized.
+    /// @param commandKey the ARSDK command key
+    /// @param elementDictionary the ARSDK argument dictionary
+    /// @param customData a pointer to an instance of FlightRecorder
+    static void m_onCommandReceivedDefault(eARCONTROLLER_DICTIONARY_KEY commandKey,
+                                           ARCONTROLLER_DICTIONARY_ELEMENT_t *elementDictionary, void *customData)
+    {
+        FlightRecorder *recorder = static_cast<FlightRecorder *>(customData);
+        if (!recorder || !elementDictionary) { return; }
+        ARCONTROLLER_DICTIONARY_ELEMENT_t *element = nullptr;
+        HASH_FIND_STR(elementDictionary, ARCONTROLLER_DICTIONARY_SINGLE_KEY, element);
+        if (!element) { return; }
+        bool queued;
+        {
+            std::lock_guard<std::mutex> lck(recorder->m_commandMutex);
+            queued = recorder->m_push(recorder->m_commandQueue, FlightRecordType::COMMAND, 0, static_cast<uint32_t>(commandKey),
+                                      [element](std::vector<uint8_t> &payload) { m_serializeCommand(element->arguments, payload); });
+        }
+        if (!queued) { recorder->m_commandsDropped++; }
+    }
+
+    /// Decoder configuration callback, runs on the ARSDK stream thread
+    /// @param codec ARSDK3 codec
+    /// @param customData a pointer to an instance of FlightRecorder
+    static eARCONTROLLER_ERROR m_decoderConfigCallDefault(ARCONTROLLER_Stream_Codec_t codec, void *customData)
+    {
+        FlightRecorder *recorder = static_cast<FlightRecorder *>(customData);
+        if (!recorder) { return ARCONTROLLER_ERROR; }
+        if (codec.type == ARCONTROLLER_STREAM_CODEC_TYPE_H264) {
+            const auto &h264 = codec.parameters.h264parameters;
+            const uint32_t spsSize = h264.spsBuffer && h264.spsSize > 0 ? static_cast<uint32_t>(h264.spsSize) : 0;
+            const uint32_t ppsSize = h264.ppsBuffer && h264.ppsSize > 0 ? static_cast<uint32_t>(h264.ppsSize) : 0;
+            if (!recorder->m_push(recorder->m_videoQueue, FlightRecordType::DECODER_CONFIG, 0, 0,
+                                  [&](std::vector<uint8_t> &payload) {
+                payload.resize(8 + spsSize + ppsSize);
+                std::memcpy(payload.data(), &spsSize, 4);
+                std::memcpy(payload.data() + 4, &ppsSize, 4);
+                if (spsSize) { std::memcpy(payload.data() + 8, h264.spsBuffer, spsSize); }
+                if (ppsSize) { std::memcpy(payload.data() + 8 + spsSize, h264.ppsBuffer, ppsSize); }
+            })) {
+                recorder->m_videoDropped++;
+            }
+        }
+        return recorder->m_decoderCallback ? recorder->m_decoderCallback(codec, recorder->m_videoCustomData) : ARCONTROLLER_OK;
+    }
+
+    /// Frame callback, runs on the ARSDK stream thread
+    /// @param frame pointer to a ARSDK3 frame
+    /// @param customData a pointer to an instance of FlightRecorder
+    static eARCONTROLLER_ERROR m_onFrameReceivedDefault(ARCONTROLLER_Frame_t *frame, void *customData)
+    {
+        FlightRecorder *recorder = static_cast<FlightRecorder *>(customData);
+        if (!recorder || !frame) { return ARCONTROLLER_ERROR; }
+        if (frame->data && frame->used > 0) {
+            if (!recorder->m_push(recorder->m_videoQueue, FlightRecordType::VIDEO_FRAME,
+                                  frame->isIFrame ? FLIGHT_RECORD_IFRAME : 0, 0,
+                                  [frame](std::vector<uint8_t> &payload) {
+                payload.assign(frame->data, frame->data + frame->used);
+            })) {
+                recorder->m_videoDropped++;
+            }
+        }
+        return recorder->m_videoCallback ? recorder->m_videoCallback(frame, recorder->m_videoCustomData) : ARCONTROLLER_OK;
+    }
+};
+
+} // wscDrone
+
+#endif /* FLIGHTRECORDER_H_ */
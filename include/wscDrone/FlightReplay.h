@@ -0,0 +1,239 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the FlightReplay, which plays a flight log back
+ * through the DroneTransport callbacks.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef FLIGHTREPLAY_H_
+#define FLIGHTREPLAY_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libARController/ARController.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "FlightLog.h"
+#include "LocalTransport.h"
+#include "Utils.h"
+#include "VideoFrame.h"
+
+namespace wscDrone {
+
+/// Configuration of a FlightReplay
+struct FlightReplayOptions {
+    double   speed   = 1.0;   ///< 1 for real time, 2 for twice as fast, 0 for as fast as possible
+    bool     loop    = false; ///< restart at the beginning at the end of the log
+    uint64_t startNs = 0;     ///< log time to start at, from the I-frame at or before it. 0 for the beginning.
+    std::shared_ptr<VideoFrame> frame = nullptr; ///< returned by getFrame(), may be nullptr
+};
+
+/// A DroneTransport that plays a flight log recorded by FlightRecorder back through the same callbacks
+/// the drone used, so field issues can be reproduced and decoder changes benchmarked offline with
+/// DecodePipeline, TelemetryCache and the rest of the library unchanged.
+/// @details Commands are replayed from start(), video records from startVideo(). The most recent
+/// decoder configuration is sent before the first frame after startVideo(). Moves are ignored, since
+/// the drone's response is already in the log. When replaying as fast as possible the receiver's queue
+/// policy decides what happens to frames it cannot keep up with.
+class FlightReplay : public LocalTransport {
+public:
+    FlightReplay() = delete;
+
+    /// Construct a replay. It is stopped until start() is called.
+    /// @param log the flight log, which may be shared by several replays
+    /// @param options playback configuration
+    FlightReplay(std::shared_ptr<const FlightLogReader> log, const FlightReplayOptions &options = FlightReplayOptions())
+        : m_log(log), m_options(options) {}
+
+    /// Stops the replay thread
+    ~FlightReplay() override { stop(); }
+
+    FlightReplay(const FlightReplay &) = delete;
+    FlightReplay &operator=(const FlightReplay &) = delete;
+
+    void start() override
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            if (m_thread.joinable()) { return; }
+            m_stopRequested = false;
+            m_finished      = false;
+            m_thread = std::thread(&FlightReplay::m_replayLoop, this);
+        }
+        m_setState(ARCONTROLLER_DEVICE_STATE_STARTING);
+    }
+
+    void stop() override
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            if (!m_thread.joinable()) { return; }
+            m_stopRequested = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+        m_setState(ARCONTROLLER_DEVICE_STATE_STOPPED);
+    }
+
+    void startVideo() override
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        if (!m_videoRunning) { m_configPending = true; }
+        m_videoRunning = true;
+    }
+
+    void stopVideo() override
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        m_videoRunning = false;
+    }
+
+    std::shared_ptr<VideoFrame> getFrame() override { return m_options.frame; }
+
+    void moveRelativeMetres(float, float, float, float) override {}
+
+    unsigned getBatteryLevel() override { return m_batteryLevel.load(); }
+
+    /// Wait for the end of the log. A looping replay never finishes.
+    /// @param timeMilliseconds the maximum time to wait
+    /// @returns true if the whole log has been replayed
+    bool waitFinished(unsigned timeMilliseconds)
+    {
+        std::unique_lock<std::mutex> lck(m_mutex);
+        return m_cv.wait_for(lck, std::chrono::milliseconds(timeMilliseconds), [this]() { return m_finished; });
+    }
+
+private:
+    std::shared_ptr<const FlightLogReader> m_log = nullptr; ///< the log being replayed
+    const FlightReplayOptions m_options;                   ///< configuration
+    std::atomic<unsigned> m_batteryLevel{0};               ///< last replayed battery percent
+
+    std::mutex              m_mutex;                ///< protects everything below
+    std::condition_variable m_cv;                   ///< wakes the replay thread and waitFinished()
+    std::thread             m_thread;               ///< the replay thread
+    bool m_stopRequested = false;                   ///< tells the thread to exit
+    bool m_videoRunning  = false;                   ///< true between startVideo() and stopVideo()
+    bool m_configPending = false;                   ///< the decoder configuration must be sent
+    bool m_finished      = false;                   ///< true once the end of the log was reached
+
+    /// Send the most recent decoder configuration at or before a record
+    /// @param index the record number
+    void m_dispatchLastConfig(size_t index)
+    {
+        const FlightLogReader &log = *m_log;
+        for (size_t i = index + 1; i > 0; i--) {
+            const uint8_t *sps;
+            const uint8_t *pps;
+            uint32_t spsSize;
+            uint32_t ppsSize;
+            if (FlightLogReader::parseDecoderConfig(log[i - 1], sps, spsSize, pps, ppsSize)) {
+                m_dispatchDecoderConfig(sps, spsSize, pps, ppsSize);
+                return;
+            }
+        }
+    }
+
+    /// Replay one record. Called without m_mutex held.
+    /// @param index the record number
+    /// @param video true if video records are replayed
+    /// @param sendConfig true if the decoder configuration must be sent before a frame
+    /// @param dictionary reused to build commands
+    void m_replay(size_t index, bool video, bool sendConfig, CommandDictionary &dictionary)
+    {
+        const FlightLogRecord &record = (*m_log)[index];
+        switch (record.type) {
+        case FlightRecordType::DECODER_CONFIG :
+            if (video) { m_dispatchLastConfig(index); }
+            break;
+        case FlightRecordType::VIDEO_FRAME :
+            if (!video) { break; }
+            if (sendConfig) { m_dispatchLastConfig(index); }
+            m_dispatchFrame(record.data, record.size, (record.flags & FLIGHT_RECORD_IFRAME) != 0);
+            break;
+        case FlightRecordType::COMMAND :
+        {
+            const auto key = static_cast<eARCONTROLLER_DICTIONARY_KEY>(record.key);
+            dictionary.clear();
+            FlightLogReader::forEachArgument(record, [&](const char *name, eARCONTROLLER_DICTIONARY_VALUE_TYPE type,
+                                                         const ARCONTROLLER_DICTIONARY_VALUE_t &value) {
+                dictionary.add(name, type, value);
+                if (key == ARCONTROLLER_DICTIONARY_KEY_COMMON_COMMONSTATE_BATTERYSTATECHANGED &&
+                    std::strcmp(name, ARCONTROLLER_DICTIONARY_KEY_COMMON_COMMONSTATE_BATTERYSTATECHANGED_PERCENT) == 0) {
+                    m_batteryLevel = value.U8;
+                }
+            });
+            m_dispatchCommand(key, dictionary);
+            break;
+        }
+        default :
+            break;
+        }
+    }
+
+    void m_replayLoop()
+    {
+        using Clock = std::chrono::steady_clock;
+        m_setState(ARCONTROLLER_DEVICE_STATE_RUNNING);
+
+        const FlightLogReader &log = *m_log;
+        size_t begin = 0;
+        if (m_options.startNs) {
+            begin = log.seekIFrame(m_options.startNs);
+            if (begin >= log.size()) { begin = log.seek(m_options.startNs); }
+        }
+        CommandDictionary dictionary;
+
+        std::unique_lock<std::mutex> lck(m_mutex);
+        do {
+            const Clock::time_point wallStart = Clock::now();
+            const uint64_t logStartNs = begin < log.size() ? log[begin].timestampNs : 0;
+            for (size_t index = begin; index < log.size() && !m_stopRequested; index++) {
+                if (m_options.speed > 0.0) {
+                    const double offsetNs = static_cast<double>(log[index].timestampNs - logStartNs) / m_options.speed;
+                    const Clock::time_point due = wallStart + std::chrono::nanoseconds(static_cast<int64_t>(offsetNs));
+                    if (m_cv.wait_until(lck, due, [this]() { return m_stopRequested; })) { break; }
+                }
+                const FlightRecordType type = log[index].type;
+                const bool video = m_videoRunning;
+                bool sendConfig  = false;
+                if (video && m_configPending &&
+                    (type == FlightRecordType::VIDEO_FRAME || type == FlightRecordType::DECODER_CONFIG)) {
+                    sendConfig      = true;
+                    m_configPending = false;
+                }
+                lck.unlock();
+                m_replay(index, video, sendConfig, dictionary);
+                lck.lock();
+            }
+        } while (m_options.loop && !m_stopRequested && begin < log.size());
+
+        m_finished = true;
+        m_cv.notify_all();
+        m_cv.wait(lck, [this]() { return m_stopRequested; });
+    }
+};
+
+} // wscDrone
+
+#endif /* FLIGHTREPLAY_H_ */
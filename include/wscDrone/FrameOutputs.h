@@ -0,0 +1,243 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the FrameOutputSet, which produces region of
+ * interest crops and an image pyramid from each decoded frame.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef FRAMEOUTPUTS_H_
+#define FRAMEOUTPUTS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libavcodec/avcodec.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+#include "ColourConvert.h"
+#include "FramePool.h"
+#include "PixelFormat.h"
+#include "SeqLock.h"
+
+namespace wscDrone {
+
+/// Most region of interest outputs of one FrameOutputSet
+constexpr unsigned MAX_REGION_OUTPUTS = 8;
+
+/// A rectangle of the decoded frame
+struct FrameRegion {
+    unsigned x      = 0; ///< left edge in pixels
+    unsigned y      = 0; ///< top edge in lines
+    unsigned width  = 0; ///< width in pixels, 0 to disable the output
+    unsigned height = 0; ///< height in lines, 0 to disable the output
+};
+
+/// The outputs produced from one decoded frame. Handles are empty for outputs that are not configured,
+/// are disabled or found their FramePool exhausted. Copy a handle to keep its frame.
+struct FrameOutputs {
+    uint64_t sequence   = 0;                      ///< receive sequence number of the frame
+    uint64_t receivedNs = 0;                      ///< monotonic time the compressed frame was received
+    FrameRef levels[PYRAMID_LEVELS];              ///< pyramid level n is 1/2^n of the decoded size
+    unsigned numRegions = 0;                      ///< number of region outputs configured
+    FrameRef regions[MAX_REGION_OUTPUTS];         ///< the crop of each region output, in addRegion() order
+    FrameRegion regionRects[MAX_REGION_OUTPUTS];  ///< the rectangle each crop was taken from, after clamping
+
+    /// Release every handle
+    void reset()
+    {
+        for (auto &level : levels) { level.reset(); }
+        for (auto &region : regions) { region.reset(); }
+    }
+};
+
+/// alias for the callback invoked on the decode thread with the outputs of each decoded frame
+using FrameOutputsCallback = void (*)(const FrameOutputs &outputs, void *customData);
+
+/// A configurable set of outputs produced from each decoded frame in addition to the VideoFrame: up to
+/// three levels of an image pyramid and up to MAX_REGION_OUTPUTS region of interest crops, each written
+/// into its own pooled buffer.
+/// @details The pyramid levels are produced in a single pass over the decoded picture by
+/// convertYUV420PPyramid(), and each crop reads only its own rectangle, so a tracker that wants a full
+/// size crop around its target and a small overview moves a fraction of the bytes of a full frame
+/// conversion followed by its own resampling. Outputs are converted straight from the decoder's YUV420P
+/// picture into RGB24, BGR24, RGBA or GRAY8. Configure the outputs before the pipeline starts; regions
+/// may be moved at any time with setRegion() and take effect on the next decoded frame.
+class FrameOutputSet {
+public:
+    /// Construct an empty output set
+    /// @param format pixel format of every output, RGB24, BGR24, RGBA or GRAY8
+    explicit FrameOutputSet(PixelFormat format = PixelFormat::RGB24) : m_format(format)
+    {
+        if (format != PixelFormat::RGB24 && format != PixelFormat::BGR24 && format != PixelFormat::RGBA &&
+            format != PixelFormat::GRAY8) {
+            throw std::invalid_argument("FrameOutputSet: unsupported pixel format");
+        }
+    }
+
+    FrameOutputSet(const FrameOutputSet &) = delete;
+    FrameOutputSet &operator=(const FrameOutputSet &) = delete;
+
+    /// Produce a pyramid level. Call before the pipeline starts.
+    /// @param level 0 for full size, 1 for half and 2 for quarter size
+    /// @param pool pool of frames large enough for the level, nullptr to remove the level
+    void setPyramidLevel(unsigned level, std::shared_ptr<FramePool> pool)
+    {
+        if (level >= PYRAMID_LEVELS) { throw std::out_of_range("FrameOutputSet: invalid pyramid level"); }
+        m_levelPools[level] = pool;
+    }
+
+    /// Add a region of interest output. Call before the pipeline starts.
+    /// @param pool pool of frames large enough for the largest region the output will be set to, after scaling
+    /// @param region the initial rectangle
+    /// @param scale downscale factor of the crop, 1, 2 or 4
+    /// @returns the index of the output, for setRegion() and FrameOutputs::regions
+    unsigned addRegion(std::shared_ptr<FramePool> pool, const FrameRegion &region = FrameRegion(), unsigned scale = 1)
+    {
+        if (m_numRegions >= MAX_REGION_OUTPUTS) { throw std::length_error("FrameOutputSet: too many regions"); }
+        if (scale != 1 && scale != 2 && scale != 4) { throw std::invalid_argument("FrameOutputSet: invalid region scale"); }
+        const unsigned index = m_numRegions++;
+        m_regionPools[index]  = pool;
+        m_regionScales[index] = scale;
+        m_regions[index].store(region);
+        return index;
+    }
+
+    /// Move a region of interest, e.g. to follow a target. Takes effect on the next decoded frame.
+    /// Safe to call from any one thread at a time.
+    /// @param index the output index returned by addRegion()
+    /// @param region the new rectangle, clamped to the frame. A zero width or height disables the output.
+    void setRegion(unsigned index, const FrameRegion &region)
+    {
+        if (index < m_numRegions) { m_regions[index].store(region); }
+    }
+
+    /// Get the rectangle of a region of interest
+    /// @param index the output index returned by addRegion()
+    /// @returns the rectangle last set
+    FrameRegion getRegion(unsigned index) const { return index < m_numRegions ? m_regions[index].load() : FrameRegion(); }
+
+    /// Get the number of region of interest outputs
+    /// @returns the number of regions added
+    unsigned getNumRegions() const { return m_numRegions; }
+
+    /// Get the pixel format of the outputs
+    /// @returns the format
+    PixelFormat getFormat() const { return m_format; }
+
+    /// Produce every output from a decoded picture. Runs on the decode thread.
+    /// @param picture the decoded picture, only YUV420P is supported
+    /// @param sequence receive sequence number of the frame
+    /// @param receivedNs monotonic receive time of the frame
+    /// @param outputs receives the handles, any it already held are released
+    /// @returns the number of outputs lost because their FramePool was exhausted or too small
+    unsigned produce(const AVFrame &picture, uint64_t sequence, uint64_t receivedNs, FrameOutputs &outputs)
+    {
+        outputs.reset();
+        outputs.sequence   = sequence;
+        outputs.receivedNs = receivedNs;
+        outputs.numRegions = m_numRegions;
+        if (picture.format != AV_PIX_FMT_YUV420P && picture.format != AV_PIX_FMT_YUVJ420P) { return 0; }
+
+        unsigned lost = 0;
+        const unsigned width  = static_cast<unsigned>(picture.width);
+        const unsigned height = static_cast<unsigned>(picture.height);
+        const int srcStride[3] = { picture.linesize[0], picture.linesize[1], picture.linesize[2] };
+
+        // every pyramid level in one pass
+        uint8_t *levelDst[PYRAMID_LEVELS]    = { nullptr, nullptr, nullptr };
+        int      levelStride[PYRAMID_LEVELS] = { 0, 0, 0 };
+        for (unsigned n = 0; n < PYRAMID_LEVELS; n++) {
+            if (!m_levelPools[n] || (width >> n) == 0 || (height >> n) == 0) { continue; }
+            if (!m_acquire(*m_levelPools[n], width >> n, height >> n, sequence, receivedNs, outputs.levels[n])) {
+                lost++;
+                continue;
+            }
+            levelDst[n]    = outputs.levels[n].mutableData();
+            levelStride[n] = outputs.levels[n].planeStride(0);
+        }
+        if (levelDst[0] || levelDst[1] || levelDst[2]) {
+            const uint8_t *src[3] = { picture.data[0], picture.data[1], picture.data[2] };
+            convertYUV420PPyramid(src, srcStride, width, height, m_format, levelDst, levelStride);
+        }
+
+        for (unsigned i = 0; i < m_numRegions; i++) {
+            const unsigned scale = m_regionScales[i];
+            FrameRegion rect = m_clamp(m_regions[i].load(), width, height, scale);
+            outputs.regionRects[i] = rect;
+            if (rect.width == 0 || rect.height == 0) { continue; }
+            if (!m_acquire(*m_regionPools[i], rect.width / scale, rect.height / scale, sequence, receivedNs,
+                           outputs.regions[i])) {
+                lost++;
+                continue;
+            }
+            // offsetting the planes to an even corner keeps the chroma aligned with the luma
+            const uint8_t *src[3] = {
+                picture.data[0] + static_cast<size_t>(rect.y) * srcStride[0] + rect.x,
+                picture.data[1] + static_cast<size_t>(rect.y / 2) * srcStride[1] + rect.x / 2,
+                picture.data[2] + static_cast<size_t>(rect.y / 2) * srcStride[2] + rect.x / 2
+            };
+            uint8_t *dst[PYRAMID_LEVELS]    = { nullptr, nullptr, nullptr };
+            int      stride[PYRAMID_LEVELS] = { 0, 0, 0 };
+            const unsigned n = scale == 1 ? 0 : (scale == 2 ? 1 : 2);
+            dst[n]    = outputs.regions[i].mutableData();
+            stride[n] = outputs.regions[i].planeStride(0);
+            convertYUV420PPyramid(src, srcStride, rect.width, rect.height, m_format, dst, stride);
+        }
+        return lost;
+    }
+
+private:
+    const PixelFormat m_format;                                   ///< format of every output
+    std::shared_ptr<FramePool> m_levelPools[PYRAMID_LEVELS];      ///< pool of each pyramid level, nullptr if unused
+    unsigned                   m_numRegions = 0;                  ///< number of region outputs
+    std::shared_ptr<FramePool> m_regionPools[MAX_REGION_OUTPUTS]; ///< pool of each region output
+    unsigned                   m_regionScales[MAX_REGION_OUTPUTS] = {}; ///< downscale factor of each region output
+    SeqLock<FrameRegion>       m_regions[MAX_REGION_OUTPUTS];     ///< rectangle of each region output
+
+    /// Take a frame from a pool and describe it
+    /// @returns false when the pool is exhausted or its frames are too small
+    bool m_acquire(FramePool &pool, unsigned width, unsigned height, uint64_t sequence, uint64_t receivedNs,
+                   FrameRef &frame)
+    {
+        if (pool.getFrameSizeBytes() < getPlaneLayout(m_format, width, height).totalBytes) { return false; }
+        frame = pool.acquire();
+        if (!frame) { return false; }
+        frame.setInfo(width, height, m_format, sequence, receivedNs);
+        return true;
+    }
+
+    /// Clamp a region to the frame, with an even corner and a size that is a multiple of the scale
+    /// @returns the clamped region, with a zero size if nothing is left
+    static FrameRegion m_clamp(FrameRegion rect, unsigned width, unsigned height, unsigned scale)
+    {
+        rect.x &= ~1u;
+        rect.y &= ~1u;
+        if (rect.x >= width || rect.y >= height) { return FrameRegion(); }
+        if (rect.width > width - rect.x) { rect.width = width - rect.x; }
+        if (rect.height > height - rect.y) { rect.height = height - rect.y; }
+        rect.width  -= rect.width % scale;
+        rect.height -= rect.height % scale;
+        return rect;
+    }
+};
+
+} // wscDrone
+
+#endif /* FRAMEOUTPUTS_H_ */
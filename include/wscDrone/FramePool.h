@@ -0,0 +1,322 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains a fixed-size pool of decoded video frames handed
+ * out as intrusive reference-counted handles.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef FRAMEPOOL_H_
+#define FRAMEPOOL_H_
+
+#include <sys/mman.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "PixelFormat.h"
+#include "VideoDriver.h"
+
+namespace wscDrone {
+
+class FramePool;
+
+/// Alignment of each frame in the pool. Page alignment keeps every frame on its own pages, which
+/// suits first-touch NUMA placement and any SIMD width.
+constexpr size_t FRAME_POOL_ALIGNMENT = 4096;
+
+/// Size of a transparent huge page on x86-64 Linux
+constexpr size_t FRAME_POOL_HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+
+/// A reference-counted handle to one frame in a FramePool.
+/// @details Copying a handle adds a reference and destroying the last handle returns the frame to
+/// the pool, so consumers can hold on to any number of frames for temporal processing without
+/// allocating or copying pixel data. Handles may be copied and released from any thread, but the
+/// FramePool must outlive every handle.
+class FrameRef {
+public:
+    FrameRef() = default; ///< construct an empty handle
+    FrameRef(const FrameRef &other);
+    FrameRef(FrameRef &&other) noexcept : m_pool(other.m_pool), m_index(other.m_index) { other.m_pool = nullptr; }
+    FrameRef &operator=(FrameRef other) noexcept { swap(other); return *this; }
+    ~FrameRef() { reset(); }
+
+    /// Drop this handle's reference and make it empty
+    void reset();
+
+    /// Exchange two handles
+    /// @param other the handle to exchange with
+    void swap(FrameRef &other) noexcept { std::swap(m_pool, other.m_pool); std::swap(m_index, other.m_index); }
+
+    /// Check if the handle refers to a frame
+    /// @returns true when not empty
+    explicit operator bool() const { return m_pool != nullptr; }
+
+    const uint8_t *data() const;        ///< @returns pointer to the pixel bytes
+    uint8_t       *mutableData();       ///< @returns writable pointer to the pixel bytes, for the producer
+    size_t         sizeBytes() const;   ///< @returns size of the pixel data in bytes
+    unsigned       width() const;       ///< @returns width in pixels
+    unsigned       height() const;      ///< @returns height in lines
+    unsigned       stride() const;      ///< @returns bytes per line of the first plane
+    PixelFormat    format() const;      ///< @returns the pixel format of the frame
+    unsigned       numPlanes() const;   ///< @returns the number of planes of the pixel format
+
+    /// Get a plane of the frame
+    /// @param plane plane index, less than numPlanes()
+    /// @returns pointer to the first line of the plane
+    const uint8_t *planeData(unsigned plane) const;
+
+    /// Get the stride of a plane
+    /// @param plane plane index, less than numPlanes()
+    /// @returns bytes per line of the plane
+    int            planeStride(unsigned plane) const;
+    uint64_t       sequence() const;    ///< @returns frame sequence number assigned by the producer
+    uint64_t       timestampNs() const; ///< @returns monotonic timestamp assigned by the producer
+    unsigned       useCount() const;    ///< @returns number of handles referring to this frame
+
+    /// Set the frame description. For the producer, before the handle is shared. The planes are laid out
+    /// contiguously as getPlaneLayout() describes.
+    /// @param width width in pixels
+    /// @param height height in lines
+    /// @param format pixel format
+    /// @param sequence frame sequence number
+    /// @param timestampNs monotonic timestamp
+    void setInfo(unsigned width, unsigned height, PixelFormat format, uint64_t sequence, uint64_t timestampNs);
+
+private:
+    friend FramePool;
+    FrameRef(FramePool *pool, uint32_t index) : m_pool(pool), m_index(index) {}
+
+    FramePool *m_pool  = nullptr; ///< owning pool, nullptr when empty
+    uint32_t   m_index = 0;       ///< slot index within the pool
+};
+
+/// A snapshot of the FramePool counters
+struct FramePoolStats {
+    size_t   capacity  = 0;     ///< number of frames in the pool
+    size_t   inUse     = 0;     ///< frames currently referenced by at least one handle
+    size_t   highWater = 0;     ///< most frames ever in use at once
+    uint64_t acquired  = 0;     ///< successful acquire() calls
+    uint64_t exhausted = 0;     ///< acquire() calls that failed because every frame was in use
+    size_t   frameBytes = 0;    ///< usable bytes per frame
+    bool     hugePages = false; ///< true when the slab is backed by explicit huge pages
+};
+
+/// A fixed-size pool of aligned frame buffers carved from one slab.
+/// @details The slab is mapped once at construction, with explicit huge pages when available and
+/// transparent huge pages otherwise, and is pre-faulted by the constructing thread. Construct the pool
+/// on the thread (or NUMA node) that will fill it. acquire() and release are lock-free.
+class FramePool {
+public:
+    FramePool() = delete;
+
+    /// Construct a pool of frames sized for the Bebop 2 stream by default
+    /// @param numFrames number of frames in the pool
+    /// @param width width in pixels
+    /// @param height height in lines
+    /// @param bytesPerPixel bytes per pixel, the default of 4 fits every PixelFormat at full size, RGBA
+    /// being the largest. 3 is enough for every format but RGBA.
+    /// @param useHugePages when true try to back the slab with huge pages
+    FramePool(size_t numFrames, unsigned width = BEBOP2_STREAM_WIDTH, unsigned height = BEBOP2_STREAM_HEIGHT,
+              unsigned bytesPerPixel = 4, bool useHugePages = true)
+        : m_capacity(numFrames), m_width(width), m_height(height), m_stride(width * bytesPerPixel)
+    {
+        if (numFrames == 0 || numFrames > UINT32_MAX - 1) {
+            throw std::invalid_argument("FramePool: invalid number of frames");
+        }
+        m_frameBytes = static_cast<size_t>(m_stride) * height;
+        m_slotStride = (m_frameBytes + FRAME_POOL_ALIGNMENT - 1) & ~(FRAME_POOL_ALIGNMENT - 1);
+        m_slabBytes  = m_slotStride * numFrames;
+
+        if (useHugePages) {
+            m_slabBytes = (m_slabBytes + FRAME_POOL_HUGE_PAGE_BYTES - 1) & ~(FRAME_POOL_HUGE_PAGE_BYTES - 1);
+#ifdef MAP_HUGETLB
+            m_slab = mmap(nullptr, m_slabBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            m_hugePages = (m_slab != MAP_FAILED);
+#endif
+        }
+        if (!m_hugePages) {
+            m_slab = mmap(nullptr, m_slabBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (m_slab == MAP_FAILED) {
+                throw std::runtime_error("FramePool: unable to map frame slab");
+            }
+#ifdef MADV_HUGEPAGE
+            if (useHugePages) { madvise(m_slab, m_slabBytes, MADV_HUGEPAGE); }
+#endif
+        }
+        std::memset(m_slab, 0, m_slabBytes); // pre-fault on the constructing thread
+
+        m_slots.reset(new Slot[numFrames]);
+        for (size_t i = 0; i < numFrames; i++) {
+            m_slots[i].data = static_cast<uint8_t *>(m_slab) + i * m_slotStride;
+            m_slots[i].next.store(i + 2 <= numFrames ? static_cast<uint32_t>(i + 2) : 0, std::memory_order_relaxed);
+        }
+        m_freeHead.store(1, std::memory_order_release);
+    }
+
+    /// Unmaps the slab. Every FrameRef must have been released.
+    ~FramePool() { munmap(m_slab, m_slabBytes); }
+
+    FramePool(const FramePool &) = delete;
+    FramePool &operator=(const FramePool &) = delete;
+
+    /// Take a free frame from the pool. Safe to call from any thread.
+    /// @returns a handle with one reference, or an empty handle when the pool is exhausted
+    FrameRef acquire()
+    {
+        uint64_t head = m_freeHead.load(std::memory_order_acquire);
+        for (;;) {
+            uint32_t top = static_cast<uint32_t>(head);
+            if (top == 0) {
+                m_exhausted.fetch_add(1, std::memory_order_relaxed);
+                return FrameRef();
+            }
+            uint32_t next    = m_slots[top - 1].next.load(std::memory_order_relaxed);
+            uint64_t newHead = (((head >> 32) + 1) << 32) | next;
+            if (m_freeHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                Slot &slot = m_slots[top - 1];
+                slot.refs.store(1, std::memory_order_relaxed);
+                slot.width    = m_width;
+                slot.height   = m_height;
+                slot.format   = PixelFormat::RGB24;
+                slot.layout   = PlaneLayout();
+                slot.layout.numPlanes = 1;
+                slot.layout.stride[0] = static_cast<int>(m_stride);
+                slot.layout.lines[0]  = m_height;
+                slot.layout.totalBytes = m_frameBytes;
+                slot.sequence = 0;
+                slot.timestampNs = 0;
+
+                m_acquired.fetch_add(1, std::memory_order_relaxed);
+                size_t inUse = m_inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+                size_t prev  = m_highWater.load(std::memory_order_relaxed);
+                while (inUse > prev && !m_highWater.compare_exchange_weak(prev, inUse, std::memory_order_relaxed)) {}
+                return FrameRef(this, top - 1);
+            }
+        }
+    }
+
+    /// Get a snapshot of the pool counters. Safe to call from any thread.
+    /// @returns the current counters
+    FramePoolStats getStats() const
+    {
+        FramePoolStats stats;
+        stats.capacity   = m_capacity;
+        stats.inUse      = m_inUse.load(std::memory_order_relaxed);
+        stats.highWater  = m_highWater.load(std::memory_order_relaxed);
+        stats.acquired   = m_acquired.load(std::memory_order_relaxed);
+        stats.exhausted  = m_exhausted.load(std::memory_order_relaxed);
+        stats.frameBytes = m_frameBytes;
+        stats.hugePages  = m_hugePages;
+        return stats;
+    }
+
+    /// Get the usable size of each frame
+    /// @returns the size in bytes
+    size_t getFrameSizeBytes() const { return m_frameBytes; }
+
+private:
+    friend FrameRef;
+
+    struct Slot {
+        uint8_t              *data = nullptr; ///< pixel storage within the slab
+        std::atomic<uint32_t> refs{0};        ///< number of live handles
+        std::atomic<uint32_t> next{0};        ///< free list link, index + 1, 0 terminates
+        unsigned width  = 0;
+        unsigned height = 0;
+        PixelFormat format = PixelFormat::RGB24;
+        PlaneLayout layout;
+        uint64_t sequence    = 0;
+        uint64_t timestampNs = 0;
+    };
+
+    size_t   m_capacity;
+    unsigned m_width;
+    unsigned m_height;
+    unsigned m_stride;
+    size_t   m_frameBytes = 0;
+    size_t   m_slotStride = 0;
+    size_t   m_slabBytes  = 0;
+    void    *m_slab       = MAP_FAILED;
+    bool     m_hugePages  = false;
+    std::unique_ptr<Slot[]> m_slots;
+
+    /// Free list head: low 32 bits hold slot index + 1, high 32 bits an ABA tag
+    std::atomic<uint64_t> m_freeHead{0};
+    std::atomic<size_t>   m_inUse{0};
+    std::atomic<size_t>   m_highWater{0};
+    std::atomic<uint64_t> m_acquired{0};
+    std::atomic<uint64_t> m_exhausted{0};
+
+    /// Return a slot to the free list once its last handle is released
+    /// @param index the slot index
+    void m_release(uint32_t index)
+    {
+        uint64_t head = m_freeHead.load(std::memory_order_relaxed);
+        uint64_t newHead;
+        do {
+            m_slots[index].next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            newHead = (((head >> 32) + 1) << 32) | (index + 1);
+        } while (!m_freeHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+        m_inUse.fetch_sub(1, std::memory_order_relaxed);
+    }
+};
+
+inline FrameRef::FrameRef(const FrameRef &other) : m_pool(other.m_pool), m_index(other.m_index)
+{
+    if (m_pool) { m_pool->m_slots[m_index].refs.fetch_add(1, std::memory_order_relaxed); }
+}
+
+inline void FrameRef::reset()
+{
+    if (m_pool && m_pool->m_slots[m_index].refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        m_pool->m_release(m_index);
+    }
+    m_pool = nullptr;
+}
+
+inline const uint8_t *FrameRef::data() const      { return m_pool->m_slots[m_index].data; }
+inline uint8_t       *FrameRef::mutableData()     { return m_pool->m_slots[m_index].data; }
+inline size_t         FrameRef::sizeBytes() const { return m_pool->m_slots[m_index].layout.totalBytes; }
+inline unsigned       FrameRef::width() const     { return m_pool->m_slots[m_index].width; }
+inline unsigned       FrameRef::height() const    { return m_pool->m_slots[m_index].height; }
+inline unsigned       FrameRef::stride() const    { return m_pool->m_slots[m_index].layout.stride[0]; }
+inline PixelFormat    FrameRef::format() const    { return m_pool->m_slots[m_index].format; }
+inline unsigned       FrameRef::numPlanes() const { return m_pool->m_slots[m_index].layout.numPlanes; }
+inline int            FrameRef::planeStride(unsigned plane) const { return m_pool->m_slots[m_index].layout.stride[plane]; }
+inline const uint8_t *FrameRef::planeData(unsigned plane) const
+{
+    const FramePool::Slot &slot = m_pool->m_slots[m_index];
+    return slot.data + slot.layout.offset[plane];
+}
+inline uint64_t       FrameRef::sequence() const  { return m_pool->m_slots[m_index].sequence; }
+inline uint64_t       FrameRef::timestampNs() const { return m_pool->m_slots[m_index].timestampNs; }
+inline unsigned       FrameRef::useCount() const
+{
+    return m_pool ? m_pool->m_slots[m_index].refs.load(std::memory_order_relaxed) : 0;
+}
+
+inline void FrameRef::setInfo(unsigned width, unsigned height, PixelFormat format, uint64_t sequence, uint64_t timestampNs)
+{
+    FramePool::Slot &slot = m_pool->m_slots[m_index];
+    slot.width       = width;
+    slot.height      = height;
+    slot.format      = format;
+    slot.layout      = getPlaneLayout(format, width, height);
+    slot.sequence    = sequence;
+    slot.timestampNs = timestampNs;
+}
+
+} // wscDrone
+
+#endif /* FRAMEPOOL_H_ */
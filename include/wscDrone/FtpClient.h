@@ -0,0 +1,341 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the FtpClient, a minimal passive mode FTP client
+ * for the media server of the drone.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef FTPCLIENT_H_
+#define FTPCLIENT_H_
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace wscDrone {
+
+/// alias for a function receiving the bytes of a retrieved file as they arrive
+using FtpDataSink = std::function<void(const uint8_t *data, size_t size)>;
+
+/// A minimal FTP client for the drone's media server: login, binary passive mode retrieval with
+/// resume, file size and name listing. The control connection stays open between requests, so a
+/// series of downloads pays for the connection and login once.
+/// @details Every blocking call is bounded by the timeout given at construction. Errors throw
+/// std::runtime_error and leave the client disconnected; the next call reconnects. Passive data
+/// connections are made to the control connection's host rather than the address in the PASV reply,
+/// which is wrong behind NAT. Not thread safe, use one client per thread.
+class FtpClient {
+public:
+    FtpClient() = delete;
+
+    /// Construct a client. The connection is made by the first request or connect().
+    /// @param host server name or IP address, e.g. the drone's
+    /// @param port control port
+    /// @param user login name
+    /// @param password login password
+    /// @param timeoutMs limit on each connect, send and receive
+    FtpClient(const std::string &host, uint16_t port = 21, const std::string &user = "anonymous",
+              const std::string &password = "", unsigned timeoutMs = 5000)
+        : m_host(host), m_port(port), m_user(user), m_password(password), m_timeoutMs(timeoutMs) {}
+
+    /// Closes the connection
+    ~FtpClient() { close(); }
+
+    FtpClient(const FtpClient &) = delete;
+    FtpClient &operator=(const FtpClient &) = delete;
+
+    /// Connect, log in and select binary mode, unless already connected
+    void connect()
+    {
+        if (m_control >= 0) { return; }
+        m_control = m_connectTcp(m_port);
+        m_received.clear();
+        try {
+            std::string text;
+            m_expect(m_readReply(text), 2, "greeting", text);
+            int code = m_command("USER " + m_user, text);
+            if (code / 100 == 3) { code = m_command("PASS " + m_password, text); }
+            m_expect(code, 2, "login", text);
+            m_expect(m_command("TYPE I", text), 2, "TYPE I", text);
+        } catch (...) {
+            m_closeFd(m_control);
+            throw;
+        }
+    }
+
+    /// Check if the control connection is open
+    /// @returns true when connected
+    bool isConnected() const { return m_control >= 0; }
+
+    /// Log out and close the connection
+    void close()
+    {
+        if (m_control < 0) { return; }
+        const std::string quit = "QUIT\r\n";
+        (void)::send(m_control, quit.data(), quit.size(), MSG_NOSIGNAL);
+        m_closeFd(m_control);
+    }
+
+    /// Get the size of a file
+    /// @param path the file
+    /// @param size receives the size in bytes
+    /// @returns false if the server does not report it
+    bool size(const std::string &path, uint64_t &size)
+    {
+        connect();
+        std::string text;
+        if (m_command("SIZE " + path, text) != 213) { return false; }
+        size = std::strtoull(text.c_str() + (text.size() > 4 ? 4 : text.size()), nullptr, 10);
+        return true;
+    }
+
+    /// List the names in a directory
+    /// @param directory the directory
+    /// @returns the names, without the directory
+    std::vector<std::string> list(const std::string &directory)
+    {
+        std::string listing;
+        m_transfer("NLST " + directory, 0, nullptr, [&listing](const uint8_t *data, size_t size) {
+            listing.append(reinterpret_cast<const char *>(data), size);
+        });
+
+        std::vector<std::string> names;
+        size_t start = 0;
+        while (start < listing.size()) {
+            size_t end = listing.find('\n', start);
+            if (end == std::string::npos) { end = listing.size(); }
+            std::string name = listing.substr(start, end - start);
+            start = end + 1;
+            if (!name.empty() && name.back() == '\r') { name.pop_back(); }
+            const size_t slash = name.rfind('/');
+            if (slash != std::string::npos) { name.erase(0, slash + 1); }
+            if (!name.empty() && name != "." && name != "..") { names.push_back(name); }
+        }
+        return names;
+    }
+
+    /// Retrieve a file, or its remainder
+    /// @param path the file
+    /// @param offset byte to start at, set to 0 before the first byte arrives if the server cannot resume
+    /// @param sink receives the bytes as they arrive
+    /// @returns the number of bytes received
+    uint64_t retrieve(const std::string &path, uint64_t &offset, const FtpDataSink &sink)
+    {
+        return m_transfer("RETR " + path, offset, &offset, sink);
+    }
+
+    /// Get the server address
+    /// @returns the host given at construction
+    const std::string &getHost() const { return m_host; }
+
+private:
+    /// Size of each receive from the data connection
+    static constexpr size_t RECEIVE_BYTES = 64 * 1024;
+
+    const std::string m_host;      ///< server name or address
+    const uint16_t    m_port;      ///< control port
+    const std::string m_user;      ///< login name
+    const std::string m_password;  ///< login password
+    const unsigned    m_timeoutMs; ///< limit on each blocking call
+    int               m_control = -1; ///< control connection, -1 when disconnected
+    std::string       m_received;  ///< control bytes received but not yet parsed
+
+    /// Run one command that transfers data over a passive connection
+    /// @param command the command, e.g. RETR or NLST
+    /// @param restart byte to start at, 0 for the start
+    /// @param restartUsed when not nullptr, set to 0 if the server refused to restart
+    /// @param sink receives the bytes
+    /// @returns the number of bytes received
+    uint64_t m_transfer(const std::string &command, uint64_t restart, uint64_t *restartUsed, const FtpDataSink &sink)
+    {
+        connect();
+        std::string text;
+        int data = -1;
+        bool refused = false;
+        uint64_t received = 0;
+        try {
+            m_expect(m_command("PASV", text), 2, "PASV", text);
+            data = m_connectTcp(m_passivePort(text));
+            if (restart > 0 && m_command("REST " + std::to_string(restart), text) != 350 && restartUsed) {
+                *restartUsed = 0;
+            }
+            const int code = m_command(command, text);
+            if (code / 100 != 1) {
+                // e.g. 550 for a missing file, the control connection is still usable
+                refused = code / 100 == 4 || code / 100 == 5;
+                throw std::runtime_error("FtpClient: " + command + " failed: " + text);
+            }
+
+            std::vector<uint8_t> buffer(RECEIVE_BYTES);
+            while (true) {
+                const ssize_t n = ::recv(data, buffer.data(), buffer.size(), 0);
+                if (n == 0) { break; }
+                if (n < 0) {
+                    if (errno == EINTR) { continue; }
+                    throw std::runtime_error("FtpClient: data connection to " + m_host + " failed: " +
+                                             std::strerror(errno));
+                }
+                received += static_cast<uint64_t>(n);
+                sink(buffer.data(), static_cast<size_t>(n));
+            }
+            m_closeFd(data);
+            m_expect(m_readReply(text), 2, command, text);
+            return received;
+        } catch (...) {
+            m_closeFd(data);
+            // otherwise the control connection may be out of step with the server, so start afresh
+            if (!refused) { m_closeFd(m_control); }
+            throw;
+        }
+    }
+
+    /// Send a command and read its reply
+    /// @returns the reply code
+    int m_command(const std::string &command, std::string &text)
+    {
+        const std::string line = command + "\r\n";
+        size_t sent = 0;
+        while (sent < line.size()) {
+            const ssize_t n = ::send(m_control, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) { continue; }
+            if (n <= 0) {
+                m_closeFd(m_control);
+                throw std::runtime_error("FtpClient: unable to send to " + m_host);
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return m_readReply(text);
+    }
+
+    /// Read one reply, following multi-line replies to their last line
+    /// @param text receives the last line
+    /// @returns the reply code
+    int m_readReply(std::string &text)
+    {
+        std::string first;
+        while (true) {
+            const std::string line = m_readLine();
+            if (first.empty()) {
+                if (line.size() < 4) {
+                    m_closeFd(m_control);
+                    throw std::runtime_error("FtpClient: malformed reply from " + m_host);
+                }
+                first = line;
+            }
+            // a multi-line reply ends with its code followed by a space
+            if (line.size() >= 4 && line.compare(0, 3, first, 0, 3) == 0 && line[3] == ' ') {
+                text = line;
+                return std::atoi(line.substr(0, 3).c_str());
+            }
+            if (first[3] != '-') {
+                text = line;
+                return std::atoi(line.substr(0, 3).c_str());
+            }
+        }
+    }
+
+    std::string m_readLine()
+    {
+        while (true) {
+            const size_t end = m_received.find('\n');
+            if (end != std::string::npos) {
+                std::string line = m_received.substr(0, end);
+                m_received.erase(0, end + 1);
+                if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+                return line;
+            }
+            char buffer[512];
+            const ssize_t n = ::recv(m_control, buffer, sizeof(buffer), 0);
+            if (n < 0 && errno == EINTR) { continue; }
+            if (n <= 0) {
+                m_closeFd(m_control);
+                throw std::runtime_error("FtpClient: connection to " + m_host + " closed or timed out");
+            }
+            m_received.append(buffer, static_cast<size_t>(n));
+        }
+    }
+
+    /// Throw unless a reply code is in the expected class
+    void m_expect(int code, int expectedClass, const std::string &what, const std::string &text)
+    {
+        if (code / 100 != expectedClass) { throw std::runtime_error("FtpClient: " + what + " failed: " + text); }
+    }
+
+    /// Get the port of a PASV reply, "227 Entering Passive Mode (h1,h2,h3,h4,p1,p2)"
+    uint16_t m_passivePort(const std::string &text)
+    {
+        const size_t open = text.find('(');
+        unsigned values[6];
+        if (open == std::string::npos ||
+            std::sscanf(text.c_str() + open + 1, "%u,%u,%u,%u,%u,%u", &values[0], &values[1], &values[2],
+                        &values[3], &values[4], &values[5]) != 6) {
+            throw std::runtime_error("FtpClient: malformed PASV reply: " + text);
+        }
+        return static_cast<uint16_t>((values[4] & 0xff) << 8 | (values[5] & 0xff));
+    }
+
+    /// Open a TCP connection to the server with the timeout applied to connect, send and receive
+    /// @returns the socket
+    int m_connectTcp(uint16_t port)
+    {
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *addresses = nullptr;
+        if (getaddrinfo(m_host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0 || !addresses) {
+            throw std::runtime_error("FtpClient: unable to resolve " + m_host);
+        }
+
+        timeval timeout;
+        timeout.tv_sec  = static_cast<time_t>(m_timeoutMs / 1000);
+        timeout.tv_usec = static_cast<suseconds_t>((m_timeoutMs % 1000) * 1000);
+        int fd = -1;
+        for (addrinfo *address = addresses; address && fd < 0; address = address->ai_next) {
+            fd = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+            if (fd < 0) { continue; }
+            // SO_SNDTIMEO also bounds connect() on Linux
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            const int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            if (::connect(fd, address->ai_addr, address->ai_addrlen) != 0) { m_closeFd(fd); }
+        }
+        freeaddrinfo(addresses);
+        if (fd < 0) {
+            throw std::runtime_error("FtpClient: unable to connect to " + m_host + ":" + std::to_string(port));
+        }
+        return fd;
+    }
+
+    static void m_closeFd(int &fd)
+    {
+        if (fd >= 0) { ::close(fd); }
+        fd = -1;
+    }
+};
+
+} // wscDrone
+
+#endif /* FTPCLIENT_H_ */
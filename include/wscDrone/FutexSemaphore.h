@@ -0,0 +1,158 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains a counting semaphore built on an atomic counter and
+ * the Linux futex system call.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef FUTEXSEMAPHORE_H_
+#define FUTEXSEMAPHORE_H_
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+
+namespace wscDrone {
+
+/// A counting semaphore with the same interface as Semaphore. notify() and a wait that finds a positive
+/// count are a single atomic operation with no lock and no system call. Only a wait that has to sleep,
+/// or a notify while someone sleeps, enters the kernel.
+/// @details Waits briefly spin before sleeping, which keeps the wake latency low when the notify
+/// arrives within a few microseconds. Timed waits never decrement the count on timeout.
+class FutexSemaphore
+{
+public:
+
+    /// Construct a semaphore with the specified count
+    /// @param count the initial count
+    explicit FutexSemaphore(int count = 0) : m_count(count) {}
+
+    FutexSemaphore(const FutexSemaphore &) = delete;
+    FutexSemaphore &operator=(const FutexSemaphore &) = delete;
+
+    /// Increment the count, waking a waiter if there is one
+    void notify()
+    {
+        m_count.fetch_add(1, std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_seq_cst) > 0)
+        {
+            m_futex(FUTEX_WAKE_PRIVATE, 1, nullptr);
+        }
+    }
+
+    /// Decrement the count if it is positive, without blocking
+    /// @returns TRUE if the count was decremented
+    bool tryWait()
+    {
+        int count = m_count.load(std::memory_order_relaxed);
+        while (count > 0)
+        {
+            if (m_count.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Block until the count is positive, then decrement it
+    void wait()
+    {
+        if (m_spinWait()) { return; }
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        while (!tryWait())
+        {
+            m_futex(FUTEX_WAIT_PRIVATE, 0, nullptr);
+        }
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// Wait with a timeout. The count is only decremented when the wait succeeds.
+    /// @param timeMilliseconds the maximum time to wait
+    /// @returns TRUE if we've timed out, matching Semaphore::waitTimed()
+    bool waitTimed(unsigned int timeMilliseconds)
+    {
+        return waitUntil(std::chrono::steady_clock::now() + std::chrono::milliseconds(timeMilliseconds));
+    }
+
+    /// Wait until a deadline. The count is only decremented when the wait succeeds.
+    /// @param deadline the steady_clock time at which to give up
+    /// @returns TRUE if we've timed out
+    bool waitUntil(std::chrono::steady_clock::time_point deadline)
+    {
+        if (m_spinWait()) { return false; }
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        bool timedOut = false;
+        while (!tryWait())
+        {
+            auto remaining = deadline - std::chrono::steady_clock::now();
+            if (remaining <= std::chrono::steady_clock::duration::zero())
+            {
+                timedOut = true;
+                break;
+            }
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+            timespec timeout;
+            timeout.tv_sec  = static_cast<time_t>(seconds.count());
+            timeout.tv_nsec = static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds).count());
+            m_futex(FUTEX_WAIT_PRIVATE, 0, &timeout);
+        }
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+        return timedOut;
+    }
+
+    /// Get the current count
+    /// @returns the count
+    int getCount()
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr unsigned SPIN_ITERATIONS = 64;
+
+    static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex word must be a plain int");
+
+    std::atomic<int> m_count;      ///< the semaphore count, also the futex word
+    std::atomic<int> m_waiters{0}; ///< number of threads that may be sleeping on the futex
+
+    /// Spin briefly in the hope of a notify arriving before we have to sleep
+    /// @returns true if the count was decremented
+    bool m_spinWait()
+    {
+        for (unsigned i = 0; i < SPIN_ITERATIONS; i++)
+        {
+            if (tryWait()) { return true; }
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+        return false;
+    }
+
+    /// Issue a futex operation on the count. Spurious returns from FUTEX_WAIT are handled by the callers.
+    /// @param op FUTEX_WAIT_PRIVATE to sleep while the count equals value, FUTEX_WAKE_PRIVATE to wake value sleepers
+    /// @param value the expected count or the number of sleepers to wake
+    /// @param timeout relative timeout for FUTEX_WAIT_PRIVATE, nullptr to wait forever
+    /// @returns the system call result
+    long m_futex(int op, int value, const timespec *timeout)
+    {
+        return syscall(SYS_futex, reinterpret_cast<int *>(&m_count), op, value, timeout, nullptr, 0);
+    }
+};
+
+}
+
+#endif /* FUTEXSEMAPHORE_H_ */
@@ -0,0 +1,418 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the H264Decoder class, a multi-threaded H.264
+ * decoder built on the libavcodec send/receive API.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef H264DECODER_H_
+#define H264DECODER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "ColourConvert.h"
+#include "PixelFormat.h"
+
+#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(57, 37, 100)
+#error "H264Decoder requires the libavcodec send/receive API (FFmpeg 3.1 or newer)"
+#endif
+
+namespace wscDrone {
+
+/// Decoder threading and latency options
+struct DecoderOptions {
+    /// Number of decoder threads, 0 lets libavcodec pick one per core
+    int  threadCount = 0;
+    /// FF_THREAD_FRAME and/or FF_THREAD_SLICE. Frame threading decodes several frames in parallel and
+    /// adds up to threadCount - 1 frames of delay, slice threading adds no delay but only helps streams
+    /// with several slices per frame.
+    int  threadType  = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    /// When true the decoder is told to output frames as early as possible, which disables frame threading
+    bool lowDelay    = false;
+    /// When true, YUV420P to RGB24/BGR24/RGBA at 1/1, 1/2 or 1/4 of the decoded size uses the
+    /// ColourConvert.h kernels instead of swscale
+    bool simdConversion = true;
+};
+
+/// How much of the stream a decoder works on. Each level saves more CPU than the one before it, at a
+/// cost in picture quality or frame rate.
+enum class DecodeQuality : unsigned {
+    FULL               = 0, ///< decode every frame normally
+    FAST               = 1, ///< skip the deblocking loop filter. Pictures may show blocking
+    SKIP_NON_REFERENCE = 2, ///< FAST, and frames no other frame refers to are not decoded
+    IDR_ONLY           = 3  ///< only I-frames are decoded
+};
+
+/// Check if an H.264 access unit may be referenced by later frames, from the nal_ref_idc of its first slice
+/// @param data the access unit in Annex B format
+/// @param size size of the access unit in bytes
+/// @returns false only for a non-reference frame, true if in doubt
+inline bool h264IsReferenceFrame(const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i + 3 < size; i++) {
+        if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1) { continue; }
+        const uint8_t header = data[i + 3];
+        const unsigned type  = header & 0x1f;
+        if (type == 1 || type == 5) { return (header & 0x60) != 0; }
+        i += 2;
+    }
+    return true;
+}
+
+/// An H.264 decoder for the Bebop 2 stream using avcodec_send_packet()/avcodec_receive_frame().
+/// @details Unlike bebop_driver::VideoDecoder, decoding and colour conversion are separate steps, so
+/// the caller decides where converted pixels go and can convert straight into its own buffers.
+/// A packet may produce zero frames (the decoder is still filling its delay line) or several
+/// (after a flush), so call receiveFrame() until it returns nullptr after every sendPacket().
+/// The pts passed to sendPacket() is returned in AVFrame::pts to match frames to packets.
+class H264Decoder {
+public:
+    /// Construct a decoder with the specified options
+    /// @param options threading and latency options
+    explicit H264Decoder(const DecoderOptions &options = DecoderOptions()) : m_options(options)
+    {
+        m_codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+        if (!m_codec) {
+            throw std::runtime_error("H264Decoder: libavcodec has no H.264 decoder");
+        }
+        m_packet = av_packet_alloc();
+        m_frame  = av_frame_alloc();
+        if (!m_packet || !m_frame) {
+            m_cleanup();
+            throw std::runtime_error("H264Decoder: unable to allocate packet or frame");
+        }
+    }
+
+    /// Destructor releases all libav resources
+    ~H264Decoder() { m_cleanup(); }
+
+    H264Decoder(const H264Decoder &) = delete;
+    H264Decoder &operator=(const H264Decoder &) = delete;
+
+    /// Store new SPS/PPS from the drone. They are prepended to the next I-frame and the decoder is
+    /// reopened if they changed.
+    /// @param spsBuffer SPS NAL unit including its start code
+    /// @param spsSize size of the SPS in bytes
+    /// @param ppsBuffer PPS NAL unit including its start code
+    /// @param ppsSize size of the PPS in bytes
+    /// @returns true on success
+    bool setH264Params(const uint8_t *spsBuffer, uint32_t spsSize, const uint8_t *ppsBuffer, uint32_t ppsSize)
+    {
+        if (!spsBuffer || !ppsBuffer) { return false; }
+        std::vector<uint8_t> params(spsBuffer, spsBuffer + spsSize);
+        params.insert(params.end(), ppsBuffer, ppsBuffer + ppsSize);
+        if (params != m_codecData) {
+            m_codecData = params;
+            reset();
+        }
+        m_paramsPending = true;
+        return true;
+    }
+
+    /// Open the codec ahead of the first packet, e.g. once the SPS/PPS are known, so the first I-frame
+    /// does not also pay for opening it. sendPacket() opens it otherwise.
+    /// @returns true if the codec is open
+    bool open() { return m_codecCtx || m_openCodec(); }
+
+    /// Submit one H.264 access unit. Frames before the first I-frame are discarded.
+    /// @param data the access unit in Annex B format
+    /// @param size size of the access unit in bytes
+    /// @param isIFrame true if the drone flagged the access unit as an I-frame
+    /// @param pts value returned in AVFrame::pts for the frame decoded from this packet
+    /// @returns false if the packet was rejected by the decoder
+    bool sendPacket(const uint8_t *data, size_t size, bool isIFrame, int64_t pts)
+    {
+        if (m_quality == DecodeQuality::IDR_ONLY && !isIFrame) {
+            // later P-frames refer to the ones skipped here, so resume at an I-frame
+            m_awaitingIFrame = true;
+        }
+        if (m_awaitingIFrame) {
+            if (!isIFrame) {
+                m_packetsSkipped++;
+                return true;
+            }
+            m_awaitingIFrame = false;
+        }
+        if (m_quality == DecodeQuality::SKIP_NON_REFERENCE && !isIFrame && !h264IsReferenceFrame(data, size)) {
+            m_packetsSkipped++;
+            return true;
+        }
+        if (!m_codecCtx && !m_openCodec()) { return false; }
+
+        const uint8_t *payload = data;
+        if (isIFrame && m_paramsPending && !m_codecData.empty()) {
+            m_scratch.assign(m_codecData.begin(), m_codecData.end());
+            m_scratch.insert(m_scratch.end(), data, data + size);
+            payload = m_scratch.data();
+            size    = m_scratch.size();
+            m_paramsPending = false;
+        }
+
+        m_packet->data  = const_cast<uint8_t *>(payload);
+        m_packet->size  = static_cast<int>(size);
+        m_packet->pts   = pts;
+        m_packet->dts   = pts;
+        m_packet->flags = isIFrame ? AV_PKT_FLAG_KEY : 0;
+
+        int ret = avcodec_send_packet(m_codecCtx, m_packet);
+        if (ret == AVERROR(EAGAIN)) {
+            // The caller did not drain every frame. Never happens when receiveFrame() is called
+            // until it returns nullptr, but recover rather than wedge the stream.
+            av_frame_unref(m_frame);
+            while (avcodec_receive_frame(m_codecCtx, m_frame) == 0) { av_frame_unref(m_frame); }
+            ret = avcodec_send_packet(m_codecCtx, m_packet);
+        }
+        m_packet->data = nullptr;
+        m_packet->size = 0;
+        if (ret < 0) {
+            m_awaitingIFrame = true; // resync on the next I-frame
+            return false;
+        }
+        return true;
+    }
+
+    /// Retrieve the next decoded frame, if any
+    /// @returns a frame owned by the decoder and valid until the next call, or nullptr when the decoder
+    /// needs more input
+    const AVFrame *receiveFrame()
+    {
+        if (!m_codecCtx) { return nullptr; }
+        av_frame_unref(m_frame);
+        int ret = avcodec_receive_frame(m_codecCtx, m_frame);
+        if (ret == 0) { return m_frame; }
+        if (ret == AVERROR_EOF) {
+            // drained by flush(), make the decoder accept packets again
+            avcodec_flush_buffers(m_codecCtx);
+        }
+        return nullptr;
+    }
+
+    /// Get the most recently received frame again, e.g. to produce further outputs from it
+    /// @returns the frame returned by the last receiveFrame(), or nullptr if that returned nullptr
+    const AVFrame *getPicture() const { return m_frame->data[0] ? m_frame : nullptr; }
+
+    /// Signal end of stream so that receiveFrame() returns every delayed frame. Afterwards the decoder
+    /// accepts new packets starting with an I-frame.
+    void flush()
+    {
+        if (!m_codecCtx) { return; }
+        avcodec_send_packet(m_codecCtx, nullptr);
+        m_awaitingIFrame = true;
+        m_paramsPending  = !m_codecData.empty();
+    }
+
+    /// Discard packets until the next I-frame, e.g. after the caller dropped a reference frame. Frames
+    /// already submitted are still returned.
+    void awaitIFrame() { m_awaitingIFrame = true; }
+
+    /// Change how much of the stream is decoded. Takes effect on the next packet and survives reset().
+    /// Leaving IDR_ONLY resumes full decoding at the next I-frame.
+    /// @param quality the new level
+    void setQuality(DecodeQuality quality)
+    {
+        m_quality = quality;
+        if (m_codecCtx) { m_applyQuality(); }
+    }
+
+    /// Get the decode quality
+    /// @returns the current level
+    DecodeQuality getQuality() const { return m_quality; }
+
+    /// Get the number of packets not decoded while waiting for an I-frame or because of the quality level
+    /// @returns the packet count since construction
+    uint64_t getPacketsSkipped() const { return m_packetsSkipped; }
+
+    /// Discard all decoder state, including delayed frames. The next packet must be an I-frame.
+    void reset()
+    {
+        av_frame_unref(m_frame);
+        if (m_codecCtx) { avcodec_free_context(&m_codecCtx); }
+        m_awaitingIFrame = true;
+        m_paramsPending  = !m_codecData.empty();
+    }
+
+    /// Convert the most recently received frame into caller-owned planes.
+    /// @param dstFormat destination pixel format
+    /// @param dstData destination plane pointers
+    /// @param dstStride destination plane strides in bytes
+    /// @param dstWidth destination width, scaled if different from the decoded width
+    /// @param dstHeight destination height, scaled if different from the decoded height
+    /// @param swsFlags swscale algorithm flags
+    /// @returns true on success
+    bool convert(AVPixelFormat dstFormat, uint8_t *const dstData[4], const int dstStride[4],
+                 int dstWidth, int dstHeight, int swsFlags = SWS_FAST_BILINEAR)
+    {
+        if (!m_frame->data[0] || dstWidth <= 0 || dstHeight <= 0) { return false; }
+        m_swsCtx = sws_getCachedContext(m_swsCtx, m_frame->width, m_frame->height,
+                                        static_cast<AVPixelFormat>(m_frame->format),
+                                        dstWidth, dstHeight, dstFormat, swsFlags, nullptr, nullptr, nullptr);
+        if (!m_swsCtx) { return false; }
+        return sws_scale(m_swsCtx, m_frame->data, m_frame->linesize, 0, m_frame->height, dstData, dstStride) > 0;
+    }
+
+    /// Convert the most recently received frame into a single packed plane such as RGB24
+    /// @param dstFormat destination packed pixel format
+    /// @param dst destination buffer
+    /// @param dstStride destination stride in bytes
+    /// @param dstWidth destination width
+    /// @param dstHeight destination height
+    /// @returns true on success
+    bool convertPacked(AVPixelFormat dstFormat, uint8_t *dst, int dstStride, int dstWidth, int dstHeight)
+    {
+        uint8_t *planes[4]  = { dst, nullptr, nullptr, nullptr };
+        int      strides[4] = { dstStride, 0, 0, 0 };
+        return convert(dstFormat, planes, strides, dstWidth, dstHeight);
+    }
+
+    /// Write the most recently received frame into a contiguous buffer laid out as getPlaneLayout() describes.
+    /// @details YUV420P and GRAY8 at the decoded size are plane copies with no colour conversion or
+    /// scaling. Packed RGB output at 1/1, 1/2 or 1/4 of the decoded size uses the SIMD kernels when
+    /// DecoderOptions::simdConversion is set and the CPU supports them. Every other combination goes
+    /// through swscale.
+    /// @param format destination pixel format
+    /// @param dst destination buffer of at least getPlaneLayout(format, dstWidth, dstHeight).totalBytes
+    /// @param dstWidth destination width, scaled if different from the decoded width
+    /// @param dstHeight destination height, scaled if different from the decoded height
+    /// @returns true on success
+    bool convertTo(PixelFormat format, uint8_t *dst, unsigned dstWidth, unsigned dstHeight)
+    {
+        if (!m_frame->data[0]) { return false; }
+        const PlaneLayout layout = getPlaneLayout(format, dstWidth, dstHeight);
+        const bool nativeYUV = (m_frame->format == AV_PIX_FMT_YUV420P || m_frame->format == AV_PIX_FMT_YUVJ420P)
+                            && static_cast<unsigned>(m_frame->width)  == dstWidth
+                            && static_cast<unsigned>(m_frame->height) == dstHeight;
+
+        if (nativeYUV && (format == PixelFormat::YUV420P || format == PixelFormat::GRAY8)) {
+            for (unsigned plane = 0; plane < layout.numPlanes; plane++) {
+                uint8_t       *dstLine = dst + layout.offset[plane];
+                const uint8_t *srcLine = m_frame->data[plane];
+                if (m_frame->linesize[plane] == layout.stride[plane]) {
+                    std::memcpy(dstLine, srcLine, static_cast<size_t>(layout.stride[plane]) * layout.lines[plane]);
+                    continue;
+                }
+                for (unsigned line = 0; line < layout.lines[plane]; line++) {
+                    std::memcpy(dstLine, srcLine, layout.stride[plane]);
+                    dstLine += layout.stride[plane];
+                    srcLine += m_frame->linesize[plane];
+                }
+            }
+            return true;
+        }
+
+        if (m_options.simdConversion && m_frame->format == AV_PIX_FMT_YUV420P && dstWidth > 0 && dstHeight > 0) {
+            const unsigned scale = static_cast<unsigned>(m_frame->width) / dstWidth;
+            if (scale > 0 && static_cast<unsigned>(m_frame->width) / scale == dstWidth
+                          && static_cast<unsigned>(m_frame->height) / scale == dstHeight) {
+                const uint8_t *srcPlanes[3]  = { m_frame->data[0], m_frame->data[1], m_frame->data[2] };
+                const int      srcStrides[3] = { m_frame->linesize[0], m_frame->linesize[1], m_frame->linesize[2] };
+                if (convertYUV420P(srcPlanes, srcStrides, m_frame->width, m_frame->height, format,
+                                   dst, layout.stride[0], scale)) {
+                    return true;
+                }
+            }
+        }
+
+        uint8_t *planes[4]  = { nullptr, nullptr, nullptr, nullptr };
+        int      strides[4] = { 0, 0, 0, 0 };
+        for (unsigned plane = 0; plane < layout.numPlanes; plane++) {
+            planes[plane]  = dst + layout.offset[plane];
+            strides[plane] = layout.stride[plane];
+        }
+        return convert(toAVPixelFormat(format), planes, strides, static_cast<int>(dstWidth), static_cast<int>(dstHeight));
+    }
+
+    /// Get the decoded frame width
+    /// @returns width in pixels, 0 before the first frame
+    unsigned getWidth() const { return m_codecCtx ? m_codecCtx->width : 0; }
+
+    /// Get the decoded frame height
+    /// @returns height in lines, 0 before the first frame
+    unsigned getHeight() const { return m_codecCtx ? m_codecCtx->height : 0; }
+
+    /// Get a raw pointer to the codec context, e.g. to adjust skip_frame
+    /// @returns the codec context, nullptr until the first I-frame
+    AVCodecContext *getCodecContext() { return m_codecCtx; }
+
+    /// Get the options the decoder was constructed with
+    /// @returns the decoder options
+    const DecoderOptions &getOptions() const { return m_options; }
+
+private:
+    DecoderOptions        m_options;
+    const AVCodec        *m_codec    = nullptr;
+    AVCodecContext       *m_codecCtx = nullptr;
+    AVPacket             *m_packet   = nullptr;
+    AVFrame              *m_frame    = nullptr;
+    SwsContext           *m_swsCtx   = nullptr;
+    std::vector<uint8_t>  m_codecData;            ///< SPS followed by PPS
+    std::vector<uint8_t>  m_scratch;              ///< SPS/PPS prepended to an I-frame
+    bool                  m_paramsPending  = false;
+    bool                  m_awaitingIFrame = true;
+    DecodeQuality         m_quality        = DecodeQuality::FULL;
+    uint64_t              m_packetsSkipped = 0;
+
+    void m_applyQuality()
+    {
+        m_codecCtx->skip_loop_filter = m_quality >= DecodeQuality::FAST ? AVDISCARD_ALL : AVDISCARD_DEFAULT;
+        switch (m_quality) {
+        case DecodeQuality::SKIP_NON_REFERENCE : m_codecCtx->skip_frame = AVDISCARD_NONREF;  break;
+        case DecodeQuality::IDR_ONLY           : m_codecCtx->skip_frame = AVDISCARD_NONKEY;  break;
+        default                                : m_codecCtx->skip_frame = AVDISCARD_DEFAULT; break;
+        }
+    }
+
+    bool m_openCodec()
+    {
+        m_codecCtx = avcodec_alloc_context3(m_codec);
+        if (!m_codecCtx) { return false; }
+        m_codecCtx->pix_fmt      = AV_PIX_FMT_YUV420P;
+        m_codecCtx->thread_count = m_options.threadCount;
+        m_codecCtx->thread_type  = m_options.lowDelay ? FF_THREAD_SLICE : m_options.threadType;
+        if (m_options.lowDelay) {
+            m_codecCtx->flags  |= AV_CODEC_FLAG_LOW_DELAY;
+            m_codecCtx->flags2 |= AV_CODEC_FLAG2_FAST;
+        }
+        m_applyQuality();
+        if (avcodec_open2(m_codecCtx, m_codec, nullptr) < 0) {
+            avcodec_free_context(&m_codecCtx);
+            return false;
+        }
+        return true;
+    }
+
+    void m_cleanup()
+    {
+        if (m_swsCtx)   { sws_freeContext(m_swsCtx); m_swsCtx = nullptr; }
+        if (m_codecCtx) { avcodec_free_context(&m_codecCtx); }
+        if (m_frame)    { av_frame_free(&m_frame); }
+        if (m_packet)   { av_packet_free(&m_packet); }
+    }
+};
+
+} // wscDrone
+
+#endif /* H264DECODER_H_ */
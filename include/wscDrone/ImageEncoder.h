@@ -0,0 +1,242 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the ImageEncoder, which compresses decoded frames
+ * into JPEG or PNG stills with libavcodec.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef IMAGEENCODER_H_
+#define IMAGEENCODER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "FramePool.h"
+#include "PixelFormat.h"
+
+namespace wscDrone {
+
+/// Still image formats
+enum class ImageFormat : unsigned {
+    JPEG = 0, ///< baseline JPEG, 4:2:0 full range
+    PNG  = 1  ///< lossless PNG, RGB24, RGBA or GRAY8 following the frame
+};
+
+/// Still image encoding options
+struct ImageEncoderOptions {
+    unsigned jpegQuality    = 90; ///< JPEG quality from 1 (smallest) to 100 (best)
+    int      pngCompression = 1;  ///< zlib level from 0 (fastest) to 9 (smallest)
+};
+
+/// Encodes FrameRefs into JPEG or PNG images with the libavcodec MJPEG and PNG encoders.
+/// @details libavcodec is already linked for decoding, and its encoders use the same SIMD code paths:
+/// the forward DCT and quantizer of the MJPEG encoder and the PNG row filters are vectorized, and
+/// swscale's vectorized converters prepare the encoder's pixel format. RGB24, RGBA and GRAY8 frames
+/// go to PNG without any conversion. The codec contexts are opened on the first image and reused
+/// until the size or pixel format changes. Not thread safe, use one encoder per thread.
+class ImageEncoder {
+public:
+    /// Construct an encoder
+    /// @param options quality options, fixed for the life of the encoder
+    explicit ImageEncoder(const ImageEncoderOptions &options = ImageEncoderOptions()) : m_options(options)
+    {
+        if (options.jpegQuality < 1 || options.jpegQuality > 100) {
+            throw std::invalid_argument("ImageEncoder: jpegQuality must be from 1 to 100");
+        }
+        m_packet    = av_packet_alloc();
+        m_frame     = av_frame_alloc();
+        m_converted = av_frame_alloc();
+        if (!m_packet || !m_frame || !m_converted) {
+            m_cleanup();
+            throw std::runtime_error("ImageEncoder: unable to allocate packet or frame");
+        }
+    }
+
+    /// Destructor releases all libav resources
+    ~ImageEncoder() { m_cleanup(); }
+
+    ImageEncoder(const ImageEncoder &) = delete;
+    ImageEncoder &operator=(const ImageEncoder &) = delete;
+
+    /// Encode one frame
+    /// @param frame the frame, in any PixelFormat
+    /// @param format the image format
+    /// @param image receives the encoded file contents
+    /// @param error receives the reason on failure
+    /// @returns true on success
+    bool encode(const FrameRef &frame, ImageFormat format, std::vector<uint8_t> &image, std::string &error)
+    {
+        image.clear();
+        if (!frame || frame.width() == 0 || frame.height() == 0) {
+            error = "ImageEncoder: empty frame";
+            return false;
+        }
+        const int width  = static_cast<int>(frame.width());
+        const int height = static_cast<int>(frame.height());
+        const AVPixelFormat srcFormat = toAVPixelFormat(frame.format());
+        const AVPixelFormat dstFormat = m_encoderFormat(frame.format(), format);
+
+        AVCodecContext *context = m_open(format, width, height, dstFormat, error);
+        if (!context) { return false; }
+
+        // the frame's own planes are encoded directly when no conversion is needed
+        AVFrame *picture = m_frame;
+        av_frame_unref(m_frame);
+        m_frame->width  = width;
+        m_frame->height = height;
+        m_frame->format = srcFormat;
+        for (unsigned plane = 0; plane < frame.numPlanes(); plane++) {
+            m_frame->data[plane]     = const_cast<uint8_t *>(frame.planeData(plane));
+            m_frame->linesize[plane] = frame.planeStride(plane);
+        }
+        if (srcFormat != dstFormat) {
+            if (!m_convert(dstFormat, width, height, error)) { return false; }
+            picture = m_converted;
+        }
+        picture->pts = static_cast<int64_t>(frame.sequence());
+        if (format == ImageFormat::JPEG) { picture->quality = context->global_quality; }
+
+        int ret = avcodec_send_frame(context, picture);
+        if (ret >= 0) { ret = avcodec_receive_packet(context, m_packet); }
+        if (picture == m_frame) {
+            // the planes belong to the FramePool, not to the AVFrame
+            for (auto &data : m_frame->data) { data = nullptr; }
+        }
+        if (ret < 0) {
+            error = "ImageEncoder: encoding failed with error " + std::to_string(ret);
+            return false;
+        }
+        image.assign(m_packet->data, m_packet->data + m_packet->size);
+        av_packet_unref(m_packet);
+        return true;
+    }
+
+    /// Get the options the encoder was constructed with
+    /// @returns the options
+    const ImageEncoderOptions &getOptions() const { return m_options; }
+
+private:
+    static constexpr unsigned NUM_FORMATS = 2;
+
+    const ImageEncoderOptions m_options;
+    AVCodecContext *m_contexts[NUM_FORMATS] = { nullptr, nullptr }; ///< open encoder of each ImageFormat
+    AVPacket       *m_packet    = nullptr;
+    AVFrame        *m_frame     = nullptr; ///< describes the FrameRef's planes
+    AVFrame        *m_converted = nullptr; ///< owns the planes of a converted picture
+    SwsContext     *m_swsCtx    = nullptr;
+
+    /// Get the pixel format the encoder is given for a frame
+    static AVPixelFormat m_encoderFormat(PixelFormat frameFormat, ImageFormat format)
+    {
+        if (format == ImageFormat::JPEG) { return AV_PIX_FMT_YUVJ420P; }
+        switch (frameFormat) {
+        case PixelFormat::RGBA  : return AV_PIX_FMT_RGBA;
+        case PixelFormat::GRAY8 : return AV_PIX_FMT_GRAY8;
+        default                 : return AV_PIX_FMT_RGB24;
+        }
+    }
+
+    /// Get the encoder for a format and size, opening it if needed
+    /// @returns the context, or nullptr with error set
+    AVCodecContext *m_open(ImageFormat format, int width, int height, AVPixelFormat pixelFormat, std::string &error)
+    {
+        AVCodecContext *&context = m_contexts[static_cast<unsigned>(format)];
+        if (context && (context->width != width || context->height != height || context->pix_fmt != pixelFormat)) {
+            avcodec_free_context(&context);
+        }
+        if (context) { return context; }
+
+        const AVCodec *codec = avcodec_find_encoder(format == ImageFormat::JPEG ? AV_CODEC_ID_MJPEG : AV_CODEC_ID_PNG);
+        if (!codec) {
+            error = format == ImageFormat::JPEG ? "ImageEncoder: libavcodec has no JPEG encoder"
+                                                : "ImageEncoder: libavcodec has no PNG encoder";
+            return nullptr;
+        }
+        context = avcodec_alloc_context3(codec);
+        if (!context) {
+            error = "ImageEncoder: unable to allocate codec context";
+            return nullptr;
+        }
+        context->width        = width;
+        context->height       = height;
+        context->pix_fmt      = pixelFormat;
+        context->time_base    = AVRational{ 1, 30 };
+        context->thread_count = 1; // one still per call, parallelism comes from running several encoders
+        if (format == ImageFormat::JPEG) {
+            // quality 100 maps to qscale 2 and quality 1 to qscale 31
+            const int qscale = 2 + static_cast<int>((100 - m_options.jpegQuality) * 29 / 99);
+            context->flags         |= AV_CODEC_FLAG_QSCALE;
+            context->global_quality = qscale * FF_QP2LAMBDA;
+            context->qmin           = qscale;
+            context->qmax           = qscale;
+        } else {
+            context->compression_level = m_options.pngCompression;
+        }
+        if (avcodec_open2(context, codec, nullptr) < 0) {
+            avcodec_free_context(&context);
+            error = "ImageEncoder: unable to open the encoder";
+            return nullptr;
+        }
+        return context;
+    }
+
+    /// Convert m_frame into m_converted
+    bool m_convert(AVPixelFormat dstFormat, int width, int height, std::string &error)
+    {
+        if (m_converted->width != width || m_converted->height != height || m_converted->format != dstFormat) {
+            av_frame_unref(m_converted);
+            m_converted->width  = width;
+            m_converted->height = height;
+            m_converted->format = dstFormat;
+            if (av_frame_get_buffer(m_converted, 32) < 0) {
+                av_frame_unref(m_converted);
+                error = "ImageEncoder: unable to allocate picture";
+                return false;
+            }
+        }
+        m_swsCtx = sws_getCachedContext(m_swsCtx, width, height, static_cast<AVPixelFormat>(m_frame->format),
+                                        width, height, dstFormat, SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!m_swsCtx || sws_scale(m_swsCtx, m_frame->data, m_frame->linesize, 0, height,
+                                   m_converted->data, m_converted->linesize) <= 0) {
+            error = "ImageEncoder: unable to convert the frame";
+            return false;
+        }
+        return true;
+    }
+
+    void m_cleanup()
+    {
+        if (m_swsCtx) { sws_freeContext(m_swsCtx); m_swsCtx = nullptr; }
+        for (auto &context : m_contexts) {
+            if (context) { avcodec_free_context(&context); }
+        }
+        if (m_frame)     { av_frame_free(&m_frame); }
+        if (m_converted) { av_frame_free(&m_converted); }
+        if (m_packet)    { av_packet_free(&m_packet); }
+    }
+};
+
+} // wscDrone
+
+#endif /* IMAGEENCODER_H_ */
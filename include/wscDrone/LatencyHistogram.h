@@ -0,0 +1,200 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the LatencyHistogram, a lock-free log-linear
+ * histogram for recording latencies on real-time threads.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace wscDrone {
+
+/// A copy of the buckets of a LatencyHistogram, for percentiles and export
+class LatencyHistogramSnapshot {
+public:
+    /// Sub-buckets per power of two. Each bucket is within 1/32, about 3%, of its values.
+    static constexpr unsigned SUB_BUCKET_BITS  = 5;
+    static constexpr unsigned SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+    /// Values at or above 2^36 ns, about 68 seconds, are counted in the last bucket
+    static constexpr unsigned MAX_EXPONENT     = 36;
+    static constexpr size_t   BUCKET_COUNT     = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    std::vector<uint64_t> buckets; ///< sample count of each bucket
+    uint64_t count   = 0;          ///< number of samples
+    uint64_t totalNs = 0;          ///< sum of all samples in nanoseconds
+    uint64_t maxNs   = 0;          ///< largest sample in nanoseconds
+
+    /// Get the bucket a value is counted in
+    /// @param ns the value in nanoseconds
+    /// @returns the bucket index
+    static size_t bucketIndex(uint64_t ns)
+    {
+        if (ns < SUB_BUCKET_COUNT) { return static_cast<size_t>(ns); }
+        if (ns >> MAX_EXPONENT) { return BUCKET_COUNT - 1; }
+        const unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(ns));
+        const unsigned shift    = exponent - SUB_BUCKET_BITS;
+        return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT + static_cast<size_t>((ns >> shift) - SUB_BUCKET_COUNT);
+    }
+
+    /// Get the smallest value counted in a bucket
+    /// @param index the bucket index
+    /// @returns the lower bound in nanoseconds
+    static uint64_t bucketLowerNs(size_t index)
+    {
+        if (index < SUB_BUCKET_COUNT) { return index; }
+        const unsigned shift = static_cast<unsigned>(index / SUB_BUCKET_COUNT) - 1;
+        return (SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT) << shift;
+    }
+
+    /// Get the largest value counted in a bucket, excluding the overflow in the last bucket
+    /// @param index the bucket index
+    /// @returns the upper bound in nanoseconds
+    static uint64_t bucketUpperNs(size_t index)
+    {
+        if (index < SUB_BUCKET_COUNT) { return index; }
+        const unsigned shift = static_cast<unsigned>(index / SUB_BUCKET_COUNT) - 1;
+        return bucketLowerNs(index) + (uint64_t(1) << shift) - 1;
+    }
+
+    /// Get the mean
+    /// @returns the mean in microseconds, 0 when there are no samples
+    double meanMicroseconds() const { return count ? (totalNs / 1000.0) / count : 0.0; }
+
+    /// Get a percentile. The result is the upper bound of the bucket it falls in, capped at the maximum.
+    /// @param percent the percentile, from 0 to 100
+    /// @returns the latency in nanoseconds, 0 when there are no samples
+    uint64_t percentileNs(double percent) const
+    {
+        uint64_t total = 0;
+        for (uint64_t n : buckets) { total += n; }
+        if (total == 0) { return 0; }
+        if (percent < 0.0) { percent = 0.0; }
+        if (percent > 100.0) { percent = 100.0; }
+        uint64_t rank = static_cast<uint64_t>(percent / 100.0 * static_cast<double>(total) + 0.5);
+        if (rank < 1) { rank = 1; }
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); i++) {
+            seen += buckets[i];
+            if (seen >= rank) { return bucketUpperNs(i) < maxNs ? bucketUpperNs(i) : maxNs; }
+        }
+        return maxNs;
+    }
+
+    /// Count the samples known to be at or below a value. Buckets that straddle the value are excluded.
+    /// @param ns the value in nanoseconds
+    /// @returns the sample count
+    uint64_t countAtOrBelowNs(uint64_t ns) const
+    {
+        uint64_t n = 0;
+        for (size_t i = 0; i < buckets.size() && bucketUpperNs(i) <= ns; i++) { n += buckets[i]; }
+        return n;
+    }
+
+    /// Append the histogram in the Prometheus text format, without the HELP and TYPE lines
+    /// @param out the text to append to
+    /// @param name the metric name, in seconds
+    /// @param labels label pairs for every line, e.g. stream="a",stage="decode", may be empty
+    void appendPrometheus(std::string &out, const char *name, const std::string &labels) const
+    {
+        static const double BOUNDS_SECONDS[] = { 0.0005, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05,
+                                                 0.1, 0.2, 0.5, 1.0 };
+        const std::string bucket = std::string(name) + "_bucket{" + labels + (labels.empty() ? "" : ",");
+        char number[32];
+        for (double bound : BOUNDS_SECONDS) {
+            std::snprintf(number, sizeof(number), "%g", bound);
+            out += bucket + "le=\"" + number + "\"} " +
+                   std::to_string(countAtOrBelowNs(static_cast<uint64_t>(bound * 1e9))) + "\n";
+        }
+        out += bucket + "le=\"+Inf\"} " + std::to_string(count) + "\n";
+        std::snprintf(number, sizeof(number), "%.9f", totalNs / 1e9);
+        out += std::string(name) + "_sum{" + labels + "} " + number + "\n";
+        out += std::string(name) + "_count{" + labels + "} " + std::to_string(count) + "\n";
+    }
+};
+
+/// A high dynamic range latency histogram. Buckets are exact below 32 ns and log-linear above, with 32
+/// buckets per power of two up to about 68 seconds, so every percentile is within about 3% at any scale.
+/// @details record() is a handful of relaxed atomic adds with no locks or allocation, so it can be
+/// called on the video threads for every frame. Any thread may take a snapshot() at any time. The
+/// snapshot of a histogram being recorded into is not an instantaneous cut; its count is taken from
+/// the copied buckets so the two always agree.
+class LatencyHistogram {
+public:
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    /// Record one sample
+    /// @param ns the latency in nanoseconds
+    void record(uint64_t ns)
+    {
+        m_buckets[LatencyHistogramSnapshot::bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_totalNs.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t prev = m_maxNs.load(std::memory_order_relaxed);
+        while (ns > prev && !m_maxNs.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+    }
+
+    /// Get the number of samples
+    /// @returns the sample count
+    uint64_t getCount() const { return m_count.load(std::memory_order_relaxed); }
+
+    /// Get the sum of all samples
+    /// @returns the total in nanoseconds
+    uint64_t getTotalNs() const { return m_totalNs.load(std::memory_order_relaxed); }
+
+    /// Get the largest sample
+    /// @returns the maximum in nanoseconds
+    uint64_t getMaxNs() const { return m_maxNs.load(std::memory_order_relaxed); }
+
+    /// Copy the buckets
+    /// @returns the snapshot
+    LatencyHistogramSnapshot snapshot() const
+    {
+        LatencyHistogramSnapshot snapshot;
+        snapshot.buckets.resize(LatencyHistogramSnapshot::BUCKET_COUNT);
+        for (size_t i = 0; i < LatencyHistogramSnapshot::BUCKET_COUNT; i++) {
+            snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+            snapshot.count     += snapshot.buckets[i];
+        }
+        snapshot.totalNs = m_totalNs.load(std::memory_order_relaxed);
+        snapshot.maxNs   = m_maxNs.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    /// Clear every bucket. Samples recorded concurrently may be partly kept.
+    void reset()
+    {
+        for (auto &bucket : m_buckets) { bucket.store(0, std::memory_order_relaxed); }
+        m_count   = 0;
+        m_totalNs = 0;
+        m_maxNs   = 0;
+    }
+
+private:
+    std::atomic<uint64_t> m_buckets[LatencyHistogramSnapshot::BUCKET_COUNT] = {}; ///< sample counts
+    std::atomic<uint64_t> m_count{0};   ///< number of samples
+    std::atomic<uint64_t> m_totalNs{0}; ///< sum of all samples
+    std::atomic<uint64_t> m_maxNs{0};   ///< largest sample
+};
+
+} // wscDrone
+
+#endif /* LATENCYHISTOGRAM_H_ */
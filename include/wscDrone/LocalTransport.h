@@ -0,0 +1,283 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the common parts of transports whose drone side runs
+ * in this process, such as the simulator and the flight log replay.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef LOCALTRANSPORT_H_
+#define LOCALTRANSPORT_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libARController/ARController.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "DroneTransport.h"
+#include "Utils.h"
+
+namespace wscDrone {
+
+/// Builds the single-key ARSDK dictionary of one command, as passed to a CommandReceivedCallback
+/// @details Argument names and string values are not copied and must outlive the dictionary. The
+/// entries are owned by this object, only the uthash tables are allocated by get().
+class CommandDictionary {
+public:
+    CommandDictionary() = default;
+    ~CommandDictionary() { m_clearTables(); }
+
+    CommandDictionary(const CommandDictionary &) = delete;
+    CommandDictionary &operator=(const CommandDictionary &) = delete;
+
+    /// Add an argument
+    /// @param name the ARSDK argument name
+    /// @param type the ARSDK value type
+    /// @param value the value
+    /// @returns this dictionary
+    CommandDictionary &add(const char *name, eARCONTROLLER_DICTIONARY_VALUE_TYPE type,
+                           const ARCONTROLLER_DICTIONARY_VALUE_t &value)
+    {
+        m_clearTables();
+        ARCONTROLLER_DICTIONARY_ARG_t argument;
+        std::memset(&argument, 0, sizeof(argument));
+        argument.argument  = name;
+        argument.value     = value;
+        argument.valueType = type;
+        m_arguments.push_back(argument);
+        return *this;
+    }
+
+    CommandDictionary &addU8(const char *name, uint8_t value)
+    {
+        ARCONTROLLER_DICTIONARY_VALUE_t v; std::memset(&v, 0, sizeof(v)); v.U8 = value;
+        return add(name, ARCONTROLLER_DICTIONARY_VALUE_TYPE_U8, v);
+    }
+
+    CommandDictionary &addEnum(const char *name, int32_t value)
+    {
+        ARCONTROLLER_DICTIONARY_VALUE_t v; std::memset(&v, 0, sizeof(v)); v.I32 = value;
+        return add(name, ARCONTROLLER_DICTIONARY_VALUE_TYPE_ENUM, v);
+    }
+
+    CommandDictionary &addFloat(const char *name, float value)
+    {
+        ARCONTROLLER_DICTIONARY_VALUE_t v; std::memset(&v, 0, sizeof(v)); v.Float = value;
+        return add(name, ARCONTROLLER_DICTIONARY_VALUE_TYPE_FLOAT, v);
+    }
+
+    CommandDictionary &addDouble(const char *name, double value)
+    {
+        ARCONTROLLER_DICTIONARY_VALUE_t v; std::memset(&v, 0, sizeof(v)); v.Double = value;
+        return add(name, ARCONTROLLER_DICTIONARY_VALUE_TYPE_DOUBLE, v);
+    }
+
+    /// Remove every argument
+    void clear()
+    {
+        m_clearTables();
+        m_arguments.clear();
+    }
+
+    /// Get the dictionary, building its hash tables on first use
+    /// @returns the dictionary head, valid until the next add() or clear()
+    ARCONTROLLER_DICTIONARY_ELEMENT_t *get()
+    {
+        if (m_dictionary) { return m_dictionary; }
+        ARCONTROLLER_DICTIONARY_ARG_t *argumentTable = nullptr;
+        for (auto &argument : m_arguments) {
+            HASH_ADD_KEYPTR(hh, argumentTable, argument.argument, std::strlen(argument.argument), &argument);
+        }
+        std::memset(&m_element, 0, sizeof(m_element));
+        m_element.key       = const_cast<char *>(ARCONTROLLER_DICTIONARY_SINGLE_KEY);
+        m_element.arguments = argumentTable;
+        HASH_ADD_KEYPTR(hh, m_dictionary, m_element.key, std::strlen(m_element.key), &m_element);
+        return m_dictionary;
+    }
+
+private:
+    std::vector<ARCONTROLLER_DICTIONARY_ARG_t> m_arguments;       ///< the arguments
+    ARCONTROLLER_DICTIONARY_ELEMENT_t          m_element;         ///< the single element
+    ARCONTROLLER_DICTIONARY_ELEMENT_t         *m_dictionary = nullptr; ///< hash head, nullptr until get()
+
+    /// Free the uthash tables. The entries themselves are not heap allocated.
+    void m_clearTables()
+    {
+        if (!m_dictionary) { return; }
+        HASH_CLEAR(hh, m_element.arguments);
+        HASH_CLEAR(hh, m_dictionary);
+        m_dictionary = nullptr;
+    }
+};
+
+/// Common base of transports whose drone side runs in this process. It holds the registered callbacks
+/// and the device state, and delivers commands, decoder configurations and frames the way the ARSDK
+/// threads do.
+/// @details The dispatch functions must not be called with any lock of the derived class held, since
+/// callbacks may call back into the transport.
+class LocalTransport : public DroneTransport {
+public:
+    eARCONTROLLER_DEVICE_STATE getLastState() override { return m_state.load(); }
+
+    /// Waits up to one second. Like a semaphore, a change since the previous call returns immediately.
+    bool waitForStateChange() override
+    {
+        std::unique_lock<std::mutex> lck(m_stateMutex);
+        const bool changed = m_stateCv.wait_for(lck, std::chrono::seconds(1), [this]() {
+            return m_stateChanges != m_stateChangesSeen;
+        });
+        m_stateChangesSeen = m_stateChanges;
+        return changed;
+    }
+
+    void registerCommandReceivedCallback(const CommandReceivedCallback &callback, void *customData) override
+    {
+        std::lock_guard<std::mutex> lck(m_callbackMutex);
+        m_commandCallbacks.emplace_back(callback, customData);
+    }
+
+    void registerVideoCallback(const VideoDecoderConfigCallback &decoderCallback,
+                               const VideoFrameReceivedCallback &videoCallback, void *customData) override
+    {
+        std::lock_guard<std::mutex> lck(m_callbackMutex);
+        m_decoderCallback = decoderCallback;
+        m_videoCallback   = videoCallback;
+        m_videoCustomData = customData;
+    }
+
+    std::shared_ptr<std::mutex> getBufferMutex() override { return m_bufferMutex; }
+
+    /// Get the number of video frames sent since construction
+    /// @returns the frame count
+    uint64_t getFramesSent() const { return m_framesSent.load(); }
+
+protected:
+    /// Change the device state and wake waitForStateChange()
+    /// @param state the new state
+    void m_setState(eARCONTROLLER_DEVICE_STATE state)
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_stateMutex);
+            m_state = state;
+            m_stateChanges++;
+        }
+        m_stateCv.notify_all();
+    }
+
+    /// Pass a command to every command callback
+    /// @param key the ARSDK command key
+    /// @param dictionary the command arguments
+    void m_dispatchCommand(eARCONTROLLER_DICTIONARY_KEY key, CommandDictionary &dictionary)
+    {
+        std::vector<std::pair<CommandReceivedCallback, void *>> callbacks;
+        {
+            std::lock_guard<std::mutex> lck(m_callbackMutex);
+            callbacks = m_commandCallbacks;
+        }
+        ARCONTROLLER_DICTIONARY_ELEMENT_t *element = dictionary.get();
+        for (const auto &callback : callbacks) {
+            callback.first(key, element, callback.second);
+        }
+    }
+
+    /// Pass an H.264 decoder configuration to the decoder callback
+    /// @param sps SPS NAL unit including its start code
+    /// @param spsSize SPS size in bytes
+    /// @param pps PPS NAL unit including its start code
+    /// @param ppsSize PPS size in bytes
+    void m_dispatchDecoderConfig(const uint8_t *sps, size_t spsSize, const uint8_t *pps, size_t ppsSize)
+    {
+        // the callback takes non-const buffers, so give it copies
+        std::vector<uint8_t> spsCopy(sps, sps + spsSize);
+        std::vector<uint8_t> ppsCopy(pps, pps + ppsSize);
+        ARCONTROLLER_Stream_Codec_t codec;
+        std::memset(&codec, 0, sizeof(codec));
+        codec.type = ARCONTROLLER_STREAM_CODEC_TYPE_H264;
+        codec.parameters.h264parameters.spsBuffer = spsCopy.data();
+        codec.parameters.h264parameters.spsSize   = static_cast<int>(spsCopy.size());
+        codec.parameters.h264parameters.ppsBuffer = ppsCopy.data();
+        codec.parameters.h264parameters.ppsSize   = static_cast<int>(ppsCopy.size());
+        codec.parameters.h264parameters.isMP4Compliant = 0;
+
+        VideoDecoderConfigCallback callback;
+        void *customData;
+        {
+            std::lock_guard<std::mutex> lck(m_callbackMutex);
+            callback   = m_decoderCallback;
+            customData = m_videoCustomData;
+        }
+        if (callback) { callback(codec, customData); }
+    }
+
+    /// Pass a compressed frame to the frame callback
+    /// @param data the H.264 access unit
+    /// @param size access unit size in bytes
+    /// @param isIFrame true if the access unit is an I-frame
+    void m_dispatchFrame(const uint8_t *data, size_t size, bool isIFrame)
+    {
+        // the receiver may modify the frame, as it owns the ARSDK buffer, so give it a copy
+        m_frameBuffer.assign(data, data + size);
+
+        ARCONTROLLER_Frame_t frame;
+        std::memset(&frame, 0, sizeof(frame));
+        frame.data      = m_frameBuffer.data();
+        frame.capacity  = static_cast<uint32_t>(m_frameBuffer.capacity());
+        frame.used      = static_cast<uint32_t>(m_frameBuffer.size());
+        frame.isIFrame  = isIFrame ? 1 : 0;
+        frame.timestamp = monotonicNanoseconds() / 1000;
+
+        VideoFrameReceivedCallback callback;
+        void *customData;
+        {
+            std::lock_guard<std::mutex> lck(m_callbackMutex);
+            callback   = m_videoCallback;
+            customData = m_videoCustomData;
+        }
+        if (callback) { callback(&frame, customData); }
+        m_framesSent++;
+    }
+
+private:
+    std::shared_ptr<std::mutex> m_bufferMutex = std::make_shared<std::mutex>(); ///< guards the VideoFrame
+
+    std::atomic<eARCONTROLLER_DEVICE_STATE> m_state{ARCONTROLLER_DEVICE_STATE_STOPPED}; ///< device state
+    std::mutex              m_stateMutex;           ///< protects the state change counters
+    std::condition_variable m_stateCv;              ///< signalled on each state change
+    uint64_t                m_stateChanges     = 0; ///< number of state changes
+    uint64_t                m_stateChangesSeen = 0; ///< m_stateChanges at the last waitForStateChange()
+
+    std::mutex m_callbackMutex;                     ///< protects the callbacks
+    std::vector<std::pair<CommandReceivedCallback, void *>> m_commandCallbacks; ///< command callbacks
+    VideoDecoderConfigCallback m_decoderCallback = nullptr; ///< decoder configuration callback
+    VideoFrameReceivedCallback m_videoCallback   = nullptr; ///< frame callback
+    void *m_videoCustomData = nullptr;                      ///< user data for the video callbacks
+
+    std::vector<uint8_t> m_frameBuffer;             ///< frame copy passed to the frame callback
+    std::atomic<uint64_t> m_framesSent{0};          ///< frames passed to the frame callback
+};
+
+} // wscDrone
+
+#endif /* LOCALTRANSPORT_H_ */
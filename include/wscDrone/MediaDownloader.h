@@ -0,0 +1,495 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the MediaDownloader, which downloads photos from
+ * the drone in the background while the camera keeps capturing.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef MEDIADOWNLOADER_H_
+#define MEDIADOWNLOADER_H_
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CommandDispatcher.h"
+#include "FtpClient.h"
+#include "Utils.h"
+
+namespace wscDrone {
+
+/// MediaDownloader configuration
+struct MediaDownloadOptions {
+    std::string host = "192.168.42.1";                          ///< FTP server, the drone's address
+    uint16_t    port = 21;                                      ///< FTP control port
+    std::string user = "anonymous";                             ///< FTP login name
+    std::string password;                                       ///< FTP login password
+    std::string mediaDirectory = "/internal_000/Bebop_2/media"; ///< directory the drone stores photos in
+    size_t      connections = 2;      ///< persistent connections, each downloading one file at a time
+    unsigned    timeoutMs = 5000;     ///< limit on each connect, send and receive
+    unsigned    maxAttempts = 3;      ///< attempts per file before it is reported as failed
+    unsigned    retryDelayMs = 500;   ///< delay before a retry, and between rescans for a new photo
+};
+
+/// The outcome of one download, passed to the completion callback
+struct MediaDownloadResult {
+    uint64_t    id = 0;               ///< the id returned by MediaDownloader::download()
+    std::string remotePath;           ///< file on the drone
+    std::string localPath;            ///< file written, empty when the file was kept in memory
+    std::vector<uint8_t> data;        ///< the file contents when localPath is empty
+    uint64_t    bytes = 0;            ///< size of the file
+    unsigned    attempts = 0;         ///< transfers attempted, more than 1 when the download was resumed
+    bool        success = false;      ///< true when the whole file was received
+    std::string error;                ///< reason for the last failure
+    uint64_t    elapsedNs = 0;        ///< time from download() to completion
+};
+
+/// A snapshot of the MediaDownloader counters
+struct MediaDownloadStats {
+    uint64_t queued     = 0; ///< downloads waiting for a connection
+    uint64_t active     = 0; ///< downloads in progress
+    uint64_t completed  = 0; ///< downloads that succeeded
+    uint64_t failed     = 0; ///< downloads that failed or were abandoned by stop()
+    uint64_t resumed    = 0; ///< retries that continued from a partial file
+    uint64_t bytes      = 0; ///< bytes received
+    uint64_t discovered = 0; ///< new photos found after picture events
+};
+
+/// alias for the callback invoked on a download thread when a download finishes or fails
+using MediaDownloadCallback = void (*)(const MediaDownloadResult &result, void *customData);
+
+/// Downloads photos from the drone's FTP server in the background.
+/// @details CameraControl::capturePhoto() only triggers the shutter. Downloads are queued and served
+/// by a set of threads, each holding its own logged-in connection, so consecutive files skip the
+/// connect and login and several files transfer at once. FTP cannot pipeline commands on one
+/// connection, so concurrency comes from the connections rather than from pipelining. A failed
+/// transfer reconnects and resumes from the last byte received. A file is either kept in memory or
+/// streamed to disk under localPath + ".part" and renamed when complete. A partial file left by an
+/// earlier run is resumed too.
+///
+/// With enableAutoDownload() every photo the drone reports as taken is downloaded without further
+/// calls. The picture event carries no file name, so the media directory is listed after each
+/// event and the new photos are queued. Capturing never waits for a download.
+class MediaDownloader {
+public:
+    /// Construct a downloader. No connection is made until start().
+    /// @param options the server and the download limits
+    explicit MediaDownloader(const MediaDownloadOptions &options = MediaDownloadOptions())
+        : m_options(options),
+          m_listClient(options.host, options.port, options.user, options.password, options.timeoutMs)
+    {
+        if (m_options.connections == 0) { throw std::invalid_argument("MediaDownloader: connections must be at least 1"); }
+        if (m_options.maxAttempts == 0) { throw std::invalid_argument("MediaDownloader: maxAttempts must be at least 1"); }
+    }
+
+    /// Stops the downloader
+    ~MediaDownloader() { stop(); }
+
+    MediaDownloader(const MediaDownloader &) = delete;
+    MediaDownloader &operator=(const MediaDownloader &) = delete;
+
+    /// Register a function to be called when each download finishes or fails. Must be called before start().
+    /// @param callback function invoked on a download thread, it should return quickly
+    /// @param customData pointer passed back to the callback
+    void registerCompletionCallback(MediaDownloadCallback callback, void *customData)
+    {
+        m_completionCallback = callback;
+        m_completionCustomData = customData;
+    }
+
+    /// Start the download threads. Downloads queued earlier begin now.
+    void start()
+    {
+        std::lock_guard<std::mutex> lck(m_jobMutex);
+        if (m_running) { return; }
+        m_running = true;
+        for (size_t i = 0; i < m_options.connections; i++) {
+            m_workers.emplace_back(&MediaDownloader::m_worker, this);
+        }
+    }
+
+    /// Stop the download threads. A transfer in progress is abandoned and kept as a partial file,
+    /// and every download still queued is reported to the completion callback as failed.
+    void stop()
+    {
+        disableAutoDownload();
+        {
+            std::lock_guard<std::mutex> lck(m_jobMutex);
+            m_running = false;
+        }
+        m_jobCv.notify_all();
+        for (auto &worker : m_workers) { worker.join(); }
+        m_workers.clear();
+
+        std::deque<Job> abandoned;
+        {
+            std::lock_guard<std::mutex> lck(m_jobMutex);
+            abandoned.swap(m_jobs);
+        }
+        for (Job &job : abandoned) {
+            if (job.scan) { continue; }
+            MediaDownloadResult result;
+            result.id         = job.id;
+            result.remotePath = job.remotePath;
+            result.localPath  = job.localPath;
+            result.error      = "MediaDownloader: stopped";
+            m_complete(job, result);
+        }
+    }
+
+    /// Queue the download of one file
+    /// @param remotePath the file on the drone, relative paths are in MediaDownloadOptions::mediaDirectory
+    /// @param localPath file to write, empty to deliver the contents in MediaDownloadResult::data
+    /// @returns the id reported in the result
+    uint64_t download(const std::string &remotePath, const std::string &localPath = "")
+    {
+        Job job;
+        job.id         = m_nextId.fetch_add(1);
+        job.remotePath = (remotePath.empty() || remotePath[0] == '/') ? remotePath
+                                                                     : m_options.mediaDirectory + "/" + remotePath;
+        job.localPath  = localPath;
+        job.queuedNs   = monotonicNanoseconds();
+        const uint64_t id = job.id;
+        m_push(std::move(job));
+        return id;
+    }
+
+    /// List the photos and videos on the drone. Uses a connection of its own, so it does not wait for downloads.
+    /// @returns the file names in MediaDownloadOptions::mediaDirectory
+    std::vector<std::string> listMedia()
+    {
+        std::lock_guard<std::mutex> lck(m_listMutex);
+        return m_listClient.list(m_options.mediaDirectory);
+    }
+
+    /// Download every photo the drone takes from now on
+    /// @param dispatcher dispatcher attached to the drone, it must outlive the auto download
+    /// @param localDirectory directory the photos are written to, empty to deliver them in memory
+    void enableAutoDownload(CommandDispatcher &dispatcher, const std::string &localDirectory)
+    {
+        disableAutoDownload();
+        {
+            std::lock_guard<std::mutex> lck(m_scanMutex);
+            m_localDirectory = localDirectory;
+            m_known.clear();
+            m_baselineDone = false;
+        }
+        // the files already on the drone are recorded first, so only new photos are downloaded
+        Job baseline;
+        baseline.scan = true;
+        m_push(std::move(baseline));
+        dispatcher.subscribe(CommandType::PICTURE_EVENT, m_onPictureEventDefault, this);
+        m_dispatcher = &dispatcher;
+    }
+
+    /// Stop downloading new photos. Downloads already queued continue.
+    void disableAutoDownload()
+    {
+        if (!m_dispatcher) { return; }
+        m_dispatcher->unsubscribe(CommandType::PICTURE_EVENT, m_onPictureEventDefault, this);
+        m_dispatcher = nullptr;
+    }
+
+    /// Get the downloader counters
+    /// @returns a snapshot of the counters
+    MediaDownloadStats getStats() const
+    {
+        MediaDownloadStats stats;
+        {
+            std::lock_guard<std::mutex> lck(m_jobMutex);
+            for (const Job &job : m_jobs) { if (!job.scan) { stats.queued++; } }
+        }
+        stats.active     = m_active.load(std::memory_order_relaxed);
+        stats.completed  = m_completed.load(std::memory_order_relaxed);
+        stats.failed     = m_failed.load(std::memory_order_relaxed);
+        stats.resumed    = m_resumed.load(std::memory_order_relaxed);
+        stats.bytes      = m_bytes.load(std::memory_order_relaxed);
+        stats.discovered = m_discovered.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    /// Suffix of a file being downloaded
+    static constexpr const char *PARTIAL_SUFFIX = ".part";
+    /// Rescans of the media directory after a picture event that found no new photo
+    static constexpr unsigned SCAN_RETRIES = 3;
+
+    /// One queued download or media directory scan
+    struct Job {
+        uint64_t    id = 0;
+        std::string remotePath;
+        std::string localPath;
+        uint64_t    queuedNs = 0;
+        bool        scan = false;        ///< list the media directory instead of downloading
+        unsigned    scanAttempt = 0;     ///< rescans already made for this picture event
+        uint64_t    notBeforeNs = 0;     ///< the job waits in the queue until this time
+    };
+
+    const MediaDownloadOptions m_options;
+    MediaDownloadCallback m_completionCallback = nullptr;
+    void *m_completionCustomData = nullptr;
+
+    mutable std::mutex      m_jobMutex;  ///< protects m_jobs and m_running
+    std::condition_variable m_jobCv;     ///< signals a new job or stop()
+    std::deque<Job>         m_jobs;      ///< downloads and scans waiting for a thread
+    bool                    m_running = false;
+    std::vector<std::thread> m_workers;  ///< download threads, one connection each
+
+    std::mutex m_listMutex;              ///< serializes listMedia()
+    FtpClient  m_listClient;             ///< connection used by listMedia()
+
+    std::mutex            m_scanMutex;   ///< serializes scans, protects the members below
+    std::set<std::string> m_known;       ///< files in the media directory already seen
+    std::string           m_localDirectory; ///< where auto downloaded photos go
+    bool                  m_baselineDone = false;
+    CommandDispatcher    *m_dispatcher = nullptr; ///< dispatcher of the auto download subscription
+
+    std::atomic<uint64_t> m_nextId{1};
+    std::atomic<uint64_t> m_active{0};
+    std::atomic<uint64_t> m_completed{0};
+    std::atomic<uint64_t> m_failed{0};
+    std::atomic<uint64_t> m_resumed{0};
+    std::atomic<uint64_t> m_bytes{0};
+    std::atomic<uint64_t> m_discovered{0};
+
+    void m_push(Job job)
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_jobMutex);
+            m_jobs.push_back(std::move(job));
+        }
+        // every thread wakes, as one may be waiting out a retry delay rather than for work
+        m_jobCv.notify_all();
+    }
+
+    /// Body of each download thread
+    void m_worker()
+    {
+        FtpClient client(m_options.host, m_options.port, m_options.user, m_options.password, m_options.timeoutMs);
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lck(m_jobMutex);
+                while (true) {
+                    if (!m_running) { return; }
+                    const uint64_t now = monotonicNanoseconds();
+                    auto ready = std::find_if(m_jobs.begin(), m_jobs.end(),
+                                              [now](const Job &j) { return j.notBeforeNs <= now; });
+                    if (ready != m_jobs.end()) {
+                        job = std::move(*ready);
+                        m_jobs.erase(ready);
+                        break;
+                    }
+                    if (m_jobs.empty()) {
+                        m_jobCv.wait(lck);
+                    } else {
+                        uint64_t earliest = UINT64_MAX;
+                        for (const Job &j : m_jobs) { earliest = std::min(earliest, j.notBeforeNs); }
+                        m_jobCv.wait_for(lck, std::chrono::nanoseconds(earliest - now));
+                    }
+                }
+            }
+            if (job.scan) {
+                m_scan(client, job);
+            } else {
+                m_active.fetch_add(1, std::memory_order_relaxed);
+                m_download(client, job);
+                m_active.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Wait before a retry
+    /// @returns false if stop() was called
+    bool m_retryDelay()
+    {
+        std::unique_lock<std::mutex> lck(m_jobMutex);
+        return !m_jobCv.wait_for(lck, std::chrono::milliseconds(m_options.retryDelayMs), [this]() { return !m_running; });
+    }
+
+    bool m_isRunning()
+    {
+        std::lock_guard<std::mutex> lck(m_jobMutex);
+        return m_running;
+    }
+
+    /// Download one file, retrying and resuming until it completes or runs out of attempts
+    void m_download(FtpClient &client, Job &job)
+    {
+        MediaDownloadResult result;
+        result.id         = job.id;
+        result.remotePath = job.remotePath;
+        result.localPath  = job.localPath;
+
+        const std::string partial = job.localPath + PARTIAL_SUFFIX;
+        std::FILE *file = nullptr;
+        uint64_t have = 0;
+        if (!job.localPath.empty()) {
+            file = std::fopen(partial.c_str(), "ab");
+            if (!file) {
+                result.error = "MediaDownloader: unable to open " + partial;
+                m_complete(job, result);
+                return;
+            }
+            struct stat status;
+            if (::fstat(::fileno(file), &status) == 0) { have = static_cast<uint64_t>(status.st_size); }
+        }
+
+        // discard what has been received, when the server cannot resume or the file is wrong
+        auto discard = [&]() {
+            if (file) {
+                std::fflush(file);
+                if (::ftruncate(::fileno(file), 0) != 0) { throw std::runtime_error("MediaDownloader: unable to truncate " + partial); }
+            } else {
+                result.data.clear();
+            }
+            have = 0;
+        };
+
+        while (result.attempts < m_options.maxAttempts) {
+            if (result.attempts > 0 && have > 0) { m_resumed.fetch_add(1, std::memory_order_relaxed); }
+            result.attempts++;
+            try {
+                uint64_t offset = have;
+                const uint64_t requested = offset;
+                bool first = true;
+                client.retrieve(job.remotePath, offset, [&](const uint8_t *data, size_t size) {
+                    if (first) {
+                        first = false;
+                        if (offset != requested) { discard(); }
+                    }
+                    if (!m_isRunning()) { throw std::runtime_error("MediaDownloader: stopped"); }
+                    if (file) {
+                        if (std::fwrite(data, 1, size, file) != size) {
+                            throw std::runtime_error("MediaDownloader: unable to write " + partial);
+                        }
+                    } else {
+                        result.data.insert(result.data.end(), data, data + size);
+                    }
+                    have += size;
+                    m_bytes.fetch_add(size, std::memory_order_relaxed);
+                });
+                if (first && offset != requested) { discard(); }
+                if (file && std::fflush(file) != 0) { throw std::runtime_error("MediaDownloader: unable to write " + partial); }
+
+                uint64_t expected = 0;
+                if (client.size(job.remotePath, expected) && expected != have) {
+                    discard();
+                    throw std::runtime_error("MediaDownloader: " + job.remotePath + " size mismatch, expected " +
+                                             std::to_string(expected));
+                }
+                result.success = true;
+                result.error.clear();
+                break;
+            } catch (const std::exception &e) {
+                result.error = e.what();
+                if (result.attempts >= m_options.maxAttempts || !m_retryDelay()) { break; }
+            }
+        }
+
+        result.bytes = have;
+        if (file) {
+            std::fclose(file);
+            // a failed download keeps its partial file for the next attempt
+            if (result.success && std::rename(partial.c_str(), job.localPath.c_str()) != 0) {
+                result.success = false;
+                result.error = "MediaDownloader: unable to rename " + partial;
+            }
+        }
+        m_complete(job, result);
+    }
+
+    void m_complete(const Job &job, MediaDownloadResult &result)
+    {
+        result.elapsedNs = monotonicNanoseconds() - job.queuedNs;
+        if (result.success) { m_completed.fetch_add(1, std::memory_order_relaxed); }
+        else { m_failed.fetch_add(1, std::memory_order_relaxed); }
+        if (m_completionCallback) { m_completionCallback(result, m_completionCustomData); }
+    }
+
+    /// List the media directory and queue every new photo
+    void m_scan(FtpClient &client, Job &job)
+    {
+        std::vector<std::string> names;
+        std::string localDirectory;
+        size_t found = 0;
+        {
+            std::lock_guard<std::mutex> lck(m_scanMutex);
+            try {
+                names = client.list(m_options.mediaDirectory);
+            } catch (const std::exception &) {
+                if (job.scanAttempt < SCAN_RETRIES) { m_rescan(job); }
+                return;
+            }
+            localDirectory = m_localDirectory;
+            const bool baseline = !m_baselineDone;
+            m_baselineDone = true;
+            for (const std::string &name : names) {
+                if (!m_known.insert(name).second || baseline || !m_isPhoto(name)) { continue; }
+                download(name, localDirectory.empty() ? "" : localDirectory + "/" + name);
+                found++;
+            }
+            if (baseline) { return; }
+        }
+        m_discovered.fetch_add(found, std::memory_order_relaxed);
+        // the drone may report the photo before its file appears in the directory
+        if (found == 0 && job.scanAttempt < SCAN_RETRIES) { m_rescan(job); }
+    }
+
+    void m_rescan(const Job &job)
+    {
+        Job rescan;
+        rescan.scan        = true;
+        rescan.scanAttempt = job.scanAttempt + 1;
+        rescan.notBeforeNs = monotonicNanoseconds() + static_cast<uint64_t>(m_options.retryDelayMs) * 1000000;
+        m_push(std::move(rescan));
+    }
+
+    /// Check if a file name is a JPEG or DNG photo
+    static bool m_isPhoto(const std::string &name)
+    {
+        const size_t dot = name.rfind('.');
+        if (dot == std::string::npos) { return false; }
+        std::string extension = name.substr(dot + 1);
+        for (char &c : extension) { c = static_cast<char>(std::tolower(static_cast<unsigned char>(c))); }
+        return extension == "jpg" || extension == "jpeg" || extension == "dng";
+    }
+
+    /// Queue a scan for each photo taken. Called on the ARSDK command thread, so it never blocks on the network.
+    static void m_onPictureEventDefault(const DecodedCommand &command, void *customData)
+    {
+        if (command.type != CommandType::PICTURE_EVENT ||
+            command.mediaState.state != ARCOMMANDS_ARDRONE3_MEDIARECORDEVENT_PICTUREEVENTCHANGED_EVENT_TAKEN) {
+            return;
+        }
+        Job scan;
+        scan.scan = true;
+        static_cast<MediaDownloader *>(customData)->m_push(std::move(scan));
+    }
+};
+
+} // wscDrone
+
+#endif /* MEDIADOWNLOADER_H_ */
@@ -0,0 +1,390 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the MoveSequencer, a non-blocking queue of relative
+ * moves and heading changes completed through futures.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef MOVESEQUENCER_H_
+#define MOVESEQUENCER_H_
+
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libARController/ARController.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "DroneController.h"
+#include "DroneTransport.h"
+#include "Pilot.h"
+#include "Utils.h"
+
+namespace wscDrone {
+
+/// Outcome of a queued move
+enum class MoveStatus : unsigned {
+    COMPLETED   = 0, ///< the drone reported the move done
+    INTERRUPTED = 1, ///< the drone reported the move interrupted, e.g. by another piloting command
+    FAILED      = 2, ///< the drone rejected the move, see MoveResult::error
+    CANCELLED   = 3, ///< cancelled before completion
+    TIMED_OUT   = 4  ///< no move-end event arrived within the timeout
+};
+
+/// Result of a queued move
+struct MoveResult {
+    uint64_t   id     = 0;                   ///< id returned in the MoveHandle
+    MoveStatus status = MoveStatus::CANCELLED; ///< outcome
+    int        error  = 0;                   ///< raw ARSDK MoveByEnd error value
+    float      dX     = 0.0f;                ///< forward displacement the drone reported, metres
+    float      dY     = 0.0f;                ///< right displacement the drone reported, metres
+    float      dZ     = 0.0f;                ///< down displacement the drone reported, metres
+    float      dPsi   = 0.0f;                ///< heading change the drone reported, radians
+    uint64_t   durationNs = 0;               ///< time from sending the move to its completion, 0 if never sent
+};
+
+/// alias for the callback invoked when a queued move finishes
+using MoveCompleteCallback = void (*)(const MoveResult &result, void *customData);
+
+/// A queued move. The future becomes ready when the move finishes in any way.
+struct MoveHandle {
+    uint64_t id = 0;                          ///< id for cancel()
+    std::shared_future<MoveResult> result;    ///< completes with the move result
+};
+
+/// Queues relative moves and heading changes for one drone and sends them one after another without
+/// blocking the caller. Each queued move returns a MoveHandle whose future completes when the drone's
+/// move-end event for that move arrives, so one mission thread can drive many drones by polling or
+/// waiting on futures instead of parking a thread per drone in Pilot::waitMoveComplete().
+/// @details The drone runs one relative move at a time and reports each one with a single move-end
+/// event, so only one move is in flight and every event completes the move at the head of the queue.
+/// Cancelling the in-flight move sends a zero move, which interrupts it; the events of both moves are
+/// consumed internally. The zero move reports last, so its event ends the interrupt even when the
+/// interrupted move had already ended and its event was lost. Each move-end event also notifies the
+/// Pilot's own move semaphore, so do not mix the sequencer with blocking Pilot moves on the same drone.
+class MoveSequencer {
+public:
+    MoveSequencer() = delete;
+
+    /// Construct a sequencer and register its command callback with the DroneController
+    /// @param droneController smart pointer to the drone's controller
+    /// @param pilot smart pointer to the drone's Pilot, used to send the moves
+    /// @param timeoutMilliseconds how long a sent move may run before it is reported TIMED_OUT
+    /// @param interruptTimeoutMilliseconds how long an interrupt waits for its move-end events before
+    /// the next move is sent anyway
+    MoveSequencer(std::shared_ptr<DroneController> droneController, std::shared_ptr<Pilot> pilot,
+                  unsigned timeoutMilliseconds = 30000, unsigned interruptTimeoutMilliseconds = 2000)
+        : MoveSequencer(std::make_shared<ArsdkTransport>(droneController, nullptr, pilot), timeoutMilliseconds,
+                        interruptTimeoutMilliseconds) {}
+
+    /// Construct a sequencer on a DroneTransport, e.g. a SimulatedDrone
+    /// @param transport smart pointer to the drone's transport, used for commands and to send the moves
+    /// @param timeoutMilliseconds how long a sent move may run before it is reported TIMED_OUT
+    /// @param interruptTimeoutMilliseconds how long an interrupt waits for its move-end events before
+    /// the next move is sent anyway
+    explicit MoveSequencer(std::shared_ptr<DroneTransport> transport, unsigned timeoutMilliseconds = 30000,
+                           unsigned interruptTimeoutMilliseconds = 2000)
+        : m_transport(transport), m_timeoutNs(static_cast<uint64_t>(timeoutMilliseconds) * 1000000ULL),
+          m_interruptTimeoutNs(static_cast<uint64_t>(interruptTimeoutMilliseconds) * 1000000ULL)
+    {
+        m_transport->registerCommandReceivedCallback(m_onCommandReceivedDefault, this);
+    }
+
+    /// Cancels everything still queued. The sequencer must outlive the controller's command stream.
+    ~MoveSequencer() { cancelAll(); }
+
+    MoveSequencer(const MoveSequencer &) = delete;
+    MoveSequencer &operator=(const MoveSequencer &) = delete;
+
+    /// Queue a relative move, see Pilot::moveRelativeMetres()
+    /// @param dx displacement in meters to the right (positive) or left (negative)
+    /// @param dy displacement in meters forward (positive) or backwards (negative)
+    /// @param heading heading change in degrees, positive is clockwise
+    /// @param callback optional function to execute when the move finishes, runs on the thread that finishes it
+    /// @param customData a raw pointer passed back to the callback
+    /// @returns the handle for the move
+    MoveHandle queueMove(float dx, float dy, float heading = 0.0f,
+                         MoveCompleteCallback callback = nullptr, void *customData = nullptr)
+    {
+        return m_queue(dx, dy, 0.0f, heading, callback, customData);
+    }
+
+    /// Queue a heading change without moving
+    /// @param heading heading change in degrees, positive is clockwise
+    /// @param callback optional function to execute when the turn finishes
+    /// @param customData a raw pointer passed back to the callback
+    /// @returns the handle for the turn
+    MoveHandle queueHeading(float heading, MoveCompleteCallback callback = nullptr, void *customData = nullptr)
+    {
+        return m_queue(0.0f, 0.0f, 0.0f, heading, callback, customData);
+    }
+
+#ifndef RESTRICTED_ALTITUDE
+    /// Queue a relative move including altitude, see Pilot::moveRelativeMetresRestricted()
+    /// @param dx displacement in meters to the right (positive) or left (negative)
+    /// @param dy displacement in meters forward (positive) or backwards (negative)
+    /// @param dz displacement in meters down (positive) or up (negative)
+    /// @param heading heading change in degrees, positive is clockwise
+    /// @param callback optional function to execute when the move finishes
+    /// @param customData a raw pointer passed back to the callback
+    /// @returns the handle for the move
+    MoveHandle queueMoveRestricted(float dx, float dy, float dz, float heading = 0.0f,
+                                   MoveCompleteCallback callback = nullptr, void *customData = nullptr)
+    {
+        return m_queue(dx, dy, dz, heading, callback, customData);
+    }
+#endif
+
+    /// Cancel a move. A queued move is removed; the in-flight move is interrupted.
+    /// @param id the id from the MoveHandle
+    /// @returns false if the move already finished
+    bool cancel(uint64_t id)
+    {
+        std::vector<Command> finished;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            auto it = m_commands.begin();
+            while (it != m_commands.end() && it->id != id) { ++it; }
+            if (it == m_commands.end()) { return false; }
+            if (it == m_commands.begin() && m_inFlight) {
+                m_interruptInFlight(finished);
+            } else {
+                finished.push_back(std::move(*it));
+                m_commands.erase(it);
+            }
+        }
+        m_finish(finished, MoveStatus::CANCELLED);
+        return true;
+    }
+
+    /// Cancel every queued move and interrupt the in-flight one
+    void cancelAll()
+    {
+        std::vector<Command> finished;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            if (m_inFlight) { m_interruptInFlight(finished); }
+            for (auto &command : m_commands) { finished.push_back(std::move(command)); }
+            m_commands.clear();
+        }
+        m_finish(finished, MoveStatus::CANCELLED);
+    }
+
+    /// Report the in-flight move TIMED_OUT if its deadline has passed and send the next one. The timed
+    /// out move is stopped with a zero move first, as cancel() does, and the next move is sent once the
+    /// drone has reported the interrupt, so a late MoveByEnd is never credited to the next move. An
+    /// interrupt whose events do not arrive within the interrupt timeout is abandoned.
+    /// Call periodically, e.g. from an EventLoop timer; the sequencer has no thread of its own.
+    void checkTimeout()
+    {
+        std::vector<Command> finished;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            if (m_swallowEvents > 0 && monotonicNanoseconds() - m_interruptNs >= m_interruptTimeoutNs) {
+                // the events of an interrupt never arrived, stop waiting for them
+                m_swallowEvents = 0;
+                m_sendNext();
+                return;
+            }
+            if (!m_inFlight || monotonicNanoseconds() - m_commands.front().sentNs < m_timeoutNs) { return; }
+            // the drone may still be flying the move, stop it before the next one
+            m_interruptInFlight(finished);
+        }
+        m_finish(finished, MoveStatus::TIMED_OUT);
+    }
+
+    /// Get the number of moves queued or in flight
+    /// @returns the number of unfinished moves
+    size_t pending()
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        return m_commands.size();
+    }
+
+    /// Check if the drone is executing a move from the sequencer
+    /// @returns true while a move is in flight
+    bool isBusy()
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        return m_inFlight;
+    }
+
+private:
+    /// MoveByEnd error values of the ARSDK eARCOMMANDS_ARDRONE3_PILOTINGEVENT_MOVEBYEND_ERROR enumeration
+    static constexpr int MOVEBYEND_ERROR_OK          = 0;
+    static constexpr int MOVEBYEND_ERROR_INTERRUPTED = 4;
+    /// Displacement below which a move-end event is taken to be the zero move's, metres or radians
+    static constexpr float ZERO_MOVE_EPSILON = 1e-3f;
+
+    struct Command {
+        uint64_t id      = 0;
+        float    dx      = 0.0f;
+        float    dy      = 0.0f;
+        float    dz      = 0.0f;
+        float    heading = 0.0f;
+        uint64_t sentNs  = 0;
+        MoveCompleteCallback callback = nullptr;
+        void    *customData = nullptr;
+        std::shared_ptr<std::promise<MoveResult>> promise;
+    };
+
+    std::shared_ptr<DroneTransport> m_transport = nullptr; ///< used to send the moves
+    const uint64_t m_timeoutNs;               ///< in-flight deadline
+    const uint64_t m_interruptTimeoutNs;      ///< deadline for the move-end events of an interrupt
+    std::mutex m_mutex;                       ///< protects everything below
+    std::deque<Command> m_commands;           ///< unfinished moves, the head is in flight when m_inFlight
+    bool     m_inFlight = false;              ///< true when the head command has been sent
+    unsigned m_swallowEvents = 0;             ///< move-end events of an interrupt still to come
+    uint64_t m_interruptNs   = 0;             ///< time of the last interrupt
+    bool     m_interruptedZero = false;       ///< the interrupted move was itself a zero move
+    uint64_t m_nextId = 1;                    ///< id of the next queued move
+
+    MoveHandle m_queue(float dx, float dy, float dz, float heading, MoveCompleteCallback callback, void *customData)
+    {
+        Command command;
+        command.dx         = dx;
+        command.dy         = dy;
+        command.dz         = dz;
+        command.heading    = heading;
+        command.callback   = callback;
+        command.customData = customData;
+        command.promise    = std::make_shared<std::promise<MoveResult>>();
+
+        MoveHandle handle;
+        handle.result = command.promise->get_future().share();
+        std::lock_guard<std::mutex> lck(m_mutex);
+        command.id = m_nextId++;
+        handle.id  = command.id;
+        m_commands.push_back(std::move(command));
+        if (!m_inFlight) { m_sendNext(); }
+        return handle;
+    }
+
+    /// Send the head command. Called with m_mutex held.
+    void m_sendNext()
+    {
+        if (m_inFlight || m_swallowEvents > 0 || m_commands.empty()) { return; }
+        Command &command = m_commands.front();
+        command.sentNs = monotonicNanoseconds();
+        m_inFlight = true;
+        m_transport->moveRelativeMetres(command.dx, command.dy, command.dz, command.heading);
+    }
+
+    /// Interrupt the in-flight command with a zero move. Called with m_mutex held.
+    void m_interruptInFlight(std::vector<Command> &finished)
+    {
+        const Command &command = m_commands.front();
+        m_interruptedZero = command.dx == 0.0f && command.dy == 0.0f && command.dz == 0.0f &&
+                            command.heading == 0.0f;
+        finished.push_back(std::move(m_commands.front()));
+        m_commands.pop_front();
+        m_inFlight = false;
+        // the interrupted move, if still running, and the zero move each produce a move-end event
+        m_swallowEvents = 2;
+        m_interruptNs = monotonicNanoseconds();
+        m_transport->moveRelativeMetres(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    /// Complete commands outside the lock
+    void m_finish(std::vector<Command> &finished, MoveStatus status, const MoveResult *reported = nullptr)
+    {
+        const uint64_t nowNs = monotonicNanoseconds();
+        for (auto &command : finished) {
+            MoveResult result = reported ? *reported : MoveResult();
+            result.id         = command.id;
+            result.status     = status;
+            result.durationNs = command.sentNs ? nowNs - command.sentNs : 0;
+            if (command.callback) { command.callback(result, command.customData); }
+            command.promise->set_value(result);
+        }
+    }
+
+    /// Handle a MoveByEnd event. Runs on the ARSDK command thread.
+    void m_onMoveEnd(const MoveResult &reported)
+    {
+        std::vector<Command> finished;
+        MoveStatus status = MoveStatus::COMPLETED;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            if (m_swallowEvents > 0) {
+                // the zero move's event comes last; unless the interrupted move was also a zero move,
+                // it ends the interrupt whether or not the interrupted move's event arrived
+                m_swallowEvents = m_isZeroMoveEnd(reported) && !m_interruptedZero ? 0 : m_swallowEvents - 1;
+                if (m_swallowEvents == 0) { m_sendNext(); }
+                return;
+            }
+            if (!m_inFlight) { return; } // a move the sequencer did not send
+            finished.push_back(std::move(m_commands.front()));
+            m_commands.pop_front();
+            m_inFlight = false;
+            m_sendNext();
+        }
+        if (reported.error == MOVEBYEND_ERROR_INTERRUPTED) {
+            status = MoveStatus::INTERRUPTED;
+        } else if (reported.error != MOVEBYEND_ERROR_OK) {
+            status = MoveStatus::FAILED;
+        }
+        m_finish(finished, status, &reported);
+    }
+
+    /// Check if a move-end event is that of a completed zero move
+    static bool m_isZeroMoveEnd(const MoveResult &reported)
+    {
+        return reported.error == MOVEBYEND_ERROR_OK && std::fabs(reported.dX) < ZERO_MOVE_EPSILON &&
+               std::fabs(reported.dY) < ZERO_MOVE_EPSILON && std::fabs(reported.dZ) < ZERO_MOVE_EPSILON &&
+               std::fabs(reported.dPsi) < ZERO_MOVE_EPSILON;
+    }
+
+    /// Command callback registered by the constructor
+    /// @param commandKey the ARSDK command key
+    /// @param elementDictionary the ARSDK argument dictionary
+    /// @param customData a pointer to an instance of MoveSequencer
+    static void m_onCommandReceivedDefault(eARCONTROLLER_DICTIONARY_KEY commandKey,
+                                           ARCONTROLLER_DICTIONARY_ELEMENT_t *elementDictionary, void *customData)
+    {
+        MoveSequencer *sequencer = static_cast<MoveSequencer *>(customData);
+        if (!sequencer || !elementDictionary || commandKey != ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND) {
+            return;
+        }
+        ARCONTROLLER_DICTIONARY_ELEMENT_t *element = nullptr;
+        HASH_FIND_STR(elementDictionary, ARCONTROLLER_DICTIONARY_SINGLE_KEY, element);
+        if (!element) { return; }
+
+        MoveResult reported;
+        ARCONTROLLER_DICTIONARY_ARG_t *arg = nullptr;
+        HASH_FIND_STR(element->arguments, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_DX, arg);
+        if (arg) { reported.dX = arg->value.Float; }
+        HASH_FIND_STR(element->arguments, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_DY, arg);
+        if (arg) { reported.dY = arg->value.Float; }
+        HASH_FIND_STR(element->arguments, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_DZ, arg);
+        if (arg) { reported.dZ = arg->value.Float; }
+        HASH_FIND_STR(element->arguments, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_DPSI, arg);
+        if (arg) { reported.dPsi = arg->value.Float; }
+        HASH_FIND_STR(element->arguments, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_ERROR, arg);
+        if (arg) { reported.error = arg->value.I32; }
+        sequencer->m_onMoveEnd(reported);
+    }
+};
+
+} // wscDrone
+
+#endif /* MOVESEQUENCER_H_ */
@@ -0,0 +1,115 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the pixel formats the library can output and the
+ * layout of each format in a contiguous frame buffer.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef PIXELFORMAT_H_
+#define PIXELFORMAT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libavutil/avutil.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <cstddef>
+
+namespace wscDrone {
+
+/// Output pixel formats for decoded video
+enum class PixelFormat : unsigned {
+    RGB24   = 0, ///< packed 8-bit R, G, B. The default, and the only format of a plain VideoFrame before this option
+    BGR24   = 1, ///< packed 8-bit B, G, R, as used by OpenCV
+    YUV420P = 2, ///< the decoder's native planar Y, U, V. Copied out without any colour conversion
+    NV12    = 3, ///< planar Y followed by interleaved U/V
+    GRAY8   = 4, ///< luma only. Copied out of the Y plane without any colour conversion
+    RGBA    = 5  ///< packed 8-bit R, G, B, A with opaque alpha, for GPU texture upload
+};
+
+/// Maximum number of planes of any PixelFormat
+constexpr unsigned MAX_PLANES = 4;
+
+/// Where each plane of an image lives in a contiguous buffer. Planes are tightly packed, in order.
+struct PlaneLayout {
+    unsigned numPlanes = 0;                 ///< number of planes in use
+    size_t   offset[MAX_PLANES] = {};       ///< byte offset of each plane from the start of the buffer
+    int      stride[MAX_PLANES] = {};       ///< bytes per line of each plane
+    unsigned lines[MAX_PLANES]  = {};       ///< number of lines in each plane
+    size_t   totalBytes = 0;                ///< bytes needed for the whole image
+};
+
+/// Compute the contiguous layout of an image
+/// @param format the pixel format
+/// @param width width in pixels
+/// @param height height in lines
+/// @returns the layout
+inline PlaneLayout getPlaneLayout(PixelFormat format, unsigned width, unsigned height)
+{
+    PlaneLayout layout;
+    const unsigned chromaWidth  = (width + 1) / 2;
+    const unsigned chromaHeight = (height + 1) / 2;
+    auto addPlane = [&layout](int stride, unsigned lines) {
+        layout.offset[layout.numPlanes] = layout.totalBytes;
+        layout.stride[layout.numPlanes] = stride;
+        layout.lines[layout.numPlanes]  = lines;
+        layout.totalBytes += static_cast<size_t>(stride) * lines;
+        layout.numPlanes++;
+    };
+
+    switch (format) {
+    case PixelFormat::RGB24 :
+    case PixelFormat::BGR24 :
+        addPlane(static_cast<int>(width * 3), height);
+        break;
+    case PixelFormat::RGBA :
+        addPlane(static_cast<int>(width * 4), height);
+        break;
+    case PixelFormat::YUV420P :
+        addPlane(static_cast<int>(width), height);
+        addPlane(static_cast<int>(chromaWidth), chromaHeight);
+        addPlane(static_cast<int>(chromaWidth), chromaHeight);
+        break;
+    case PixelFormat::NV12 :
+        addPlane(static_cast<int>(width), height);
+        addPlane(static_cast<int>(chromaWidth * 2), chromaHeight);
+        break;
+    case PixelFormat::GRAY8 :
+        addPlane(static_cast<int>(width), height);
+        break;
+    }
+    return layout;
+}
+
+/// Get the libav equivalent of a PixelFormat
+/// @param format the pixel format
+/// @returns the libav pixel format
+inline AVPixelFormat toAVPixelFormat(PixelFormat format)
+{
+    switch (format) {
+    case PixelFormat::RGB24   : return AV_PIX_FMT_RGB24;
+    case PixelFormat::BGR24   : return AV_PIX_FMT_BGR24;
+    case PixelFormat::YUV420P : return AV_PIX_FMT_YUV420P;
+    case PixelFormat::NV12    : return AV_PIX_FMT_NV12;
+    case PixelFormat::GRAY8   : return AV_PIX_FMT_GRAY8;
+    case PixelFormat::RGBA    : return AV_PIX_FMT_RGBA;
+    }
+    return AV_PIX_FMT_NONE;
+}
+
+} // wscDrone
+
+#endif /* PIXELFORMAT_H_ */
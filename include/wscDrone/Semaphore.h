@@ -26,6 +26,10 @@ namespace wscDrone {
 
 /// A semaphore based on C++11 mutex locks. This code was taken from some
 /// Stackoverflow posts
+/// @note The fixed wait semantics only apply to code compiled against this header. The prebuilt
+/// library inlined its copies of wait() and waitTimed(), so DroneController::waitForStateChange(),
+/// Pilot::waitMoveComplete() and the CameraControl photo wait still run the old code, which
+/// decrements the count even when a timed wait times out.
 class Semaphore
 {
 public:
@@ -42,41 +46,64 @@ public:
         cv.notify_one();
     }
 
-    /// Semaphore wait
+    /// Semaphore wait. Blocks until the count is positive, then decrements it.
     void wait()
     {
         std::unique_lock<std::mutex> lck(mtx);
 
-        if(count == 0)
+        cv.wait(lck, [this]() { return count > 0; });
+
+        --count;
+    }
+
+    /// Semaphore wait with a timeout. The count is only decremented when the wait succeeds.
+    /// @param timeMilliseconds the maximum time to wait
+    /// @returns TRUE if we've timed out
+    bool waitTimed(unsigned int timeMilliseconds)
+    {
+        return waitUntil(std::chrono::steady_clock::now() + std::chrono::milliseconds(timeMilliseconds));
+    }
+
+    /// Semaphore wait with a deadline. The count is only decremented when the wait succeeds.
+    /// @param deadline the time at which to give up
+    /// @returns TRUE if we've timed out
+    template <typename Clock, typename Duration>
+    bool waitUntil(const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        std::unique_lock<std::mutex> lck(mtx);
+
+        if (!cv.wait_until(lck, deadline, [this]() { return count > 0; }))
         {
-            cv.wait(lck);
+            return true;
         }
 
         --count;
+
+        return false;
     }
 
-    /// Semaphore wait
-    // Returns TRUE if we've timed out
-    bool waitTimed(unsigned int timeMilliseconds)
+    /// Decrement the count if it is positive, without blocking
+    /// @returns TRUE if the count was decremented
+    bool tryWait()
     {
-	    bool ret = false;
         std::unique_lock<std::mutex> lck(mtx);
 
-        if (count == 0)
+        if (count <= 0)
         {
-            auto returnValue = cv.wait_for(lck, std::chrono::milliseconds(timeMilliseconds));
-            if (returnValue == std::cv_status::timeout) {
-	            ret = true;
-            }
+            return false;
         }
 
         --count;
 
-        return ret;
+        return true;
     }
 
+    /// Get the current count
+    /// @returns the count
     int getCount()
     {
+        std::unique_lock<std::mutex> lck(mtx);
+
         return count;
     }
 
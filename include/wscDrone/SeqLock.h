@@ -0,0 +1,100 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains a sequence lock for publishing small structs from
+ * one writer to any number of lock-free readers.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef SEQLOCK_H_
+#define SEQLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace wscDrone {
+
+/// Holds one value of a trivially copyable type T. store() never blocks and load() never blocks the
+/// writer; a reader that overlaps a store simply retries, so it always returns a value that was stored
+/// as a whole and never a mix of two.
+/// @details There must be only one writer at a time. The value is kept in relaxed atomic words rather
+/// than plain memory so that concurrent reads are well defined.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+public:
+    /// Construct holding an initial value
+    /// @param initial the value load() returns until the first store()
+    explicit SeqLock(const T &initial = T())
+    {
+        uint64_t words[NUM_WORDS] = {};
+        std::memcpy(words, &initial, sizeof(T));
+        for (size_t i = 0; i < NUM_WORDS; i++) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    SeqLock(const SeqLock &) = delete;
+    SeqLock &operator=(const SeqLock &) = delete;
+
+    /// Publish a new value. Writer thread only.
+    /// @param value the value to publish
+    void store(const T &value)
+    {
+        uint64_t words[NUM_WORDS] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        const uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < NUM_WORDS; i++) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /// Read a consistent copy of the value. Safe from any thread.
+    /// @returns the most recently published value
+    T load() const
+    {
+        uint64_t words[NUM_WORDS];
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = m_sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < NUM_WORDS; i++) {
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    /// Get the number of store() calls so far
+    /// @returns the store count
+    uint32_t getVersion() const { return m_sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+    static constexpr size_t NUM_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> m_sequence{0};          ///< odd while a store is in progress
+    std::atomic<uint64_t> m_words[NUM_WORDS];     ///< the value, split into words
+};
+
+} // wscDrone
+
+#endif /* SEQLOCK_H_ */
@@ -0,0 +1,321 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the SetpointStreamer, which flies the drone with a
+ * continuous stream of piloting setpoints sent at a fixed rate.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef SETPOINTSTREAMER_H_
+#define SETPOINTSTREAMER_H_
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include "DroneTransport.h"
+#include "LatencyHistogram.h"
+#include "Utils.h"
+
+namespace wscDrone {
+
+/// SetpointStreamer configuration
+struct SetpointStreamOptions {
+    unsigned rateHz           = 50;  ///< setpoints sent per second
+    unsigned watchdogMs       = 250; ///< setpoint age after which the drone is told to hover, 0 disables the watchdog
+    int      realtimePriority = 0;   ///< SCHED_FIFO priority of the control thread, 0 keeps the default policy
+    int      cpu              = -1;  ///< CPU the control thread is pinned to, -1 for none
+};
+
+/// Counters and timing of a SetpointStreamer
+struct SetpointStreamStats {
+    uint64_t updates        = 0;     ///< calls to setSetpoint() and keepAlive()
+    uint64_t ticks          = 0;     ///< control periods run
+    uint64_t sent           = 0;     ///< setpoints the transport accepted
+    uint64_t sendErrors     = 0;     ///< setpoints the transport rejected
+    uint64_t missedTicks    = 0;     ///< whole periods skipped because the thread woke too late
+    uint64_t watchdogTrips  = 0;     ///< times the producer stalled and the drone was told to hover
+    bool     watchdogActive = false; ///< true while a hover is being sent in place of a stale setpoint
+    bool     realtime       = false; ///< true if the control thread runs with SCHED_FIFO
+    LatencyHistogramSnapshot jitter; ///< time each period started after its deadline
+    LatencyHistogramSnapshot send;   ///< time taken to hand each setpoint to the transport
+    LatencyHistogramSnapshot age;    ///< age of the setpoint sent at each period, the control loop delay
+};
+
+/// Flies the drone with continuous roll, pitch, yaw and gaz setpoints, e.g. from a visual servoing
+/// loop, instead of discrete moves that each wait for a move-complete event.
+/// @details A dedicated control thread wakes at absolute deadlines, one period apart, and sends the
+/// latest setpoint through DroneTransport::sendPilotingSetpoint(). Deadlines do not drift with the time
+/// taken by each period, and a thread that wakes more than a period late skips the missed periods
+/// rather than sending a burst. setSetpoint() packs the setpoint into one atomic word, so any number of
+/// threads may update it without a lock and the control thread never waits for a producer.
+/// If no update arrives within SetpointStreamOptions::watchdogMs, e.g. because the tracker stalled, a
+/// hover setpoint is sent instead until the next update. On a real drone each setpoint replaces the
+/// PCMD values stored in the ARSDK device controller, which sends them every 25 ms, so rateHz sets how
+/// often the stored values are refreshed; stop() zeroes them. The jitter, send and age histograms in
+/// getStats() measure the control loop for tuning. The drone must be flying for setpoints to move it;
+/// do not mix setpoints with Pilot moves.
+class SetpointStreamer {
+public:
+    SetpointStreamer() = delete;
+
+    /// Construct a streamer. The control thread is started by start().
+    /// @param transport the drone to fly
+    /// @param options rate, watchdog and thread configuration
+    explicit SetpointStreamer(std::shared_ptr<DroneTransport> transport,
+                              const SetpointStreamOptions &options = SetpointStreamOptions())
+        : m_transport(transport), m_options(options)
+    {
+        if (!m_transport) { throw std::invalid_argument("SetpointStreamer: null transport"); }
+        if (m_options.rateHz == 0 || m_options.rateHz > 1000) {
+            throw std::invalid_argument("SetpointStreamer: rate must be 1 to 1000 Hz");
+        }
+    }
+
+    /// Stops the control thread, setting a zero setpoint
+    ~SetpointStreamer() { stop(); }
+
+    SetpointStreamer(const SetpointStreamer &) = delete;
+    SetpointStreamer &operator=(const SetpointStreamer &) = delete;
+
+    /// Start the control thread. Until the first setSetpoint() it sends hover setpoints.
+    void start()
+    {
+        if (m_running.exchange(true)) { return; }
+        m_watchdogActive = true;
+        m_thread = std::thread(&SetpointStreamer::m_controlLoop, this);
+    }
+
+    /// Stop the control thread and set a zero setpoint, so the drone hovers rather than flying the
+    /// last setpoint on
+    void stop()
+    {
+        if (!m_running.exchange(false)) { return; }
+        if (m_thread.joinable()) { m_thread.join(); }
+        PilotingSetpoint hover;
+        hover.timestampAndSeqNum = m_timestampAndSeqNum(monotonicNanoseconds());
+        const bool sent = m_transport->sendPilotingSetpoint(hover);
+        (sent ? m_sent : m_sendErrors).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Check if the control thread is running
+    /// @returns true between start() and stop()
+    bool isRunning() const { return m_running.load(); }
+
+    /// Set the setpoint sent from the next period on. Safe to call from any thread without blocking.
+    /// @param roll percentage of the maximum tilt, positive rolls right
+    /// @param pitch percentage of the maximum tilt, positive pitches down and flies forward
+    /// @param yaw percentage of the maximum rotation speed, positive turns clockwise
+    /// @param gaz percentage of the maximum vertical speed, positive climbs
+    /// Values are clamped to -100 to 100. Roll and pitch are applied only when either is non-zero.
+    void setSetpoint(float roll, float pitch, float yaw, float gaz)
+    {
+        PilotingSetpoint setpoint;
+        setpoint.roll  = m_percent(roll);
+        setpoint.pitch = m_percent(pitch);
+        setpoint.yaw   = m_percent(yaw);
+        setpoint.gaz   = m_percent(gaz);
+        setpoint.useRollPitch = setpoint.roll != 0 || setpoint.pitch != 0;
+        m_setpoint.store(m_pack(setpoint), std::memory_order_relaxed);
+        keepAlive();
+    }
+
+    /// Hold position. Equivalent to setSetpoint(0, 0, 0, 0).
+    void hover() { setSetpoint(0.0f, 0.0f, 0.0f, 0.0f); }
+
+    /// Confirm the current setpoint is still wanted, resetting the watchdog without changing it
+    void keepAlive()
+    {
+        m_updateNs.store(monotonicNanoseconds(), std::memory_order_release);
+        m_updates.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Get the setpoint last set
+    /// @returns the setpoint, without its timestamp
+    PilotingSetpoint getSetpoint() const { return m_unpack(m_setpoint.load(std::memory_order_relaxed)); }
+
+    /// Check if the watchdog is holding the drone in place because the setpoint went stale
+    /// @returns true while hovers are sent in place of the setpoint
+    bool isWatchdogActive() const { return m_watchdogActive.load(std::memory_order_relaxed); }
+
+    /// Get the counters and control loop histograms. Safe to call from any thread.
+    /// @returns the statistics
+    SetpointStreamStats getStats() const
+    {
+        SetpointStreamStats stats;
+        stats.updates        = m_updates.load(std::memory_order_relaxed);
+        stats.ticks          = m_ticks.load(std::memory_order_relaxed);
+        stats.sent           = m_sent.load(std::memory_order_relaxed);
+        stats.sendErrors     = m_sendErrors.load(std::memory_order_relaxed);
+        stats.missedTicks    = m_missedTicks.load(std::memory_order_relaxed);
+        stats.watchdogTrips  = m_watchdogTrips.load(std::memory_order_relaxed);
+        stats.watchdogActive = m_watchdogActive.load(std::memory_order_relaxed);
+        stats.realtime       = m_realtime.load(std::memory_order_relaxed);
+        stats.jitter         = m_jitter.snapshot();
+        stats.send           = m_send.snapshot();
+        stats.age            = m_age.snapshot();
+        return stats;
+    }
+
+    /// Reset the counters and histograms
+    void resetStats()
+    {
+        m_updates       = 0;
+        m_ticks         = 0;
+        m_sent          = 0;
+        m_sendErrors    = 0;
+        m_missedTicks   = 0;
+        m_watchdogTrips = 0;
+        m_jitter.reset();
+        m_send.reset();
+        m_age.reset();
+    }
+
+    /// Get the configuration
+    /// @returns the options given at construction
+    const SetpointStreamOptions &getOptions() const { return m_options; }
+
+private:
+    std::shared_ptr<DroneTransport> m_transport;     ///< the drone
+    const SetpointStreamOptions     m_options;       ///< configuration
+    std::thread                     m_thread;        ///< the control thread
+    std::atomic<bool>               m_running{false}; ///< true while the control thread should run
+
+    std::atomic<uint64_t> m_setpoint{0};             ///< latest setpoint, packed by m_pack()
+    std::atomic<uint64_t> m_updateNs{0};             ///< time of the latest update, 0 before the first
+    std::atomic<bool>     m_watchdogActive{false};   ///< hovers are replacing a stale setpoint
+    std::atomic<bool>     m_realtime{false};         ///< the control thread got SCHED_FIFO
+    uint8_t               m_sequence = 0;            ///< PCMD sequence number, control thread only
+
+    std::atomic<uint64_t> m_updates{0};
+    std::atomic<uint64_t> m_ticks{0};
+    std::atomic<uint64_t> m_sent{0};
+    std::atomic<uint64_t> m_sendErrors{0};
+    std::atomic<uint64_t> m_missedTicks{0};
+    std::atomic<uint64_t> m_watchdogTrips{0};
+    LatencyHistogram      m_jitter;                  ///< wake time past each deadline
+    LatencyHistogram      m_send;                    ///< duration of each send
+    LatencyHistogram      m_age;                     ///< age of each setpoint sent
+
+    /// Clamp and round a percentage, treating NaN as 0
+    static int8_t m_percent(float value)
+    {
+        if (!(value > -100.0f)) { return value < 0.0f ? -100 : 0; }
+        if (value > 100.0f) { return 100; }
+        return static_cast<int8_t>(std::lround(value));
+    }
+
+    /// Pack a setpoint into one word, so it is stored and loaded atomically
+    static uint64_t m_pack(const PilotingSetpoint &setpoint)
+    {
+        return uint64_t(uint8_t(setpoint.roll)) | uint64_t(uint8_t(setpoint.pitch)) << 8 |
+               uint64_t(uint8_t(setpoint.yaw)) << 16 | uint64_t(uint8_t(setpoint.gaz)) << 24 |
+               uint64_t(setpoint.useRollPitch ? 1 : 0) << 32;
+    }
+
+    static PilotingSetpoint m_unpack(uint64_t packed)
+    {
+        PilotingSetpoint setpoint;
+        setpoint.roll  = static_cast<int8_t>(packed & 0xff);
+        setpoint.pitch = static_cast<int8_t>((packed >> 8) & 0xff);
+        setpoint.yaw   = static_cast<int8_t>((packed >> 16) & 0xff);
+        setpoint.gaz   = static_cast<int8_t>((packed >> 24) & 0xff);
+        setpoint.useRollPitch = ((packed >> 32) & 1) != 0;
+        return setpoint;
+    }
+
+    /// Build the PCMD timestamp, milliseconds in the low 24 bits and a sequence number in the high 8
+    uint32_t m_timestampAndSeqNum(uint64_t nowNs)
+    {
+        const uint32_t milliseconds = static_cast<uint32_t>(nowNs / 1000000) & 0xffffff;
+        return uint32_t(m_sequence++) << 24 | milliseconds;
+    }
+
+    /// Apply the real-time priority and CPU affinity to the control thread
+    void m_configureThread()
+    {
+#ifdef __linux__
+        if (m_options.cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(m_options.cpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+        if (m_options.realtimePriority > 0) {
+            // needs CAP_SYS_NICE or an rtprio limit, otherwise the thread keeps the default policy
+            sched_param param;
+            param.sched_priority = m_options.realtimePriority;
+            m_realtime = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+        }
+#endif
+    }
+
+    /// Sleep until an absolute monotonic deadline
+    static void m_sleepUntil(uint64_t deadlineNs)
+    {
+        timespec deadline;
+        deadline.tv_sec  = static_cast<time_t>(deadlineNs / 1000000000ULL);
+        deadline.tv_nsec = static_cast<long>(deadlineNs % 1000000000ULL);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {}
+    }
+
+    /// Body of the control thread
+    void m_controlLoop()
+    {
+        m_configureThread();
+        const uint64_t periodNs   = 1000000000ULL / m_options.rateHz;
+        const uint64_t watchdogNs = static_cast<uint64_t>(m_options.watchdogMs) * 1000000ULL;
+        uint64_t deadlineNs = monotonicNanoseconds();
+
+        while (m_running.load(std::memory_order_relaxed)) {
+            m_sleepUntil(deadlineNs);
+            const uint64_t wakeNs = monotonicNanoseconds();
+            m_jitter.record(wakeNs > deadlineNs ? wakeNs - deadlineNs : 0);
+            if (wakeNs >= deadlineNs + periodNs) {
+                const uint64_t missed = (wakeNs - deadlineNs) / periodNs;
+                m_missedTicks.fetch_add(missed, std::memory_order_relaxed);
+                deadlineNs += missed * periodNs;
+            }
+            deadlineNs += periodNs;
+            m_ticks.fetch_add(1, std::memory_order_relaxed);
+
+            // reading the time first pairs with keepAlive(), so the setpoint is at least as new as the time
+            const uint64_t updateNs = m_updateNs.load(std::memory_order_acquire);
+            PilotingSetpoint setpoint = m_unpack(m_setpoint.load(std::memory_order_relaxed));
+            const uint64_t ageNs = updateNs != 0 && wakeNs > updateNs ? wakeNs - updateNs : 0;
+            if (updateNs == 0 || (watchdogNs != 0 && ageNs > watchdogNs)) {
+                if (!m_watchdogActive.exchange(true, std::memory_order_relaxed)) {
+                    m_watchdogTrips.fetch_add(1, std::memory_order_relaxed);
+                }
+                setpoint = PilotingSetpoint();
+            } else {
+                m_watchdogActive.store(false, std::memory_order_relaxed);
+                m_age.record(ageNs);
+            }
+
+            setpoint.timestampAndSeqNum = m_timestampAndSeqNum(wakeNs);
+            const bool sent = m_transport->sendPilotingSetpoint(setpoint);
+            m_send.record(monotonicNanoseconds() - wakeNs);
+            (sent ? m_sent : m_sendErrors).fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+} // wscDrone
+
+#endif /* SETPOINTSTREAMER_H_ */
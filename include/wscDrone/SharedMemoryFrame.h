@@ -0,0 +1,426 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the SharedMemoryFrame and SharedFrameSubscriber,
+ * a POSIX shared memory frame bus for consumers in other processes.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef SHAREDMEMORYFRAME_H_
+#define SHAREDMEMORYFRAME_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include "PixelFormat.h"
+#include "TripleBufferFrame.h"
+#include "Utils.h"
+#include "VideoFrame.h"
+
+namespace wscDrone {
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "the shared frame bus requires lock-free atomics, which are also address-free");
+
+namespace detail {
+
+/// Identifies a mapping as a shared frame bus, "WSCF"
+constexpr uint32_t SHARED_FRAME_MAGIC   = 0x46435357;
+/// Layout version, bumped on any change to the structures below
+constexpr uint32_t SHARED_FRAME_VERSION = 1;
+/// Alignment of the slot headers and pixel data
+constexpr size_t   SHARED_FRAME_ALIGNMENT = 4096;
+
+/// The start of the shared memory, written once by the publisher before magic is set
+struct SharedFrameHeader {
+    std::atomic<uint32_t> magic;     ///< SHARED_FRAME_MAGIC once the rest is initialised
+    uint32_t version;                ///< SHARED_FRAME_VERSION
+    uint32_t slotCount;              ///< number of frames in the ring
+    uint32_t width;                  ///< width in pixels
+    uint32_t height;                 ///< height in lines
+    uint32_t format;                 ///< PixelFormat of every slot
+    uint64_t frameBytes;             ///< bytes of pixel data per slot
+    uint64_t slotStride;             ///< bytes from one slot's pixel data to the next
+    uint64_t dataOffset;             ///< offset of the first slot's pixel data from the start of the mapping
+    uint64_t mappingBytes;           ///< size of the whole mapping
+    alignas(64) std::atomic<uint64_t> published; ///< index of the latest published frame, counting from 1
+};
+
+/// Per-slot state, in an array after the header. state is 2i - 1 while frame i is being written into the
+/// slot and 2i once it is published, so a reader can tell whether the pixels it used were overwritten.
+struct alignas(64) SharedFrameSlot {
+    std::atomic<uint64_t> state;        ///< seqlock word, see above
+    std::atomic<uint64_t> sequence;     ///< frame sequence number assigned by the publisher
+    std::atomic<uint64_t> timestampNs;  ///< monotonic timestamp assigned by the publisher
+    std::atomic<uint64_t> publishNs;    ///< monotonic time the frame was published
+};
+
+/// Get the offset of the first slot's pixel data
+inline size_t sharedFrameDataOffset(unsigned slotCount)
+{
+    const size_t headers = sizeof(SharedFrameHeader) + slotCount * sizeof(SharedFrameSlot);
+    return (headers + SHARED_FRAME_ALIGNMENT - 1) & ~(SHARED_FRAME_ALIGNMENT - 1);
+}
+
+/// Make a POSIX shared memory name from a bus name
+inline std::string sharedFrameName(const std::string &name) { return name.empty() || name[0] != '/' ? "/" + name : name; }
+
+} // detail
+
+/// A frame as seen by a SharedFrameSubscriber. The pixels are read in place from shared memory; check
+/// SharedFrameSubscriber::isCurrent() after using them to know they were not overwritten meanwhile.
+struct SharedFrameView : FrameView {
+    uint64_t index     = 0; ///< position of the frame in the publish order, counting from 1
+    uint64_t publishNs = 0; ///< monotonic time the frame was published
+};
+
+/// A VideoFrame whose frames are published into a ring of slots in POSIX shared memory, so that any
+/// number of processes can map the same decoded frames with a SharedFrameSubscriber, with no sockets
+/// and no copies.
+/// @details The decoder converts straight into the next slot and publish() makes it the latest. The
+/// publisher never waits for a subscriber: each slot carries a sequence word, odd while the slot is
+/// being written, that subscribers check before and after reading it, so a slow subscriber sees its
+/// frame was overwritten instead of holding up the decoder. A published frame stays intact for the
+/// next slotCount - 2 publishes. There must be a single writer thread. DecodePipeline publishes into it
+/// like a TripleBufferFrame, and getRawPointer() returns the slot being written so it also works as a
+/// plain VideoFrame for the VideoDriver, which then never publishes it.
+class SharedMemoryFrame : public VideoFrame {
+public:
+    SharedMemoryFrame() = delete;
+
+    /// Create the shared memory and map it. An existing bus of the same name is replaced.
+    /// @param name the bus name, e.g. "wscdrone-192.168.42.1", shared with the subscribers
+    /// @param height height in lines
+    /// @param width width in pixels
+    /// @param format pixel format of every frame, planes are laid out as getPlaneLayout() describes
+    /// @param slotCount frames in the ring, at least 3. More slots give slow subscribers longer to read.
+    /// @param mode permission bits of the shared memory object
+    SharedMemoryFrame(const std::string &name, unsigned height, unsigned width,
+                      PixelFormat format = PixelFormat::RGB24, unsigned slotCount = 8, mode_t mode = 0600)
+        : VideoFrame(height, width), m_name(detail::sharedFrameName(name)), m_height(height), m_width(width),
+          m_format(format), m_layout(wscDrone::getPlaneLayout(format, width, height)), m_slotCount(slotCount)
+    {
+        if (slotCount < 3) { throw std::invalid_argument("SharedMemoryFrame: at least three slots are required"); }
+        m_slotStride = (m_layout.totalBytes + detail::SHARED_FRAME_ALIGNMENT - 1) & ~(detail::SHARED_FRAME_ALIGNMENT - 1);
+        m_mappingBytes = detail::sharedFrameDataOffset(slotCount) + m_slotStride * slotCount;
+
+        // A bus left behind by a publisher that crashed is unlinked rather than resized, since its
+        // subscribers still map it. They keep the old object and must reopen the name.
+        shm_unlink(m_name.c_str());
+        const int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, mode);
+        if (fd < 0) { throw std::runtime_error("SharedMemoryFrame: unable to create " + m_name + ": " + std::strerror(errno)); }
+        if (ftruncate(fd, static_cast<off_t>(m_mappingBytes)) != 0) {
+            const int error = errno;
+            close(fd);
+            shm_unlink(m_name.c_str());
+            throw std::runtime_error("SharedMemoryFrame: unable to size " + m_name + ": " + std::strerror(error));
+        }
+        m_mapping = mmap(nullptr, m_mappingBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (m_mapping == MAP_FAILED) {
+            shm_unlink(m_name.c_str());
+            throw std::runtime_error("SharedMemoryFrame: unable to map " + m_name);
+        }
+
+        m_header = new (m_mapping) detail::SharedFrameHeader;
+        m_header->version      = detail::SHARED_FRAME_VERSION;
+        m_header->slotCount    = slotCount;
+        m_header->width        = width;
+        m_header->height       = height;
+        m_header->format       = static_cast<uint32_t>(format);
+        m_header->frameBytes   = m_layout.totalBytes;
+        m_header->slotStride   = m_slotStride;
+        m_header->dataOffset   = detail::sharedFrameDataOffset(slotCount);
+        m_header->mappingBytes = m_mappingBytes;
+        m_header->published.store(0, std::memory_order_relaxed);
+        m_slots = reinterpret_cast<detail::SharedFrameSlot *>(static_cast<uint8_t *>(m_mapping) + sizeof(detail::SharedFrameHeader));
+        for (unsigned i = 0; i < slotCount; i++) {
+            detail::SharedFrameSlot *slot = new (&m_slots[i]) detail::SharedFrameSlot;
+            slot->state.store(0, std::memory_order_relaxed);
+        }
+        m_data = static_cast<uint8_t *>(m_mapping) + m_header->dataOffset;
+        m_beginWrite();
+        m_header->magic.store(detail::SHARED_FRAME_MAGIC, std::memory_order_release);
+    }
+
+    /// Unmaps the shared memory and removes its name. Subscribers keep their mapping until they close it.
+    ~SharedMemoryFrame() override
+    {
+        m_header->magic.store(0, std::memory_order_release);
+        munmap(m_mapping, m_mappingBytes);
+        shm_unlink(m_name.c_str());
+    }
+
+    SharedMemoryFrame(const SharedMemoryFrame &) = delete;
+    SharedMemoryFrame &operator=(const SharedMemoryFrame &) = delete;
+
+    /// Get the height of the VideoFrame object
+    /// @returns the height in lines
+    unsigned getHeight() override { return m_height; }
+
+    /// Get the width of the VideoFrame object
+    /// @returns the width in pixels
+    unsigned getWidth() override { return m_width; }
+
+    /// Get raw pointer to the slot being written
+    /// @returns a char* pointer to the raw pixel bytes
+    char *getRawPointer() override { return reinterpret_cast<char *>(getWriteBuffer()); }
+
+    /// Get the size in bytes of one frame
+    /// @returns the size in bytes
+    size_t getFrameSizeBytes() override { return m_layout.totalBytes; }
+
+    /// Get the pixel format of the frames
+    /// @returns the pixel format
+    PixelFormat getFormat() const { return m_format; }
+
+    /// Get the layout of the planes within each frame
+    /// @returns the plane layout
+    const PlaneLayout &getPlaneLayout() const { return m_layout; }
+
+    /// Get the bus name subscribers open
+    /// @returns the POSIX shared memory name
+    const std::string &getName() const { return m_name; }
+
+    /// Get the slot being written. Writer thread only.
+    /// @returns pointer to getFrameSizeBytes() writable bytes
+    uint8_t *getWriteBuffer() { return m_data + m_writeSlot * m_slotStride; }
+
+    /// Publish the slot being written as the latest frame and start writing the oldest slot. Writer thread only.
+    /// @param sequence frame sequence number to attach to the frame
+    /// @param timestampNs monotonic timestamp to attach to the frame
+    void publish(uint64_t sequence, uint64_t timestampNs)
+    {
+        detail::SharedFrameSlot &slot = m_slots[m_writeSlot];
+        slot.sequence.store(sequence, std::memory_order_relaxed);
+        slot.timestampNs.store(timestampNs, std::memory_order_relaxed);
+        slot.publishNs.store(monotonicNanoseconds(), std::memory_order_relaxed);
+        slot.state.store(2 * m_writeIndex, std::memory_order_release);
+        m_header->published.store(m_writeIndex, std::memory_order_release);
+        m_beginWrite();
+    }
+
+    /// Get the number of frames published so far. Writer thread only.
+    /// @returns the publish count
+    uint64_t getPublishedCount() const { return m_writeIndex - 1; }
+
+private:
+    const std::string m_name;            ///< POSIX shared memory name
+    unsigned    m_height;                ///< height in lines
+    unsigned    m_width;                 ///< width in pixels
+    PixelFormat m_format;                ///< pixel format of every slot
+    PlaneLayout m_layout;                ///< plane layout within each slot
+    unsigned    m_slotCount;             ///< frames in the ring
+    size_t      m_slotStride   = 0;      ///< bytes between slots
+    size_t      m_mappingBytes = 0;      ///< size of the mapping
+    void       *m_mapping      = MAP_FAILED; ///< the mapping
+    detail::SharedFrameHeader *m_header = nullptr; ///< header at the start of the mapping
+    detail::SharedFrameSlot   *m_slots  = nullptr; ///< slot states after the header
+    uint8_t    *m_data         = nullptr; ///< pixel data of the first slot
+    uint64_t    m_writeIndex   = 0;      ///< index of the frame being written, counting from 1
+    unsigned    m_writeSlot    = 0;      ///< slot of the frame being written
+
+    /// Claim the slot of the next frame. Its state turns odd before any pixel is written.
+    void m_beginWrite()
+    {
+        m_writeIndex++;
+        m_writeSlot = static_cast<unsigned>((m_writeIndex - 1) % m_slotCount);
+        m_slots[m_writeSlot].state.store(2 * m_writeIndex - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+};
+
+/// Maps a SharedMemoryFrame published by another process, read only.
+/// @details acquireLatest() returns the newest frame for consumers such as a UI that only want to be
+/// current; acquireNext() returns every frame in order for consumers such as a recorder, skipping
+/// ahead when they fall more than a ring behind. Neither waits for the publisher or copies pixels. The
+/// pixels of a view are read in place and may be overwritten once the publisher wraps around, so
+/// check isCurrent() after using them, or use copyLatest(). One subscriber is for one thread.
+class SharedFrameSubscriber {
+public:
+    SharedFrameSubscriber() = delete;
+
+    /// Open and map a bus
+    /// @param name the bus name the publisher was constructed with
+    explicit SharedFrameSubscriber(const std::string &name) : m_name(detail::sharedFrameName(name))
+    {
+        const int fd = shm_open(m_name.c_str(), O_RDONLY, 0);
+        if (fd < 0) { throw std::runtime_error("SharedFrameSubscriber: unable to open " + m_name + ": " + std::strerror(errno)); }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(detail::SharedFrameHeader)) {
+            close(fd);
+            throw std::runtime_error("SharedFrameSubscriber: " + m_name + " is not ready");
+        }
+        m_mappingBytes = static_cast<size_t>(info.st_size);
+        m_mapping = mmap(nullptr, m_mappingBytes, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (m_mapping == MAP_FAILED) { throw std::runtime_error("SharedFrameSubscriber: unable to map " + m_name); }
+
+        m_header = static_cast<const detail::SharedFrameHeader *>(m_mapping);
+        if (m_header->magic.load(std::memory_order_acquire) != detail::SHARED_FRAME_MAGIC ||
+            m_header->version != detail::SHARED_FRAME_VERSION || m_header->mappingBytes != m_mappingBytes) {
+            munmap(m_mapping, m_mappingBytes);
+            throw std::runtime_error("SharedFrameSubscriber: " + m_name + " is not ready or not a compatible frame bus");
+        }
+        m_slots  = reinterpret_cast<const detail::SharedFrameSlot *>(static_cast<const uint8_t *>(m_mapping) +
+                                                                     sizeof(detail::SharedFrameHeader));
+        m_data   = static_cast<const uint8_t *>(m_mapping) + m_header->dataOffset;
+        m_format = static_cast<PixelFormat>(m_header->format);
+        m_layout = getPlaneLayout(m_format, m_header->width, m_header->height);
+        m_nextIndex = m_header->published.load(std::memory_order_acquire) + 1;
+    }
+
+    /// Unmaps the shared memory
+    ~SharedFrameSubscriber() { munmap(m_mapping, m_mappingBytes); }
+
+    SharedFrameSubscriber(const SharedFrameSubscriber &) = delete;
+    SharedFrameSubscriber &operator=(const SharedFrameSubscriber &) = delete;
+
+    /// Get the newest published frame
+    /// @returns a view of the frame, invalid before the first publish
+    SharedFrameView acquireLatest()
+    {
+        SharedFrameView view;
+        for (;;) {
+            const uint64_t index = m_header->published.load(std::memory_order_acquire);
+            if (index == 0) { return view; }
+            if (m_read(index, view)) {
+                m_nextIndex = index + 1;
+                return view;
+            }
+        }
+    }
+
+    /// Get the frame after the one last returned. When the publisher has lapped the subscriber the
+    /// frames it can no longer read are counted in getDroppedCount() and the oldest readable one is returned.
+    /// @returns a view of the frame, invalid when no newer frame has been published
+    SharedFrameView acquireNext()
+    {
+        SharedFrameView view;
+        for (;;) {
+            const uint64_t latest = m_header->published.load(std::memory_order_acquire);
+            if (latest < m_nextIndex) { return view; }
+            // the slot after the latest one is already being rewritten
+            const uint64_t oldest = latest > m_header->slotCount - 2 ? latest - (m_header->slotCount - 2) : 1;
+            if (m_nextIndex < oldest) {
+                m_dropped  += oldest - m_nextIndex;
+                m_nextIndex = oldest;
+            }
+            if (m_read(m_nextIndex, view)) {
+                m_nextIndex++;
+                return view;
+            }
+            m_dropped++;
+            m_nextIndex++;
+        }
+    }
+
+    /// Check that the pixels of a view have not been overwritten since it was acquired
+    /// @param view a view returned by this subscriber
+    /// @returns true when everything read from the view so far is the published frame
+    bool isCurrent(const SharedFrameView &view) const
+    {
+        if (!view.valid()) { return false; }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_slots[m_slotOf(view.index)].state.load(std::memory_order_relaxed) == 2 * view.index;
+    }
+
+    /// Copy the newest frame out of shared memory, retrying if it is overwritten during the copy
+    /// @param dst destination of at least getFrameSizeBytes() bytes
+    /// @param view receives the description of the copied frame, with its pixel pointers into dst
+    /// @returns false before the first publish
+    bool copyLatest(uint8_t *dst, SharedFrameView &view)
+    {
+        for (;;) {
+            view = acquireLatest();
+            if (!view.valid()) { return false; }
+            std::memcpy(dst, view.data, view.sizeBytes);
+            if (!isCurrent(view)) { continue; }
+            view.data = dst;
+            for (unsigned plane = 0; plane < view.numPlanes; plane++) { view.planes[plane] = dst + m_layout.offset[plane]; }
+            return true;
+        }
+    }
+
+    /// Check if the publisher still exists. A bus whose publisher exited never publishes again.
+    /// @returns false once the publisher has been destroyed
+    bool isPublisherAlive() const { return m_header->magic.load(std::memory_order_acquire) == detail::SHARED_FRAME_MAGIC; }
+
+    /// Get the number of frames acquireNext() skipped because the publisher overwrote them first
+    /// @returns the count since construction
+    uint64_t getDroppedCount() const { return m_dropped; }
+
+    unsigned    getWidth() const          { return m_header->width; }      ///< @returns width in pixels
+    unsigned    getHeight() const         { return m_header->height; }     ///< @returns height in lines
+    PixelFormat getFormat() const         { return m_format; }             ///< @returns the pixel format
+    size_t      getFrameSizeBytes() const { return m_header->frameBytes; } ///< @returns bytes per frame
+    unsigned    getSlotCount() const      { return m_header->slotCount; }  ///< @returns frames in the ring
+
+private:
+    const std::string m_name;                       ///< POSIX shared memory name
+    void       *m_mapping      = MAP_FAILED;        ///< the read-only mapping
+    size_t      m_mappingBytes = 0;                 ///< size of the mapping
+    const detail::SharedFrameHeader *m_header = nullptr; ///< header at the start of the mapping
+    const detail::SharedFrameSlot   *m_slots  = nullptr; ///< slot states after the header
+    const uint8_t *m_data      = nullptr;           ///< pixel data of the first slot
+    PixelFormat m_format       = PixelFormat::RGB24; ///< pixel format of every slot
+    PlaneLayout m_layout;                           ///< plane layout within each slot
+    uint64_t    m_nextIndex    = 1;                 ///< index acquireNext() returns next
+    uint64_t    m_dropped      = 0;                 ///< frames acquireNext() skipped
+
+    /// Get the slot a frame is written to
+    /// @param index the frame index
+    /// @returns the slot number
+    unsigned m_slotOf(uint64_t index) const { return static_cast<unsigned>((index - 1) % m_header->slotCount); }
+
+    /// Describe a published frame
+    /// @param index the frame index
+    /// @param view receives the description
+    /// @returns false when the slot no longer, or not yet, holds the frame
+    bool m_read(uint64_t index, SharedFrameView &view) const
+    {
+        const unsigned slotIndex = m_slotOf(index);
+        const detail::SharedFrameSlot &slot = m_slots[slotIndex];
+        if (slot.state.load(std::memory_order_acquire) != 2 * index) { return false; }
+        view.index       = index;
+        view.sequence    = slot.sequence.load(std::memory_order_relaxed);
+        view.timestampNs = slot.timestampNs.load(std::memory_order_relaxed);
+        view.publishNs   = slot.publishNs.load(std::memory_order_relaxed);
+        view.data        = m_data + slotIndex * m_header->slotStride;
+        view.sizeBytes   = m_header->frameBytes;
+        view.width       = m_header->width;
+        view.height      = m_header->height;
+        view.format      = m_format;
+        view.numPlanes   = m_layout.numPlanes;
+        for (unsigned plane = 0; plane < m_layout.numPlanes; plane++) {
+            view.planes[plane]  = view.data + m_layout.offset[plane];
+            view.strides[plane] = m_layout.stride[plane];
+        }
+        if (!isCurrent(view)) {
+            view = SharedFrameView();
+            return false;
+        }
+        return true;
+    }
+};
+
+} // wscDrone
+
+#endif /* SHAREDMEMORYFRAME_H_ */
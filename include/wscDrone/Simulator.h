@@ -0,0 +1,693 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains a simulated drone that replays an H.264 elementary
+ * stream and emits ARSDK commands, for testing without hardware.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef SIMULATOR_H_
+#define SIMULATOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libARController/ARController.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "LocalTransport.h"
+#include "Utils.h"
+#include "VideoFrame.h"
+
+namespace wscDrone {
+
+/// An H.264 Annex-B elementary stream split into access units, shared read-only by any number of
+/// SimulatedDrones
+class H264ElementaryStream {
+public:
+    /// One access unit within the stream data
+    struct AccessUnit {
+        size_t offset   = 0;     ///< byte offset of the first start code
+        size_t size     = 0;     ///< size in bytes, including start codes
+        bool   isIFrame = false; ///< true if the access unit contains an IDR slice
+    };
+
+    /// Load an elementary stream from a file, e.g. one produced with ffmpeg -c:v copy -f h264
+    /// @param filename path to the .h264 file
+    /// @returns smart pointer to the stream
+    static std::shared_ptr<const H264ElementaryStream> load(const std::string &filename)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("H264ElementaryStream: unable to open " + filename);
+        }
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return std::make_shared<const H264ElementaryStream>(std::move(data));
+    }
+
+    /// Split an elementary stream held in memory
+    /// @param data the Annex-B byte stream
+    explicit H264ElementaryStream(std::vector<uint8_t> data) : m_data(std::move(data))
+    {
+        m_split();
+        if (m_sps.empty() || m_pps.empty() || m_firstIFrame >= m_accessUnits.size()) {
+            throw std::runtime_error("H264ElementaryStream: stream has no SPS, PPS or IDR frame");
+        }
+    }
+
+    /// Get the stream bytes
+    /// @returns pointer to the start of the stream
+    const uint8_t *getData() const { return m_data.data(); }
+
+    /// Get the access units in stream order
+    /// @returns the access units
+    const std::vector<AccessUnit> &getAccessUnits() const { return m_accessUnits; }
+
+    /// Get the index of the first IDR access unit, where playback starts and loops back to
+    /// @returns the access unit index
+    size_t getFirstIFrame() const { return m_firstIFrame; }
+
+    /// Get the first sequence parameter set
+    /// @returns the SPS NAL unit including its start code
+    const std::vector<uint8_t> &getSps() const { return m_sps; }
+
+    /// Get the first picture parameter set
+    /// @returns the PPS NAL unit including its start code
+    const std::vector<uint8_t> &getPps() const { return m_pps; }
+
+private:
+    std::vector<uint8_t>    m_data;            ///< the byte stream
+    std::vector<AccessUnit> m_accessUnits;     ///< access units in stream order
+    size_t                  m_firstIFrame = 0; ///< index of the first IDR access unit
+    std::vector<uint8_t>    m_sps;             ///< first SPS with start code
+    std::vector<uint8_t>    m_pps;             ///< first PPS with start code
+
+    /// Find the next 3 byte start code at or after pos
+    /// @returns the offset of the start code, or the stream size if there is none
+    size_t m_findStartCode(size_t pos) const
+    {
+        const size_t size = m_data.size();
+        while (pos + 3 <= size) {
+            if (m_data[pos + 2] > 1) {
+                pos += 3;
+            } else if (m_data[pos] == 0 && m_data[pos + 1] == 0 && m_data[pos + 2] == 1) {
+                return pos;
+            } else {
+                pos++;
+            }
+        }
+        return size;
+    }
+
+    /// Group the NAL units into access units. A new access unit starts at an access unit delimiter,
+    /// SEI, SPS or PPS following a slice, or at a slice whose first_mb_in_slice is zero following a slice.
+    void m_split()
+    {
+        m_firstIFrame = SIZE_MAX;
+        bool haveUnit = false;
+        bool unitHasSlice = false;
+        AccessUnit unit;
+
+        size_t startCode = m_findStartCode(0);
+        while (startCode < m_data.size()) {
+            const size_t header = startCode + 3;
+            const size_t next   = m_findStartCode(header);
+            // a zero before the start code belongs to this NAL unit's 4 byte start code
+            const size_t nalStart = (startCode > 0 && m_data[startCode - 1] == 0) ? startCode - 1 : startCode;
+            size_t nalEnd = next;
+            while (nalEnd > header && next < m_data.size() && m_data[nalEnd - 1] == 0) { nalEnd--; }
+            if (header >= m_data.size()) { break; }
+
+            const unsigned type = m_data[header] & 0x1f;
+            const bool isSlice  = type == 1 || type == 5;
+            const bool isPrefix = type == 6 || type == 7 || type == 8 || type == 9 || (type >= 14 && type <= 18);
+            const bool firstMb  = isSlice && header + 1 < m_data.size() && (m_data[header + 1] & 0x80);
+
+            if (haveUnit && unitHasSlice && (isPrefix || firstMb)) {
+                m_accessUnits.push_back(unit);
+                haveUnit = false;
+            }
+            if (!haveUnit) {
+                unit = AccessUnit();
+                unit.offset  = nalStart;
+                haveUnit     = true;
+                unitHasSlice = false;
+            }
+            unit.size = nalEnd - unit.offset;
+            unitHasSlice = unitHasSlice || isSlice;
+            if (type == 5) {
+                unit.isIFrame = true;
+                if (m_firstIFrame == SIZE_MAX) { m_firstIFrame = m_accessUnits.size(); }
+            }
+            if (type == 7 && m_sps.empty()) { m_sps.assign(m_data.begin() + nalStart, m_data.begin() + nalEnd); }
+            if (type == 8 && m_pps.empty()) { m_pps.assign(m_data.begin() + nalStart, m_data.begin() + nalEnd); }
+            startCode = next;
+        }
+        if (haveUnit && unitHasSlice) { m_accessUnits.push_back(unit); }
+    }
+};
+
+/// Configuration of a SimulatedDrone
+struct SimulatorOptions {
+    std::shared_ptr<const H264ElementaryStream> video = nullptr; ///< stream to replay, nullptr for no video
+    std::shared_ptr<VideoFrame> frame = nullptr; ///< returned by getFrame(), may be nullptr
+    unsigned frameRate        = 30;    ///< video frames per second
+    bool     loopVideo        = true;  ///< restart at the first IDR frame at the end of the stream
+    unsigned telemetryHz      = 5;     ///< attitude, speed, altitude and position updates per second
+    unsigned batteryPeriodMs  = 1000;  ///< interval between battery updates
+    float    batteryDrainPerMinute = 1.0f; ///< battery percent lost per minute after connecting
+    float    moveSpeed        = 1.0f;  ///< horizontal and vertical move speed in m/s
+    float    rotationSpeed    = 90.0f; ///< heading change speed in degrees/s
+    float    maxTilt          = 20.0f; ///< roll or pitch in degrees at a 100% piloting setpoint
+    unsigned connectDelayMs   = 100;   ///< time from start() to the running state
+    double   latitude         = 500.0; ///< reported latitude, 500 when there is no GPS fix
+    double   longitude        = 500.0; ///< reported longitude, 500 when there is no GPS fix
+    double   altitude         = 1.0;   ///< altitude in metres after connecting
+    unsigned cameraLatencyMs  = 40;    ///< time from a camera orientation command to its orientation report
+    float    cameraFov        = 80.0f; ///< reported horizontal field of view in degrees
+    float    cameraTiltMin    = -83.0f; ///< reported minimum tilt in degrees
+    float    cameraTiltMax    = 17.0f;  ///< reported maximum tilt in degrees
+    float    cameraPanMin     = -35.0f; ///< reported minimum pan in degrees
+    float    cameraPanMax     = 35.0f;  ///< reported maximum pan in degrees
+};
+
+/// A DroneTransport that simulates a hovering Bebop2. A thread per drone emits the decoder
+/// configuration, replays the video access units at the configured frame rate and sends battery,
+/// flying state, attitude, speed, altitude, position and move-end commands as ARSDK dictionaries, so
+/// DecodePipeline, TelemetryCache, MoveSequencer and Fleet run unchanged without hardware. The camera
+/// reports its settings on connecting, and each orientation command is reported back, clamped to the
+/// limits, after SimulatorOptions::cameraLatencyMs. A piloting setpoint flies the drone at its
+/// percentage of moveSpeed, climb speed and rotationSpeed, tilted by its percentage of maxTilt, until
+/// the next setpoint, and is reported in the attitude, speed and altitude telemetry.
+/// @details Moves complete after the time they would take at the configured speeds. A move sent while
+/// another is running interrupts it, which reports the partial displacement with the ARSDK interrupted
+/// error, as the drone does. Callbacks run on the simulator thread without any simulator lock held, so
+/// they may call back into the drone.
+class SimulatedDrone : public LocalTransport {
+public:
+    SimulatedDrone() = delete;
+
+    /// Construct a simulated drone. It is stopped until start() is called.
+    /// @param options the simulation configuration
+    explicit SimulatedDrone(const SimulatorOptions &options) : m_options(options) {}
+
+    /// Stops the simulator thread
+    ~SimulatedDrone() override { stop(); }
+
+    SimulatedDrone(const SimulatedDrone &) = delete;
+    SimulatedDrone &operator=(const SimulatedDrone &) = delete;
+
+    void start() override
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            if (m_thread.joinable()) { return; }
+            m_stopRequested = false;
+            m_thread = std::thread(&SimulatedDrone::m_simLoop, this);
+        }
+        m_setState(ARCONTROLLER_DEVICE_STATE_STARTING);
+    }
+
+    void stop() override
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            if (!m_thread.joinable()) { return; }
+            m_stopRequested = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_move.active = false;
+            m_camera.pending = false;
+            m_setpoint = SimSetpoint();
+            m_pending.clear();
+        }
+        m_setState(ARCONTROLLER_DEVICE_STATE_STOPPED);
+    }
+
+    void startVideo() override
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            if (m_videoRunning || !m_options.video) { return; }
+            m_videoRunning = true;
+            m_configPending = true;
+            m_wakeRequested = true;
+        }
+        m_cv.notify_all();
+    }
+
+    void stopVideo() override
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        m_videoRunning = false;
+    }
+
+    std::shared_ptr<VideoFrame> getFrame() override { return m_options.frame; }
+
+    void moveRelativeMetres(float dx, float dy, float dz, float heading) override
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            if (getLastState() != ARCONTROLLER_DEVICE_STATE_RUNNING) { return; }
+            const uint64_t nowNs = monotonicNanoseconds();
+            if (m_move.active) { m_endMove(nowNs, MOVEBYEND_ERROR_INTERRUPTED); }
+
+            // ARSDK moveBy is forward, right, down and heading in radians
+            m_move.active = true;
+            m_move.dX     = dy;
+            m_move.dY     = dx;
+            m_move.dZ     = dz;
+            m_move.dPsi   = heading * PI_F / 180.0f;
+            const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+            const double seconds = std::max(m_options.moveSpeed > 0.0f ? distance / m_options.moveSpeed : 0.0f,
+                                            m_options.rotationSpeed > 0.0f ? std::fabs(heading) / m_options.rotationSpeed : 0.0f);
+            m_move.startNs = nowNs;
+            m_move.endNs   = nowNs + static_cast<uint64_t>(seconds * 1e9);
+            if (seconds > 0.0) {
+                m_pushFlyingState(ARCOMMANDS_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE_FLYING);
+            }
+            m_wakeRequested = true;
+        }
+        m_cv.notify_all();
+    }
+
+    unsigned getBatteryLevel() override { return m_batteryLevel.load(); }
+
+    bool sendPilotingSetpoint(const PilotingSetpoint &setpoint) override
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        if (getLastState() != ARCONTROLLER_DEVICE_STATE_RUNNING) { return false; }
+        const uint64_t nowNs = monotonicNanoseconds();
+        m_integrateSetpoint(nowNs);
+
+        const bool wasFlying = m_setpoint.isFlying();
+        // as on the drone, roll and pitch are ignored unless the flag is set
+        m_setpoint.roll    = setpoint.useRollPitch ? setpoint.roll / 100.0f : 0.0f;
+        m_setpoint.pitch   = setpoint.useRollPitch ? setpoint.pitch / 100.0f : 0.0f;
+        m_setpoint.yaw     = setpoint.yaw / 100.0f;
+        m_setpoint.gaz     = setpoint.gaz / 100.0f;
+        m_setpoint.startNs = nowNs;
+        if (m_setpoint.isFlying() != wasFlying && !m_move.active) {
+            m_pushFlyingState(wasFlying ? ARCOMMANDS_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE_HOVERING
+                                        : ARCOMMANDS_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE_FLYING);
+        }
+        return true;
+    }
+
+    bool sendCameraOrientation(float tilt, float pan) override
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            if (getLastState() != ARCONTROLLER_DEVICE_STATE_RUNNING) { return false; }
+            // a command sent before the last one was reported replaces it, the camera slews to the newest
+            m_camera.pending = true;
+            m_camera.tilt    = std::max(m_options.cameraTiltMin, std::min(m_options.cameraTiltMax, tilt));
+            m_camera.pan     = std::max(m_options.cameraPanMin, std::min(m_options.cameraPanMax, pan));
+            m_camera.dueNs   = monotonicNanoseconds() + static_cast<uint64_t>(m_options.cameraLatencyMs) * 1000000ULL;
+            m_wakeRequested  = true;
+        }
+        m_cv.notify_all();
+        return true;
+    }
+
+private:
+    static constexpr int32_t MOVEBYEND_ERROR_OK          = 0;
+    static constexpr int32_t MOVEBYEND_ERROR_INTERRUPTED = 4;
+    static constexpr unsigned MAX_ARGUMENTS = 5;
+
+    /// A command waiting to be sent on the simulator thread
+    struct SimCommand {
+        /// One argument
+        struct Argument {
+            const char *name;
+            eARCONTROLLER_DICTIONARY_VALUE_TYPE type;
+            ARCONTROLLER_DICTIONARY_VALUE_t value;
+        };
+
+        eARCONTROLLER_DICTIONARY_KEY key;
+        unsigned numArguments = 0;
+        Argument arguments[MAX_ARGUMENTS];
+
+        SimCommand &add(const char *name, eARCONTROLLER_DICTIONARY_VALUE_TYPE type, ARCONTROLLER_DICTIONARY_VALUE_t value)
+        {
+            arguments[numArguments].name  = name;
+            arguments[numArguments].type  = type;
+            arguments[numArguments].value = value;
+            numArguments++;
+            return *this;
+        }
+        SimCommand &addU8(const char *name, uint8_t value)
+        {
+            ARCONTROLLER_DICTIONARY_VALUE_t v; std::memset(&v, 0, sizeof(v)); v.U8 = value;
+            return add(name, ARCONTROLLER_DICTIONARY_VALUE_TYPE_U8, v);
+        }
+        SimCommand &addEnum(const char *name, int32_t value)
+        {
+            ARCONTROLLER_DICTIONARY_VALUE_t v; std::memset(&v, 0, sizeof(v)); v.I32 = value;
+            return add(name, ARCONTROLLER_DICTIONARY_VALUE_TYPE_ENUM, v);
+        }
+        SimCommand &addFloat(const char *name, float value)
+        {
+            ARCONTROLLER_DICTIONARY_VALUE_t v; std::memset(&v, 0, sizeof(v)); v.Float = value;
+            return add(name, ARCONTROLLER_DICTIONARY_VALUE_TYPE_FLOAT, v);
+        }
+        SimCommand &addDouble(const char *name, double value)
+        {
+            ARCONTROLLER_DICTIONARY_VALUE_t v; std::memset(&v, 0, sizeof(v)); v.Double = value;
+            return add(name, ARCONTROLLER_DICTIONARY_VALUE_TYPE_DOUBLE, v);
+        }
+    };
+
+    /// The move in progress
+    struct SimMove {
+        bool     active  = false;
+        float    dX      = 0.0f; ///< forward metres
+        float    dY      = 0.0f; ///< right metres
+        float    dZ      = 0.0f; ///< down metres
+        float    dPsi    = 0.0f; ///< heading radians
+        uint64_t startNs = 0;
+        uint64_t endNs   = 0;
+    };
+
+    /// The piloting setpoint being flown, as fractions of the maximum
+    struct SimSetpoint {
+        float    roll    = 0.0f; ///< right
+        float    pitch   = 0.0f; ///< forward
+        float    yaw     = 0.0f; ///< clockwise
+        float    gaz     = 0.0f; ///< up
+        uint64_t startNs = 0;    ///< time the heading and altitude were last integrated
+
+        bool isFlying() const { return roll != 0.0f || pitch != 0.0f || yaw != 0.0f || gaz != 0.0f; }
+    };
+
+    /// The camera orientation waiting to be reported
+    struct SimCamera {
+        bool     pending = false;
+        float    tilt    = 0.0f; ///< degrees
+        float    pan     = 0.0f; ///< degrees
+        uint64_t dueNs   = 0;
+    };
+
+    const SimulatorOptions m_options;                 ///< configuration
+    std::mutex              m_mutex;                ///< protects everything below
+    std::condition_variable m_cv;                   ///< wakes the simulator thread
+    std::thread             m_thread;               ///< the simulator thread
+    bool m_stopRequested = false;                   ///< tells the thread to exit
+    bool m_wakeRequested = false;                   ///< tells the thread to recompute its schedule
+    bool m_videoRunning  = false;                   ///< true between startVideo() and stopVideo()
+    bool m_configPending = false;                   ///< the decoder configuration must be sent
+    SimMove m_move;                                 ///< the move in progress
+    SimCamera m_camera;                             ///< the camera orientation in progress
+    SimSetpoint m_setpoint;                         ///< the piloting setpoint being flown
+    float   m_yaw      = 0.0f;                      ///< heading in radians
+    double  m_altitude = 0.0;                       ///< altitude in metres
+    std::vector<SimCommand> m_pending;              ///< commands to send
+
+    std::atomic<unsigned> m_batteryLevel{100};      ///< battery percent
+
+    /// Called with m_mutex held
+    void m_pushFlyingState(eARCOMMANDS_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE state)
+    {
+        SimCommand command;
+        command.key = ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED;
+        command.addEnum(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE, state);
+        m_pending.push_back(command);
+    }
+
+    /// Complete or interrupt the move in progress. Called with m_mutex held.
+    void m_endMove(uint64_t nowNs, int32_t error)
+    {
+        float fraction = 1.0f;
+        if (nowNs < m_move.endNs && m_move.endNs > m_move.startNs) {
+            fraction = static_cast<float>(nowNs - m_move.startNs) / static_cast<float>(m_move.endNs - m_move.startNs);
+        }
+        m_yaw      += m_move.dPsi * fraction;
+        m_altitude -= m_move.dZ * fraction;
+        m_move.active = false;
+
+        SimCommand command;
+        command.key = ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND;
+        command.addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_DX, m_move.dX * fraction)
+               .addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_DY, m_move.dY * fraction)
+               .addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_DZ, m_move.dZ * fraction)
+               .addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_DPSI, m_move.dPsi * fraction)
+               .addEnum(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGEVENT_MOVEBYEND_ERROR, error);
+        m_pending.push_back(command);
+        if (error == MOVEBYEND_ERROR_OK && !m_setpoint.isFlying()) {
+            m_pushFlyingState(ARCOMMANDS_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE_HOVERING);
+        }
+    }
+
+    /// Apply the heading and altitude change of the setpoint since it was last integrated. Called with
+    /// m_mutex held.
+    void m_integrateSetpoint(uint64_t nowNs)
+    {
+        if (nowNs <= m_setpoint.startNs) { return; }
+        const float seconds = static_cast<float>(nowNs - m_setpoint.startNs) / 1e9f;
+        m_yaw      += m_setpoint.yaw * m_options.rotationSpeed * PI_F / 180.0f * seconds;
+        m_altitude += m_setpoint.gaz * m_options.moveSpeed * seconds;
+        m_setpoint.startNs = nowNs;
+    }
+
+    /// Queue the periodic telemetry. Called with m_mutex held.
+    void m_pushTelemetry(uint64_t nowNs)
+    {
+        m_integrateSetpoint(nowNs);
+        // a setpoint flies forward and right at its fraction of the move speed
+        const float forward = m_setpoint.pitch * m_options.moveSpeed;
+        const float right   = m_setpoint.roll * m_options.moveSpeed;
+        float speedX = forward * std::cos(m_yaw) - right * std::sin(m_yaw);
+        float speedY = forward * std::sin(m_yaw) + right * std::cos(m_yaw);
+        float speedZ = -m_setpoint.gaz * m_options.moveSpeed;
+        float yaw    = m_yaw;
+        double altitude = m_altitude;
+        if (m_move.active && m_move.endNs > m_move.startNs) {
+            const float seconds  = static_cast<float>(m_move.endNs - m_move.startNs) / 1e9f;
+            const float fraction = std::min(1.0f, static_cast<float>(nowNs - m_move.startNs) / 1e9f / seconds);
+            // speed is reported north, east, down; the simulated drone treats its start heading as north
+            speedX += (m_move.dX * std::cos(m_yaw) - m_move.dY * std::sin(m_yaw)) / seconds;
+            speedY += (m_move.dX * std::sin(m_yaw) + m_move.dY * std::cos(m_yaw)) / seconds;
+            speedZ += m_move.dZ / seconds;
+            yaw      += m_move.dPsi * fraction;
+            altitude -= m_move.dZ * fraction;
+        }
+
+        SimCommand attitude;
+        attitude.key = ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED;
+        const float maxTilt = m_options.maxTilt * PI_F / 180.0f;
+        // the drone pitches nose down, a negative pitch, to fly forward
+        attitude.addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED_ROLL, m_setpoint.roll * maxTilt)
+                .addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED_PITCH, -m_setpoint.pitch * maxTilt)
+                .addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED_YAW,
+                          std::remainder(yaw, 2.0f * PI_F));
+        m_pending.push_back(attitude);
+
+        SimCommand speed;
+        speed.key = ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED;
+        speed.addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED_SPEEDX, speedX)
+             .addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED_SPEEDY, speedY)
+             .addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED_SPEEDZ, speedZ);
+        m_pending.push_back(speed);
+
+        SimCommand altitudeCommand;
+        altitudeCommand.key = ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ALTITUDECHANGED;
+        altitudeCommand.addDouble(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ALTITUDECHANGED_ALTITUDE, altitude);
+        m_pending.push_back(altitudeCommand);
+
+        SimCommand position;
+        position.key = ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED;
+        position.addDouble(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED_LATITUDE, m_options.latitude)
+                .addDouble(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED_LONGITUDE, m_options.longitude)
+                .addDouble(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED_ALTITUDE, altitude);
+        m_pending.push_back(position);
+    }
+
+    /// Queue a camera orientation report. Called with m_mutex held.
+    void m_pushCameraOrientation(float tilt, float pan)
+    {
+        SimCommand orientation;
+        orientation.key = ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_CAMERASTATE_ORIENTATIONV2;
+        orientation.addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_CAMERASTATE_ORIENTATIONV2_TILT, tilt)
+                   .addFloat(ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_CAMERASTATE_ORIENTATIONV2_PAN, pan);
+        m_pending.push_back(orientation);
+    }
+
+    /// Queue the camera field of view and limits. Called with m_mutex held.
+    void m_pushCameraSettings()
+    {
+        SimCommand settings;
+        settings.key = ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED;
+        settings.addFloat(ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_FOV, m_options.cameraFov)
+                .addFloat(ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_PANMAX, m_options.cameraPanMax)
+                .addFloat(ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_PANMIN, m_options.cameraPanMin)
+                .addFloat(ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_TILTMAX, m_options.cameraTiltMax)
+                .addFloat(ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_TILTMIN, m_options.cameraTiltMin);
+        m_pending.push_back(settings);
+    }
+
+    /// Queue a battery update. Called with m_mutex held.
+    void m_pushBattery(uint64_t nowNs, uint64_t connectedNs)
+    {
+        const double minutes = static_cast<double>(nowNs - connectedNs) / 60e9;
+        const double level   = 100.0 - minutes * m_options.batteryDrainPerMinute;
+        m_batteryLevel = static_cast<unsigned>(std::max(0.0, std::min(100.0, std::ceil(level))));
+
+        SimCommand battery;
+        battery.key = ARCONTROLLER_DICTIONARY_KEY_COMMON_COMMONSTATE_BATTERYSTATECHANGED;
+        battery.addU8(ARCONTROLLER_DICTIONARY_KEY_COMMON_COMMONSTATE_BATTERYSTATECHANGED_PERCENT,
+                      static_cast<uint8_t>(m_batteryLevel.load()));
+        m_pending.push_back(battery);
+    }
+
+    /// Pass a queued command to the command callbacks
+    void m_dispatch(const SimCommand &command, CommandDictionary &dictionary)
+    {
+        dictionary.clear();
+        for (unsigned i = 0; i < command.numArguments; i++) {
+            dictionary.add(command.arguments[i].name, command.arguments[i].type, command.arguments[i].value);
+        }
+        m_dispatchCommand(command.key, dictionary);
+    }
+
+    void m_simLoop()
+    {
+        using Clock = std::chrono::steady_clock;
+        const uint64_t clockOffsetNs = monotonicNanoseconds();
+        const Clock::time_point clockBase = Clock::now();
+        auto toTimePoint = [&](uint64_t ns) {
+            return clockBase + std::chrono::nanoseconds(static_cast<int64_t>(ns - clockOffsetNs));
+        };
+
+        std::unique_lock<std::mutex> lck(m_mutex);
+        const uint64_t connectedNs = clockOffsetNs + static_cast<uint64_t>(m_options.connectDelayMs) * 1000000ULL;
+        if (m_cv.wait_until(lck, toTimePoint(connectedNs), [this]() { return m_stopRequested; })) { return; }
+
+        m_altitude = m_options.altitude;
+        m_yaw      = 0.0f;
+        m_setpoint = SimSetpoint();
+        lck.unlock();
+        m_setState(ARCONTROLLER_DEVICE_STATE_RUNNING);
+        lck.lock();
+
+        const uint64_t telemetryPeriodNs = m_options.telemetryHz ? 1000000000ULL / m_options.telemetryHz : 0;
+        const uint64_t batteryPeriodNs   = static_cast<uint64_t>(m_options.batteryPeriodMs) * 1000000ULL;
+        const uint64_t framePeriodNs     = m_options.frameRate ? 1000000000ULL / m_options.frameRate : 0;
+        uint64_t nowNs = monotonicNanoseconds();
+        uint64_t nextTelemetryNs = nowNs;
+        uint64_t nextBatteryNs   = nowNs;
+        uint64_t nextFrameNs     = nowNs;
+        size_t   nextUnit        = m_options.video ? m_options.video->getFirstIFrame() : 0;
+        bool     videoEnded      = false;
+        std::vector<SimCommand> commands;
+        CommandDictionary dictionary;
+
+        m_pushFlyingState(ARCOMMANDS_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE_HOVERING);
+        m_pushCameraSettings();
+        m_pushCameraOrientation(0.0f, 0.0f);
+
+        while (!m_stopRequested) {
+            nowNs = monotonicNanoseconds();
+            if (m_move.active && nowNs >= m_move.endNs) {
+                m_endMove(nowNs, MOVEBYEND_ERROR_OK);
+            }
+            if (m_camera.pending && nowNs >= m_camera.dueNs) {
+                m_pushCameraOrientation(m_camera.tilt, m_camera.pan);
+                m_camera.pending = false;
+            }
+            if (telemetryPeriodNs && nowNs >= nextTelemetryNs) {
+                m_pushTelemetry(nowNs);
+                nextTelemetryNs = std::max(nextTelemetryNs + telemetryPeriodNs, nowNs);
+            }
+            if (batteryPeriodNs && nowNs >= nextBatteryNs) {
+                m_pushBattery(nowNs, connectedNs);
+                nextBatteryNs = std::max(nextBatteryNs + batteryPeriodNs, nowNs);
+            }
+
+            const bool sendConfig = m_videoRunning && m_configPending;
+            if (sendConfig) {
+                m_configPending = false;
+                nextFrameNs = nowNs;
+                nextUnit    = m_options.video->getFirstIFrame();
+                videoEnded  = false;
+            }
+            bool sendFrame = false;
+            size_t unit = nextUnit;
+            if (m_videoRunning && !videoEnded && framePeriodNs && nowNs >= nextFrameNs) {
+                sendFrame = true;
+                // keep the frame rate without bursting to catch up after a stall
+                nextFrameNs += framePeriodNs;
+                if (nextFrameNs + framePeriodNs < nowNs) { nextFrameNs = nowNs; }
+                nextUnit++;
+                if (nextUnit >= m_options.video->getAccessUnits().size()) {
+                    nextUnit   = m_options.video->getFirstIFrame();
+                    videoEnded = !m_options.loopVideo;
+                }
+            }
+            commands.swap(m_pending);
+
+            lck.unlock();
+            for (const auto &command : commands) { m_dispatch(command, dictionary); }
+            commands.clear();
+            if (sendConfig) {
+                const H264ElementaryStream &video = *m_options.video;
+                m_dispatchDecoderConfig(video.getSps().data(), video.getSps().size(),
+                                        video.getPps().data(), video.getPps().size());
+            }
+            if (sendFrame) {
+                const H264ElementaryStream::AccessUnit &accessUnit = m_options.video->getAccessUnits()[unit];
+                m_dispatchFrame(m_options.video->getData() + accessUnit.offset, accessUnit.size, accessUnit.isIFrame);
+            }
+            lck.lock();
+
+            if (!m_pending.empty() || m_stopRequested) { continue; }
+            uint64_t wakeNs = UINT64_MAX;
+            if (telemetryPeriodNs) { wakeNs = std::min(wakeNs, nextTelemetryNs); }
+            if (batteryPeriodNs)   { wakeNs = std::min(wakeNs, nextBatteryNs); }
+            if (m_move.active)     { wakeNs = std::min(wakeNs, m_move.endNs); }
+            if (m_camera.pending)  { wakeNs = std::min(wakeNs, m_camera.dueNs); }
+            if (m_videoRunning && !videoEnded && framePeriodNs) { wakeNs = std::min(wakeNs, nextFrameNs); }
+            auto wake = [this]() { return m_stopRequested || m_wakeRequested; };
+            if (wakeNs == UINT64_MAX) {
+                m_cv.wait(lck, wake);
+            } else {
+                m_cv.wait_until(lck, toTimePoint(wakeNs), wake);
+            }
+            m_wakeRequested = false;
+        }
+    }
+};
+
+} // wscDrone
+
+#endif /* SIMULATOR_H_ */
@@ -0,0 +1,379 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the SnapshotEncoder, which turns decoded video
+ * frames into JPEG or PNG stills on background threads.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef SNAPSHOTENCODER_H_
+#define SNAPSHOTENCODER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DecodePipeline.h"
+#include "FramePool.h"
+#include "ImageEncoder.h"
+#include "LatencyHistogram.h"
+#include "Utils.h"
+
+namespace wscDrone {
+
+/// SnapshotEncoder configuration
+struct SnapshotOptions {
+    size_t threads    = 2; ///< encoding threads, each with its own encoders
+    size_t queueDepth = 8; ///< snapshots waiting for a thread or for their frame, further requests are rejected
+    size_t history    = 4; ///< recent frames kept for captureSequence(), each holds a frame of the pipeline's FramePool
+    ImageEncoderOptions encoder; ///< JPEG quality and PNG compression
+};
+
+/// One encoded still, passed to the snapshot callback
+struct SnapshotResult {
+    uint64_t    id = 0;                     ///< the id returned by the capture call
+    uint64_t    sequence = 0;               ///< receive sequence number of the frame encoded
+    uint64_t    receivedNs = 0;             ///< monotonic time the frame's compressed data was received
+    ImageFormat format = ImageFormat::JPEG; ///< image format
+    unsigned    width  = 0;                 ///< width in pixels
+    unsigned    height = 0;                 ///< height in lines
+    std::vector<uint8_t> image;             ///< the encoded file contents
+    std::string path;                       ///< file the image was written to, empty if none was requested
+    bool        success = false;            ///< true when the image was encoded, and written if requested
+    std::string error;                      ///< reason for a failure
+    uint64_t    encodeNs = 0;               ///< time spent encoding
+};
+
+/// A snapshot of the SnapshotEncoder counters
+struct SnapshotStats {
+    uint64_t requested = 0; ///< capture calls accepted
+    uint64_t rejected  = 0; ///< capture calls refused: queue full, no frame yet, or frame no longer held
+    uint64_t encoded   = 0; ///< snapshots encoded successfully
+    uint64_t failed    = 0; ///< snapshots that failed to encode or write, or were abandoned by stop()
+    uint64_t bytes     = 0; ///< encoded bytes
+    size_t   queued    = 0; ///< snapshots waiting for a thread or for their frame
+    LatencyHistogramSnapshot encodeLatency; ///< time spent encoding each snapshot
+};
+
+/// alias for the callback invoked on an encoding thread with each finished snapshot
+using SnapshotCallback = void (*)(const SnapshotResult &result, void *customData);
+
+/// Produces JPEG or PNG stills from the live video without touching the drone's camera.
+/// @details Every PhotoType except SNAPSHOT interrupts the video, and every CameraControl capture is a
+/// round trip to the drone. The SnapshotEncoder instead keeps handles to the most recent decoded frames
+/// of a DecodePipeline and encodes the requested ones on its own threads with an ImageEncoder. Holding
+/// a frame is a reference count, so the decode thread never waits for an encoder; the only cost to the
+/// stream is the frames held, so size the pipeline's FramePool for history + queueDepth frames more than
+/// the application needs. Requests beyond queueDepth are rejected rather than queued, so a burst of
+/// captures cannot grow memory or latency without bound.
+class SnapshotEncoder {
+public:
+    /// Construct an encoder. Feed it frames with attach() or onDecodedFrame().
+    /// @param options threads, queue depth and encoder quality
+    explicit SnapshotEncoder(const SnapshotOptions &options = SnapshotOptions())
+        : m_options(options), m_history(options.history > 0 ? options.history : 1)
+    {
+        if (m_options.threads == 0) { throw std::invalid_argument("SnapshotEncoder: threads must be at least 1"); }
+        if (m_options.queueDepth == 0) { throw std::invalid_argument("SnapshotEncoder: queueDepth must be at least 1"); }
+        if (m_options.encoder.jpegQuality < 1 || m_options.encoder.jpegQuality > 100) {
+            throw std::invalid_argument("SnapshotEncoder: jpegQuality must be from 1 to 100");
+        }
+    }
+
+    /// Stops the encoder
+    ~SnapshotEncoder() { stop(); }
+
+    SnapshotEncoder(const SnapshotEncoder &) = delete;
+    SnapshotEncoder &operator=(const SnapshotEncoder &) = delete;
+
+    /// Register the encoder's decoded frame callback with a DecodePipeline, which must have a FramePool.
+    /// Call before the pipeline starts. An application that needs the callback itself forwards each frame
+    /// to onDecodedFrame() instead.
+    /// @param pipeline smart pointer to the pipeline, it must stop before the encoder is destroyed
+    void attach(std::shared_ptr<DecodePipeline> pipeline)
+    {
+        if (!pipeline->getFramePool()) { throw std::invalid_argument("SnapshotEncoder: the pipeline has no FramePool"); }
+        pipeline->registerDecodedFrameCallback(m_onDecodedFrameDefault, this);
+    }
+
+    /// Register a function to be called with each finished snapshot. Must be called before start().
+    /// @param callback function invoked on an encoding thread, it should return quickly
+    /// @param customData pointer passed back to the callback
+    void registerSnapshotCallback(SnapshotCallback callback, void *customData)
+    {
+        m_callback = callback;
+        m_customData = customData;
+    }
+
+    /// Start the encoding threads
+    void start()
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        if (m_running) { return; }
+        m_running = true;
+        for (size_t i = 0; i < m_options.threads; i++) {
+            m_workers.emplace_back(&SnapshotEncoder::m_worker, this);
+        }
+    }
+
+    /// Stop the encoding threads and release every frame held. Snapshots not yet encoded are reported
+    /// to the callback as failed.
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_running = false;
+        }
+        m_cv.notify_all();
+        for (auto &worker : m_workers) { worker.join(); }
+        m_workers.clear();
+
+        std::deque<Job> abandoned;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            abandoned.swap(m_jobs);
+            abandoned.insert(abandoned.end(), m_pending.begin(), m_pending.end());
+            m_pending.clear();
+            for (auto &frame : m_history) { frame.reset(); }
+        }
+        for (Job &job : abandoned) {
+            SnapshotResult result = m_describe(job);
+            result.error = "SnapshotEncoder: stopped";
+            m_complete(result);
+        }
+    }
+
+    /// Hand the encoder a decoded frame. Called on the decode thread; it only copies the handle.
+    /// @param frame the frame
+    void onDecodedFrame(const FrameRef &frame)
+    {
+        if (!frame) { return; }
+        bool ready = false;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_history[m_newest++ % m_history.size()] = frame;
+            for (auto it = m_pending.begin(); it != m_pending.end();) {
+                if (frame.sequence() < it->sequence) {
+                    ++it;
+                    continue;
+                }
+                // a frame the pipeline dropped is never published, so the next one stands in for it
+                it->frame = frame;
+                m_jobs.push_back(std::move(*it));
+                it = m_pending.erase(it);
+                ready = true;
+            }
+        }
+        if (ready) { m_cv.notify_all(); }
+    }
+
+    /// Encode the most recent decoded frame
+    /// @param format the image format
+    /// @param path file to write the image to, empty to deliver it in SnapshotResult::image only
+    /// @returns the id reported in the result, 0 if the request was rejected
+    uint64_t captureLatest(ImageFormat format, const std::string &path = "")
+    {
+        std::unique_lock<std::mutex> lck(m_mutex);
+        if (m_newest == 0 || m_queued() >= m_options.queueDepth) { return m_reject(); }
+        Job job = m_makeJob(format, path);
+        job.frame    = m_history[(m_newest - 1) % m_history.size()];
+        job.sequence = job.frame.sequence();
+        m_jobs.push_back(std::move(job));
+        const uint64_t id = m_jobs.back().id;
+        lck.unlock();
+        m_cv.notify_one();
+        return id;
+    }
+
+    /// Encode the frame with a given sequence number, e.g. from FrameTimestamps or FrameOutputs. A frame
+    /// not yet decoded is encoded when it arrives. If the pipeline drops it, the next frame is used instead.
+    /// @param sequence receive sequence number of the frame
+    /// @param format the image format
+    /// @param path file to write the image to, empty to deliver it in SnapshotResult::image only
+    /// @returns the id reported in the result, 0 if the request was rejected because the queue is full
+    /// or the frame is older than the history
+    uint64_t captureSequence(uint64_t sequence, ImageFormat format, const std::string &path = "")
+    {
+        std::unique_lock<std::mutex> lck(m_mutex);
+        if (m_queued() >= m_options.queueDepth) { return m_reject(); }
+        // the oldest held frame at or after the sequence
+        FrameRef found;
+        const size_t held = m_newest < m_history.size() ? static_cast<size_t>(m_newest) : m_history.size();
+        for (size_t age = held; age > 0; age--) {
+            const FrameRef &frame = m_history[(m_newest - age) % m_history.size()];
+            if (frame && frame.sequence() >= sequence) {
+                // the frame asked for has already left the history
+                if (age == held && frame.sequence() > sequence) { return m_reject(); }
+                found = frame;
+                break;
+            }
+        }
+
+        Job job = m_makeJob(format, path);
+        job.sequence = sequence;
+        job.frame    = std::move(found);
+        const uint64_t id = job.id;
+        if (job.frame) {
+            m_jobs.push_back(std::move(job));
+            lck.unlock();
+            m_cv.notify_one();
+        } else {
+            m_pending.push_back(std::move(job));
+        }
+        return id;
+    }
+
+    /// Get the encoder counters
+    /// @returns a snapshot of the counters
+    SnapshotStats getStats() const
+    {
+        SnapshotStats stats;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            stats.queued = m_queued();
+        }
+        stats.requested     = m_requested.load(std::memory_order_relaxed);
+        stats.rejected      = m_rejected.load(std::memory_order_relaxed);
+        stats.encoded       = m_encoded.load(std::memory_order_relaxed);
+        stats.failed        = m_failed.load(std::memory_order_relaxed);
+        stats.bytes         = m_bytes.load(std::memory_order_relaxed);
+        stats.encodeLatency = m_encodeLatency.snapshot();
+        return stats;
+    }
+
+private:
+    /// One requested snapshot
+    struct Job {
+        uint64_t    id = 0;
+        uint64_t    sequence = 0;   ///< sequence asked for, the frame's may be later
+        ImageFormat format = ImageFormat::JPEG;
+        std::string path;
+        FrameRef    frame;          ///< empty while waiting for the frame to be decoded
+    };
+
+    const SnapshotOptions m_options;
+    SnapshotCallback m_callback = nullptr;
+    void *m_customData = nullptr;
+
+    mutable std::mutex      m_mutex;      ///< protects every member below
+    std::condition_variable m_cv;         ///< signals a job ready to encode or stop()
+    bool                    m_running = false;
+    std::vector<FrameRef>   m_history;    ///< ring of the most recent frames
+    uint64_t                m_newest = 0; ///< frames handed in, the newest is at (m_newest - 1) % size
+    std::deque<Job>         m_jobs;       ///< jobs with their frame, waiting for a thread
+    std::deque<Job>         m_pending;    ///< jobs waiting for their frame to be decoded
+    std::vector<std::thread> m_workers;   ///< encoding threads
+
+    std::atomic<uint64_t> m_nextId{1};
+    std::atomic<uint64_t> m_requested{0};
+    std::atomic<uint64_t> m_rejected{0};
+    std::atomic<uint64_t> m_encoded{0};
+    std::atomic<uint64_t> m_failed{0};
+    std::atomic<uint64_t> m_bytes{0};
+    LatencyHistogram      m_encodeLatency;
+
+    /// Get the number of jobs not yet encoding. Called with m_mutex held.
+    size_t m_queued() const { return m_jobs.size() + m_pending.size(); }
+
+    uint64_t m_reject()
+    {
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    Job m_makeJob(ImageFormat format, const std::string &path)
+    {
+        Job job;
+        job.id     = m_nextId.fetch_add(1);
+        job.format = format;
+        job.path   = path;
+        m_requested.fetch_add(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    static SnapshotResult m_describe(const Job &job)
+    {
+        SnapshotResult result;
+        result.id       = job.id;
+        result.sequence = job.frame ? job.frame.sequence() : job.sequence;
+        result.format   = job.format;
+        result.path     = job.path;
+        if (job.frame) {
+            result.receivedNs = job.frame.timestampNs();
+            result.width      = job.frame.width();
+            result.height     = job.frame.height();
+        }
+        return result;
+    }
+
+    void m_complete(const SnapshotResult &result)
+    {
+        if (result.success) { m_encoded.fetch_add(1, std::memory_order_relaxed); }
+        else { m_failed.fetch_add(1, std::memory_order_relaxed); }
+        if (m_callback) { m_callback(result, m_customData); }
+    }
+
+    /// Body of each encoding thread
+    void m_worker()
+    {
+        ImageEncoder encoder(m_options.encoder);
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lck(m_mutex);
+                m_cv.wait(lck, [this]() { return !m_running || !m_jobs.empty(); });
+                if (!m_running) { return; }
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            SnapshotResult result = m_describe(job);
+            const uint64_t startNs = monotonicNanoseconds();
+            result.success  = encoder.encode(job.frame, job.format, result.image, result.error);
+            result.encodeNs = monotonicNanoseconds() - startNs;
+            // the frame goes back to the pipeline's pool before the callback runs
+            job.frame.reset();
+            if (result.success) {
+                m_encodeLatency.record(result.encodeNs);
+                m_bytes.fetch_add(result.image.size(), std::memory_order_relaxed);
+                if (!job.path.empty() && !m_write(job.path, result.image)) {
+                    result.success = false;
+                    result.error   = "SnapshotEncoder: unable to write " + job.path;
+                }
+            }
+            m_complete(result);
+        }
+    }
+
+    static bool m_write(const std::string &path, const std::vector<uint8_t> &image)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) { return false; }
+        file.write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+        return static_cast<bool>(file);
+    }
+
+    static void m_onDecodedFrameDefault(const FrameRef &frame, void *customData)
+    {
+        static_cast<SnapshotEncoder *>(customData)->onDecodedFrame(frame);
+    }
+};
+
+} // wscDrone
+
+#endif /* SNAPSHOTENCODER_H_ */
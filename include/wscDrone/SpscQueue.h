@@ -0,0 +1,134 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains a bounded, lock-free single-producer queue used to
+ * hand work between the ARSDK callback threads and the library worker threads.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef SPSCQUEUE_H_
+#define SPSCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace wscDrone {
+
+/// Size of a cache line, used to keep the producer and consumer indices apart.
+constexpr size_t CACHE_LINE_BYTES = 64;
+
+/// A bounded lock-free ring buffer with one producer and one consumer.
+/// @details Elements are never constructed or destroyed after the queue is built. Instead the
+/// producer fills a slot in place and the consumer drains it in place, so elements holding
+/// buffers (e.g. std::vector) keep their capacity and steady-state operation does not allocate.
+/// Every slot carries a sequence number, which makes it safe for the producer to also pop
+/// (e.g. to discard the oldest element when the queue is full) while the consumer is popping.
+template <typename T>
+class SpscQueue {
+public:
+    SpscQueue() = delete;
+
+    /// Construct a queue holding at least the requested number of elements
+    /// @param capacity minimum number of elements, rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity) { size <<= 1; }
+        m_mask  = size - 1;
+        m_slots.reset(new Slot[size]);
+        for (size_t i = 0; i < size; i++) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    ~SpscQueue() = default; ///< default destructor
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    /// Fill the next free slot in place. Must only be called from the producer thread.
+    /// @param fill callable invoked as fill(T&) to write the element
+    /// @returns true if the element was queued, false if the queue is full
+    template <typename Fill>
+    bool tryPush(Fill &&fill)
+    {
+        size_t pos  = m_tail.load(std::memory_order_relaxed);
+        Slot  &slot = m_slots[pos & m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != pos) {
+            return false; // full, or the consumer is still draining this slot
+        }
+        fill(slot.value);
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        m_tail.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Drain the oldest element in place.
+    /// @param consume callable invoked as consume(T&). It should move or swap out what it needs
+    /// quickly, since the slot cannot be refilled until it returns.
+    /// @returns true if an element was consumed, false if the queue is empty
+    template <typename Consume>
+    bool tryPop(Consume &&consume)
+    {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot     &slot = m_slots[pos & m_mask];
+            size_t    seq  = slot.sequence.load(std::memory_order_acquire);
+            intptr_t  diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    consume(slot.value);
+                    slot.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // empty
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Discard the oldest element without looking at it. Safe to call from the producer.
+    /// @returns true if an element was discarded
+    bool dropOldest() { return tryPop([](T &) {}); }
+
+    /// Get the approximate number of queued elements
+    /// @returns the element count at some instant during the call
+    size_t size() const
+    {
+        size_t head = m_head.load(std::memory_order_acquire);
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    /// Get the maximum number of queued elements
+    /// @returns the queue capacity
+    size_t capacity() const { return m_mask + 1; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence; ///< slot ownership, see Vyukov's bounded queue
+        T value;                      ///< the element storage, reused for the life of the queue
+    };
+
+    std::unique_ptr<Slot[]> m_slots;  ///< ring storage
+    size_t m_mask = 0;                ///< capacity - 1
+    char m_pad0[CACHE_LINE_BYTES];    ///< keep the indices off the read-mostly members
+    std::atomic<size_t> m_head{0};    ///< next position to pop
+    char m_pad1[CACHE_LINE_BYTES - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_tail{0};    ///< next position to push
+    char m_pad2[CACHE_LINE_BYTES - sizeof(std::atomic<size_t>)];
+};
+
+} // wscDrone
+
+#endif /* SPSCQUEUE_H_ */
@@ -0,0 +1,709 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the StreamRecorder, which records the drone's
+ * compressed H.264 stream to MP4 or MPEG-TS files without decoding it.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef STREAMRECORDER_H_
+#define STREAMRECORDER_H_
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libARController/ARController.h>
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/dict.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "DroneTransport.h"
+#include "SpscQueue.h"
+#include "Utils.h"
+
+namespace wscDrone {
+
+/// Containers a StreamRecorder writes
+enum class RecordingContainer : unsigned {
+    MP4    = 0, ///< ISO MP4, fragmented at each I-frame unless fragmentedMp4 is false
+    MPEGTS = 1  ///< MPEG-2 transport stream
+};
+
+/// Configuration of a StreamRecorder
+struct StreamRecorderOptions {
+    RecordingContainer container = RecordingContainer::MP4;
+    unsigned segmentSeconds   = 300;         ///< a new file is started at the first I-frame after this long, 0 for one file
+    size_t   queueDepth       = 128;         ///< compressed frames waiting for the writer
+    size_t   writeBufferBytes = 1024 * 1024; ///< the muxer output reaches the disk in writes of this size
+    bool     fragmentedMp4    = true;        ///< MP4 files stay playable when the recording is interrupted
+};
+
+/// Counters of a StreamRecorder
+struct StreamRecorderStats {
+    uint64_t framesWritten = 0; ///< frames muxed
+    uint64_t bytesWritten  = 0; ///< bytes written to the segment files
+    uint64_t diskWrites    = 0; ///< write calls made for those bytes
+    uint64_t framesDropped = 0; ///< frames and decoder configurations lost to a full queue
+    uint64_t framesSkipped = 0; ///< frames discarded while waiting for an I-frame or the decoder configuration
+    uint64_t writeErrors   = 0; ///< segments that could not be created or were cut short
+    uint32_t segments      = 0; ///< segment files created
+};
+
+/// A finished segment file
+struct RecordingSegment {
+    std::string path;            ///< the file
+    uint64_t startNs    = 0;     ///< monotonic time the first frame was received
+    uint64_t durationNs = 0;     ///< receive time of the last frame minus startNs
+    uint64_t frames     = 0;     ///< frames in the file
+    uint64_t bytes      = 0;     ///< size of the file
+    bool     complete   = true;  ///< false if a write failed and the file may be truncated
+};
+
+/// Function called on the writer thread when a segment file is closed
+typedef void (*RecordingSegmentCallback)(const RecordingSegment &segment, void *customData);
+
+/// Records the drone's H.264 stream to MP4 or MPEG-TS files by stream copy, the compressed frames are
+/// muxed as received with the SPS/PPS of the decoder configuration and are never decoded. The recorder
+/// wraps the drone's DroneTransport and is used in its place, e.g. DecodePipeline(recorder), so the
+/// video callbacks pass through it and recording runs alongside decoding.
+/// @details The ARSDK stream thread only copies each frame into a preallocated slot of a lock-free
+/// queue. A writer thread muxes the frames with libavformat into a buffer of writeBufferBytes that is
+/// written to the file in large blocks, so the live path never waits for the disk and the cost of a
+/// recording is one copy per frame. Frames are timestamped with their receive time in a 90 kHz time
+/// base. Every file starts with an I-frame; a new file is started at the first I-frame after
+/// segmentSeconds, or after the decoder configuration changes. When the queue is full frames are
+/// dropped until the next I-frame, so a recording never contains a frame with a missing reference.
+class StreamRecorder : public DroneTransport {
+public:
+    StreamRecorder() = delete;
+
+    /// Wrap a drone's transport. Nothing is recorded until startRecording().
+    /// @param transport smart pointer to the drone's transport
+    /// @param options container, segment and buffer sizes
+    explicit StreamRecorder(std::shared_ptr<DroneTransport> transport,
+                            const StreamRecorderOptions &options = StreamRecorderOptions())
+        : m_transport(transport), m_options(options), m_queue(options.queueDepth)
+    {
+        if (!transport) {
+            throw std::invalid_argument("StreamRecorder: transport is null");
+        }
+        if (options.writeBufferBytes < 4096 || options.writeBufferBytes > 64 * 1024 * 1024) {
+            throw std::invalid_argument("StreamRecorder: writeBufferBytes must be from 4 KiB to 64 MiB");
+        }
+        m_packet = av_packet_alloc();
+        if (!m_packet) {
+            throw std::runtime_error("StreamRecorder: unable to allocate packet");
+        }
+    }
+
+    /// Stops recording. The recorder must outlive the drone's video stream.
+    ~StreamRecorder() override
+    {
+        stopRecording();
+        av_packet_free(&m_packet);
+    }
+
+    StreamRecorder(const StreamRecorder &) = delete;
+    StreamRecorder &operator=(const StreamRecorder &) = delete;
+
+    /// Start recording. The first file begins at the next I-frame.
+    /// @param basePath path of the files without extension, segments are named basePath_00000.mp4 etc.
+    void startRecording(const std::string &basePath)
+    {
+        std::lock_guard<std::mutex> lck(m_controlMutex);
+        if (m_recording.load()) {
+            throw std::runtime_error("StreamRecorder: already recording");
+        }
+        m_basePath      = basePath;
+        m_segmentNumber = 0;
+        const uint64_t generation = ++m_generation;
+        m_recording = true;
+        m_writerThread = std::thread(&StreamRecorder::m_writerLoop, this, generation);
+    }
+
+    /// Write everything queued, close the current file and stop recording
+    void stopRecording()
+    {
+        std::lock_guard<std::mutex> lck(m_controlMutex);
+        if (!m_recording.exchange(false)) { return; }
+        {
+            std::lock_guard<std::mutex> wakeLck(m_wakeMutex);
+            m_wakeCv.notify_one();
+        }
+        m_writerThread.join();
+    }
+
+    /// Check if recording
+    /// @returns true between startRecording() and stopRecording()
+    bool isRecording() const { return m_recording.load(); }
+
+    /// Set the callback for closed segment files. Must be called while not recording.
+    /// @param callback the function to execute on the writer thread for each closed file
+    /// @param customData a raw pointer passed back to the callback
+    void registerSegmentCallback(const RecordingSegmentCallback &callback, void *customData)
+    {
+        std::lock_guard<std::mutex> lck(m_controlMutex);
+        m_segmentCallback   = callback;
+        m_segmentCustomData = customData;
+    }
+
+    /// Get the recorder counters
+    /// @returns a snapshot of the counters
+    StreamRecorderStats getStats()
+    {
+        StreamRecorderStats stats;
+        stats.framesWritten = m_framesWritten.load(std::memory_order_relaxed);
+        stats.bytesWritten  = m_bytesWritten.load(std::memory_order_relaxed);
+        stats.diskWrites    = m_diskWrites.load(std::memory_order_relaxed);
+        stats.framesDropped = m_framesDropped.load(std::memory_order_relaxed);
+        stats.framesSkipped = m_framesSkipped.load(std::memory_order_relaxed);
+        stats.writeErrors   = m_writeErrors.load(std::memory_order_relaxed);
+        stats.segments      = m_segments.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void start() override { m_transport->start(); }
+    void stop() override  { m_transport->stop(); }
+    eARCONTROLLER_DEVICE_STATE getLastState() override { return m_transport->getLastState(); }
+    bool waitForStateChange() override { return m_transport->waitForStateChange(); }
+
+    void registerCommandReceivedCallback(const CommandReceivedCallback &callback, void *customData) override
+    {
+        m_transport->registerCommandReceivedCallback(callback, customData);
+    }
+
+    /// The callbacks are called by the recorder after it has queued each frame
+    void registerVideoCallback(const VideoDecoderConfigCallback &decoderCallback,
+                               const VideoFrameReceivedCallback &videoCallback, void *customData) override
+    {
+        m_decoderCallback = decoderCallback;
+        m_videoCallback   = videoCallback;
+        m_videoCustomData = customData;
+        m_transport->registerVideoCallback(m_decoderConfigCallDefault, m_onFrameReceivedDefault, this);
+    }
+
+    void startVideo() override { m_transport->startVideo(); }
+    void stopVideo() override  { m_transport->stopVideo(); }
+    std::shared_ptr<VideoFrame> getFrame() override { return m_transport->getFrame(); }
+    std::shared_ptr<std::mutex> getBufferMutex() override { return m_transport->getBufferMutex(); }
+
+    void moveRelativeMetres(float dx, float dy, float dz, float heading) override
+    {
+        m_transport->moveRelativeMetres(dx, dy, dz, heading);
+    }
+
+    unsigned getBatteryLevel() override { return m_transport->getBatteryLevel(); }
+
+    bool sendPilotingSetpoint(const PilotingSetpoint &setpoint) override
+    {
+        return m_transport->sendPilotingSetpoint(setpoint);
+    }
+
+    bool sendCameraOrientation(float tilt, float pan) override
+    {
+        return m_transport->sendCameraOrientation(tilt, pan);
+    }
+
+private:
+    static constexpr int     H264_NAL_SPS   = 7;
+    static constexpr int     H264_NAL_IDR   = 5;
+    static constexpr int     H264_NAL_SLICE = 1;
+
+    /// A frame or decoder configuration waiting for the writer. The data capacity is reused.
+    struct PendingFrame {
+        uint64_t generation = 0;     ///< recording the frame belongs to
+        uint64_t receivedNs = 0;     ///< monotonic receive time
+        bool     isConfig   = false; ///< data holds the SPS followed by the PPS
+        bool     isIFrame   = false;
+        size_t   spsSize    = 0;     ///< size of the SPS in a configuration
+        std::vector<uint8_t> data;
+    };
+
+    std::shared_ptr<DroneTransport> m_transport = nullptr; ///< the recorded drone
+    const StreamRecorderOptions m_options;                 ///< configuration
+
+    VideoDecoderConfigCallback m_decoderCallback = nullptr; ///< forwarded decoder configuration callback
+    VideoFrameReceivedCallback m_videoCallback   = nullptr; ///< forwarded frame callback
+    void *m_videoCustomData = nullptr;                      ///< user data for the forwarded callbacks
+
+    RecordingSegmentCallback m_segmentCallback = nullptr;   ///< user callback for closed files
+    void *m_segmentCustomData = nullptr;                    ///< user data for m_segmentCallback
+
+    SpscQueue<PendingFrame> m_queue;          ///< filled by the ARSDK stream thread
+    std::mutex              m_controlMutex;   ///< serializes startRecording() and stopRecording()
+    std::atomic<bool>       m_recording{false};
+    std::atomic<uint64_t>   m_generation{0};  ///< incremented by each startRecording()
+    std::thread             m_writerThread;   ///< muxes the frames
+    std::mutex              m_wakeMutex;
+    std::condition_variable m_wakeCv;
+    std::atomic<bool>       m_writerWaiting{false};
+
+    // Latest decoder configuration, written by the ARSDK stream thread under m_configMutex
+    std::mutex           m_configMutex;
+    std::vector<uint8_t> m_sps;
+    std::vector<uint8_t> m_pps;
+
+    // Producer (ARSDK thread) state
+    bool m_awaitingIFrame = false; ///< a frame was dropped, frames are skipped until the next I-frame
+    bool m_configUnsent   = false; ///< the last configuration did not fit in the queue
+
+    // Writer thread state
+    std::string          m_basePath;            ///< path of the files without extension
+    uint32_t             m_segmentNumber = 0;   ///< number of the next file
+    std::vector<uint8_t> m_writerSps;           ///< configuration of the frames being muxed
+    std::vector<uint8_t> m_writerPps;
+    bool                 m_configChanged = false; ///< the next I-frame starts a new file
+    int                  m_width  = 0;          ///< picture size of m_writerSps, 0 until parsed
+    int                  m_height = 0;
+    AVFormatContext     *m_context = nullptr;   ///< the open file's muxer
+    AVStream            *m_stream  = nullptr;
+    AVPacket            *m_packet  = nullptr;
+    int                  m_fd      = -1;        ///< the open file
+    bool                 m_headerWritten = false;
+    bool                 m_segmentFailed = false; ///< a write to the open file failed
+    int64_t              m_lastPts = -1;
+    RecordingSegment     m_segment;             ///< the open file
+    std::vector<uint8_t> m_scratch;             ///< I-frames with the SPS/PPS prepended, for MPEG-TS
+
+    std::atomic<uint64_t> m_framesWritten{0};
+    std::atomic<uint64_t> m_bytesWritten{0};
+    std::atomic<uint64_t> m_diskWrites{0};
+    std::atomic<uint64_t> m_framesDropped{0};
+    std::atomic<uint64_t> m_framesSkipped{0};
+    std::atomic<uint64_t> m_writeErrors{0};
+    std::atomic<uint32_t> m_segments{0};
+
+    /// Wake the writer if it is asleep. Runs on the ARSDK stream thread.
+    void m_wake()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_writerWaiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lck(m_wakeMutex);
+            m_wakeCv.notify_one();
+        }
+    }
+
+    /// Queue the latest decoder configuration. Runs on the ARSDK stream thread.
+    /// @returns false if the queue was full
+    bool m_pushConfig(uint64_t generation)
+    {
+        return m_queue.tryPush([&](PendingFrame &pending) {
+            pending.generation = generation;
+            pending.receivedNs = monotonicNanoseconds();
+            pending.isConfig   = true;
+            pending.isIFrame   = false;
+            pending.spsSize    = m_sps.size();
+            pending.data.assign(m_sps.begin(), m_sps.end());
+            pending.data.insert(pending.data.end(), m_pps.begin(), m_pps.end());
+        });
+    }
+
+    /// Queue a compressed frame. Runs on the ARSDK stream thread.
+    void m_pushFrame(const ARCONTROLLER_Frame_t *frame)
+    {
+        const bool isIFrame = frame->isIFrame != 0;
+        if (m_awaitingIFrame && !isIFrame) {
+            m_framesSkipped++;
+            return;
+        }
+        const uint64_t generation = m_generation.load();
+        if (m_configUnsent) {
+            if (!m_pushConfig(generation)) {
+                m_framesDropped++;
+                m_awaitingIFrame = true;
+                return;
+            }
+            m_configUnsent = false;
+        }
+        const uint64_t receivedNs = monotonicNanoseconds();
+        const bool queued = m_queue.tryPush([&](PendingFrame &pending) {
+            pending.generation = generation;
+            pending.receivedNs = receivedNs;
+            pending.isConfig   = false;
+            pending.isIFrame   = isIFrame;
+            pending.spsSize    = 0;
+            pending.data.assign(frame->data, frame->data + frame->used);
+        });
+        if (!queued) {
+            m_framesDropped++;
+            m_awaitingIFrame = true;
+            return;
+        }
+        m_awaitingIFrame = false;
+        m_wake();
+    }
+
+    void m_writerLoop(uint64_t generation)
+    {
+        {
+            std::lock_guard<std::mutex> lck(m_configMutex);
+            m_writerSps = m_sps;
+            m_writerPps = m_pps;
+        }
+        m_width  = 0;
+        m_height = 0;
+        m_configChanged = false;
+
+        auto consume = [this, generation](PendingFrame &pending) {
+            // frames a late producer queued for an earlier recording are discarded
+            if (pending.generation == generation) { m_write(pending); }
+        };
+        while (true) {
+            bool wrote = false;
+            while (m_queue.tryPop(consume)) { wrote = true; }
+            if (wrote) { continue; }
+            if (!m_recording.load()) { break; }
+
+            std::unique_lock<std::mutex> lck(m_wakeMutex);
+            m_writerWaiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_wakeCv.wait_for(lck, std::chrono::milliseconds(100), [this]() {
+                return !m_recording.load() || m_queue.size() > 0;
+            });
+            m_writerWaiting.store(false, std::memory_order_relaxed);
+        }
+        m_closeSegment();
+    }
+
+    /// Mux one queued frame or configuration. Runs on the writer thread.
+    void m_write(const PendingFrame &pending)
+    {
+        if (pending.isConfig) {
+            const size_t ppsSize = pending.data.size() - pending.spsSize;
+            const bool same = m_writerSps.size() == pending.spsSize && m_writerPps.size() == ppsSize &&
+                              std::equal(m_writerSps.begin(), m_writerSps.end(), pending.data.begin()) &&
+                              std::equal(m_writerPps.begin(), m_writerPps.end(), pending.data.begin() + pending.spsSize);
+            if (!same) {
+                m_writerSps.assign(pending.data.begin(), pending.data.begin() + pending.spsSize);
+                m_writerPps.assign(pending.data.begin() + pending.spsSize, pending.data.end());
+                m_width  = 0;
+                m_height = 0;
+                m_configChanged = true;
+            }
+            return;
+        }
+
+        if (pending.isIFrame && !m_writerSps.empty() && !m_writerPps.empty()) {
+            const uint64_t segmentNs = static_cast<uint64_t>(m_options.segmentSeconds) * 1000000000ULL;
+            if (!m_context || m_configChanged ||
+                (segmentNs > 0 && pending.receivedNs - m_segment.startNs >= segmentNs)) {
+                m_closeSegment();
+                if (!m_openSegment(pending)) { m_writeErrors++; }
+            }
+        }
+        if (!m_context) {
+            m_framesSkipped++;
+            return;
+        }
+
+        const uint8_t *data = pending.data.data();
+        size_t size = pending.data.size();
+        if (pending.isIFrame && m_options.container == RecordingContainer::MPEGTS && !m_hasSps(data, size)) {
+            // each I-frame of a transport stream carries its parameter sets so playback can start there
+            m_scratch.assign(m_writerSps.begin(), m_writerSps.end());
+            m_scratch.insert(m_scratch.end(), m_writerPps.begin(), m_writerPps.end());
+            m_scratch.insert(m_scratch.end(), pending.data.begin(), pending.data.end());
+            data = m_scratch.data();
+            size = m_scratch.size();
+        }
+
+        const AVRational nanoseconds = { 1, 1000000000 };
+        int64_t pts = av_rescale_q(static_cast<int64_t>(pending.receivedNs - m_segment.startNs),
+                                   nanoseconds, m_stream->time_base);
+        if (pts <= m_lastPts) { pts = m_lastPts + 1; }
+        m_lastPts = pts;
+
+        // the packet is not reference counted, av_write_frame() muxes it without taking a copy
+        m_packet->data         = const_cast<uint8_t *>(data);
+        m_packet->size         = static_cast<int>(size);
+        m_packet->pts          = pts;
+        m_packet->dts          = pts;
+        m_packet->duration     = 0;
+        m_packet->stream_index = m_stream->index;
+        m_packet->flags        = pending.isIFrame ? AV_PKT_FLAG_KEY : 0;
+        const int ret = av_write_frame(m_context, m_packet);
+        m_packet->data = nullptr;
+        m_packet->size = 0;
+        if (ret < 0 || m_segmentFailed) {
+            // the file is closed and the recording continues in a new one at the next I-frame
+            m_writeErrors++;
+            m_segmentFailed = true;
+            m_closeSegment();
+            return;
+        }
+        m_segment.frames++;
+        m_segment.durationNs = pending.receivedNs - m_segment.startNs;
+        m_framesWritten++;
+    }
+
+    /// Check if an access unit carries an SPS before its first slice
+    static bool m_hasSps(const uint8_t *data, size_t size)
+    {
+        for (size_t i = 0; i + 3 < size; i++) {
+            if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1) { continue; }
+            const int type = data[i + 3] & 0x1f;
+            if (type == H264_NAL_SPS) { return true; }
+            if (type == H264_NAL_IDR || type == H264_NAL_SLICE) { return false; }
+            i += 2;
+        }
+        return false;
+    }
+
+    /// Find the picture size of the current configuration by parsing it with an I-frame
+    /// @returns false if the size could not be found
+    bool m_parseSize(const PendingFrame &iFrame)
+    {
+        if (m_width > 0 && m_height > 0) { return true; }
+        AVCodecParserContext *parser = av_parser_init(AV_CODEC_ID_H264);
+        AVCodecContext *context = avcodec_alloc_context3(nullptr);
+        if (parser && context) {
+            parser->flags |= PARSER_FLAG_COMPLETE_FRAMES;
+            m_scratch.assign(m_writerSps.begin(), m_writerSps.end());
+            m_scratch.insert(m_scratch.end(), m_writerPps.begin(), m_writerPps.end());
+            m_scratch.insert(m_scratch.end(), iFrame.data.begin(), iFrame.data.end());
+            m_scratch.resize(m_scratch.size() + AV_INPUT_BUFFER_PADDING_SIZE, 0);
+            uint8_t *out  = nullptr;
+            int      outSize = 0;
+            av_parser_parse2(parser, context, &out, &outSize, m_scratch.data(),
+                             static_cast<int>(m_scratch.size() - AV_INPUT_BUFFER_PADDING_SIZE),
+                             AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
+            m_width  = parser->width;
+            m_height = parser->height;
+        }
+        if (context) { avcodec_free_context(&context); }
+        if (parser)  { av_parser_close(parser); }
+        return m_width > 0 && m_height > 0;
+    }
+
+    /// Get the file name of a segment
+    std::string m_segmentPath(uint32_t segment) const
+    {
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), "_%05u", segment);
+        return m_basePath + suffix + (m_options.container == RecordingContainer::MP4 ? ".mp4" : ".ts");
+    }
+
+    /// Create the next file, starting with an I-frame
+    /// @returns false if the file could not be created
+    bool m_openSegment(const PendingFrame &iFrame)
+    {
+        if (!m_parseSize(iFrame)) { return false; }
+        m_configChanged = false;
+
+        m_segment = RecordingSegment();
+        m_segment.path    = m_segmentPath(m_segmentNumber++);
+        m_segment.startNs = iFrame.receivedNs;
+        m_segmentFailed   = false;
+        m_headerWritten   = false;
+        m_lastPts         = -1;
+
+        m_fd = open(m_segment.path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (m_fd < 0) { return false; }
+        const char *format = m_options.container == RecordingContainer::MP4 ? "mp4" : "mpegts";
+        if (avformat_alloc_output_context2(&m_context, nullptr, format, m_segment.path.c_str()) < 0 || !m_context) {
+            m_context = nullptr;
+            m_releaseSegment(true);
+            return false;
+        }
+
+        m_stream = avformat_new_stream(m_context, nullptr);
+        const size_t extradataSize = m_writerSps.size() + m_writerPps.size();
+        uint8_t *extradata = m_stream ? static_cast<uint8_t *>(av_mallocz(extradataSize + AV_INPUT_BUFFER_PADDING_SIZE))
+                                      : nullptr;
+        if (!extradata) {
+            m_releaseSegment(true);
+            return false;
+        }
+        // the Annex B parameter sets are converted to an avcC box by the MP4 muxer
+        std::memcpy(extradata, m_writerSps.data(), m_writerSps.size());
+        std::memcpy(extradata + m_writerSps.size(), m_writerPps.data(), m_writerPps.size());
+        AVCodecParameters *codecpar = m_stream->codecpar;
+        codecpar->codec_type     = AVMEDIA_TYPE_VIDEO;
+        codecpar->codec_id       = AV_CODEC_ID_H264;
+        codecpar->width          = m_width;
+        codecpar->height         = m_height;
+        codecpar->extradata      = extradata;
+        codecpar->extradata_size = static_cast<int>(extradataSize);
+        m_stream->time_base      = AVRational{ 1, 90000 };
+
+        // the muxer writes through our buffer, so the file sees writeBufferBytes sized writes
+        unsigned char *buffer = static_cast<unsigned char *>(av_malloc(m_options.writeBufferBytes));
+        AVIOContext *io = buffer ? avio_alloc_context(buffer, static_cast<int>(m_options.writeBufferBytes), 1, this,
+                                                      nullptr, m_writePacketDefault, m_seekDefault)
+                                 : nullptr;
+        if (!io) {
+            av_free(buffer);
+            m_releaseSegment(true);
+            return false;
+        }
+        m_context->pb     = io;
+        m_context->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+        AVDictionary *muxerOptions = nullptr;
+        if (m_options.container == RecordingContainer::MP4 && m_options.fragmentedMp4) {
+            av_dict_set(&muxerOptions, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+        }
+        const int ret = avformat_write_header(m_context, &muxerOptions);
+        av_dict_free(&muxerOptions);
+        if (ret < 0) {
+            m_releaseSegment(true);
+            return false;
+        }
+        m_headerWritten = true;
+        m_segments++;
+        return true;
+    }
+
+    /// Finish the current file and report it
+    void m_closeSegment()
+    {
+        if (!m_context) { return; }
+        if (m_headerWritten && av_write_trailer(m_context) < 0) { m_segmentFailed = true; }
+        avio_flush(m_context->pb);
+        struct stat info;
+        if (fstat(m_fd, &info) == 0) { m_segment.bytes = static_cast<uint64_t>(info.st_size); }
+        m_segment.complete = !m_segmentFailed;
+        m_releaseSegment(false);
+        if (m_segmentCallback) { m_segmentCallback(m_segment, m_segmentCustomData); }
+    }
+
+    /// Free the muxer and close the file
+    /// @param remove true to delete the file, when it could not be started
+    void m_releaseSegment(bool remove)
+    {
+        if (m_context) {
+            if (m_context->pb) {
+                av_freep(&m_context->pb->buffer);
+                avio_context_free(&m_context->pb);
+            }
+            avformat_free_context(m_context);
+            m_context = nullptr;
+        }
+        m_stream = nullptr;
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+        if (remove) { unlink(m_segment.path.c_str()); }
+    }
+
+    /// Muxer output callback, writes a full buffer to the file. Runs on the writer thread.
+    /// @param opaque a pointer to an instance of StreamRecorder
+    /// @param buffer the muxed bytes
+    /// @param size number of bytes
+    /// @returns size, or a negative AVERROR
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+    static int m_writePacketDefault(void *opaque, const uint8_t *buffer, int size)
+#else
+    static int m_writePacketDefault(void *opaque, uint8_t *buffer, int size)
+#endif
+    {
+        StreamRecorder *recorder = static_cast<StreamRecorder *>(opaque);
+        size_t written = 0;
+        while (written < static_cast<size_t>(size)) {
+            const ssize_t ret = ::write(recorder->m_fd, buffer + written, static_cast<size_t>(size) - written);
+            if (ret < 0) {
+                if (errno == EINTR) { continue; }
+                recorder->m_segmentFailed = true;
+                return AVERROR(errno);
+            }
+            written += static_cast<size_t>(ret);
+            recorder->m_diskWrites++;
+        }
+        recorder->m_bytesWritten += written;
+        return size;
+    }
+
+    /// Muxer seek callback, used when a non-fragmented MP4 is finished
+    /// @param opaque a pointer to an instance of StreamRecorder
+    /// @param offset the position
+    /// @param whence SEEK_SET, SEEK_CUR, SEEK_END or AVSEEK_SIZE
+    /// @returns the new position or file size, or a negative AVERROR
+    static int64_t m_seekDefault(void *opaque, int64_t offset, int whence)
+    {
+        StreamRecorder *recorder = static_cast<StreamRecorder *>(opaque);
+        if (whence == AVSEEK_SIZE) {
+            struct stat info;
+            return fstat(recorder->m_fd, &info) == 0 ? static_cast<int64_t>(info.st_size) : AVERROR(errno);
+        }
+        const off_t position = lseek(recorder->m_fd, static_cast<off_t>(offset), whence);
+        return position < 0 ? AVERROR(errno) : static_cast<int64_t>(position);
+    }
+
+    /// Decoder configuration callback, runs on the ARSDK stream thread
+    /// @param codec ARSDK3 codec
+    /// @param customData a pointer to an instance of StreamRecorder
+    static eARCONTROLLER_ERROR m_decoderConfigCallDefault(ARCONTROLLER_Stream_Codec_t codec, void *customData)
+    {
+        StreamRecorder *recorder = static_cast<StreamRecorder *>(customData);
+        if (!recorder) { return ARCONTROLLER_ERROR; }
+        const auto &h264 = codec.parameters.h264parameters;
+        if (codec.type == ARCONTROLLER_STREAM_CODEC_TYPE_H264 && h264.spsBuffer && h264.spsSize > 0 &&
+            h264.ppsBuffer && h264.ppsSize > 0) {
+            {
+                std::lock_guard<std::mutex> lck(recorder->m_configMutex);
+                recorder->m_sps.assign(h264.spsBuffer, h264.spsBuffer + h264.spsSize);
+                recorder->m_pps.assign(h264.ppsBuffer, h264.ppsBuffer + h264.ppsSize);
+            }
+            if (recorder->m_recording.load()) {
+                if (recorder->m_pushConfig(recorder->m_generation.load())) {
+                    recorder->m_configUnsent = false;
+                    recorder->m_wake();
+                } else {
+                    recorder->m_framesDropped++;
+                    recorder->m_configUnsent   = true;
+                    recorder->m_awaitingIFrame = true;
+                }
+            }
+        }
+        return recorder->m_decoderCallback ? recorder->m_decoderCallback(codec, recorder->m_videoCustomData) : ARCONTROLLER_OK;
+    }
+
+    /// Frame callback, runs on the ARSDK stream thread
+    /// @param frame pointer to a ARSDK3 frame
+    /// @param customData a pointer to an instance of StreamRecorder
+    static eARCONTROLLER_ERROR m_onFrameReceivedDefault(ARCONTROLLER_Frame_t *frame, void *customData)
+    {
+        StreamRecorder *recorder = static_cast<StreamRecorder *>(customData);
+        if (!recorder || !frame) { return ARCONTROLLER_ERROR; }
+        if (frame->data && frame->used > 0 && recorder->m_recording.load()) {
+            recorder->m_pushFrame(frame);
+        }
+        return recorder->m_videoCallback ? recorder->m_videoCallback(frame, recorder->m_videoCustomData) : ARCONTROLLER_OK;
+    }
+};
+
+} // wscDrone
+
+#endif /* STREAMRECORDER_H_ */
@@ -0,0 +1,329 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains the TelemetryCache, a typed store of the drone
+ * state reported through the ARSDK command-received callback.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libARController/ARController.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "DroneController.h"
+#include "DroneTransport.h"
+#include "SeqLock.h"
+#include "Utils.h"
+
+namespace wscDrone {
+
+// Every snapshot carries the monotonic time it was received, 0 until the drone first reports it.
+
+/// Battery state
+struct BatteryTelemetry {
+    uint64_t timestampNs = 0; ///< monotonic receive time
+    unsigned percent     = 0; ///< battery level, 0 to 100
+};
+
+/// Piloting flying state
+struct FlyingStateTelemetry {
+    uint64_t timestampNs = 0; ///< monotonic receive time
+    eARCOMMANDS_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE state =
+        ARCOMMANDS_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE_LANDED; ///< the flying state
+};
+
+/// Attitude in radians
+struct AttitudeTelemetry {
+    uint64_t timestampNs = 0; ///< monotonic receive time
+    float roll  = 0.0f;       ///< roll in radians
+    float pitch = 0.0f;       ///< pitch in radians
+    float yaw   = 0.0f;       ///< yaw in radians
+};
+
+/// GPS position. The drone reports 500.0 for each field when it has no fix.
+struct PositionTelemetry {
+    uint64_t timestampNs = 0; ///< monotonic receive time
+    double latitude  = 500.0; ///< latitude in degrees
+    double longitude = 500.0; ///< longitude in degrees
+    double altitude  = 500.0; ///< altitude in metres above sea level
+};
+
+/// Speed in the NED frame
+struct SpeedTelemetry {
+    uint64_t timestampNs = 0; ///< monotonic receive time
+    float speedX = 0.0f;      ///< north speed in m/s
+    float speedY = 0.0f;      ///< east speed in m/s
+    float speedZ = 0.0f;      ///< down speed in m/s
+};
+
+/// Altitude above the take-off point
+struct AltitudeTelemetry {
+    uint64_t timestampNs = 0; ///< monotonic receive time
+    double altitude = 0.0;    ///< altitude in metres
+};
+
+/// Current camera orientation
+struct CameraOrientationTelemetry {
+    uint64_t timestampNs = 0; ///< monotonic receive time
+    float tilt = 0.0f;        ///< tilt in degrees
+    float pan  = 0.0f;        ///< pan in degrees
+};
+
+/// Camera field of view and orientation limits
+struct CameraSettingsTelemetry {
+    uint64_t timestampNs = 0; ///< monotonic receive time
+    float fov     = 0.0f;     ///< horizontal field of view in degrees
+    float panMax  = 0.0f;     ///< maximum pan in degrees
+    float panMin  = 0.0f;     ///< minimum pan in degrees
+    float tiltMax = 0.0f;     ///< maximum tilt in degrees
+    float tiltMin = 0.0f;     ///< minimum tilt in degrees
+};
+
+/// Picture or video recording state, as the raw ARSDK state and error enumerations
+struct MediaStateTelemetry {
+    uint64_t timestampNs = 0; ///< monotonic receive time
+    int state = 0;            ///< ARSDK state value
+    int error = 0;            ///< ARSDK error value
+};
+
+/// A typed cache of drone telemetry. The ARSDK command callback thread writes each snapshot through a
+/// SeqLock, and any number of reader threads get a consistent, timestamped copy without taking a lock.
+/// @details This replaces polling the unsynchronized members updated by the Bebop2, Pilot and
+/// CameraControl callbacks, e.g. from a control loop. attach() adds the cache's callback to a
+/// DroneController; ARSDK keeps a list of command callbacks, so the existing library callbacks keep
+/// working. A user command callback can also forward to onCommandReceived() instead.
+class TelemetryCache {
+public:
+    TelemetryCache() = default;
+    TelemetryCache(const TelemetryCache &) = delete;
+    TelemetryCache &operator=(const TelemetryCache &) = delete;
+
+    /// Register the cache's command callback with a DroneController. The cache must outlive the
+    /// controller's command stream.
+    /// @param droneController smart pointer to the controller to listen to
+    void attach(std::shared_ptr<DroneController> droneController)
+    {
+        droneController->registerCommandReceivedCallback(m_onCommandReceivedDefault, this);
+    }
+
+    /// Register the cache's command callback with a DroneTransport, e.g. a SimulatedDrone
+    /// @param transport smart pointer to the transport to listen to
+    void attach(std::shared_ptr<DroneTransport> transport)
+    {
+        transport->registerCommandReceivedCallback(m_onCommandReceivedDefault, this);
+    }
+
+    /// Update the cache from one received command. Called on the ARSDK command thread.
+    /// @param commandKey the ARSDK command key
+    /// @param elementDictionary the ARSDK argument dictionary
+    void onCommandReceived(eARCONTROLLER_DICTIONARY_KEY commandKey, ARCONTROLLER_DICTIONARY_ELEMENT_t *elementDictionary)
+    {
+        if (!elementDictionary) { return; }
+        ARCONTROLLER_DICTIONARY_ELEMENT_t *element = nullptr;
+        HASH_FIND_STR(elementDictionary, ARCONTROLLER_DICTIONARY_SINGLE_KEY, element);
+        if (!element) { return; }
+        const uint64_t nowNs = monotonicNanoseconds();
+
+        switch (commandKey) {
+        case ARCONTROLLER_DICTIONARY_KEY_COMMON_COMMONSTATE_BATTERYSTATECHANGED :
+        {
+            BatteryTelemetry battery;
+            battery.timestampNs = nowNs;
+            battery.percent = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_COMMON_COMMONSTATE_BATTERYSTATECHANGED_PERCENT).U8;
+            m_battery.store(battery);
+            break;
+        }
+        case ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED :
+        {
+            FlyingStateTelemetry flying;
+            flying.timestampNs = nowNs;
+            flying.state = static_cast<eARCOMMANDS_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE>(
+                m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_FLYINGSTATECHANGED_STATE).I32);
+            m_flyingState.store(flying);
+            break;
+        }
+        case ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED :
+        {
+            AttitudeTelemetry attitude;
+            attitude.timestampNs = nowNs;
+            attitude.roll  = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED_ROLL).Float;
+            attitude.pitch = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED_PITCH).Float;
+            attitude.yaw   = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ATTITUDECHANGED_YAW).Float;
+            m_attitude.store(attitude);
+            break;
+        }
+        case ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED :
+        {
+            PositionTelemetry position;
+            position.timestampNs = nowNs;
+            position.latitude  = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED_LATITUDE).Double;
+            position.longitude = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED_LONGITUDE).Double;
+            position.altitude  = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_POSITIONCHANGED_ALTITUDE).Double;
+            m_position.store(position);
+            break;
+        }
+        case ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED :
+        {
+            SpeedTelemetry speed;
+            speed.timestampNs = nowNs;
+            speed.speedX = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED_SPEEDX).Float;
+            speed.speedY = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED_SPEEDY).Float;
+            speed.speedZ = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_SPEEDCHANGED_SPEEDZ).Float;
+            m_speed.store(speed);
+            break;
+        }
+        case ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ALTITUDECHANGED :
+        {
+            AltitudeTelemetry altitude;
+            altitude.timestampNs = nowNs;
+            altitude.altitude = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_PILOTINGSTATE_ALTITUDECHANGED_ALTITUDE).Double;
+            m_altitude.store(altitude);
+            break;
+        }
+        case ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_CAMERASTATE_ORIENTATIONV2 :
+        {
+            CameraOrientationTelemetry orientation;
+            orientation.timestampNs = nowNs;
+            orientation.tilt = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_CAMERASTATE_ORIENTATIONV2_TILT).Float;
+            orientation.pan  = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_CAMERASTATE_ORIENTATIONV2_PAN).Float;
+            m_cameraOrientation.store(orientation);
+            break;
+        }
+        case ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED :
+        {
+            CameraSettingsTelemetry settings;
+            settings.timestampNs = nowNs;
+            settings.fov     = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_FOV).Float;
+            settings.panMax  = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_PANMAX).Float;
+            settings.panMin  = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_PANMIN).Float;
+            settings.tiltMax = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_TILTMAX).Float;
+            settings.tiltMin = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_COMMON_CAMERASETTINGSSTATE_CAMERASETTINGSCHANGED_TILTMIN).Float;
+            m_cameraSettings.store(settings);
+            break;
+        }
+        case ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDSTATE_PICTURESTATECHANGEDV2 :
+        {
+            MediaStateTelemetry picture;
+            picture.timestampNs = nowNs;
+            picture.state = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDSTATE_PICTURESTATECHANGEDV2_STATE).I32;
+            picture.error = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDSTATE_PICTURESTATECHANGEDV2_ERROR).I32;
+            m_pictureState.store(picture);
+            break;
+        }
+        case ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDSTATE_VIDEOSTATECHANGEDV2 :
+        {
+            MediaStateTelemetry video;
+            video.timestampNs = nowNs;
+            video.state = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDSTATE_VIDEOSTATECHANGEDV2_STATE).I32;
+            video.error = m_argument(element, ARCONTROLLER_DICTIONARY_KEY_ARDRONE3_MEDIARECORDSTATE_VIDEOSTATECHANGEDV2_ERROR).I32;
+            m_videoState.store(video);
+            break;
+        }
+        default :
+            break;
+        }
+    }
+
+    /// Get the latest battery state
+    /// @returns the battery snapshot
+    BatteryTelemetry getBattery() const { return m_battery.load(); }
+
+    /// Get the latest flying state
+    /// @returns the flying state snapshot
+    FlyingStateTelemetry getFlyingState() const { return m_flyingState.load(); }
+
+    /// Get the latest attitude
+    /// @returns the attitude snapshot
+    AttitudeTelemetry getAttitude() const { return m_attitude.load(); }
+
+    /// Get the latest GPS position
+    /// @returns the position snapshot
+    PositionTelemetry getPosition() const { return m_position.load(); }
+
+    /// Get the latest speed
+    /// @returns the speed snapshot
+    SpeedTelemetry getSpeed() const { return m_speed.load(); }
+
+    /// Get the latest altitude above the take-off point
+    /// @returns the altitude snapshot
+    AltitudeTelemetry getAltitude() const { return m_altitude.load(); }
+
+    /// Get the latest camera orientation
+    /// @returns the orientation snapshot
+    CameraOrientationTelemetry getCameraOrientation() const { return m_cameraOrientation.load(); }
+
+    /// Get the latest camera field of view and limits
+    /// @returns the camera settings snapshot
+    CameraSettingsTelemetry getCameraSettings() const { return m_cameraSettings.load(); }
+
+    /// Get the latest picture state
+    /// @returns the picture state snapshot
+    MediaStateTelemetry getPictureState() const { return m_pictureState.load(); }
+
+    /// Get the latest video recording state
+    /// @returns the video recording state snapshot
+    MediaStateTelemetry getVideoRecordState() const { return m_videoState.load(); }
+
+private:
+    SeqLock<BatteryTelemetry>           m_battery;           ///< battery state
+    SeqLock<FlyingStateTelemetry>       m_flyingState;       ///< flying state
+    SeqLock<AttitudeTelemetry>          m_attitude;          ///< attitude
+    SeqLock<PositionTelemetry>          m_position;          ///< GPS position
+    SeqLock<SpeedTelemetry>             m_speed;             ///< speed
+    SeqLock<AltitudeTelemetry>          m_altitude;          ///< altitude
+    SeqLock<CameraOrientationTelemetry> m_cameraOrientation; ///< camera orientation
+    SeqLock<CameraSettingsTelemetry>    m_cameraSettings;    ///< camera field of view and limits
+    SeqLock<MediaStateTelemetry>        m_pictureState;      ///< picture state
+    SeqLock<MediaStateTelemetry>        m_videoState;        ///< video recording state
+
+    /// Look up one argument of a command
+    /// @param element the single-key dictionary element
+    /// @param name the ARSDK argument name
+    /// @returns the argument value, zero if it is missing
+    static ARCONTROLLER_DICTIONARY_VALUE_t m_argument(ARCONTROLLER_DICTIONARY_ELEMENT_t *element, const char *name)
+    {
+        ARCONTROLLER_DICTIONARY_ARG_t *arg = nullptr;
+        HASH_FIND_STR(element->arguments, name, arg);
+        if (!arg) {
+            ARCONTROLLER_DICTIONARY_VALUE_t zero;
+            std::memset(&zero, 0, sizeof(zero));
+            return zero;
+        }
+        return arg->value;
+    }
+
+    /// Command callback registered by attach()
+    /// @param commandKey the ARSDK command key
+    /// @param elementDictionary the ARSDK argument dictionary
+    /// @param customData a pointer to an instance of TelemetryCache
+    static void m_onCommandReceivedDefault(eARCONTROLLER_DICTIONARY_KEY commandKey,
+                                           ARCONTROLLER_DICTIONARY_ELEMENT_t *elementDictionary, void *customData)
+    {
+        TelemetryCache *cache = static_cast<TelemetryCache *>(customData);
+        if (cache) { cache->onCommandReceived(commandKey, elementDictionary); }
+    }
+};
+
+} // wscDrone
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,231 @@
+/****************************************************************************//**
+ * @file
+ * @brief This file contains a triple-buffered VideoFrame implementation that
+ * lets the decoder and a consumer exchange frames without locks or copies.
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#ifndef TRIPLEBUFFERFRAME_H_
+#define TRIPLEBUFFERFRAME_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "PixelFormat.h"
+#include "VideoFrame.h"
+
+namespace wscDrone {
+
+/// A read-only view of one published frame
+struct FrameView {
+    const uint8_t *data        = nullptr; ///< pointer to the pixel bytes
+    size_t         sizeBytes   = 0;       ///< size of the pixel data in bytes
+    unsigned       width       = 0;       ///< width in pixels
+    unsigned       height      = 0;       ///< height in lines
+    uint64_t       sequence    = 0;       ///< frame sequence number assigned by the publisher
+    uint64_t       timestampNs = 0;       ///< monotonic timestamp assigned by the publisher
+    PixelFormat    format      = PixelFormat::RGB24; ///< pixel format of the data
+    const uint8_t *planes[MAX_PLANES]  = {}; ///< pointer to the first line of each plane
+    int            strides[MAX_PLANES] = {}; ///< bytes per line of each plane
+    unsigned       numPlanes   = 0;       ///< number of planes in use
+
+    /// Check if the view refers to a published frame
+    /// @returns false until the first frame has been published
+    bool valid() const { return data != nullptr; }
+};
+
+/// A VideoFrame made of rotating buffers. The writer fills the back buffer and publishes it. Each reader
+/// acquires the most recently published buffer. Neither side ever waits for the other and no pixel
+/// data is copied between them.
+/// @details There is one writer thread and a fixed number of reader threads, each identified by a reader
+/// index. With one reader this is a classic triple buffer; every further reader adds one buffer, so the
+/// writer always finds a buffer that is neither the latest nor held by a reader. A reader holds its
+/// buffer by announcing its index, then checks that the buffer is still the latest and retries if not,
+/// so acquiring never blocks the writer. A view returned by acquireLatest() remains valid until the same
+/// reader calls acquireLatest() again. getRawPointer() returns the writer's back buffer, which makes
+/// this class a drop-in frame for DecodePipeline.
+class TripleBufferFrame : public VideoFrame {
+public:
+    TripleBufferFrame() = delete;
+
+    /// Construct a triple buffered frame of specified height and width.
+    /// @param height height in lines
+    /// @param width width in pixels
+    /// @param format pixel format of the buffers, planes are laid out as getPlaneLayout() describes
+    /// @param readers number of reader threads, each uses the reader index from 0 to readers - 1
+    TripleBufferFrame(unsigned height, unsigned width, PixelFormat format = PixelFormat::RGB24, unsigned readers = 1)
+        : VideoFrame(height, width), m_height(height), m_width(width), m_format(format),
+          m_layout(wscDrone::getPlaneLayout(format, width, height)), m_frameSizeBytes(m_layout.totalBytes),
+          m_numReaders(readers), m_numBuffers(readers + 2)
+    {
+        if (readers == 0 || readers > MAX_READERS) {
+            throw std::invalid_argument("TripleBufferFrame: readers must be from 1 to " + std::to_string(MAX_READERS));
+        }
+        m_buffers.reset(new Buffer[m_numBuffers]);
+        for (unsigned i = 0; i < m_numBuffers; i++) {
+            m_buffers[i].data.reset(new uint8_t[m_frameSizeBytes]());
+        }
+        m_readers.reset(new Reader[m_numReaders]);
+    }
+    virtual ~TripleBufferFrame() = default;
+
+    /// Get the height of the VideoFrame object
+    /// @returns the height in lines
+    unsigned getHeight() override { return m_height; }
+
+    /// Get the width of the VideoFrame object
+    /// @returns the width in pixels
+    unsigned getWidth() override { return m_width; }
+
+    /// Get raw pointer to the writer's back buffer
+    /// @returns a char* pointer to the raw pixel bytes
+    char *getRawPointer() override { return reinterpret_cast<char *>(getWriteBuffer()); }
+
+    /// Get the size in bytes of one buffer
+    /// @returns the size in bytes
+    size_t getFrameSizeBytes() override { return m_frameSizeBytes; }
+
+    /// Get the pixel format of the buffers
+    /// @returns the pixel format
+    PixelFormat getFormat() const { return m_format; }
+
+    /// Get the layout of the planes within each buffer
+    /// @returns the plane layout
+    const PlaneLayout &getPlaneLayout() const { return m_layout; }
+
+    /// Get the back buffer for the writer to fill. Writer thread only.
+    /// @returns pointer to getFrameSizeBytes() writable bytes
+    uint8_t *getWriteBuffer() { return m_buffers[m_back].data.get(); }
+
+    /// Get the number of reader threads
+    /// @returns the number of reader indexes
+    unsigned getNumReaders() const { return m_numReaders; }
+
+    /// Publish the back buffer as the latest frame and take a new back buffer. Writer thread only.
+    /// @param sequence frame sequence number to attach to the frame
+    /// @param timestampNs monotonic timestamp to attach to the frame
+    void publish(uint64_t sequence, uint64_t timestampNs)
+    {
+        Buffer &buffer = m_buffers[m_back];
+        buffer.sequence    = sequence;
+        buffer.timestampNs = timestampNs;
+        buffer.published   = m_published.load(std::memory_order_relaxed) + 1;
+        m_latest.store(m_back, std::memory_order_seq_cst);
+        m_published.store(buffer.published, std::memory_order_relaxed);
+
+        // a reader announces its buffer before checking it is still the latest, so a buffer that is
+        // not announced here cannot be taken by a reader until it is published again
+        for (unsigned candidate = 0; candidate < m_numBuffers; candidate++) {
+            if (candidate == m_back || m_isHeld(candidate)) { continue; }
+            m_back = candidate;
+            return;
+        }
+    }
+
+    /// Acquire the most recently published frame. Thread of the given reader only.
+    /// @param reader the reader index, from 0 to getNumReaders() - 1
+    /// @returns a view of the latest frame, or the previously acquired frame if nothing new has been
+    /// published. The view is invalid until the first publish.
+    FrameView acquireLatest(unsigned reader = 0)
+    {
+        Reader &state = m_readers[reader];
+        unsigned latest = m_latest.load(std::memory_order_seq_cst);
+        if (latest != NO_BUFFER && latest != state.front) {
+            while (true) {
+                state.held.store(latest, std::memory_order_seq_cst);
+                const unsigned check = m_latest.load(std::memory_order_seq_cst);
+                if (check == latest) { break; }
+                latest = check;
+            }
+            state.front = latest;
+            state.acquired.store(m_buffers[latest].published, std::memory_order_relaxed);
+        }
+
+        FrameView view;
+        if (state.front != NO_BUFFER) {
+            const Buffer &buffer = m_buffers[state.front];
+            view.data        = buffer.data.get();
+            view.sizeBytes   = m_frameSizeBytes;
+            view.width       = m_width;
+            view.height      = m_height;
+            view.sequence    = buffer.sequence;
+            view.timestampNs = buffer.timestampNs;
+            view.format      = m_format;
+            view.numPlanes   = m_layout.numPlanes;
+            for (unsigned plane = 0; plane < m_layout.numPlanes; plane++) {
+                view.planes[plane]  = view.data + m_layout.offset[plane];
+                view.strides[plane] = m_layout.stride[plane];
+            }
+        }
+        return view;
+    }
+
+    /// Check if a frame has been published since a reader's last acquireLatest(). Safe from any thread.
+    /// @param reader the reader index
+    /// @returns true when a newer frame is available
+    bool hasNewFrame(unsigned reader = 0) const
+    {
+        return m_published.load(std::memory_order_relaxed) != m_readers[reader].acquired.load(std::memory_order_relaxed);
+    }
+
+    /// Get the number of frames published so far. Safe from any thread.
+    /// @returns the publish count
+    uint64_t getPublishedCount() const { return m_published.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr unsigned MAX_READERS = 16;
+    static constexpr unsigned NO_BUFFER   = ~0u;
+
+    struct Buffer {
+        std::unique_ptr<uint8_t[]> data;     ///< pixel storage
+        uint64_t sequence    = 0;            ///< sequence number of the frame in this buffer
+        uint64_t timestampNs = 0;            ///< timestamp of the frame in this buffer
+        uint64_t published   = 0;            ///< publish count when the frame was published
+    };
+
+    /// State of one reader
+    struct Reader {
+        std::atomic<unsigned> held{NO_BUFFER};  ///< buffer the reader holds or is about to hold
+        std::atomic<uint64_t> acquired{0};      ///< publish count of the reader's buffer
+        unsigned front = NO_BUFFER;             ///< buffer of the reader's current view
+    };
+
+    /// Check if any reader holds a buffer. Writer thread only.
+    bool m_isHeld(unsigned buffer) const
+    {
+        for (unsigned reader = 0; reader < m_numReaders; reader++) {
+            if (m_readers[reader].held.load(std::memory_order_seq_cst) == buffer) { return true; }
+        }
+        return false;
+    }
+
+    unsigned m_height;                       ///< height in lines
+    unsigned m_width;                        ///< width in pixels
+    PixelFormat m_format;                    ///< pixel format of the buffers
+    PlaneLayout m_layout;                    ///< plane layout within each buffer
+    size_t   m_frameSizeBytes;               ///< bytes per buffer
+    unsigned m_numReaders;                   ///< number of reader indexes
+    unsigned m_numBuffers;                   ///< one per reader, the latest and the back buffer
+    std::unique_ptr<Buffer[]> m_buffers;     ///< the buffers
+    std::unique_ptr<Reader[]> m_readers;     ///< per reader state
+
+    unsigned m_back = 0;                     ///< writer-owned buffer index
+    std::atomic<unsigned> m_latest{NO_BUFFER}; ///< most recently published buffer
+    std::atomic<uint64_t> m_published{0};    ///< number of publish() calls
+};
+
+} // wscDrone
+
+#endif /* TRIPLEBUFFERFRAME_H_ */
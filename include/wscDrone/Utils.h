@@ -16,6 +16,8 @@
 #define SRC_UTILS_H_
 
 #include <cmath>
+#include <chrono>
+#include <cstdint>
 
 namespace wscDrone {
 
@@ -36,6 +38,14 @@ void waitMilliseconds(int milliseconds);
 /// @returns the angle converted to radians
 float degressToRadians(float degrees);
 
+/// Read the monotonic clock used for all timestamps and latency measurements in the library
+/// @returns nanoseconds since an arbitrary, fixed epoch
+inline uint64_t monotonicNanoseconds()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
 } // wscDrone
 
 #endif /* SRC_UTILS_H_ */
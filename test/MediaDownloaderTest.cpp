@@ -0,0 +1,567 @@
+/****************************************************************************//**
+ * @file
+ * @brief Tests MediaDownloader against an in-process FTP stand-in. It checks
+ * resume via REST, a server that refuses REST, a size mismatch and reconnecting
+ * after a dropped connection.
+ * Build and run with the ARSDK headers on the include path:
+ * g++ -std=c++14 -O2 -pthread -Iinclude -I<ARSDK>/usr/include test/MediaDownloaderTest.cpp
+ * -o MediaDownloaderTest && ./MediaDownloaderTest
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "wscDrone/MediaDownloader.h"
+
+namespace {
+
+using namespace wscDrone;
+
+unsigned g_failures = 0;
+
+void check(bool condition, const std::string &test, const char *what)
+{
+    if (!condition) {
+        std::printf("FAIL %s: %s\n", test.c_str(), what);
+        g_failures++;
+    }
+}
+
+/// A passive mode FTP server on the loopback interface serving files from memory. Each control
+/// connection runs on its own thread. Files and faults are set up before start().
+class FtpStandIn {
+public:
+    std::map<std::string, std::string> files;        ///< contents by name, the directory is ignored
+    bool refuseRest = false;                         ///< reply 502 to REST
+    std::map<std::string, size_t> dropConnection;   ///< close data and control after this many bytes, once
+    std::map<std::string, size_t> abortTransfer;    ///< close data after this many bytes and reply 426, once
+    std::map<std::string, unsigned> wrongSize;      ///< SIZE replies that report one byte too many
+
+    FtpStandIn() { m_listen = m_listenLoopback(m_port); }
+
+    ~FtpStandIn()
+    {
+        m_stopping = true;
+        ::shutdown(m_listen, SHUT_RDWR);
+        if (m_acceptThread.joinable()) { m_acceptThread.join(); }
+        ::close(m_listen);
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lck(m_mutex);
+            for (int fd : m_controls) { ::shutdown(fd, SHUT_RDWR); }
+            threads.swap(m_threads);
+        }
+        for (auto &thread : threads) { thread.join(); }
+    }
+
+    /// Start accepting connections
+    void start() { m_acceptThread = std::thread(&FtpStandIn::m_acceptLoop, this); }
+
+    uint16_t getPort() const { return m_port; }
+
+    /// Get the control connections accepted so far
+    unsigned getConnections() const { return m_connections.load(); }
+
+    /// Get the commands received so far, e.g. "REST 1000"
+    std::vector<std::string> getCommands()
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        return m_commands;
+    }
+
+private:
+    int m_listen = -1;
+    uint16_t m_port = 0;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<unsigned> m_connections{0};
+    std::thread m_acceptThread;
+    std::mutex m_mutex;                 ///< protects the fault maps and everything below
+    std::vector<std::thread> m_threads;
+    std::vector<int> m_controls;
+    std::vector<std::string> m_commands;
+
+    static int m_listenLoopback(uint16_t &port)
+    {
+        const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in address{};
+        address.sin_family      = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr *>(&address), length) != 0 || ::listen(fd, 16) != 0 ||
+            ::getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length) != 0) {
+            std::perror("FtpStandIn: listen");
+            std::exit(2);
+        }
+        port = ntohs(address.sin_port);
+        return fd;
+    }
+
+    static void m_sendAll(int fd, const std::string &data)
+    {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) { return; }
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    static void m_reply(int fd, const std::string &line) { m_sendAll(fd, line + "\r\n"); }
+
+    static std::string m_baseName(const std::string &path)
+    {
+        const size_t slash = path.rfind('/');
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    /// Take one injected fault for a file
+    template <typename T>
+    bool m_takeFault(std::map<std::string, T> &faults, const std::string &name, T &value)
+    {
+        std::lock_guard<std::mutex> lck(m_mutex);
+        auto fault = faults.find(name);
+        if (fault == faults.end()) { return false; }
+        value = fault->second;
+        faults.erase(fault);
+        return true;
+    }
+
+    void m_acceptLoop()
+    {
+        while (!m_stopping) {
+            const int fd = ::accept4(m_listen, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) { continue; }
+            m_connections++;
+            std::lock_guard<std::mutex> lck(m_mutex);
+            m_controls.push_back(fd);
+            m_threads.emplace_back(&FtpStandIn::m_serve, this, fd);
+        }
+    }
+
+    void m_serve(int control)
+    {
+        std::string received;
+        int passive = -1;
+        uint64_t rest = 0;
+        m_reply(control, "220 FtpStandIn ready");
+        while (true) {
+            const size_t end = received.find("\r\n");
+            if (end == std::string::npos) {
+                char buffer[256];
+                const ssize_t n = ::recv(control, buffer, sizeof(buffer), 0);
+                if (n <= 0) { break; }
+                received.append(buffer, static_cast<size_t>(n));
+                continue;
+            }
+            const std::string line = received.substr(0, end);
+            received.erase(0, end + 2);
+            const size_t space = line.find(' ');
+            const std::string command  = line.substr(0, space);
+            const std::string argument = space == std::string::npos ? "" : line.substr(space + 1);
+            {
+                std::lock_guard<std::mutex> lck(m_mutex);
+                m_commands.push_back(line);
+            }
+
+            if (command == "USER") {
+                m_reply(control, "331 Password required");
+            } else if (command == "PASS") {
+                m_reply(control, "230 Logged in");
+            } else if (command == "TYPE") {
+                m_reply(control, "200 Type set");
+            } else if (command == "PASV") {
+                if (passive >= 0) { ::close(passive); }
+                uint16_t port = 0;
+                passive = m_listenLoopback(port);
+                m_reply(control, "227 Entering Passive Mode (127,0,0,1," + std::to_string(port >> 8) + "," +
+                                 std::to_string(port & 0xff) + ")");
+            } else if (command == "REST") {
+                if (refuseRest) {
+                    m_reply(control, "502 REST not implemented");
+                } else {
+                    rest = std::strtoull(argument.c_str(), nullptr, 10);
+                    m_reply(control, "350 Restarting at " + argument);
+                }
+            } else if (command == "SIZE") {
+                std::string contents;
+                bool found = false;
+                unsigned wrong = 0;
+                {
+                    std::lock_guard<std::mutex> lck(m_mutex);
+                    auto file = files.find(m_baseName(argument));
+                    if ((found = file != files.end())) { contents = file->second; }
+                    auto fault = wrongSize.find(m_baseName(argument));
+                    if (fault != wrongSize.end() && fault->second > 0) {
+                        fault->second--;
+                        wrong = 1;
+                    }
+                }
+                m_reply(control, found ? "213 " + std::to_string(contents.size() + wrong) : "550 No such file");
+            } else if (command == "RETR" || command == "NLST") {
+                if (passive < 0) {
+                    m_reply(control, "425 Use PASV first");
+                    continue;
+                }
+                const int data = ::accept4(passive, nullptr, nullptr, SOCK_CLOEXEC);
+                ::close(passive);
+                passive = -1;
+                if (data < 0) {
+                    m_reply(control, "425 No data connection");
+                    continue;
+                }
+
+                std::string contents;
+                bool found = true;
+                {
+                    std::lock_guard<std::mutex> lck(m_mutex);
+                    if (command == "NLST") {
+                        for (const auto &file : files) { contents += file.first + "\r\n"; }
+                    } else {
+                        auto file = files.find(m_baseName(argument));
+                        if ((found = file != files.end())) { contents = file->second; }
+                    }
+                }
+                if (!found) {
+                    ::close(data);
+                    rest = 0;
+                    m_reply(control, "550 No such file");
+                    continue;
+                }
+                contents.erase(0, std::min<size_t>(rest, contents.size()));
+                rest = 0;
+                m_reply(control, "150 Opening data connection");
+
+                size_t limit = 0;
+                if (m_takeFault(dropConnection, m_baseName(argument), limit)) {
+                    m_sendAll(data, contents.substr(0, limit));
+                    ::close(data);
+                    break;
+                }
+                if (m_takeFault(abortTransfer, m_baseName(argument), limit)) {
+                    m_sendAll(data, contents.substr(0, limit));
+                    ::close(data);
+                    m_reply(control, "426 Connection closed; transfer aborted");
+                    continue;
+                }
+                m_sendAll(data, contents);
+                ::close(data);
+                m_reply(control, "226 Transfer complete");
+            } else if (command == "QUIT") {
+                m_reply(control, "221 Goodbye");
+                break;
+            } else {
+                m_reply(control, "502 Command not implemented");
+            }
+        }
+        if (passive >= 0) { ::close(passive); }
+        std::lock_guard<std::mutex> lck(m_mutex);
+        for (auto fd = m_controls.begin(); fd != m_controls.end(); ++fd) {
+            if (*fd == control) {
+                m_controls.erase(fd);
+                break;
+            }
+        }
+        ::close(control);
+    }
+};
+
+/// Collects the results passed to the completion callback
+class Results {
+public:
+    static void onComplete(const MediaDownloadResult &result, void *customData)
+    {
+        Results *results = static_cast<Results *>(customData);
+        std::lock_guard<std::mutex> lck(results->m_mutex);
+        results->m_results.push_back(result);
+        results->m_cv.notify_all();
+    }
+
+    /// Wait for a number of results
+    /// @returns the results, fewer if they did not all arrive within 10 s
+    std::vector<MediaDownloadResult> waitFor(size_t count)
+    {
+        std::unique_lock<std::mutex> lck(m_mutex);
+        m_cv.wait_for(lck, std::chrono::seconds(10), [&]() { return m_results.size() >= count; });
+        return m_results;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<MediaDownloadResult> m_results;
+};
+
+std::string g_directory; ///< scratch directory for the downloaded files
+
+std::string makeContents(size_t size, unsigned seed)
+{
+    std::string contents(size, '\0');
+    for (size_t i = 0; i < size; i++) { contents[i] = static_cast<char>((i * 131 + seed * 7 + (i >> 9)) & 0xff); }
+    return contents;
+}
+
+std::string readFile(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+bool fileExists(const std::string &path) { return ::access(path.c_str(), F_OK) == 0; }
+
+bool hasCommand(FtpStandIn &server, const std::string &command)
+{
+    for (const std::string &line : server.getCommands()) {
+        if (line == command) { return true; }
+    }
+    return false;
+}
+
+MediaDownloadOptions makeOptions(const FtpStandIn &server)
+{
+    MediaDownloadOptions options;
+    options.host           = "127.0.0.1";
+    options.port           = server.getPort();
+    options.mediaDirectory = "/media";
+    options.connections    = 1;
+    options.timeoutMs      = 2000;
+    options.retryDelayMs   = 10;
+    return options;
+}
+
+/// Download one file with a completion callback and return its result
+MediaDownloadResult downloadOne(const MediaDownloadOptions &options, const std::string &name,
+                                const std::string &localPath, MediaDownloadStats *stats = nullptr)
+{
+    Results results;
+    MediaDownloader downloader(options);
+    downloader.registerCompletionCallback(Results::onComplete, &results);
+    downloader.start();
+    downloader.download(name, localPath);
+    std::vector<MediaDownloadResult> done = results.waitFor(1);
+    if (stats) { *stats = downloader.getStats(); }
+    downloader.stop();
+    if (done.empty()) {
+        MediaDownloadResult timedOut;
+        timedOut.error = "no result";
+        return timedOut;
+    }
+    return done.front();
+}
+
+/// Several files over one connection, to a file and to memory, and a missing file
+void testDownload()
+{
+    const std::string test = "download";
+    FtpStandIn server;
+    server.files["a.jpg"] = makeContents(200000, 1);
+    server.files["b.jpg"] = makeContents(1000, 2);
+
+    server.start();
+
+    Results results;
+    MediaDownloader downloader(makeOptions(server));
+    downloader.registerCompletionCallback(Results::onComplete, &results);
+    check(downloader.listMedia().size() == 2, test, "listMedia did not return both files");
+    downloader.start();
+    downloader.download("a.jpg", g_directory + "/a.jpg");
+    downloader.download("b.jpg");
+    downloader.download("missing.jpg");
+    std::vector<MediaDownloadResult> done = results.waitFor(3);
+    downloader.stop();
+
+    check(done.size() == 3, test, "not every download completed");
+    for (const MediaDownloadResult &result : done) {
+        if (result.remotePath == "/media/a.jpg") {
+            check(result.success && result.attempts == 1, test, "a.jpg failed");
+            check(readFile(g_directory + "/a.jpg") == server.files["a.jpg"], test, "a.jpg contents differ");
+            check(!fileExists(g_directory + "/a.jpg.part"), test, "a.jpg.part left behind");
+        } else if (result.remotePath == "/media/b.jpg") {
+            check(result.success, test, "b.jpg failed");
+            check(std::string(result.data.begin(), result.data.end()) == server.files["b.jpg"], test,
+                  "b.jpg contents in memory differ");
+        } else {
+            check(!result.success && !result.error.empty(), test, "missing file reported as downloaded");
+        }
+    }
+    // one for listMedia() and one for the single download connection
+    check(server.getConnections() == 2, test, "downloads did not share the persistent connection");
+}
+
+/// A connection lost mid-transfer is reconnected and the transfer resumed with REST from the last
+/// byte received, to a file and in memory
+void testResume()
+{
+    for (int inMemory = 0; inMemory < 2; inMemory++) {
+        const std::string test = inMemory ? "resume in memory" : "resume to file";
+        FtpStandIn server;
+        server.files["big.jpg"] = makeContents(300000, 3);
+        server.dropConnection["big.jpg"] = 100000;
+
+        const std::string localPath = inMemory ? "" : g_directory + "/big.jpg";
+        MediaDownloadStats stats;
+        server.start();
+        const MediaDownloadResult result = downloadOne(makeOptions(server), "big.jpg", localPath, &stats);
+        check(result.success, test, result.error.c_str());
+        check(result.attempts == 2, test, "expected one retry");
+        check(stats.resumed == 1, test, "retry not counted as resumed");
+        check(stats.bytes == 300000, test, "bytes were received twice");
+        check(hasCommand(server, "REST 100000"), test, "retry did not restart at the last byte received");
+        check(server.getConnections() == 2, test, "did not reconnect after the connection was lost");
+        const std::string contents = inMemory ? std::string(result.data.begin(), result.data.end())
+                                              : readFile(localPath);
+        check(contents == server.files["big.jpg"], test, "resumed contents differ");
+    }
+}
+
+/// A partial file left by an earlier run is resumed rather than downloaded again
+void testResumePartialFile()
+{
+    const std::string test = "resume partial file";
+    FtpStandIn server;
+    server.files["old.jpg"] = makeContents(50000, 4);
+    const std::string localPath = g_directory + "/old.jpg";
+    {
+        std::ofstream partial(localPath + ".part", std::ios::binary);
+        partial << server.files["old.jpg"].substr(0, 12345);
+    }
+
+    server.start();
+
+    const MediaDownloadResult result = downloadOne(makeOptions(server), "old.jpg", localPath);
+    check(result.success && result.attempts == 1, test, result.error.c_str());
+    check(hasCommand(server, "REST 12345"), test, "partial file was not resumed");
+    check(readFile(localPath) == server.files["old.jpg"], test, "resumed contents differ");
+}
+
+/// A server that refuses REST sends the whole file again, and what was received is discarded
+void testRefusedRest()
+{
+    for (int inMemory = 0; inMemory < 2; inMemory++) {
+        const std::string test = inMemory ? "refused REST in memory" : "refused REST to file";
+        FtpStandIn server;
+        server.refuseRest = true;
+        server.files["big.jpg"] = makeContents(300000, 5);
+        server.dropConnection["big.jpg"] = 100000;
+
+        const std::string localPath = inMemory ? "" : g_directory + "/norest.jpg";
+        server.start();
+        const MediaDownloadResult result = downloadOne(makeOptions(server), "big.jpg", localPath);
+        check(result.success, test, result.error.c_str());
+        check(result.attempts == 2, test, "expected one retry");
+        check(hasCommand(server, "REST 100000"), test, "retry did not try to resume");
+        check(result.bytes == 300000, test, "bytes before the restart were kept");
+        const std::string contents = inMemory ? std::string(result.data.begin(), result.data.end())
+                                              : readFile(localPath);
+        check(contents == server.files["big.jpg"], test, "restarted contents differ");
+    }
+}
+
+/// A file whose size does not match SIZE is discarded and downloaded again, and fails once the
+/// attempts run out
+void testSizeMismatch()
+{
+    {
+        const std::string test = "size mismatch once";
+        FtpStandIn server;
+        server.files["c.jpg"] = makeContents(40000, 6);
+        server.wrongSize["c.jpg"] = 1;
+
+        const std::string localPath = g_directory + "/c.jpg";
+        server.start();
+        const MediaDownloadResult result = downloadOne(makeOptions(server), "c.jpg", localPath);
+        check(result.success, test, result.error.c_str());
+        check(result.attempts == 2, test, "mismatch did not cause a retry");
+        check(!hasCommand(server, "REST 40000"), test, "mismatched file was resumed instead of discarded");
+        check(readFile(localPath) == server.files["c.jpg"], test, "contents differ");
+    }
+    {
+        const std::string test = "size mismatch always";
+        FtpStandIn server;
+        server.files["d.jpg"] = makeContents(40000, 7);
+        server.wrongSize["d.jpg"] = 100;
+
+        MediaDownloadOptions options = makeOptions(server);
+        options.maxAttempts = 3;
+        const std::string localPath = g_directory + "/d.jpg";
+        MediaDownloadStats stats;
+        server.start();
+        const MediaDownloadResult result = downloadOne(options, "d.jpg", localPath, &stats);
+        check(!result.success, test, "mismatched file reported as downloaded");
+        check(result.attempts == 3, test, "did not use every attempt");
+        check(result.error.find("size mismatch") != std::string::npos, test, "error does not name the mismatch");
+        check(stats.failed == 1 && stats.completed == 0, test, "stats do not show the failure");
+        check(!fileExists(localPath), test, "mismatched file renamed into place");
+        check(readFile(localPath + ".part").empty(), test, "mismatched bytes kept in the partial file");
+    }
+}
+
+/// A data connection closed early with a 426 reply is retried on a new control connection and resumed
+void testDroppedDataConnection()
+{
+    const std::string test = "dropped data connection";
+    FtpStandIn server;
+    server.files["e.jpg"] = makeContents(250000, 8);
+    server.abortTransfer["e.jpg"] = 65536;
+
+    const std::string localPath = g_directory + "/e.jpg";
+    server.start();
+    const MediaDownloadResult result = downloadOne(makeOptions(server), "e.jpg", localPath);
+    check(result.success, test, result.error.c_str());
+    check(result.attempts == 2, test, "expected one retry");
+    check(server.getConnections() == 2, test, "did not reconnect after the transfer was aborted");
+    check(hasCommand(server, "REST 65536"), test, "retry did not restart at the last byte received");
+    check(readFile(localPath) == server.files["e.jpg"], test, "resumed contents differ");
+}
+
+} // namespace
+
+int main()
+{
+    char directory[] = "/tmp/MediaDownloaderTest.XXXXXX";
+    if (!::mkdtemp(directory)) {
+        std::perror("mkdtemp");
+        return 2;
+    }
+    g_directory = directory;
+
+    testDownload();
+    testResume();
+    testResumePartialFile();
+    testRefusedRest();
+    testSizeMismatch();
+    testDroppedDataConnection();
+
+    const std::string remove = "rm -rf " + g_directory;
+    if (std::system(remove.c_str()) != 0) { std::printf("unable to remove %s\n", g_directory.c_str()); }
+    if (g_failures) {
+        std::printf("%u checks failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
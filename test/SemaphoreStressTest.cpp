@@ -0,0 +1,190 @@
+/****************************************************************************//**
+ * @file
+ * @brief Stress test of Semaphore and FutexSemaphore. Threads notify, wait,
+ * waitTimed and tryWait concurrently and the count invariants are checked.
+ * Build and run with:
+ * g++ -std=c++14 -O2 -pthread -Iinclude test/SemaphoreStressTest.cpp -o SemaphoreStressTest
+ * && ./SemaphoreStressTest
+ * @ingroup wscDrone wscDrone
+ * @author agent
+ * @date Oct. 17, 2026
+ * @copyright CONFIDENTIAL and PROPRIETARY to L3 Technologies Wescam. This
+ * source code is copyrighted. The source code may not be copied, reproduced,
+ * translated, or reduced to any electronic medium or machine-readable form
+ * without the prior written consent of L-3 Wescam. This source code is
+ * confidential and proprietary to L-3 Wescam and may not be reproduced,
+ * published, or disclosed to others without company authorization.
+ ******************************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "wscDrone/FutexSemaphore.h"
+#include "wscDrone/Semaphore.h"
+
+namespace {
+
+unsigned g_failures = 0;
+
+void check(bool condition, const std::string &test, const char *what)
+{
+    if (!condition) {
+        std::printf("FAIL %s: %s\n", test.c_str(), what);
+        g_failures++;
+    }
+}
+
+/// Producers notify a fixed number of times while consumers take with wait(), waitTimed() and
+/// tryWait(). Every notify must be taken exactly once or remain in the count, and the count must
+/// never be seen negative.
+template <typename SemaphoreType>
+void testConcurrentNotifyWait(const std::string &name)
+{
+    const std::string test = name + " concurrent notify/wait";
+    constexpr unsigned PRODUCERS = 4;
+    constexpr unsigned CONSUMERS = 6;
+    constexpr unsigned NOTIFIES  = 50000; // per producer
+
+    SemaphoreType semaphore;
+    std::atomic<uint64_t> taken{0};
+    std::atomic<uint64_t> timeouts{0};
+    std::atomic<bool>     negative{false};
+    std::atomic<bool>     producing{true};
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < CONSUMERS; i++) {
+        threads.emplace_back([&, i]() {
+            while (producing.load() || semaphore.getCount() > 0) {
+                bool got = false;
+                switch (i % 3) {
+                case 0 : got = !semaphore.waitTimed(1); break;
+                case 1 : got = semaphore.tryWait(); break;
+                default: got = !semaphore.waitUntil(std::chrono::steady_clock::now() + std::chrono::microseconds(200)); break;
+                }
+                if (got) { taken++; } else if (i % 3 != 1) { timeouts++; }
+                if (semaphore.getCount() < 0) { negative = true; }
+            }
+        });
+    }
+    // one consumer blocks in wait(), released by the extra notifies below
+    std::atomic<uint64_t> blockingTaken{0};
+    std::thread blocking([&]() {
+        for (unsigned i = 0; i < 1000; i++) {
+            semaphore.wait();
+            blockingTaken++;
+        }
+    });
+
+    std::vector<std::thread> producers;
+    for (unsigned i = 0; i < PRODUCERS; i++) {
+        producers.emplace_back([&]() {
+            for (unsigned n = 0; n < NOTIFIES; n++) {
+                semaphore.notify();
+                if ((n & 0xff) == 0) { std::this_thread::yield(); }
+            }
+        });
+    }
+    for (auto &producer : producers) { producer.join(); }
+    for (unsigned i = 0; i < 1000; i++) { semaphore.notify(); }
+    blocking.join();
+    producing = false;
+    for (auto &thread : threads) { thread.join(); }
+
+    const uint64_t notified = uint64_t(PRODUCERS) * NOTIFIES + 1000;
+    const uint64_t remaining = static_cast<uint64_t>(semaphore.getCount());
+    check(!negative.load(), test, "count was negative");
+    check(taken.load() + blockingTaken.load() + remaining == notified, test, "notifies lost or taken twice");
+    check(remaining == 0, test, "count left after consumers drained it");
+    std::printf("%s: %llu taken, %llu timed out\n", test.c_str(),
+                static_cast<unsigned long long>(taken.load() + blockingTaken.load()),
+                static_cast<unsigned long long>(timeouts.load()));
+}
+
+/// Many threads time out on an empty semaphore at once. No timeout may change the count, so a later
+/// notify must be taken by exactly one waiter.
+template <typename SemaphoreType>
+void testTimeoutsKeepCount(const std::string &name)
+{
+    const std::string test = name + " timeouts keep count";
+    constexpr unsigned WAITERS = 8;
+
+    SemaphoreType semaphore;
+    std::atomic<unsigned> timedOut{0};
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < WAITERS; i++) {
+        threads.emplace_back([&]() {
+            for (unsigned n = 0; n < 20; n++) {
+                if (semaphore.waitTimed(1)) { timedOut++; }
+            }
+        });
+    }
+    for (auto &thread : threads) { thread.join(); }
+    check(timedOut.load() == WAITERS * 20, test, "a wait succeeded without a notify");
+    check(semaphore.getCount() == 0, test, "timeouts changed the count");
+
+    semaphore.notify();
+    std::atomic<unsigned> woken{0};
+    threads.clear();
+    for (unsigned i = 0; i < WAITERS; i++) {
+        threads.emplace_back([&]() {
+            if (!semaphore.waitTimed(50)) { woken++; }
+        });
+    }
+    for (auto &thread : threads) { thread.join(); }
+    check(woken.load() == 1, test, "one notify did not wake exactly one waiter");
+    check(semaphore.getCount() == 0, test, "count not zero after the notify was taken");
+}
+
+/// A waiter blocked in wait() is released by a notify from another thread and the count returns
+/// to zero, repeated to catch lost wakeups
+template <typename SemaphoreType>
+void testPingPong(const std::string &name)
+{
+    const std::string test = name + " ping-pong";
+    constexpr unsigned ROUNDS = 20000;
+
+    SemaphoreType ping;
+    SemaphoreType pong;
+    std::thread other([&]() {
+        for (unsigned i = 0; i < ROUNDS; i++) {
+            ping.wait();
+            pong.notify();
+        }
+    });
+    bool lost = false;
+    for (unsigned i = 0; i < ROUNDS && !lost; i++) {
+        ping.notify();
+        lost = pong.waitTimed(5000);
+    }
+    if (lost) { ping.notify(); } // let the other thread finish
+    other.join();
+    check(!lost, test, "a wakeup was lost");
+    check(ping.getCount() == 0 || lost, test, "ping count not zero");
+    check(pong.getCount() == 0, test, "pong count not zero");
+}
+
+template <typename SemaphoreType>
+void runAll(const std::string &name)
+{
+    testConcurrentNotifyWait<SemaphoreType>(name);
+    testTimeoutsKeepCount<SemaphoreType>(name);
+    testPingPong<SemaphoreType>(name);
+}
+
+} // namespace
+
+int main()
+{
+    runAll<wscDrone::Semaphore>("Semaphore");
+    runAll<wscDrone::FutexSemaphore>("FutexSemaphore");
+    if (g_failures) {
+        std::printf("%u checks failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}